@@ -0,0 +1,836 @@
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <random>
+#include <thread>
+#include <unordered_map>
+
+#include "../include/AnalyticsEncoding.h"
+#include "../include/AnalyticsKernels.h"
+#include "../include/AnalyticsLog.h"
+#include "../include/AnalyticsPipeline.h"
+#include "../include/BufferPool.h"
+#include "../include/ClientSession.h"
+#include "../include/ConnectionProtocol.h"
+#include "../include/ServerMetrics.h"
+#include "../include/Utf8Analytics.h"
+#include "../utils/BenchmarkHarness.h"
+#include "../utils/HelperFunctions.h"
+
+namespace {
+
+using WindowsSocketApp::BenchmarkRunner;
+using WindowsSocketApp::do_not_optimize;
+using WindowsSocketApp::MessageAnalytics;
+using WindowsSocketApp::SocketWrapper;
+
+struct Payload_Size {
+  const char *name;
+  size_t size;
+};
+
+constexpr Payload_Size payload_sizes[]{{"64B", 64},
+                                       {"4KiB", 4 * 1024},
+                                       {"64KiB", 64 * 1024},
+                                       {"1MiB", 1024 * 1024},
+                                       {"16MiB", 16 * 1024 * 1024}};
+
+// Character mixes: English-like text, numbers and arbitrary bytes
+const char *const payload_mixes[]{"prose", "numeric", "binary"};
+
+// UTF-8 text in several scripts, for the UTF-8 analytics only
+constexpr const char *multilingual_mix{"multilingual"};
+
+std::string make_payload(const std::string &mix, size_t size) {
+  static const char *const words[]{"the",     "Server",  "analyzes", "every",
+                                   "message", "quickly", "and",      "sends",
+                                   "its",     "counts",  "back",     "to",
+                                   "each",    "Client",  "over",     "TCP"};
+  // u8 literals stay UTF-8 whatever the compiler's execution character set
+  static const char *const multilingual_words[]{
+      u8"Grüße", u8"naïve",   u8"Ελλάδα", u8"Москва",  u8"世界",
+      u8"こんにちは", u8"مرحبا", u8"١٢٣",    u8"😀",      u8"«quote»",
+      u8"—",     u8"Ünïcödé", u8"\u3000", "the",      "message", "42"};
+  std::mt19937_64 random_engine{size};
+  std::string payload;
+  payload.reserve(size + 16);
+  while (payload.size() < size) {
+    if (mix == multilingual_mix) {
+      // Whole words only, so no sequence is cut at the end
+      std::string word = multilingual_words[random_engine() %
+                                            std::size(multilingual_words)];
+      word += random_engine() % 8 == 0 ? u8"、" : " ";
+      if (payload.size() + word.size() > size) {
+        payload.append(size - payload.size(), ' ');
+        break;
+      }
+      payload += word;
+    } else if (mix == "prose") {
+      payload += words[random_engine() % std::size(words)];
+      payload += random_engine() % 8 == 0 ? ". " : " ";
+    } else if (mix == "numeric") {
+      payload += std::to_string(random_engine() % 100000);
+      payload += ", ";
+    } else {
+      payload += static_cast<char>(random_engine());
+    }
+  }
+  payload.resize(size);
+  return payload;
+}
+
+bool same_analytics(const MessageAnalytics &lhs, const MessageAnalytics &rhs) {
+  return lhs.length == rhs.length &&
+         lhs.punctuation_marks_count == rhs.punctuation_marks_count &&
+         lhs.spaces_count == rhs.spaces_count &&
+         lhs.digits_count == rhs.digits_count &&
+         lhs.uppercase_count == rhs.uppercase_count &&
+         lhs.lowercase_count == rhs.lowercase_count &&
+         lhs.vowels_count == rhs.vowels_count &&
+         lhs.consonants_count == rhs.consonants_count;
+}
+
+// Connected stream sockets that live entirely in memory where the platform
+// allows it (socketpair), loopback TCP on Windows.
+bool make_socket_pair(SocketWrapper &first, SocketWrapper &second) {
+#ifdef _WIN32
+  SocketWrapper listener{socket(AF_INET, SOCK_STREAM, IPPROTO_TCP)};
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  int address_size{sizeof(address)};
+  if (!listener.valid() ||
+      bind(listener.get(), reinterpret_cast<sockaddr *>(&address),
+           address_size) == SOCKET_ERROR ||
+      listen(listener.get(), 1) == SOCKET_ERROR ||
+      getsockname(listener.get(), reinterpret_cast<sockaddr *>(&address),
+                  &address_size) == SOCKET_ERROR) {
+    return false;
+  }
+  first = SocketWrapper{socket(AF_INET, SOCK_STREAM, IPPROTO_TCP)};
+  if (!first.valid() ||
+      connect(first.get(), reinterpret_cast<sockaddr *>(&address),
+              address_size) == SOCKET_ERROR) {
+    return false;
+  }
+  second = SocketWrapper{accept(listener.get(), nullptr, nullptr)};
+  return second.valid();
+#else
+  int descriptors[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, descriptors) == -1) {
+    return false;
+  }
+  first = SocketWrapper{descriptors[0]};
+  second = SocketWrapper{descriptors[1]};
+  return true;
+#endif
+}
+
+// Writes payload to the socket from another thread and shuts down sending,
+// like a legacy client.
+std::thread send_from_client(SOCKET client_socket, const std::string &payload) {
+  return std::thread{[client_socket, &payload]() {
+    WindowsSocketApp::send_buffer_content(client_socket, payload, false);
+    WindowsSocketApp::shutdown_sending_side(client_socket);
+  }};
+}
+
+bool same_ranked_terms(const WindowsSocketApp::Ranked_Terms &lhs,
+                       const WindowsSocketApp::Ranked_Terms &rhs) {
+  for (size_t i = 0; i < lhs.size(); ++i) {
+    if (lhs[i].count != rhs[i].count ||
+        std::string(lhs[i].term.text.data(), lhs[i].term.length) !=
+            std::string(rhs[i].term.text.data(), rhs[i].term.length)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Every kernel against REFERENCE on every payload, before anything is timed.
+bool verify_kernels() {
+  using WindowsSocketApp::Analytics_Kernel;
+  bool all_match{true};
+  for (const char *mix : payload_mixes) {
+    for (const auto &payload_size : payload_sizes) {
+      const std::string payload = make_payload(mix, payload_size.size);
+      MessageAnalytics expected{};
+      WindowsSocketApp::run_analytics_kernel(Analytics_Kernel::REFERENCE,
+                                             payload.data(), payload.size(),
+                                             expected);
+      for (auto kernel : {Analytics_Kernel::SCALAR, Analytics_Kernel::SSE2,
+                          Analytics_Kernel::AVX2, Analytics_Kernel::AVX512}) {
+        MessageAnalytics actual{};
+        if (WindowsSocketApp::run_analytics_kernel(
+                kernel, payload.data(), payload.size(), actual) &&
+            !same_analytics(expected, actual)) {
+          std::cerr << "Kernel "
+                    << WindowsSocketApp::get_analytics_kernel_name(kernel)
+                    << " differs from the reference on " << mix << "/"
+                    << payload_size.name << std::endl;
+          all_match = false;
+        }
+      }
+
+      // The fused pipeline, fed in chunks that split words, must agree with
+      // the reference and with itself fed the whole payload
+      constexpr size_t chunk_size{1000};
+      WindowsSocketApp::PipelineAnalyzer chunked{
+          WindowsSocketApp::analytics_all_counters};
+      for (size_t offset = 0; offset < payload.size(); offset += chunk_size) {
+        chunked.update(payload.data() + offset,
+                       std::min(chunk_size, payload.size() - offset));
+      }
+      chunked.finish();
+      const auto whole = WindowsSocketApp::calculate_pipeline_analytics(
+          payload.data(), payload.size(),
+          WindowsSocketApp::analytics_all_counters);
+      const auto &actual = chunked.get_analytics();
+      if (!same_analytics(expected, actual.classes) ||
+          actual.words_count != whole.words_count ||
+          actual.lines_count != whole.lines_count ||
+          actual.code_points_count != whole.code_points_count ||
+          actual.byte_histogram != whole.byte_histogram ||
+          !same_ranked_terms(actual.top_words.message_words,
+                             whole.top_words.message_words) ||
+          !same_ranked_terms(actual.top_words.message_bigrams,
+                             whole.top_words.message_bigrams)) {
+        std::cerr << "The analytics pipeline differs on " << mix << "/"
+                  << payload_size.name << std::endl;
+        all_match = false;
+      }
+    }
+  }
+  return all_match;
+}
+
+bool same_utf8_analytics(const WindowsSocketApp::Utf8_Analytics &lhs,
+                         const WindowsSocketApp::Utf8_Analytics &rhs) {
+  // The counts of invalid text depend on where the kernel stopped
+  if (!lhs.valid || !rhs.valid) {
+    return lhs.valid == rhs.valid;
+  }
+  return lhs.code_points_count == rhs.code_points_count &&
+         lhs.code_points_count == rhs.code_points_count &&
+         lhs.letters_count == rhs.letters_count &&
+         lhs.uppercase_count == rhs.uppercase_count &&
+         lhs.lowercase_count == rhs.lowercase_count &&
+         lhs.digits_count == rhs.digits_count &&
+         lhs.whitespace_count == rhs.whitespace_count &&
+         lhs.punctuation_count == rhs.punctuation_count;
+}
+
+// Every UTF-8 kernel against SCALAR, on whole payloads and on payloads fed
+// in chunks that split sequences, then on sequences every validator must
+// accept or reject wherever they fall in a 32-byte block.
+bool verify_utf8_kernels() {
+  using WindowsSocketApp::Utf8_Kernel;
+  bool all_match{true};
+  const char *const mixes[]{"prose", "binary", multilingual_mix};
+  for (const char *mix : mixes) {
+    for (const auto &payload_size : payload_sizes) {
+      const std::string payload = make_payload(mix, payload_size.size);
+      WindowsSocketApp::Utf8_Analytics expected{};
+      WindowsSocketApp::run_utf8_analytics(Utf8_Kernel::SCALAR, payload.data(),
+                                           payload.size(), expected);
+      for (auto kernel : {Utf8_Kernel::SCALAR, Utf8_Kernel::AVX2}) {
+        if (!WindowsSocketApp::is_utf8_kernel_supported(kernel)) {
+          continue;
+        }
+        WindowsSocketApp::Utf8_Analytics whole{};
+        WindowsSocketApp::run_utf8_analytics(kernel, payload.data(),
+                                             payload.size(), whole);
+        bool match = same_utf8_analytics(expected, whole);
+        for (size_t chunk_size : {1, 7, 1000}) {
+          WindowsSocketApp::Utf8Analyzer chunked{kernel};
+          for (size_t offset = 0; offset < payload.size();
+               offset += chunk_size) {
+            chunked.update(payload.data() + offset,
+                           std::min(chunk_size, payload.size() - offset));
+          }
+          match = match && same_utf8_analytics(expected,
+                                               chunked.get_analytics());
+        }
+        if (!match) {
+          std::cerr << "UTF-8 kernel "
+                    << WindowsSocketApp::get_utf8_kernel_name(kernel)
+                    << " differs from scalar on " << mix << "/"
+                    << payload_size.name << std::endl;
+          all_match = false;
+        }
+      }
+    }
+  }
+
+  struct Sequence {
+    const char *bytes;
+    bool valid;
+  };
+  const Sequence sequences[]{
+      {"\xC3\xA9", true},          {"\xE2\x82\xAC", true},
+      {"\xED\x9F\xBF", true},      {"\xEF\xBF\xBF", true},
+      {"\xF0\x9F\x98\x80", true},  {"\xF4\x8F\xBF\xBF", true},
+      {"\x80", false},              {"\xBF\xBF", false},
+      {"\xC0\xAF", false},          {"\xC1\xBF", false},
+      {"\xC3", false},              {"\xC3\x28", false},
+      {"\xE0\x80\xAF", false},      {"\xE2\x82", false},
+      {"\xED\xA0\x80", false},      {"\xF0\x8F\xBF\xBF", false},
+      {"\xF4\x90\x80\x80", false},  {"\xF5\x80\x80\x80", false},
+      {"\xF0\x9F\x98", false},      {"\xFF", false}};
+  for (const auto &sequence : sequences) {
+    for (size_t offset = 0; offset < 40; ++offset) {
+      const std::string text = std::string(offset, 'a') + sequence.bytes +
+                               std::string(64 - offset, 'b');
+      for (auto kernel : {Utf8_Kernel::SCALAR, Utf8_Kernel::AVX2}) {
+        WindowsSocketApp::Utf8_Analytics analytics{};
+        if (WindowsSocketApp::run_utf8_analytics(kernel, text.data(),
+                                                 text.size(), analytics) &&
+            analytics.valid != sequence.valid) {
+          std::cerr << "UTF-8 kernel "
+                    << WindowsSocketApp::get_utf8_kernel_name(kernel)
+                    << (sequence.valid ? " rejects" : " accepts")
+                    << " a sequence at offset " << offset << std::endl;
+          all_match = false;
+        }
+      }
+    }
+  }
+  return all_match;
+}
+
+// The top words against exact counts: on prose, whose few words the
+// sketches hold exactly, and on a word planted every tenth token among
+// numbers that are nearly all distinct.
+bool verify_top_words() {
+  bool all_match{true};
+  const auto check = [&all_match](const char *name, const std::string &text) {
+    std::unordered_map<std::string, uint64_t> exact;
+    std::string word;
+    for (const char c : text + " ") {
+      if (std::isalnum(static_cast<unsigned char>(c)) != 0) {
+        word += static_cast<char>(
+            std::tolower(static_cast<unsigned char>(c)));
+      } else if (!word.empty()) {
+        ++exact[word];
+        word.clear();
+      }
+    }
+    // Ties are ranked in the order of their text
+    const auto most_frequent = std::max_element(
+        exact.begin(), exact.end(), [](const auto &lhs, const auto &rhs) {
+          return lhs.second < rhs.second ||
+                 (lhs.second == rhs.second && lhs.first > rhs.first);
+        });
+    const auto analytics = WindowsSocketApp::calculate_pipeline_analytics(
+        text.data(), text.size(), WindowsSocketApp::analytics_top_words);
+    const auto &top = analytics.top_words.message_words[0];
+    if (std::string(top.term.text.data(), top.term.length) !=
+            most_frequent->first ||
+        top.count < most_frequent->second ||
+        top.count > most_frequent->second + most_frequent->second / 100) {
+      std::cerr << "The top words differ from the exact counts on " << name
+                << std::endl;
+      all_match = false;
+    }
+  };
+  check("prose", make_payload("prose", 1024 * 1024));
+  std::string planted;
+  std::mt19937_64 random_engine{42};
+  for (int i = 0; i < 200000; ++i) {
+    planted += i % 10 == 0 ? std::string{"planted"}
+                           : std::to_string(random_engine() % 10000000);
+    planted += ' ';
+  }
+  check("numbers", planted);
+  return all_match;
+}
+
+// The analytics log against the records written to it: by 8 threads into a
+// new log, after reopening it, and past its capacity. POSIX only.
+bool verify_analytics_log() {
+#ifdef _WIN32
+  return true;
+#else
+  using WindowsSocketApp::AnalyticsLog;
+  const std::filesystem::path path =
+      std::filesystem::temp_directory_path() / "benchmarks_analytics.log";
+  std::filesystem::remove(path);
+  const std::string message = make_payload("prose", 1000);
+  const MessageAnalytics analytics =
+      WindowsSocketApp::calculate_message_analytics(message.data(),
+                                                    message.size());
+  bool all_match{true};
+  const auto check = [&](const char *name, uint64_t messages_count) {
+    WindowsSocketApp::AnalyticsLogReader reader;
+    if (!reader.open(path.string())) {
+      all_match = false;
+      return;
+    }
+    const auto summary = WindowsSocketApp::summarize_analytics_log(
+        reader.get_records(), reader.get_committed_slots());
+    if (summary.analytics.messages_count != messages_count ||
+        summary.analytics.classified_messages_count != messages_count ||
+        summary.analytics.classes.vowels_count !=
+            analytics.vowels_count * messages_count ||
+        summary.analytics.message_sizes[WindowsSocketApp::
+                                            get_message_size_bucket(
+                                                message.size())] !=
+            messages_count) {
+      std::cerr << "The analytics log differs from the records written "
+                << name << std::endl;
+      all_match = false;
+    }
+  };
+
+  AnalyticsLog log;
+  constexpr uint64_t per_thread_count{1000};
+  if (!log.open(path.string(), 64 * AnalyticsLog::chunk_slots)) {
+    return false;
+  }
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 8; ++i) {
+    threads.emplace_back([&log, &analytics]() {
+      for (uint64_t j = 0; j < per_thread_count; ++j) {
+        log.append(analytics);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  log.close();
+  check("by 8 threads", 8 * per_thread_count);
+
+  if (!log.open(path.string())) {
+    return false;
+  }
+  for (uint64_t j = 0; j < per_thread_count; ++j) {
+    log.append(analytics);
+  }
+  log.close();
+  check("after reopening", 9 * per_thread_count);
+
+  std::filesystem::remove(path);
+  if (!log.open(path.string(), AnalyticsLog::chunk_slots)) {
+    return false;
+  }
+  for (uint64_t j = 0; j < AnalyticsLog::chunk_slots + 10; ++j) {
+    log.append(analytics);
+  }
+  if (log.get_dropped_records() != 10) {
+    std::cerr << "The full analytics log dropped "
+              << log.get_dropped_records() << " records instead of 10"
+              << std::endl;
+    all_match = false;
+  }
+  log.close();
+  check("past its capacity", AnalyticsLog::chunk_slots);
+  std::filesystem::remove(path);
+  return all_match;
+#endif
+}
+
+
+void benchmark_kernels(BenchmarkRunner &runner) {
+  using WindowsSocketApp::Analytics_Kernel;
+  for (auto kernel : {Analytics_Kernel::REFERENCE, Analytics_Kernel::SCALAR,
+                      Analytics_Kernel::SSE2, Analytics_Kernel::AVX2,
+                      Analytics_Kernel::AVX512}) {
+    if (!WindowsSocketApp::is_analytics_kernel_supported(kernel)) {
+      continue;
+    }
+    for (const char *mix : payload_mixes) {
+      for (const auto &payload_size : payload_sizes) {
+        // The byte-by-byte loop would take seconds on the large payloads
+        if (kernel == Analytics_Kernel::REFERENCE &&
+            payload_size.size > 64 * 1024) {
+          continue;
+        }
+        const std::string name =
+            std::string{"kernel/"} +
+            WindowsSocketApp::get_analytics_kernel_name(kernel) + "/" + mix +
+            "/" + payload_size.name;
+        if (!runner.selected(name)) {
+          continue;
+        }
+        const std::string payload = make_payload(mix, payload_size.size);
+        runner.run(name, payload.size(), [&]() {
+          MessageAnalytics analytics{};
+          WindowsSocketApp::run_analytics_kernel(kernel, payload.data(),
+                                                 payload.size(), analytics);
+          do_not_optimize(analytics);
+        });
+      }
+    }
+  }
+}
+
+// Counter selections of the analytics pipeline: every counter a request
+// leaves out should take its time with it.
+void benchmark_pipeline(BenchmarkRunner &runner) {
+  struct Selection {
+    const char *name;
+    uint16_t counters;
+  };
+  const Selection selections[]{
+      {"classes", WindowsSocketApp::analytics_character_classes},
+      {"words", WindowsSocketApp::analytics_words},
+      {"words+lines", static_cast<uint16_t>(WindowsSocketApp::analytics_words |
+                                            WindowsSocketApp::analytics_lines)},
+      {"classes+words",
+       static_cast<uint16_t>(WindowsSocketApp::analytics_character_classes |
+                             WindowsSocketApp::analytics_words)},
+      {"top-words", WindowsSocketApp::analytics_top_words},
+      {"all", WindowsSocketApp::analytics_all_counters}};
+  for (const auto &selection : selections) {
+    for (const char *mix : payload_mixes) {
+      const std::string name = std::string{"pipeline/"} + selection.name +
+                               "/" + mix + "/64KiB";
+      if (!runner.selected(name)) {
+        continue;
+      }
+      const std::string payload = make_payload(mix, 64 * 1024);
+      WindowsSocketApp::PipelineAnalyzer analyzer{selection.counters};
+      runner.run(name, payload.size(), [&]() {
+        analyzer.reset(selection.counters);
+        analyzer.update(payload.data(), payload.size());
+        analyzer.finish();
+        do_not_optimize(analyzer.get_analytics().words_count);
+      });
+    }
+  }
+}
+
+// The UTF-8 analytics, to compare with the byte scans of the same payloads
+// above: ASCII text should stay within a small factor of them.
+void benchmark_utf8(BenchmarkRunner &runner) {
+  using WindowsSocketApp::Utf8_Kernel;
+  for (auto kernel : {Utf8_Kernel::SCALAR, Utf8_Kernel::AVX2}) {
+    if (!WindowsSocketApp::is_utf8_kernel_supported(kernel)) {
+      continue;
+    }
+    for (const char *mix : {"prose", multilingual_mix}) {
+      const std::string name =
+          std::string{"utf8/"} + WindowsSocketApp::get_utf8_kernel_name(kernel) +
+          "/" + mix + "/64KiB";
+      if (!runner.selected(name)) {
+        continue;
+      }
+      const std::string payload = make_payload(mix, 64 * 1024);
+      runner.run(name, payload.size(), [&]() {
+        WindowsSocketApp::Utf8_Analytics analytics{};
+        WindowsSocketApp::run_utf8_analytics(kernel, payload.data(),
+                                             payload.size(), analytics);
+        do_not_optimize(analytics);
+      });
+    }
+  }
+}
+
+// The server's own method: analyze the received buffer with the active
+// kernel (all cores from 1 MiB) and build the reply text.
+void benchmark_session_analytics(BenchmarkRunner &runner) {
+  for (const char *mix : payload_mixes) {
+    for (const auto &payload_size : payload_sizes) {
+      const std::string name =
+          std::string{"calculate_recv_message_analytics/"} + mix + "/" +
+          payload_size.name;
+      if (!runner.selected(name)) {
+        continue;
+      }
+      const std::string payload = make_payload(mix, payload_size.size);
+      SocketWrapper server_socket;
+      SocketWrapper client_socket;
+      if (!make_socket_pair(server_socket, client_socket)) {
+        std::cerr << "Failed to create a socket pair" << std::endl;
+        return;
+      }
+      std::thread client = send_from_client(client_socket.get(), payload);
+      WindowsSocketApp::ClientSession session{std::move(server_socket),
+                                              16 * 1024, false};
+      session.receive_client_message();
+      client.join();
+
+      runner.run(name, payload.size(),
+                 [&session]() { session.calculate_recv_message_analytics(); });
+    }
+  }
+}
+
+void benchmark_character_classes(BenchmarkRunner &runner) {
+  for (const char *mix : payload_mixes) {
+    const std::string payload = make_payload(mix, 64 * 1024);
+    runner.run(std::string{"is_vowel/"} + mix + "/64KiB", payload.size(),
+               [&payload]() {
+                 size_t count{0};
+                 for (const char c : payload) {
+                   count += WindowsSocketApp::is_vowel(c) ? 1 : 0;
+                 }
+                 do_not_optimize(count);
+               });
+    runner.run(std::string{"is_consonant/"} + mix + "/64KiB", payload.size(),
+               [&payload]() {
+                 size_t count{0};
+                 for (const char c : payload) {
+                   count += WindowsSocketApp::is_consonant(c) ? 1 : 0;
+                 }
+                 do_not_optimize(count);
+               });
+  }
+}
+
+void benchmark_responses(BenchmarkRunner &runner) {
+  const std::string message = make_payload("prose", 64 * 1024);
+  const MessageAnalytics analytics =
+      WindowsSocketApp::calculate_message_analytics(message.data(),
+                                                    message.size());
+  WindowsSocketApp::Analytics_Text_Buffer text;
+  runner.run("response/write_text", 0, [&]() {
+    do_not_optimize(
+        WindowsSocketApp::write_message_analytics_text(analytics, text));
+  });
+  runner.run("response/format_string", 0, [&]() {
+    do_not_optimize(WindowsSocketApp::format_message_analytics(analytics));
+  });
+  char binary[WindowsSocketApp::message_analytics_binary_size];
+  runner.run("response/encode_binary", 0, [&]() {
+    WindowsSocketApp::encode_message_analytics_binary(analytics, binary);
+    do_not_optimize(binary);
+  });
+  std::string frame;
+  runner.run("response/text_frame", 0, [&]() {
+    frame.clear();
+    const size_t text_length =
+        WindowsSocketApp::write_message_analytics_text(analytics, text);
+    WindowsSocketApp::append_frame(frame,
+                                   WindowsSocketApp::Frame_Type::RESPONSE, 1,
+                                   text.data(), text_length);
+    do_not_optimize(frame.data());
+  });
+}
+
+// Request frames fed to the server's protocol in 16 KiB reads, with the
+// replies drained as an I/O engine would.
+void benchmark_framing(BenchmarkRunner &runner) {
+  for (size_t message_size : {size_t{64}, size_t{4096}}) {
+    const std::string message = make_payload("prose", message_size);
+    std::string frames;
+    for (uint32_t request_id = 1; request_id <= 256; ++request_id) {
+      WindowsSocketApp::append_frame(frames,
+                                     WindowsSocketApp::Frame_Type::REQUEST,
+                                     request_id, message);
+    }
+    WindowsSocketApp::ConnectionProtocol protocol;
+    constexpr size_t read_size{16 * 1024};
+    runner.run("framing/256_requests/" + std::to_string(message_size) + "B",
+               frames.size(), [&]() {
+                 for (size_t offset = 0; offset < frames.size();
+                      offset += read_size) {
+                   protocol.on_bytes_received(
+                       frames.data() + offset,
+                       std::min(read_size, frames.size() - offset));
+                   protocol.consume_output(protocol.pending_output_size());
+                 }
+               });
+  }
+}
+
+// receive_until_empty_input() against a connected socket pair, with the
+// server's default read size and a larger one.
+void benchmark_receive(BenchmarkRunner &runner) {
+  for (size_t read_size : {size_t{1024}, size_t{64 * 1024}}) {
+    for (const auto &payload_size : payload_sizes) {
+      if (payload_size.size < 64 * 1024) {
+        continue;
+      }
+      const std::string name = "receive_until_empty_input/read" +
+                               std::to_string(read_size / 1024) + "KiB/" +
+                               payload_size.name;
+      if (!runner.selected(name)) {
+        continue;
+      }
+      const std::string payload = make_payload("prose", payload_size.size);
+      std::vector<char> receive_buffer;
+      runner.run(name, payload.size(), [&]() {
+        SocketWrapper server_socket;
+        SocketWrapper client_socket;
+        if (!make_socket_pair(server_socket, client_socket)) {
+          return;
+        }
+        std::thread client = send_from_client(client_socket.get(), payload);
+        receive_buffer.resize(read_size);
+        WindowsSocketApp::receive_until_empty_input(server_socket.get(),
+                                                    receive_buffer, false);
+        client.join();
+        do_not_optimize(receive_buffer.data());
+      });
+    }
+  }
+}
+
+// What a reply adds to the server-wide analytics, and what a query of them
+// costs once 16 threads have counted into their shards.
+void benchmark_aggregate(BenchmarkRunner &runner) {
+  const std::string message = make_payload("prose", 4096);
+  const MessageAnalytics analytics =
+      WindowsSocketApp::calculate_message_analytics(message.data(),
+                                                    message.size());
+  WindowsSocketApp::ServerMetrics &metrics =
+      WindowsSocketApp::get_server_metrics();
+  runner.run("aggregate/add_message_analytics", 0, [&]() {
+    metrics.local().add_message_analytics(analytics);
+  });
+  if (!runner.selected("aggregate/query/16_threads")) {
+    return;
+  }
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 16; ++i) {
+    threads.emplace_back([&metrics, &analytics]() {
+      metrics.local().add_message_analytics(analytics);
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  runner.run("aggregate/query/16_threads", 0, [&]() {
+    do_not_optimize(metrics.aggregate_analytics().messages_count);
+  });
+}
+
+// An append into the mapping of a log file, page faults of fresh pages
+// included, and a scan of the records as the log reader runs it.
+void benchmark_analytics_log(BenchmarkRunner &runner) {
+#ifndef _WIN32
+  using WindowsSocketApp::AnalyticsLog;
+  const std::string message = make_payload("prose", 4096);
+  const MessageAnalytics analytics =
+      WindowsSocketApp::calculate_message_analytics(message.data(),
+                                                    message.size());
+  if (runner.selected("analytics_log/append")) {
+    const std::filesystem::path path =
+        std::filesystem::temp_directory_path() / "benchmarks_append.log";
+    // Logs are recreated once full, so the cost of creating one is spread
+    // over its million records
+    constexpr uint64_t capacity{1024 * 1024};
+    AnalyticsLog log;
+    const auto recreate = [&log, &path]() {
+      log.close();
+      std::filesystem::remove(path);
+      return log.open(path.string(), capacity);
+    };
+    if (recreate()) {
+      runner.run("analytics_log/append", 0, [&]() {
+        if (log.get_dropped_records() != 0) {
+          recreate();
+        }
+        log.append(analytics);
+      });
+    }
+    log.close();
+    std::filesystem::remove(path);
+  }
+#endif
+  if (!runner.selected("analytics_log/scan")) {
+    return;
+  }
+  WindowsSocketApp::Analytics_Log_Record record;
+  record.timestamp_nanoseconds = 1;
+  record.message_size = analytics.length;
+  record.counters = WindowsSocketApp::analytics_character_classes;
+  record.classes[0] = analytics.length;
+  const std::vector<WindowsSocketApp::Analytics_Log_Record> records(
+      256 * 1024, record);
+  runner.run("analytics_log/scan/32MiB",
+             records.size() * sizeof(record), [&]() {
+               do_not_optimize(WindowsSocketApp::summarize_analytics_log(
+                                   records.data(), records.size())
+                                   .analytics.messages_count);
+             });
+}
+
+void benchmark_buffers(BenchmarkRunner &runner) {
+  constexpr size_t buffer_size{16 * 1024};
+  runner.run("buffers/pool_acquire_release/16KiB", 0, []() {
+    const WindowsSocketApp::PooledBuffer buffer{
+        WindowsSocketApp::get_buffer_pool().acquire(buffer_size)};
+    do_not_optimize(buffer.data());
+  });
+  runner.run("buffers/vector_allocate/16KiB", 0, []() {
+    const std::vector<char> buffer(buffer_size);
+    do_not_optimize(buffer.data());
+  });
+}
+
+}  // namespace
+
+// Usage: benchmarks [options]
+// Options:
+//   --filter=TEXT     run only the benchmarks whose name contains TEXT
+//   --min-time=MS     time spent measuring each benchmark (default 100)
+//   --csv=PATH        write the results as CSV
+//   --baseline=PATH   compare against the CSV of an earlier run
+// Every analytics kernel is checked against the reference kernel first, and
+// the analytics log against the records written to it; the exit code is 1
+// when one of them differs.
+int main(int argc, char *argv[]) {
+  WSADATA wsaData;
+  if (!WindowsSocketApp::initialize_winsock_2_0(wsaData)) {
+    std::cerr << "Failed to initialize Winsock 2.0. Exiting from main()..."
+              << std::endl;
+    return 1;
+  }
+
+  std::vector<std::string> options{};
+  for (int i = 1; i < argc; ++i) {
+    options.emplace_back(argv[i]);
+  }
+  const auto get_option_value = [&options](const std::string &name) {
+    const std::string prefix{name + "="};
+    for (const auto &option : options) {
+      if (option.rfind(prefix, 0) == 0) {
+        return option.substr(prefix.size());
+      }
+    }
+    return std::string{};
+  };
+
+  const std::string minimum_time{get_option_value("--min-time")};
+  BenchmarkRunner runner{
+      minimum_time.empty()
+          ? BenchmarkRunner::default_minimum_time
+          : std::chrono::milliseconds{
+                std::strtoul(minimum_time.c_str(), nullptr, 10)},
+      BenchmarkRunner::default_repetitions, get_option_value("--filter")};
+  const std::string baseline{get_option_value("--baseline")};
+  if (!baseline.empty() && !runner.load_baseline(baseline)) {
+    WSACleanup();
+    return 1;
+  }
+
+  if (!verify_kernels() || !verify_utf8_kernels() || !verify_top_words() ||
+      !verify_analytics_log()) {
+    WSACleanup();
+    return 1;
+  }
+  std::cout << "All analytics kernels match the reference. Active kernel: "
+            << WindowsSocketApp::get_analytics_kernel_name(
+                   WindowsSocketApp::get_active_analytics_kernel())
+            << std::endl;
+
+  benchmark_kernels(runner);
+  benchmark_pipeline(runner);
+  benchmark_utf8(runner);
+  benchmark_session_analytics(runner);
+  benchmark_character_classes(runner);
+  benchmark_responses(runner);
+  benchmark_framing(runner);
+  benchmark_receive(runner);
+  benchmark_aggregate(runner);
+  benchmark_analytics_log(runner);
+  benchmark_buffers(runner);
+
+  const std::string csv{get_option_value("--csv")};
+  const bool written = csv.empty() || runner.write_csv(csv);
+  WSACleanup();
+  return written ? 0 : 1;
+}
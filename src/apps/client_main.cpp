@@ -1,6 +1,312 @@
+#include <algorithm>
+#include <chrono>
+
+#include "../include/AsyncClient.h"
+#include "../include/AsyncEventLoop.h"
 #include "../include/Client.h"
+#include "../include/ConnectionPool.h"
+
+namespace {
+
+constexpr size_t default_async_connection_count{100};
+
+// Counter groups named in a --counters list; an empty list leaves them 0.
+bool parse_counters(const std::string &list, uint16_t &counters) {
+  static const std::pair<const char *, uint16_t> counter_names[]{
+      {"classes", WindowsSocketApp::analytics_character_classes},
+      {"words", WindowsSocketApp::analytics_words},
+      {"lines", WindowsSocketApp::analytics_lines},
+      {"code-points", WindowsSocketApp::analytics_code_points},
+      {"histogram", WindowsSocketApp::analytics_byte_histogram},
+      {"unicode", WindowsSocketApp::analytics_unicode},
+      {"top-words", WindowsSocketApp::analytics_top_words},
+      {"all", WindowsSocketApp::analytics_all_counters}};
+  size_t start{0};
+  while (start < list.size()) {
+    size_t end = list.find(',', start);
+    if (end == std::string::npos) {
+      end = list.size();
+    }
+    const std::string name{list.substr(start, end - start)};
+    const auto *const found = std::find_if(
+        std::begin(counter_names), std::end(counter_names),
+        [&name](const auto &entry) { return name == entry.first; });
+    if (found == std::end(counter_names)) {
+      std::cerr << "Unknown counter group: " << name << std::endl;
+      return false;
+    }
+    counters = static_cast<uint16_t>(counters | found->second);
+    start = end + 1;
+  }
+  return true;
+}
+
+// One connection per request: the end of the message is marked by shutting
+// down the sending side and the reply is read until the server closes.
+bool run_legacy_requests(const std::string &server_ip, const std::string &port,
+                         const std::string &message, size_t request_count) {
+  const bool verbose{request_count == 1};
+  for (size_t i = 0; i < request_count; ++i) {
+    WindowsSocketApp::Client client{message, 1024, server_ip, port};
+
+    if (verbose) {
+      std::cout << "Connecting to server at " << server_ip << ":" << port
+                << "..." << std::endl;
+    }
+
+    // Connect to server
+    client.connect_to_server();
+
+    if (client.get_client_init_status() !=
+        WindowsSocketApp::Client_Initialization_Status::CONNECTED) {
+      std::cerr << "Failed to connect to server." << std::endl;
+      return false;
+    }
+
+    if (verbose) {
+      std::cout << "Connected to server successfully!" << std::endl;
+      std::cout << "Sending message: \"" << message << "\"" << std::endl;
+    }
+    client.send_buffer_to_server();
+
+    // Shutdown sending
+    if (verbose) {
+      std::cout << "Shutting down sending..." << std::endl;
+    }
+    client.shutdown_message_sending();
+
+    // Receive response
+    if (verbose) {
+      std::cout << "Waiting for server response..." << std::endl;
+    }
+    client.receive_server_message();
+
+    if (i + 1 == request_count) {
+      std::cout << "Received analytics from server:" << std::endl;
+      client.display_recv_buffer();
+    }
+  }  // Client destructor automatically called to clean up the resources.
+  return true;
+}
+
+// All requests as frames over one persistent connection.
+bool run_framed_requests(const std::string &server_ip, const std::string &port,
+                         const std::string &message, size_t request_count,
+                         bool binary_analytics, uint16_t counters) {
+  WindowsSocketApp::Client client{message, 1024, server_ip, port};
+  client.set_binary_analytics(binary_analytics);
+  client.set_analytics_counters(counters);
+
+  std::cout << "Connecting to server at " << server_ip << ":" << port
+            << "..." << std::endl;
+  client.connect_to_server();
+  if (client.get_client_init_status() !=
+      WindowsSocketApp::Client_Initialization_Status::CONNECTED) {
+    std::cerr << "Failed to connect to server." << std::endl;
+    return false;
+  }
+
+  std::cout << "Sending " << request_count << " framed request(s): \""
+            << message << "\"" << std::endl;
+  for (size_t i = 0; i < request_count; ++i) {
+    if (!client.send_request_frame() || !client.receive_response_frame()) {
+      return false;
+    }
+  }
+
+  std::cout << "Received analytics from server:" << std::endl;
+  client.display_recv_buffer();
+
+  // Tells the server that no more requests follow
+  client.shutdown_message_sending();
+  return true;
+}
+
+// The requests in batches of batch_size messages over one persistent
+// connection, each batch one request frame answered by one response frame.
+bool run_batched_requests(const std::string &server_ip,
+                          const std::string &port, const std::string &message,
+                          size_t request_count, size_t batch_size,
+                          bool binary_analytics, uint16_t counters) {
+  // Longer batches are not listed record by record
+  constexpr size_t max_displayed_batch_size{16};
+  WindowsSocketApp::Client client{message, 1024, server_ip, port};
+  client.set_binary_analytics(binary_analytics);
+  client.set_analytics_counters(counters);
+
+  std::cout << "Connecting to server at " << server_ip << ":" << port
+            << "..." << std::endl;
+  client.connect_to_server();
+  if (client.get_client_init_status() !=
+      WindowsSocketApp::Client_Initialization_Status::CONNECTED) {
+    std::cerr << "Failed to connect to server." << std::endl;
+    return false;
+  }
+
+  std::cout << "Sending " << request_count << " request(s) in batches of "
+            << batch_size << ": \"" << message << "\"" << std::endl;
+  std::vector<std::string> batch;
+  for (size_t sent = 0; sent < request_count; sent += batch.size()) {
+    batch.assign(std::min(batch_size, request_count - sent), message);
+    if (!client.send_batch_request(batch) ||
+        !client.receive_response_frame()) {
+      return false;
+    }
+    const size_t record_count =
+        !binary_analytics ? client.get_batch_texts().size()
+        : counters != 0
+            ? client.get_batch_pipeline_analytics().size()
+            : client.get_batch_analytics().size();
+    if (record_count != batch.size()) {
+      std::cerr << "Received " << record_count << " record(s) for a batch of "
+                << batch.size() << std::endl;
+      return false;
+    }
+  }
+
+  std::cout << "Received analytics from server:" << std::endl;
+  if (batch.size() <= max_displayed_batch_size) {
+    client.display_recv_buffer();
+  } else {
+    std::cout << batch.size() << " records in the last batch" << std::endl;
+  }
+
+  // Tells the server that no more requests follow
+  client.shutdown_message_sending();
+  return true;
+}
+
+// Every request as its own Client, with the connection taken from a pool and
+// handed back after the response, so only the first request resolves the
+// address and connects.
+bool run_pooled_requests(const std::string &server_ip, const std::string &port,
+                         const std::string &message, size_t request_count,
+                         bool binary_analytics, uint16_t counters) {
+  WindowsSocketApp::ConnectionPool pool;
+  for (size_t i = 0; i < request_count; ++i) {
+    WindowsSocketApp::Client client{message, 1024, server_ip, port};
+    client.set_binary_analytics(binary_analytics);
+    client.set_analytics_counters(counters);
+    client.connect_to_server(pool);
+    if (client.get_client_init_status() !=
+        WindowsSocketApp::Client_Initialization_Status::CONNECTED) {
+      std::cerr << "Failed to connect to server." << std::endl;
+      return false;
+    }
+    const bool answered =
+        client.send_request_frame() && client.receive_response_frame();
+    if (answered && i + 1 == request_count) {
+      std::cout << "Received analytics from server:" << std::endl;
+      client.display_recv_buffer();
+    }
+    client.release_connection(pool);
+    if (!answered) {
+      return false;
+    }
+  }
+
+  const auto statistics = pool.get_statistics();
+  std::cout << "Connections opened: " << statistics.connections_opened
+            << ", reused: " << statistics.connections_reused
+            << ", discarded: " << statistics.connections_discarded
+            << std::endl;
+  return true;
+}
+
+// Asks the server for the analytics of every message it analyzed so far,
+// over a connection of its own.
+bool query_aggregate_analytics(const std::string &server_ip,
+                               const std::string &port,
+                               bool binary_analytics) {
+  WindowsSocketApp::Client client{"", 1024, server_ip, port};
+  client.set_binary_analytics(binary_analytics);
+  client.connect_to_server();
+  if (client.get_client_init_status() !=
+      WindowsSocketApp::Client_Initialization_Status::CONNECTED) {
+    std::cerr << "Failed to connect to server." << std::endl;
+    return false;
+  }
+  if (!client.send_aggregate_request() || !client.receive_response_frame()) {
+    return false;
+  }
+
+  std::cout << "Received server-wide analytics:" << std::endl;
+  client.display_recv_buffer();
+  client.shutdown_message_sending();
+  return true;
+}
+
+// One connection of run_async_requests(): connects, then sends its requests
+// one after the other, each once the previous response arrived.
+WindowsSocketApp::Task<void> run_async_connection(
+    WindowsSocketApp::AsyncClient &client, const std::string &message,
+    size_t request_count, size_t &answered_count) {
+  if (!co_await client.connect_to_server()) {
+    co_return;
+  }
+  for (size_t i = 0; i < request_count; ++i) {
+    if (!co_await client.request(message.data(), message.size())) {
+      co_return;
+    }
+    ++answered_count;
+  }
+  // Tells the server that no more requests follow
+  client.shutdown_message_sending();
+}
+
+// The requests spread over connection_count framed connections, all served
+// by one event loop on this thread, so every connection has a request in
+// flight at the same time.
+bool run_async_requests(const std::string &server_ip, const std::string &port,
+                        const std::string &message, size_t request_count,
+                        size_t connection_count, bool binary_analytics,
+                        uint16_t counters) {
+  connection_count = std::min(connection_count, request_count);
+  WindowsSocketApp::AsyncEventLoop loop;
+  std::vector<WindowsSocketApp::AsyncClient> clients;
+  // No reallocation: the tasks hold on to their clients
+  clients.reserve(connection_count);
+  size_t answered_count{0};
+
+  std::cout << "Sending " << request_count << " framed request(s) over "
+            << connection_count << " connection(s) from one thread: \""
+            << message << "\"" << std::endl;
+  for (size_t i = 0; i < connection_count; ++i) {
+    auto &client = clients.emplace_back(loop, server_ip, port);
+    client.set_binary_analytics(binary_analytics);
+    client.set_analytics_counters(counters);
+    // The first request_count % connection_count connections take one more
+    const size_t share = request_count / connection_count +
+                         (i < request_count % connection_count ? 1 : 0);
+    loop.spawn(run_async_connection(client, message, share, answered_count));
+  }
+  if (!loop.run()) {
+    return false;
+  }
+
+  std::cout << answered_count << " of " << request_count
+            << " request(s) answered" << std::endl;
+  return answered_count == request_count;
+}
 
-int main() {
+}  // namespace
+
+// Usage: Client [server ip] [port] [message] [requests] [options]
+// Options:
+//   --framed  send the requests as frames over one persistent connection
+//             instead of opening a connection per request
+//   --binary  framed, with the analytics returned in the binary encoding
+//   --pooled  framed, one Client per request sharing pooled connections
+//   --async   framed, from one thread over many connections at once
+//   --connections=N  connections used by --async (default 100)
+//   --batch=N  framed, the requests sent N messages per batch request
+//   --counters=LIST  framed, ask for these counter groups only, a comma
+//                    separated list of classes, words, lines, code-points,
+//                    histogram, unicode, top-words or all
+//   --aggregate  then ask for the server-wide analytics of every message
+//                the server analyzed, from all its clients
+// Without arguments the configuration is read interactively.
+int main(int argc, char *argv[]) {
   WSADATA wsaData;
   if (!WindowsSocketApp::initialize_winsock_2_0(wsaData)) {
     std::cerr << "Failed to initialize Winsock 2.0. Exiting from main()..."
@@ -8,74 +314,131 @@ int main() {
     return 1;
   }
 
+  // Options start with "--" and may carry "=value", everything else is
+  // positional
+  std::vector<std::string> arguments{};
+  std::vector<std::string> options{};
+  for (int i = 1; i < argc; ++i) {
+    std::string argument{argv[i]};
+    if (argument.rfind("--", 0) == 0) {
+      options.push_back(std::move(argument));
+    } else {
+      arguments.push_back(std::move(argument));
+    }
+  }
+  const auto has_option = [&options](const std::string &name) {
+    return std::find(options.begin(), options.end(), name) != options.end();
+  };
+  // Value of "--name=value", or empty
+  const auto option_value = [&options](const std::string &name) {
+    const std::string prefix{name + "="};
+    for (const auto &option : options) {
+      if (option.rfind(prefix, 0) == 0) {
+        return option.substr(prefix.size());
+      }
+    }
+    return std::string{};
+  };
+  const bool interactive{argc < 2};
+
   // Collect client configuration from user
   std::string server_ip;
   std::string port;
   std::string message;
 
-  std::cout << "Enter server IP address (default: localhost): ";
-  std::getline(std::cin, server_ip);
+  if (interactive) {
+    std::cout << "Enter server IP address (default: localhost): ";
+    std::getline(std::cin, server_ip);
+  } else if (!arguments.empty()) {
+    server_ip = arguments[0];
+  }
   if (server_ip.empty()) {
     server_ip = "localhost";
   }
 
-  std::cout << "Enter server port (default: 27015): ";
-  std::getline(std::cin, port);
+  if (interactive) {
+    std::cout << "Enter server port (default: 27015): ";
+    std::getline(std::cin, port);
+  } else if (arguments.size() > 1) {
+    port = arguments[1];
+  }
   if (port.empty()) {
     port = "27015";
   }
 
-  std::cout << "Enter message to send to server: ";
-  std::getline(std::cin, message);
+  if (interactive) {
+    std::cout << "Enter message to send to server: ";
+    std::getline(std::cin, message);
+  } else if (arguments.size() > 2) {
+    message = arguments[2];
+  }
   if (message.empty()) {
     message = "Hello from client!";
   }
 
-  // Create client
-  {  // Open scope for the Client object
-    WindowsSocketApp::Client client{message, 1024, server_ip, port};
-
-    std::cout << "Connecting to server at " << server_ip << ":" << port << "..."
-              << std::endl;
-
-    // Connect to server
-    client.connect_to_server();
-
-    if (client.get_client_init_status() ==
-        WindowsSocketApp::Client_Initialization_Status::CONNECTED) {
-      std::cout << "Connected to server successfully!" << std::endl;
-
-      // Send the message
-      std::cout << "Sending message: \"" << message << "\"" << std::endl;
-      client.send_buffer_to_server();
-
-      // Shutdown sending
-      std::cout << "Shutting down sending..." << std::endl;
-      client.shutdown_message_sending();
-
-      // Receive response
-      std::cout << "Waiting for server response..." << std::endl;
-      client.receive_server_message();
+  size_t request_count{1};
+  if (arguments.size() > 3) {
+    request_count =
+        std::max<size_t>(std::strtoul(arguments[3].c_str(), nullptr, 10), 1);
+  }
 
-      std::cout << "Received analytics from server:" << std::endl;
-      client.display_recv_buffer();
+  const auto started = std::chrono::steady_clock::now();
+  const bool binary_analytics{has_option("--binary")};
+  uint16_t counters{0};
+  if (!parse_counters(option_value("--counters"), counters)) {
+    WSACleanup();
+    return 1;
+  }
+  bool completed{false};
+  if (has_option("--async")) {
+    const std::string connections{option_value("--connections")};
+    const size_t connection_count =
+        connections.empty()
+            ? default_async_connection_count
+            : std::max<size_t>(
+                  std::strtoul(connections.c_str(), nullptr, 10), 1);
+    completed = run_async_requests(server_ip, port, message, request_count,
+                                   connection_count, binary_analytics,
+                                   counters);
+  } else if (!option_value("--batch").empty()) {
+    const size_t batch_size = std::max<size_t>(
+        std::strtoul(option_value("--batch").c_str(), nullptr, 10), 1);
+    completed = run_batched_requests(server_ip, port, message, request_count,
+                                     batch_size, binary_analytics, counters);
+  } else if (has_option("--pooled")) {
+    completed = run_pooled_requests(server_ip, port, message, request_count,
+                                    binary_analytics, counters);
+  } else if (has_option("--framed") || binary_analytics || counters != 0) {
+    completed = run_framed_requests(server_ip, port, message, request_count,
+                                    binary_analytics, counters);
+  } else {
+    completed = run_legacy_requests(server_ip, port, message, request_count);
+  }
+  const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - started);
+  if (completed && has_option("--aggregate")) {
+    completed = query_aggregate_analytics(server_ip, port, binary_analytics);
+  }
 
-      std::cout << "Communication completed successfully!" << std::endl;
-    } else {
-      std::cerr << "Failed to connect to server." << std::endl;
+  if (completed) {
+    std::cout << "Communication completed successfully!" << std::endl;
+    if (request_count > 1) {
+      std::cout << request_count << " requests in " << elapsed.count()
+                << " us" << std::endl;
     }
+  }
 
-    std::cout << "Client shutting down..." << std::endl;
-
-  }  // Client destructor automatically called to clean up the resources.
+  std::cout << "Client shutting down..." << std::endl;
 
   // Cleanup Winsock
   WSACleanup();
   std::cout << "Client shutdown completed." << std::endl;
 
-  // Keep the window open
-  std::cout << "\nPress Enter to exit...";
-  std::cin.get();
+  if (interactive) {
+    // Keep the window open
+    std::cout << "\nPress Enter to exit...";
+    std::cin.get();
+  }
 
-  return 0;
+  return completed ? 0 : 1;
 }
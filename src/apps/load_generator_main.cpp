@@ -0,0 +1,180 @@
+#include <algorithm>
+#include <iomanip>
+
+#include "../include/LoadGenerator.h"
+
+namespace {
+
+void print_report(const WindowsSocketApp::Load_Generator_Config &config,
+                  const WindowsSocketApp::Load_Report &report) {
+  const double seconds =
+      std::chrono::duration<double>(report.elapsed).count();
+  const auto &latencies = report.latencies;
+  const auto microseconds = [](uint64_t nanoseconds) {
+    return static_cast<double>(nanoseconds) / 1000.0;
+  };
+
+  std::cout << std::fixed << std::setprecision(1);
+  std::cout << "\nRequests: " << report.completed_requests << " in "
+            << seconds << " s" << std::endl;
+  std::cout << "Throughput: "
+            << static_cast<double>(report.completed_requests) / seconds
+            << " requests/s, "
+            << static_cast<double>(report.request_bytes) / seconds / 1e6
+            << " MB/s of messages";
+  if (config.mode == WindowsSocketApp::Load_Mode::OPEN_LOOP) {
+    std::cout << " (target " << config.request_rate << " requests/s)";
+  }
+  std::cout << std::endl;
+  std::cout << "Latency (us): min "
+            << microseconds(latencies.get_minimum_value()) << ", p50 "
+            << microseconds(latencies.get_value_at_percentile(50))
+            << ", p90 " << microseconds(latencies.get_value_at_percentile(90))
+            << ", p99 " << microseconds(latencies.get_value_at_percentile(99))
+            << ", p99.9 "
+            << microseconds(latencies.get_value_at_percentile(99.9))
+            << ", max " << microseconds(latencies.get_maximum_value())
+            << ", mean " << latencies.get_mean_value() / 1000.0 << std::endl;
+  if (report.failed_connections > 0 || report.mismatched_responses > 0) {
+    std::cout << "Failed connections: " << report.failed_connections
+              << ", mismatched responses: " << report.mismatched_responses
+              << std::endl;
+  }
+}
+
+void print_usage() {
+  std::cout
+      << "Usage: LoadGenerator [server ip] [port] [options]\n"
+         "Options:\n"
+         "  --threads=N      client threads (default 1)\n"
+         "  --connections=M  framed connections, spread over the threads\n"
+         "                   (default: one per thread)\n"
+         "  --duration=S     seconds to run (default 10)\n"
+         "  --rate=R         open loop at R requests/s in total; without it\n"
+         "                   every connection sends its next request when\n"
+         "                   the previous response arrived (closed loop)\n"
+         "  --sizes=SPEC     message sizes: fixed:N, uniform:MIN:MAX or\n"
+         "                   exponential:MEAN[:MAX] (default fixed:64)\n"
+         "  --text           ask for text analytics instead of the binary\n"
+         "                   encoding; responses are then not checked\n"
+         "  --help           print this message\n"
+         "Exits with 1 when a connection failed or a response did not "
+         "match.\n";
+}
+
+}  // namespace
+
+// Usage: LoadGenerator [server ip] [port] [options]
+// Options:
+//   --threads=N      client threads (default 1)
+//   --connections=M  framed connections, spread over the threads (default:
+//                    one per thread)
+//   --duration=S     seconds to run (default 10)
+//   --rate=R         open loop at R requests/s in total; without it every
+//                    connection sends its next request when the previous
+//                    response arrived (closed loop)
+//   --sizes=SPEC     message sizes: fixed:N, uniform:MIN:MAX or
+//                    exponential:MEAN[:MAX] (default fixed:64)
+//   --text           ask for text analytics instead of the binary encoding;
+//                    responses are then not checked
+//   --help           print the usage and exit
+// Exits with 1 when a connection failed or a response did not match.
+int main(int argc, char *argv[]) {
+  for (int i = 1; i < argc; ++i) {
+    const std::string argument{argv[i]};
+    if (argument == "--help" || argument == "-h") {
+      print_usage();
+      return 0;
+    }
+  }
+
+  WSADATA wsaData;
+  if (!WindowsSocketApp::initialize_winsock_2_0(wsaData)) {
+    std::cerr << "Failed to initialize Winsock 2.0. Exiting from main()..."
+              << std::endl;
+    return 1;
+  }
+
+  // Options start with "--" and may carry "=value", everything else is
+  // positional
+  std::vector<std::string> arguments{};
+  std::vector<std::string> options{};
+  for (int i = 1; i < argc; ++i) {
+    std::string argument{argv[i]};
+    if (argument.rfind("--", 0) == 0) {
+      options.push_back(std::move(argument));
+    } else {
+      arguments.push_back(std::move(argument));
+    }
+  }
+  const auto has_option = [&options](const std::string &name) {
+    return std::find(options.begin(), options.end(), name) != options.end();
+  };
+  const auto get_option_value = [&options](const std::string &name) {
+    const std::string prefix{name + "="};
+    for (const auto &option : options) {
+      if (option.rfind(prefix, 0) == 0) {
+        return option.substr(prefix.size());
+      }
+    }
+    return std::string{};
+  };
+
+  WindowsSocketApp::Load_Generator_Config config{};
+  if (!arguments.empty()) {
+    config.server_ip = arguments[0];
+  }
+  if (arguments.size() > 1) {
+    config.port = arguments[1];
+  }
+  const std::string threads{get_option_value("--threads")};
+  if (!threads.empty()) {
+    config.thread_count = std::strtoul(threads.c_str(), nullptr, 10);
+  }
+  const std::string connections{get_option_value("--connections")};
+  config.connection_count =
+      connections.empty() ? config.thread_count
+                          : std::strtoul(connections.c_str(), nullptr, 10);
+  const std::string duration{get_option_value("--duration")};
+  if (!duration.empty()) {
+    config.duration = std::chrono::milliseconds{static_cast<long long>(
+        std::strtod(duration.c_str(), nullptr) * 1000.0)};
+  }
+  const std::string rate{get_option_value("--rate")};
+  if (!rate.empty()) {
+    config.mode = WindowsSocketApp::Load_Mode::OPEN_LOOP;
+    config.request_rate = std::strtod(rate.c_str(), nullptr);
+  }
+  const std::string sizes{get_option_value("--sizes")};
+  if (!sizes.empty() &&
+      !WindowsSocketApp::Message_Size_Spec::parse(sizes,
+                                                  config.message_sizes)) {
+    std::cerr << "Invalid message size specification: " << sizes
+              << std::endl;
+    WSACleanup();
+    return 1;
+  }
+  config.binary_analytics = !has_option("--text");
+
+  WindowsSocketApp::LoadGenerator load_generator{config};
+  const auto &effective_config = load_generator.get_config();
+  std::cout << "Load against " << effective_config.server_ip << ":"
+            << effective_config.port << ": "
+            << (effective_config.mode ==
+                        WindowsSocketApp::Load_Mode::OPEN_LOOP
+                    ? "open"
+                    : "closed")
+            << " loop, " << effective_config.thread_count << " thread(s), "
+            << effective_config.connection_count << " connection(s), "
+            << std::chrono::duration<double>(effective_config.duration).count()
+            << " s" << std::endl;
+
+  const WindowsSocketApp::Load_Report report = load_generator.run();
+  print_report(effective_config, report);
+
+  WSACleanup();
+  const bool clean_run{report.completed_requests > 0 &&
+                       report.failed_connections == 0 &&
+                       report.mismatched_responses == 0};
+  return clean_run ? 0 : 1;
+}
@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../include/AnalyticsEncoding.h"
+#include "../include/AnalyticsLog.h"
+
+namespace {
+
+void print_time(uint64_t timestamp_nanoseconds) {
+  const std::time_t seconds =
+      static_cast<std::time_t>(timestamp_nanoseconds / 1000000000U);
+  std::tm time{};
+#ifdef _WIN32
+  gmtime_s(&time, &seconds);
+#else
+  gmtime_r(&seconds, &time);
+#endif
+  std::cout << std::put_time(&time, "%Y-%m-%d %H:%M:%S") << '.'
+            << std::setw(3) << std::setfill('0')
+            << timestamp_nanoseconds / 1000000U % 1000U << std::setfill(' ')
+            << " UTC";
+}
+
+void print_csv(const WindowsSocketApp::Analytics_Log_Record *records,
+               uint64_t count) {
+  std::cout << "timestamp_ns,message_size,counters,length,punctuation_marks,"
+               "spaces,digits,uppercase,lowercase,vowels,consonants,words,"
+               "lines,code_points\n";
+  for (uint64_t i = 0; i < count; ++i) {
+    const auto &record = records[i];
+    if (record.timestamp_nanoseconds == 0) {
+      continue;
+    }
+    std::cout << record.timestamp_nanoseconds << ',' << record.message_size
+              << ',' << record.counters;
+    for (const uint64_t count_of_class : record.classes) {
+      std::cout << ',' << count_of_class;
+    }
+    std::cout << ',' << record.words_count << ',' << record.lines_count << ','
+              << record.code_points_count << '\n';
+  }
+  std::cout << std::flush;
+}
+
+}  // namespace
+
+// Usage: AnalyticsLogReader <log file> [options]
+// Reads a log written by Server --analytics-log, also while the server is
+// still writing it, up to the records it committed.
+// Options:
+//   --csv        print every record instead of the totals
+//   --repeat=N   scan the records N times, to measure the scan rate
+int main(int argc, char *argv[]) {
+  // Options start with "--", everything else is positional
+  std::vector<std::string> arguments{};
+  std::vector<std::string> options{};
+  for (int i = 1; i < argc; ++i) {
+    std::string argument{argv[i]};
+    if (argument.rfind("--", 0) == 0) {
+      options.push_back(std::move(argument));
+    } else {
+      arguments.push_back(std::move(argument));
+    }
+  }
+  const auto has_option = [&options](const std::string &name) {
+    return std::find(options.begin(), options.end(), name) != options.end();
+  };
+  const auto get_option_value = [&options](const std::string &name) {
+    const std::string prefix{name + "="};
+    for (const auto &option : options) {
+      if (option.rfind(prefix, 0) == 0) {
+        return option.substr(prefix.size());
+      }
+    }
+    return std::string{};
+  };
+
+  if (arguments.empty()) {
+    std::cerr << "Usage: AnalyticsLogReader <log file> [--csv] [--repeat=N]"
+              << std::endl;
+    return 1;
+  }
+  WindowsSocketApp::AnalyticsLogReader reader;
+  if (!reader.open(arguments[0])) {
+    return 1;
+  }
+  const WindowsSocketApp::Analytics_Log_Record *records =
+      reader.get_records();
+  const uint64_t count = reader.get_committed_slots();
+
+  if (has_option("--csv")) {
+    print_csv(records, count);
+    return 0;
+  }
+
+  size_t repeat_count{1};
+  const std::string repeat{get_option_value("--repeat")};
+  if (!repeat.empty()) {
+    repeat_count = std::max<size_t>(
+        1, std::strtoul(repeat.c_str(), nullptr, 10));
+  }
+  WindowsSocketApp::Analytics_Log_Summary summary;
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < repeat_count; ++i) {
+    summary = WindowsSocketApp::summarize_analytics_log(records, count);
+  }
+  const double seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count() /
+                         static_cast<double>(repeat_count);
+
+  std::cout << "Slots: " << summary.slots_count << " committed, "
+            << summary.empty_slots_count << " empty" << std::endl;
+  if (summary.analytics.messages_count > 0) {
+    std::cout << "Records from ";
+    print_time(summary.first_timestamp_nanoseconds);
+    std::cout << " to ";
+    print_time(summary.last_timestamp_nanoseconds);
+    std::cout << std::endl;
+  }
+  std::string totals;
+  WindowsSocketApp::append_aggregate_analytics_text(summary.analytics, totals);
+  std::cout << totals << std::endl;
+  std::cout << "Words: " << summary.words_count
+            << ", lines: " << summary.lines_count
+            << ", code points: " << summary.code_points_count << std::endl;
+
+  const double megabytes =
+      static_cast<double>(count *
+                          sizeof(WindowsSocketApp::Analytics_Log_Record)) /
+      1e6;
+  std::cout << std::fixed << std::setprecision(2) << "Scanned " << megabytes
+            << " MB in " << seconds * 1000.0 << " ms";
+  if (seconds > 0.0) {
+    std::cout << " (" << megabytes / 1000.0 / seconds << " GB/s)";
+  }
+  std::cout << std::endl;
+  return 0;
+}
@@ -1,6 +1,93 @@
+#include <algorithm>
+
+#include "../include/AnalyticsCache.h"
+#include "../include/AnalyticsLog.h"
+#include "../include/FlowControl.h"
 #include "../include/Server.h"
+#include "../include/StatsReporter.h"
+#include "../include/TopWords.h"
+
+namespace {
+
+void serve_single_client(WindowsSocketApp::Server &server) {
+  // Accept client connection
+  server.accept_connections();
+
+  if (server.get_server_init_status() !=
+      WindowsSocketApp::Server_Initialization_Status::
+          CLIENT_CONNECTION_HANDLED) {
+    std::cerr << "Failed to accept client connection." << std::endl;
+    return;
+  }
+  std::cout << "Client connected successfully!" << std::endl;
+
+  if (server.detect_client_wire_format() ==
+      WindowsSocketApp::Wire_Format::FRAMED) {
+    // Requests and responses flow until the client closes the connection
+    std::cout << "Serving framed requests..." << std::endl;
+    server.serve_framed_client();
+    std::cout << "Framed session completed." << std::endl;
+    return;
+  }
+
+  // Receive the message from a client
+  std::cout << "Waiting for client message..." << std::endl;
+  server.receive_client_message();
+
+  std::cout << "Received message from client:" << std::endl;
+  server.display_recv_buffer();
+
+  // Calculate analytics
+  std::cout << "Calculating message analytics..." << std::endl;
+  server.calculate_recv_message_analytics();
+
+  // Send analytics back to a client
+  if (server.get_echo_message() &&
+      server.get_receive_mode() ==
+          WindowsSocketApp::Session_Receive_Mode::BUFFERED) {
+    std::cout << "Sending message and analytics to client..." << std::endl;
+    server.send_echo_and_analytics_to_client();
+  } else {
+    std::cout << "Sending analytics to client..." << std::endl;
+    server.send_recv_message_analytics_to_client();
+  }
+
+  // Shutdown sending
+  std::cout << "Shutting down sending..." << std::endl;
+  server.shutdown_message_sending();
 
-int main() {
+  std::cout << "Message processing completed successfully!" << std::endl;
+}
+
+}  // namespace
+
+// Usage: Server [port] [mode] [worker threads] [options]
+// The worker thread count is the number of shards in sharded mode.
+// Options:
+//   --stream    analyze messages while they are received, in constant memory
+//   --echo      send legacy messages back ahead of their analytics
+//   --zerocopy  send large echoed messages with MSG_ZEROCOPY (Linux)
+//   --stats-port=N  serve the server metrics as text on 127.0.0.1:N
+//   --pin       sharded mode: pin every shard thread to its own CPU
+//   --cache=MB  reuse the replies to repeated messages, in up to MB megabytes
+//   --top-words-window=S  window of the traffic top words, in seconds
+// Analytics log (see AnalyticsLog.h, POSIX only):
+//   --analytics-log=PATH        append the analytics of every reply to PATH
+//   --analytics-log-size=MB     size of a new log file
+//   --analytics-log-sync=MS     interval between commits to disk
+// Flow control (see FlowControl.h):
+//   --max-connection-output=KB  unsent replies before a connection's reads
+//                               pause
+//   --max-pending-replies=N     same, in replies
+//   --max-total-output=MB       same, over all connections
+//   --max-message=MB            largest message received into a buffer,
+//                               and largest batch request
+//   --max-batch=N               messages in one batch request
+//   --max-pending-sessions=N    pool mode: sessions queued for a worker
+//   --slow-reader-timeout=MS    close clients that stop reading (0: never)
+// On POSIX, SIGUSR1 prints the server metrics to standard output.
+// Without arguments the configuration is read interactively.
+int main(int argc, char *argv[]) {
   // Initialize Winsock
   WSADATA wsaData;
   if (!WindowsSocketApp::initialize_winsock_2_0(wsaData)) {
@@ -9,17 +96,142 @@ int main() {
     return 1;
   }
 
+  // Options start with "--", everything else is positional
+  std::vector<std::string> arguments{};
+  std::vector<std::string> options{};
+  for (int i = 1; i < argc; ++i) {
+    std::string argument{argv[i]};
+    if (argument.rfind("--", 0) == 0) {
+      options.push_back(std::move(argument));
+    } else {
+      arguments.push_back(std::move(argument));
+    }
+  }
+  const auto has_option = [&options](const std::string &name) {
+    return std::find(options.begin(), options.end(), name) != options.end();
+  };
+  const auto get_option_value = [&options](const std::string &name) {
+    const std::string prefix{name + "="};
+    for (const auto &option : options) {
+      if (option.rfind(prefix, 0) == 0) {
+        return option.substr(prefix.size());
+      }
+    }
+    return std::string{};
+  };
+  const bool interactive{argc < 2};
+
   // Collect server configuration from the user
   std::string port{};
-  std::cout << "Enter server port number (default: 27015): ";
-  std::getline(std::cin, port);
+  if (interactive) {
+    std::cout << "Enter server port number (default: 27015): ";
+    std::getline(std::cin, port);
+  } else if (!arguments.empty()) {
+    port = arguments[0];
+  }
   if (port.empty()) {
     port = "27015";
   }
+
+  std::string mode{};
+  if (interactive) {
+#ifdef __linux__
+    std::cout << "Enter server mode [single|pool|epoll|uring|sharded] "
+                 "(default: single): ";
+#else
+    std::cout << "Enter server mode [single|pool] (default: single): ";
+#endif
+    std::getline(std::cin, mode);
+  } else if (arguments.size() > 1) {
+    mode = arguments[1];
+  }
+  if (mode.empty()) {
+    mode = "single";
+  }
+
+  // 0 selects one worker thread per hardware thread
+  size_t worker_count{0};
+  if (arguments.size() > 2) {
+    worker_count = std::strtoul(arguments[2].c_str(), nullptr, 10);
+  }
+
+  const std::string cache_megabytes{get_option_value("--cache")};
+  if (!cache_megabytes.empty()) {
+    WindowsSocketApp::get_analytics_cache().set_capacity_bytes(
+        std::strtoul(cache_megabytes.c_str(), nullptr, 10) * 1024 * 1024);
+  }
+  const std::string top_words_window{get_option_value("--top-words-window")};
+  if (!top_words_window.empty()) {
+    WindowsSocketApp::get_traffic_words().set_window(std::chrono::seconds{
+        std::strtoul(top_words_window.c_str(), nullptr, 10)});
+  }
+
+  WindowsSocketApp::Flow_Control_Limits limits =
+      WindowsSocketApp::get_flow_control().get_limits();
+  const auto read_limit = [&get_option_value](const std::string &name,
+                                              size_t &limit, size_t unit) {
+    const std::string value{get_option_value(name)};
+    if (!value.empty()) {
+      limit = std::strtoul(value.c_str(), nullptr, 10) * unit;
+    }
+  };
+  read_limit("--max-connection-output", limits.max_connection_output_bytes,
+             1024);
+  read_limit("--max-pending-replies", limits.max_connection_pending_replies,
+             1);
+  read_limit("--max-total-output", limits.max_total_output_bytes,
+             1024 * 1024);
+  read_limit("--max-message", limits.max_buffered_message_bytes, 1024 * 1024);
+  read_limit("--max-batch", limits.max_batch_messages, 1);
+  read_limit("--max-pending-sessions", limits.max_pending_sessions, 1);
+  const std::string slow_reader_timeout{
+      get_option_value("--slow-reader-timeout")};
+  if (!slow_reader_timeout.empty()) {
+    limits.slow_reader_timeout = std::chrono::milliseconds{
+        std::strtoul(slow_reader_timeout.c_str(), nullptr, 10)};
+  }
+  WindowsSocketApp::get_flow_control().set_limits(limits);
+
+  // Metrics stay readable while the server runs, from outside the process
+  WindowsSocketApp::StatsReporter stats_reporter;
+  stats_reporter.install_dump_signal();
+  const std::string stats_port{get_option_value("--stats-port")};
+  if (!stats_port.empty()) {
+    stats_reporter.start_stats_port(stats_port);
+  }
+
+  // Records of the last sync interval are lost when the process is killed
+  const std::string analytics_log{get_option_value("--analytics-log")};
+  if (!analytics_log.empty()) {
+    uint64_t capacity{WindowsSocketApp::AnalyticsLog::default_capacity};
+    const std::string log_megabytes{get_option_value("--analytics-log-size")};
+    if (!log_megabytes.empty()) {
+      capacity = std::strtoull(log_megabytes.c_str(), nullptr, 10) * 1024 *
+                 1024 / sizeof(WindowsSocketApp::Analytics_Log_Record);
+    }
+    std::chrono::milliseconds sync_interval{
+        WindowsSocketApp::AnalyticsLog::default_sync_interval};
+    const std::string log_sync{get_option_value("--analytics-log-sync")};
+    if (!log_sync.empty()) {
+      sync_interval = std::chrono::milliseconds{
+          std::strtoul(log_sync.c_str(), nullptr, 10)};
+    }
+    WindowsSocketApp::get_analytics_log().open(analytics_log, capacity,
+                                               sync_interval);
+  }
+
   {  // Open scope for the Server object
     // Create and start server
     WindowsSocketApp::Server new_server{1024, port};
     std::cout << "\nStarting server on port " << port << "..." << std::endl;
+    if (has_option("--stream")) {
+      new_server.set_receive_mode(
+          WindowsSocketApp::Session_Receive_Mode::STREAMING);
+    }
+    new_server.set_echo_message(has_option("--echo"));
+    new_server.set_zero_copy_send(has_option("--zerocopy"));
+    // Every shard binds a listener of its own to the port
+    new_server.set_reuse_port(mode == "sharded");
     new_server.start_server();
 
     if (new_server.get_server_init_status() ==
@@ -28,36 +240,24 @@ int main() {
       std::cout << "Server is ready. Waiting for client connections..."
                 << std::endl;
 
-      // Accept client connection
-      new_server.accept_connections();
-
-      if (new_server.get_server_init_status() ==
-          WindowsSocketApp::Server_Initialization_Status::
-              CLIENT_CONNECTION_HANDLED) {
-        std::cout << "Client connected successfully!" << std::endl;
-
-        // Receive the message from a client
-        std::cout << "Waiting for client message..." << std::endl;
-        new_server.receive_client_message();
-
-        std::cout << "Received message from client:" << std::endl;
-        new_server.display_recv_buffer();
-
-        // Calculate analytics
-        std::cout << "Calculating message analytics..." << std::endl;
-        new_server.calculate_recv_message_analytics();
-
-        // Send analytics back to a client
-        std::cout << "Sending analytics to client..." << std::endl;
-        new_server.send_recv_message_analytics_to_client();
-
-        // Shutdown sending
-        std::cout << "Shutting down sending..." << std::endl;
-        new_server.shutdown_message_sending();
-
-        std::cout << "Message processing completed successfully!" << std::endl;
+      if (mode == "single") {
+        serve_single_client(new_server);
+      } else if (mode == "pool") {
+        // Serve clients until the process is terminated
+        new_server.serve_with_worker_pool(worker_count);
+#ifdef __linux__
+      } else if (mode == "epoll") {
+        // Serve clients until the process is terminated
+        new_server.run_event_loop();
+      } else if (mode == "uring") {
+        // Serve clients until the process is terminated
+        new_server.run_io_uring_loop();
+      } else if (mode == "sharded") {
+        // Serve clients until the process is terminated
+        new_server.run_sharded_event_loops(worker_count, has_option("--pin"));
+#endif
       } else {
-        std::cerr << "Failed to accept client connection." << std::endl;
+        std::cerr << "Unknown server mode: " << mode << std::endl;
       }
     } else {
       std::cerr << "Failed to start server." << std::endl;
@@ -65,15 +265,19 @@ int main() {
 
     std::cout << "Server is shutting down..." << std::endl;
 
-  } // Server destructor automatically called to clean up the resources.
+  }  // Server destructor automatically called to clean up the resources.
 
   // Cleanup Winsock
+  stats_reporter.stop();
+  WindowsSocketApp::get_analytics_log().close();
   WSACleanup();
   std::cout << "Server shutdown completed." << std::endl;
 
-  // Keep the window open
-  std::cout << "\nPress Enter to exit...";
-  std::cin.get();
+  if (interactive) {
+    // Keep the window open
+    std::cout << "\nPress Enter to exit...";
+    std::cin.get();
+  }
 
   return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,86 @@
+#include "../include/AddressCache.h"
+
+#include "../include/WinSockFunctions.h"
+
+namespace WindowsSocketApp {
+
+AddressCache::AddressCache(
+    std::chrono::steady_clock::duration time_to_live_val)
+    : time_to_live_{time_to_live_val} {}
+
+std::string AddressCache::make_key(const std::string &host,
+                                   const std::string &port,
+                                   const addrinfo &hints) {
+  std::string key{host};
+  key += '|';
+  key += port;
+  for (const int hint : {hints.ai_family, hints.ai_socktype,
+                         hints.ai_protocol, hints.ai_flags}) {
+    key += '|';
+    key += std::to_string(hint);
+  }
+  return key;
+}
+
+Resolved_Addresses AddressCache::resolve(const std::string &host,
+                                         const std::string &port,
+                                         const addrinfo &hints) {
+  const std::string key = make_key(host, port, hints);
+  const auto now = std::chrono::steady_clock::now();
+  {
+    std::lock_guard<std::mutex> lock{entries_mutex_};
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+      if (now < it->second.expires_at) {
+        return it->second.addresses;
+      }
+      entries_.erase(it);
+    }
+  }
+
+  // Resolved without the lock, so a slow lookup does not hold up others
+  AddrInfoPtr result{nullptr};
+  if (!resolve_address_and_port(host.c_str(), port.c_str(), &hints, result) ||
+      !result) {
+    return nullptr;
+  }
+  Resolved_Addresses addresses{result.release(), AddrInfoDeleter{}};
+
+  std::lock_guard<std::mutex> lock{entries_mutex_};
+  entries_[key] = Cache_Entry{addresses, now + time_to_live_};
+  return addresses;
+}
+
+void AddressCache::invalidate(const std::string &host, const std::string &port,
+                              const addrinfo &hints) {
+  std::lock_guard<std::mutex> lock{entries_mutex_};
+  entries_.erase(make_key(host, port, hints));
+}
+
+void AddressCache::clear() {
+  std::lock_guard<std::mutex> lock{entries_mutex_};
+  entries_.clear();
+}
+
+size_t AddressCache::size() const {
+  std::lock_guard<std::mutex> lock{entries_mutex_};
+  return entries_.size();
+}
+
+std::chrono::steady_clock::duration AddressCache::get_time_to_live() const {
+  std::lock_guard<std::mutex> lock{entries_mutex_};
+  return time_to_live_;
+}
+
+void AddressCache::set_time_to_live(
+    std::chrono::steady_clock::duration time_to_live) {
+  std::lock_guard<std::mutex> lock{entries_mutex_};
+  this->time_to_live_ = time_to_live;
+}
+
+AddressCache &get_address_cache() {
+  static AddressCache address_cache;
+  return address_cache;
+}
+
+}  // namespace WindowsSocketApp
@@ -0,0 +1,253 @@
+#include "../include/AnalyticsCache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+
+#include "../include/ServerMetrics.h"
+
+namespace WindowsSocketApp {
+
+namespace {
+
+constexpr uint64_t prime_1{0x9E3779B185EBCA87ULL};
+constexpr uint64_t prime_2{0xC2B2AE3D27D4EB4FULL};
+constexpr uint64_t prime_3{0x165667B19E3779F9ULL};
+constexpr uint64_t prime_4{0x85EBCA77C2B2AE63ULL};
+constexpr uint64_t prime_5{0x27D4EB2F165667C5ULL};
+
+// Bytes charged per entry besides its text: the list node, the index node
+// and its bucket
+constexpr size_t entry_overhead{96};
+
+uint64_t rotate_left(uint64_t value, unsigned bits) {
+  return (value << bits) | (value >> (64U - bits));
+}
+
+uint64_t read_64(const char *data) {
+  uint64_t value;
+  std::memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+uint32_t read_32(const char *data) {
+  uint32_t value;
+  std::memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+uint64_t hash_round(uint64_t accumulator, uint64_t input) {
+  accumulator += input * prime_2;
+  accumulator = rotate_left(accumulator, 31);
+  return accumulator * prime_1;
+}
+
+uint64_t merge_round(uint64_t hash, uint64_t accumulator) {
+  hash ^= hash_round(0, accumulator);
+  return hash * prime_1 + prime_4;
+}
+
+uint64_t get_cache_hash_seed() {
+  static const uint64_t seed = [] {
+    std::random_device device;
+    return (static_cast<uint64_t>(device()) << 32U) ^ device();
+  }();
+  return seed;
+}
+
+}  // namespace
+
+uint64_t hash_message_bytes(const char *data, size_t size, uint64_t seed) {
+  const char *const end = data + size;
+  uint64_t hash{0};
+
+  if (size >= 32) {
+    // Four independent lanes, so the multiplies overlap
+    uint64_t lanes[4]{seed + prime_1 + prime_2, seed + prime_2, seed,
+                      seed - prime_1};
+    const char *const last_stripe = end - 32;
+    do {
+      for (int i = 0; i < 4; ++i) {
+        lanes[i] = hash_round(lanes[i], read_64(data + 8 * i));
+      }
+      data += 32;
+    } while (data <= last_stripe);
+    hash = rotate_left(lanes[0], 1) + rotate_left(lanes[1], 7) +
+           rotate_left(lanes[2], 12) + rotate_left(lanes[3], 18);
+    for (const uint64_t lane : lanes) {
+      hash = merge_round(hash, lane);
+    }
+  } else {
+    hash = seed + prime_5;
+  }
+  hash += static_cast<uint64_t>(size);
+
+  for (; data + 8 <= end; data += 8) {
+    hash ^= hash_round(0, read_64(data));
+    hash = rotate_left(hash, 27) * prime_1 + prime_4;
+  }
+  if (data + 4 <= end) {
+    hash ^= static_cast<uint64_t>(read_32(data)) * prime_1;
+    hash = rotate_left(hash, 23) * prime_2 + prime_3;
+    data += 4;
+  }
+  for (; data < end; ++data) {
+    hash ^= static_cast<uint64_t>(static_cast<unsigned char>(*data)) * prime_5;
+    hash = rotate_left(hash, 11) * prime_1;
+  }
+
+  hash ^= hash >> 33U;
+  hash *= prime_2;
+  hash ^= hash >> 29U;
+  hash *= prime_3;
+  hash ^= hash >> 32U;
+  return hash;
+}
+
+Analytics_Cache_Key make_analytics_cache_key(const char *data, size_t size) {
+  return Analytics_Cache_Key{
+      hash_message_bytes(data, size, get_cache_hash_seed()), data, size};
+}
+
+AnalyticsCache::AnalyticsCache(size_t capacity_bytes_val,
+                               size_t shard_count_val)
+    : shards_{std::make_unique<Cache_Shard[]>(std::max<size_t>(
+          shard_count_val, 1))},
+      shard_count_{std::max<size_t>(shard_count_val, 1)},
+      capacity_bytes_{0},
+      max_message_size_{default_max_message_size} {
+  set_capacity_bytes(capacity_bytes_val);
+}
+
+AnalyticsCache::Cache_Shard &AnalyticsCache::shard_for(
+    const Analytics_Cache_Key &key) const {
+  // The index buckets use the low bits of the hash
+  return shards_[(key.hash >> 32U) % shard_count_];
+}
+
+size_t AnalyticsCache::entry_size(const Cache_Entry &entry) {
+  return sizeof(Cache_Entry) + entry.message.capacity() +
+         entry.text.capacity() + entry_overhead;
+}
+
+void AnalyticsCache::evict_to_capacity(Cache_Shard &shard) {
+  while (shard.size_bytes > shard.capacity_bytes && !shard.entries.empty()) {
+    const Cache_Entry &oldest = shard.entries.back();
+    shard.size_bytes -= entry_size(oldest);
+    shard.index.erase(oldest.key);
+    shard.entries.pop_back();
+  }
+}
+
+bool AnalyticsCache::accepts(size_t message_size) const {
+  return capacity_bytes_.load(std::memory_order_relaxed) > 0 &&
+         message_size <= max_message_size_.load(std::memory_order_relaxed);
+}
+
+size_t AnalyticsCache::find(const Analytics_Cache_Key &key, bool binary,
+                            Analytics_Text_Buffer &output,
+                            MessageAnalytics &analytics) {
+  Cache_Shard &shard = shard_for(key);
+  size_t reply_size{0};
+  {
+    std::lock_guard<std::mutex> lock{shard.mutex};
+    auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+      shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+      const Cache_Entry &entry = *it->second;
+      analytics = entry.analytics;
+      if (binary) {
+        std::memcpy(output.data(), entry.binary.data(), entry.binary.size());
+        reply_size = entry.binary.size();
+      } else {
+        std::memcpy(output.data(), entry.text.data(), entry.text.size());
+        reply_size = entry.text.size();
+      }
+    }
+  }
+  Thread_Metrics &metrics = get_server_metrics().local();
+  if (reply_size > 0) {
+    metrics.count_cache_hit();
+  } else {
+    metrics.count_cache_miss();
+  }
+  return reply_size;
+}
+
+void AnalyticsCache::insert(const Analytics_Cache_Key &key,
+                            const MessageAnalytics &analytics) {
+  // Copied and encoded before the lock is taken
+  Cache_Entry entry{key, std::string(key.data, key.length), analytics, {}, {}};
+  Analytics_Text_Buffer text;
+  entry.text.assign(text.data(), write_message_analytics_text(analytics, text));
+  encode_message_analytics_binary(analytics, entry.binary.data());
+  const size_t size_bytes = entry_size(entry);
+
+  Cache_Shard &shard = shard_for(key);
+  std::lock_guard<std::mutex> lock{shard.mutex};
+  if (size_bytes > shard.capacity_bytes || shard.index.count(key) > 0) {
+    return;
+  }
+  shard.entries.push_front(std::move(entry));
+  // The message moved with the entry, which stays at this node from now on
+  Cache_Entry &stored = shard.entries.front();
+  stored.key.data = stored.message.data();
+  shard.index.emplace(stored.key, shard.entries.begin());
+  shard.size_bytes += size_bytes;
+  evict_to_capacity(shard);
+}
+
+void AnalyticsCache::clear() {
+  for (size_t i = 0; i < shard_count_; ++i) {
+    std::lock_guard<std::mutex> lock{shards_[i].mutex};
+    shards_[i].index.clear();
+    shards_[i].entries.clear();
+    shards_[i].size_bytes = 0;
+  }
+}
+
+size_t AnalyticsCache::size() const {
+  size_t entry_count{0};
+  for (size_t i = 0; i < shard_count_; ++i) {
+    std::lock_guard<std::mutex> lock{shards_[i].mutex};
+    entry_count += shards_[i].index.size();
+  }
+  return entry_count;
+}
+
+size_t AnalyticsCache::get_size_bytes() const {
+  size_t size_bytes{0};
+  for (size_t i = 0; i < shard_count_; ++i) {
+    std::lock_guard<std::mutex> lock{shards_[i].mutex};
+    size_bytes += shards_[i].size_bytes;
+  }
+  return size_bytes;
+}
+
+size_t AnalyticsCache::get_capacity_bytes() const {
+  return capacity_bytes_.load(std::memory_order_relaxed);
+}
+
+void AnalyticsCache::set_capacity_bytes(size_t capacity_bytes) {
+  for (size_t i = 0; i < shard_count_; ++i) {
+    std::lock_guard<std::mutex> lock{shards_[i].mutex};
+    shards_[i].capacity_bytes = capacity_bytes / shard_count_;
+    evict_to_capacity(shards_[i]);
+  }
+  capacity_bytes_.store(capacity_bytes, std::memory_order_relaxed);
+}
+
+size_t AnalyticsCache::get_max_message_size() const {
+  return max_message_size_.load(std::memory_order_relaxed);
+}
+
+void AnalyticsCache::set_max_message_size(size_t max_message_size) {
+  max_message_size_.store(max_message_size, std::memory_order_relaxed);
+}
+
+AnalyticsCache &get_analytics_cache() {
+  static AnalyticsCache analytics_cache;
+  return analytics_cache;
+}
+
+}  // namespace WindowsSocketApp
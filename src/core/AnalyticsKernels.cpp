@@ -0,0 +1,562 @@
+#include "../include/AnalyticsKernels.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+#include "../utils/HelperFunctions.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define ANALYTICS_X86_64 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#else
+#define ANALYTICS_X86_64 0
+#endif
+
+// GCC and Clang compile each SIMD kernel for its own instruction set; the
+// rest of the program keeps the baseline target. MSVC needs no attribute to
+// use the intrinsics.
+#if defined(__GNUC__) || defined(__clang__)
+#define ANALYTICS_TARGET(isa) __attribute__((target(isa)))
+#else
+#define ANALYTICS_TARGET(isa)
+#endif
+
+namespace WindowsSocketApp {
+
+namespace {
+
+// The SIMD kernels count these six classes; punctuation and consonants are
+// derived from them: every printable non-space byte is punctuation unless it
+// is a digit or a letter, and every letter that is not a vowel is a
+// consonant.
+struct Class_Counts {
+  uint64_t spaces{0};
+  uint64_t printable{0};  // '!' .. '~'
+  uint64_t digits{0};
+  uint64_t uppercase{0};
+  uint64_t lowercase{0};
+  uint64_t vowels{0};
+};
+
+void add_class_counts(const Class_Counts &counts, size_t size,
+                      MessageAnalytics &analytics) {
+  analytics.length += size;
+  analytics.spaces_count += counts.spaces;
+  analytics.punctuation_marks_count +=
+      counts.printable - counts.digits - counts.uppercase - counts.lowercase;
+  analytics.digits_count += counts.digits;
+  analytics.uppercase_count += counts.uppercase;
+  analytics.lowercase_count += counts.lowercase;
+  analytics.vowels_count += counts.vowels;
+  analytics.consonants_count +=
+      counts.uppercase + counts.lowercase - counts.vowels;
+}
+
+// The original loop of Server::calculate_recv_message_analytics().
+void reference_kernel(const char *data, size_t size,
+                      MessageAnalytics &analytics) {
+  // Counting into a local copy keeps the counters in registers; stores to
+  // the caller's struct could alias the char data being scanned.
+  MessageAnalytics local{analytics};
+  local.length += size;
+
+  for (size_t i = 0; i < size; ++i) {
+    const char c = data[i];
+    if (c == ' ') {
+      ++local.spaces_count;
+    } else if ((c >= '!' && c <= '/') || (c >= ':' && c <= '@') ||
+               (c >= '[' && c <= '`') || (c >= '{' && c <= '~')) {
+      ++local.punctuation_marks_count;
+    } else if (c >= '0' && c <= '9') {
+      ++local.digits_count;
+    } else if (c >= 'A' && c <= 'Z') {
+      ++local.uppercase_count;
+    } else if (c >= 'a' && c <= 'z') {
+      ++local.lowercase_count;
+    }
+    if (is_vowel(c)) {
+      ++local.vowels_count;
+    } else if (is_consonant(c)) {
+      ++local.consonants_count;
+    }
+  }
+  analytics = local;
+}
+
+// Classes of every byte value, taken from the reference kernel itself so the
+// table cannot drift from it.
+std::array<uint8_t, 256> build_class_table() {
+  std::array<uint8_t, 256> table{};
+  for (int value = 0; value < 256; ++value) {
+    const char c = static_cast<char>(value);
+    MessageAnalytics single{};
+    reference_kernel(&c, 1, single);
+    table[value] = static_cast<uint8_t>(
+        (single.spaces_count != 0 ? class_flag_space : 0) |
+        (single.punctuation_marks_count != 0 ? class_flag_punctuation : 0) |
+        (single.digits_count != 0 ? class_flag_digit : 0) |
+        (single.uppercase_count != 0 ? class_flag_uppercase : 0) |
+        (single.lowercase_count != 0 ? class_flag_lowercase : 0) |
+        (single.vowels_count != 0 ? class_flag_vowel : 0) |
+        (single.consonants_count != 0 ? class_flag_consonant : 0));
+  }
+  return table;
+}
+
+void add_flag_counts(uint8_t flags, uint64_t count,
+                     MessageAnalytics &analytics) {
+  if ((flags & class_flag_space) != 0U) {
+    analytics.spaces_count += count;
+  }
+  if ((flags & class_flag_punctuation) != 0U) {
+    analytics.punctuation_marks_count += count;
+  }
+  if ((flags & class_flag_digit) != 0U) {
+    analytics.digits_count += count;
+  }
+  if ((flags & class_flag_uppercase) != 0U) {
+    analytics.uppercase_count += count;
+  }
+  if ((flags & class_flag_lowercase) != 0U) {
+    analytics.lowercase_count += count;
+  }
+  if ((flags & class_flag_vowel) != 0U) {
+    analytics.vowels_count += count;
+  }
+  if ((flags & class_flag_consonant) != 0U) {
+    analytics.consonants_count += count;
+  }
+}
+
+// Below this size clearing and folding the byte histogram costs more than
+// looking up each byte's classes directly.
+constexpr size_t histogram_threshold{4096};
+
+void scalar_kernel(const char *data, size_t size, MessageAnalytics &analytics) {
+  const auto &class_table = get_character_class_table();
+  const auto *bytes = reinterpret_cast<const unsigned char *>(data);
+  analytics.length += size;
+
+  if (size < histogram_threshold) {
+    for (size_t i = 0; i < size; ++i) {
+      add_flag_counts(class_table[bytes[i]], 1, analytics);
+    }
+    return;
+  }
+
+  // Four interleaved histograms break the store-to-load dependency between
+  // consecutive equal bytes.
+  std::array<std::array<uint64_t, 256>, 4> histograms{};
+  size_t i = 0;
+  for (; i + 4 <= size; i += 4) {
+    ++histograms[0][bytes[i]];
+    ++histograms[1][bytes[i + 1]];
+    ++histograms[2][bytes[i + 2]];
+    ++histograms[3][bytes[i + 3]];
+  }
+  for (; i < size; ++i) {
+    ++histograms[0][bytes[i]];
+  }
+
+  for (size_t value = 0; value < 256; ++value) {
+    const uint64_t count = histograms[0][value] + histograms[1][value] +
+                           histograms[2][value] + histograms[3][value];
+    if (count != 0 && class_table[value] != 0) {
+      add_flag_counts(class_table[value], count, analytics);
+    }
+  }
+}
+
+#if ANALYTICS_X86_64
+
+// Byte lanes count up to 255 matches before they are widened to 64 bits.
+constexpr size_t maximum_vectors_per_block{255};
+
+uint64_t horizontal_sum(__m128i lanes) {
+  return static_cast<uint64_t>(_mm_cvtsi128_si64(lanes)) +
+         static_cast<uint64_t>(
+             _mm_cvtsi128_si64(_mm_unpackhi_epi64(lanes, lanes)));
+}
+
+void sse2_kernel(const char *data, size_t size, MessageAnalytics &analytics) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i space = _mm_set1_epi8(' ');
+  const __m128i before_printable = _mm_set1_epi8(' ');
+  const __m128i after_printable = _mm_set1_epi8(0x7F);
+  const __m128i before_digit = _mm_set1_epi8('0' - 1);
+  const __m128i after_digit = _mm_set1_epi8('9' + 1);
+  const __m128i before_upper = _mm_set1_epi8('A' - 1);
+  const __m128i after_upper = _mm_set1_epi8('Z' + 1);
+  const __m128i before_lower = _mm_set1_epi8('a' - 1);
+  const __m128i after_lower = _mm_set1_epi8('z' + 1);
+  const __m128i case_bit = _mm_set1_epi8(0x20);
+  const __m128i vowel_a = _mm_set1_epi8('a');
+  const __m128i vowel_e = _mm_set1_epi8('e');
+  const __m128i vowel_i = _mm_set1_epi8('i');
+  const __m128i vowel_o = _mm_set1_epi8('o');
+  const __m128i vowel_u = _mm_set1_epi8('u');
+
+  __m128i spaces = zero;
+  __m128i printable = zero;
+  __m128i digits = zero;
+  __m128i uppercase = zero;
+  __m128i lowercase = zero;
+  __m128i vowels = zero;
+
+  size_t offset = 0;
+  size_t remaining_vectors = size / 16;
+  while (remaining_vectors > 0) {
+    const size_t block_vectors =
+        std::min(remaining_vectors, maximum_vectors_per_block);
+    __m128i block_spaces = zero;
+    __m128i block_printable = zero;
+    __m128i block_digits = zero;
+    __m128i block_uppercase = zero;
+    __m128i block_lowercase = zero;
+    __m128i block_vowels = zero;
+
+    for (size_t v = 0; v < block_vectors; ++v, offset += 16) {
+      // Signed compares: bytes >= 0x80 are negative and match no class.
+      const __m128i bytes =
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + offset));
+      block_spaces = _mm_sub_epi8(block_spaces, _mm_cmpeq_epi8(bytes, space));
+      block_printable = _mm_sub_epi8(
+          block_printable,
+          _mm_and_si128(_mm_cmpgt_epi8(bytes, before_printable),
+                        _mm_cmpgt_epi8(after_printable, bytes)));
+      block_digits = _mm_sub_epi8(
+          block_digits, _mm_and_si128(_mm_cmpgt_epi8(bytes, before_digit),
+                                      _mm_cmpgt_epi8(after_digit, bytes)));
+      block_uppercase = _mm_sub_epi8(
+          block_uppercase, _mm_and_si128(_mm_cmpgt_epi8(bytes, before_upper),
+                                         _mm_cmpgt_epi8(after_upper, bytes)));
+      block_lowercase = _mm_sub_epi8(
+          block_lowercase, _mm_and_si128(_mm_cmpgt_epi8(bytes, before_lower),
+                                         _mm_cmpgt_epi8(after_lower, bytes)));
+      const __m128i folded = _mm_or_si128(bytes, case_bit);
+      const __m128i is_vowel_mask = _mm_or_si128(
+          _mm_or_si128(_mm_cmpeq_epi8(folded, vowel_a),
+                       _mm_cmpeq_epi8(folded, vowel_e)),
+          _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(folded, vowel_i),
+                                    _mm_cmpeq_epi8(folded, vowel_o)),
+                       _mm_cmpeq_epi8(folded, vowel_u)));
+      block_vowels = _mm_sub_epi8(block_vowels, is_vowel_mask);
+    }
+
+    spaces = _mm_add_epi64(spaces, _mm_sad_epu8(block_spaces, zero));
+    printable = _mm_add_epi64(printable, _mm_sad_epu8(block_printable, zero));
+    digits = _mm_add_epi64(digits, _mm_sad_epu8(block_digits, zero));
+    uppercase = _mm_add_epi64(uppercase, _mm_sad_epu8(block_uppercase, zero));
+    lowercase = _mm_add_epi64(lowercase, _mm_sad_epu8(block_lowercase, zero));
+    vowels = _mm_add_epi64(vowels, _mm_sad_epu8(block_vowels, zero));
+    remaining_vectors -= block_vectors;
+  }
+
+  Class_Counts counts;
+  counts.spaces = horizontal_sum(spaces);
+  counts.printable = horizontal_sum(printable);
+  counts.digits = horizontal_sum(digits);
+  counts.uppercase = horizontal_sum(uppercase);
+  counts.lowercase = horizontal_sum(lowercase);
+  counts.vowels = horizontal_sum(vowels);
+  add_class_counts(counts, offset, analytics);
+  scalar_kernel(data + offset, size - offset, analytics);
+}
+
+ANALYTICS_TARGET("avx2")
+uint64_t horizontal_sum_256(__m256i lanes) {
+  return horizontal_sum(_mm_add_epi64(_mm256_castsi256_si128(lanes),
+                                      _mm256_extracti128_si256(lanes, 1)));
+}
+
+ANALYTICS_TARGET("avx2")
+void avx2_kernel(const char *data, size_t size, MessageAnalytics &analytics) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i space = _mm256_set1_epi8(' ');
+  const __m256i before_printable = _mm256_set1_epi8(' ');
+  const __m256i after_printable = _mm256_set1_epi8(0x7F);
+  const __m256i before_digit = _mm256_set1_epi8('0' - 1);
+  const __m256i after_digit = _mm256_set1_epi8('9' + 1);
+  const __m256i before_upper = _mm256_set1_epi8('A' - 1);
+  const __m256i after_upper = _mm256_set1_epi8('Z' + 1);
+  const __m256i before_lower = _mm256_set1_epi8('a' - 1);
+  const __m256i after_lower = _mm256_set1_epi8('z' + 1);
+  const __m256i case_bit = _mm256_set1_epi8(0x20);
+  const __m256i vowel_a = _mm256_set1_epi8('a');
+  const __m256i vowel_e = _mm256_set1_epi8('e');
+  const __m256i vowel_i = _mm256_set1_epi8('i');
+  const __m256i vowel_o = _mm256_set1_epi8('o');
+  const __m256i vowel_u = _mm256_set1_epi8('u');
+
+  __m256i spaces = zero;
+  __m256i printable = zero;
+  __m256i digits = zero;
+  __m256i uppercase = zero;
+  __m256i lowercase = zero;
+  __m256i vowels = zero;
+
+  size_t offset = 0;
+  size_t remaining_vectors = size / 32;
+  while (remaining_vectors > 0) {
+    const size_t block_vectors =
+        std::min(remaining_vectors, maximum_vectors_per_block);
+    __m256i block_spaces = zero;
+    __m256i block_printable = zero;
+    __m256i block_digits = zero;
+    __m256i block_uppercase = zero;
+    __m256i block_lowercase = zero;
+    __m256i block_vowels = zero;
+
+    for (size_t v = 0; v < block_vectors; ++v, offset += 32) {
+      const __m256i bytes =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + offset));
+      block_spaces =
+          _mm256_sub_epi8(block_spaces, _mm256_cmpeq_epi8(bytes, space));
+      block_printable = _mm256_sub_epi8(
+          block_printable,
+          _mm256_and_si256(_mm256_cmpgt_epi8(bytes, before_printable),
+                           _mm256_cmpgt_epi8(after_printable, bytes)));
+      block_digits = _mm256_sub_epi8(
+          block_digits,
+          _mm256_and_si256(_mm256_cmpgt_epi8(bytes, before_digit),
+                           _mm256_cmpgt_epi8(after_digit, bytes)));
+      block_uppercase = _mm256_sub_epi8(
+          block_uppercase,
+          _mm256_and_si256(_mm256_cmpgt_epi8(bytes, before_upper),
+                           _mm256_cmpgt_epi8(after_upper, bytes)));
+      block_lowercase = _mm256_sub_epi8(
+          block_lowercase,
+          _mm256_and_si256(_mm256_cmpgt_epi8(bytes, before_lower),
+                           _mm256_cmpgt_epi8(after_lower, bytes)));
+      const __m256i folded = _mm256_or_si256(bytes, case_bit);
+      const __m256i is_vowel_mask = _mm256_or_si256(
+          _mm256_or_si256(_mm256_cmpeq_epi8(folded, vowel_a),
+                          _mm256_cmpeq_epi8(folded, vowel_e)),
+          _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(folded, vowel_i),
+                                          _mm256_cmpeq_epi8(folded, vowel_o)),
+                          _mm256_cmpeq_epi8(folded, vowel_u)));
+      block_vowels = _mm256_sub_epi8(block_vowels, is_vowel_mask);
+    }
+
+    spaces = _mm256_add_epi64(spaces, _mm256_sad_epu8(block_spaces, zero));
+    printable =
+        _mm256_add_epi64(printable, _mm256_sad_epu8(block_printable, zero));
+    digits = _mm256_add_epi64(digits, _mm256_sad_epu8(block_digits, zero));
+    uppercase =
+        _mm256_add_epi64(uppercase, _mm256_sad_epu8(block_uppercase, zero));
+    lowercase =
+        _mm256_add_epi64(lowercase, _mm256_sad_epu8(block_lowercase, zero));
+    vowels = _mm256_add_epi64(vowels, _mm256_sad_epu8(block_vowels, zero));
+    remaining_vectors -= block_vectors;
+  }
+
+  Class_Counts counts;
+  counts.spaces = horizontal_sum_256(spaces);
+  counts.printable = horizontal_sum_256(printable);
+  counts.digits = horizontal_sum_256(digits);
+  counts.uppercase = horizontal_sum_256(uppercase);
+  counts.lowercase = horizontal_sum_256(lowercase);
+  counts.vowels = horizontal_sum_256(vowels);
+  add_class_counts(counts, offset, analytics);
+  scalar_kernel(data + offset, size - offset, analytics);
+}
+
+ANALYTICS_TARGET("avx512f,avx512bw,popcnt")
+void avx512_kernel(const char *data, size_t size,
+                   MessageAnalytics &analytics) {
+  const __m512i space = _mm512_set1_epi8(' ');
+  const __m512i before_printable = _mm512_set1_epi8(' ');
+  const __m512i after_printable = _mm512_set1_epi8(0x7F);
+  const __m512i before_digit = _mm512_set1_epi8('0' - 1);
+  const __m512i after_digit = _mm512_set1_epi8('9' + 1);
+  const __m512i before_upper = _mm512_set1_epi8('A' - 1);
+  const __m512i after_upper = _mm512_set1_epi8('Z' + 1);
+  const __m512i before_lower = _mm512_set1_epi8('a' - 1);
+  const __m512i after_lower = _mm512_set1_epi8('z' + 1);
+  const __m512i case_bit = _mm512_set1_epi8(0x20);
+  const __m512i vowel_a = _mm512_set1_epi8('a');
+  const __m512i vowel_e = _mm512_set1_epi8('e');
+  const __m512i vowel_i = _mm512_set1_epi8('i');
+  const __m512i vowel_o = _mm512_set1_epi8('o');
+  const __m512i vowel_u = _mm512_set1_epi8('u');
+
+  Class_Counts counts;
+  for (size_t offset = 0; offset < size; offset += 64) {
+    // The tail is loaded with a mask; the zero bytes it leaves match no
+    // class, so no scalar tail loop is needed.
+    const size_t remaining = size - offset;
+    const __mmask64 load_mask = remaining >= 64
+                                    ? ~__mmask64{0}
+                                    : (__mmask64{1} << remaining) - 1;
+    const __m512i bytes = _mm512_maskz_loadu_epi8(load_mask, data + offset);
+
+    counts.spaces += static_cast<uint64_t>(
+        _mm_popcnt_u64(_mm512_cmpeq_epi8_mask(bytes, space)));
+    counts.printable += static_cast<uint64_t>(_mm_popcnt_u64(
+        _mm512_mask_cmpgt_epi8_mask(_mm512_cmpgt_epi8_mask(bytes,
+                                                           before_printable),
+                                    after_printable, bytes)));
+    counts.digits += static_cast<uint64_t>(_mm_popcnt_u64(
+        _mm512_mask_cmpgt_epi8_mask(_mm512_cmpgt_epi8_mask(bytes, before_digit),
+                                    after_digit, bytes)));
+    counts.uppercase += static_cast<uint64_t>(_mm_popcnt_u64(
+        _mm512_mask_cmpgt_epi8_mask(_mm512_cmpgt_epi8_mask(bytes, before_upper),
+                                    after_upper, bytes)));
+    counts.lowercase += static_cast<uint64_t>(_mm_popcnt_u64(
+        _mm512_mask_cmpgt_epi8_mask(_mm512_cmpgt_epi8_mask(bytes, before_lower),
+                                    after_lower, bytes)));
+    const __m512i folded = _mm512_or_si512(bytes, case_bit);
+    counts.vowels += static_cast<uint64_t>(
+        _mm_popcnt_u64(_mm512_cmpeq_epi8_mask(folded, vowel_a) |
+                       _mm512_cmpeq_epi8_mask(folded, vowel_e) |
+                       _mm512_cmpeq_epi8_mask(folded, vowel_i) |
+                       _mm512_cmpeq_epi8_mask(folded, vowel_o) |
+                       _mm512_cmpeq_epi8_mask(folded, vowel_u)));
+  }
+  add_class_counts(counts, size, analytics);
+}
+
+bool cpu_supports_avx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+  int registers[4];
+  __cpuid(registers, 1);
+  const bool os_saves_ymm = (registers[2] & (1 << 27)) != 0 &&
+                            (_xgetbv(0) & 0x6) == 0x6;
+  __cpuidex(registers, 7, 0);
+  return os_saves_ymm && (registers[1] & (1 << 5)) != 0;
+#else
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+bool cpu_supports_avx512bw() {
+#if defined(_MSC_VER) && !defined(__clang__)
+  int registers[4];
+  __cpuid(registers, 1);
+  const bool os_saves_zmm = (registers[2] & (1 << 27)) != 0 &&
+                            (_xgetbv(0) & 0xE6) == 0xE6;
+  const bool has_popcnt = (registers[2] & (1 << 23)) != 0;
+  __cpuidex(registers, 7, 0);
+  return os_saves_zmm && has_popcnt && (registers[1] & (1 << 16)) != 0 &&
+         (registers[1] & (1 << 30)) != 0;
+#else
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx512f") != 0 &&
+         __builtin_cpu_supports("avx512bw") != 0 &&
+         __builtin_cpu_supports("popcnt") != 0;
+#endif
+}
+
+#endif  // ANALYTICS_X86_64
+
+using Kernel_Function = void (*)(const char *, size_t, MessageAnalytics &);
+
+Kernel_Function get_kernel_function(Analytics_Kernel kernel) {
+  switch (kernel) {
+    case Analytics_Kernel::REFERENCE:
+      return reference_kernel;
+    case Analytics_Kernel::SCALAR:
+      return scalar_kernel;
+#if ANALYTICS_X86_64
+    case Analytics_Kernel::SSE2:
+      return sse2_kernel;
+    case Analytics_Kernel::AVX2:
+      return avx2_kernel;
+    case Analytics_Kernel::AVX512:
+      return avx512_kernel;
+#endif
+    default:
+      return nullptr;
+  }
+}
+
+Analytics_Kernel select_analytics_kernel() {
+  for (auto kernel : {Analytics_Kernel::AVX512, Analytics_Kernel::AVX2,
+                      Analytics_Kernel::SSE2}) {
+    if (is_analytics_kernel_supported(kernel)) {
+      return kernel;
+    }
+  }
+  return Analytics_Kernel::SCALAR;
+}
+
+struct Active_Kernel {
+  Analytics_Kernel kernel;
+  Kernel_Function function;
+};
+
+Active_Kernel make_active_kernel() {
+  const Analytics_Kernel kernel{select_analytics_kernel()};
+  return Active_Kernel{kernel, get_kernel_function(kernel)};
+}
+
+const Active_Kernel &get_active_kernel() {
+  static const Active_Kernel active_kernel{make_active_kernel()};
+  return active_kernel;
+}
+
+}  // namespace
+
+const std::array<uint8_t, 256> &get_character_class_table() {
+  static const std::array<uint8_t, 256> class_table{build_class_table()};
+  return class_table;
+}
+
+void accumulate_message_analytics(const char *data, size_t size,
+                                  MessageAnalytics &analytics) {
+  get_active_kernel().function(data, size, analytics);
+}
+
+Analytics_Kernel get_active_analytics_kernel() {
+  return get_active_kernel().kernel;
+}
+
+bool is_analytics_kernel_supported(Analytics_Kernel kernel) {
+  switch (kernel) {
+    case Analytics_Kernel::REFERENCE:
+    case Analytics_Kernel::SCALAR:
+      return true;
+#if ANALYTICS_X86_64
+    case Analytics_Kernel::SSE2:
+      return true;
+    case Analytics_Kernel::AVX2:
+      return cpu_supports_avx2();
+    case Analytics_Kernel::AVX512:
+      return cpu_supports_avx512bw();
+#endif
+    default:
+      return false;
+  }
+}
+
+const char *get_analytics_kernel_name(Analytics_Kernel kernel) {
+  switch (kernel) {
+    case Analytics_Kernel::REFERENCE:
+      return "reference";
+    case Analytics_Kernel::SCALAR:
+      return "scalar";
+    case Analytics_Kernel::SSE2:
+      return "sse2";
+    case Analytics_Kernel::AVX2:
+      return "avx2";
+    case Analytics_Kernel::AVX512:
+      return "avx512";
+  }
+  return "unknown";
+}
+
+bool run_analytics_kernel(Analytics_Kernel kernel, const char *data,
+                          size_t size, MessageAnalytics &analytics) {
+  if (!is_analytics_kernel_supported(kernel)) {
+    return false;
+  }
+  get_kernel_function(kernel)(data, size, analytics);
+  return true;
+}
+
+}  // namespace WindowsSocketApp
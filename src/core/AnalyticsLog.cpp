@@ -0,0 +1,471 @@
+#include "../include/AnalyticsLog.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <limits>
+
+namespace WindowsSocketApp {
+
+namespace {
+
+// Slots of the calling thread's current chunk
+struct Claimed_Chunk {
+  uint64_t generation{0};
+  uint64_t next{0};
+  uint64_t end{0};
+};
+
+thread_local Claimed_Chunk claimed_chunk;
+
+// Generations are unique over every log of the process, so a chunk is never
+// mistaken for one of another log
+std::atomic<uint64_t> last_generation{0};
+
+uint64_t get_timestamp_nanoseconds() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::system_clock::now().time_since_epoch())
+          .count());
+}
+
+size_t get_log_size(uint64_t slots) {
+  return analytics_log_header_size +
+         static_cast<size_t>(slots) * sizeof(Analytics_Log_Record);
+}
+
+bool is_valid_header(const Analytics_Log_Header &header, uint64_t file_size) {
+  return header.magic == analytics_log_magic &&
+         header.version == analytics_log_version &&
+         header.record_size == sizeof(Analytics_Log_Record) &&
+         header.committed_slots <= header.capacity &&
+         file_size >= get_log_size(header.capacity);
+}
+
+bool is_zeroed(const Analytics_Log_Record *records, uint64_t count) {
+  const auto *const bytes = reinterpret_cast<const unsigned char *>(records);
+  return std::all_of(bytes,
+                     bytes + static_cast<size_t>(count) *
+                                 sizeof(Analytics_Log_Record),
+                     [](unsigned char byte) { return byte == 0; });
+}
+
+void store_classes(const MessageAnalytics &analytics,
+                   Analytics_Log_Record &record) {
+  for (size_t i = 0; i < message_analytics_counters.size(); ++i) {
+    record.classes[i] = analytics.*message_analytics_counters[i].counter;
+  }
+}
+
+}  // namespace
+
+AnalyticsLog::AnalyticsLog()
+    : open_{false},
+      generation_{0},
+      file_descriptor_{-1},
+      mapping_{nullptr},
+      mapping_size_{0},
+      header_{nullptr},
+      records_{nullptr},
+      capacity_{0},
+      next_chunk_{0},
+      dropped_records_{0},
+      sync_interval_{default_sync_interval},
+      stop_requested_{false} {}
+
+AnalyticsLog::~AnalyticsLog() { close(); }
+
+bool AnalyticsLog::open(const std::string &path, uint64_t capacity,
+                        std::chrono::milliseconds sync_interval) {
+#ifdef _WIN32
+  (void)capacity;
+  (void)sync_interval;
+  std::cerr << "Failed to open the analytics log " << path
+            << ": not supported on Windows" << std::endl;
+  return false;
+#else
+  std::lock_guard<std::mutex> lock{open_mutex_};
+  if (open_.load(std::memory_order_relaxed)) {
+    std::cerr << "The analytics log is already open" << std::endl;
+    return false;
+  }
+  const int file_descriptor =
+      ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (file_descriptor == -1) {
+    std::cerr << "Failed to open the analytics log " << path << ": " << errno
+              << std::endl;
+    return false;
+  }
+  const auto fail = [file_descriptor, &path](const char *reason, int error) {
+    std::cerr << "Failed to open the analytics log " << path << ": " << reason
+              << ' ' << error << std::endl;
+    ::close(file_descriptor);
+    return false;
+  };
+
+  struct stat status {};
+  if (fstat(file_descriptor, &status) == -1) {
+    return fail("fstat", errno);
+  }
+  const bool created = status.st_size == 0;
+  if (created) {
+    capacity = std::max<uint64_t>(capacity, chunk_slots);
+    // Blocks are allocated up front and the new size made durable, so
+    // appends never extend the file and a commit only flushes data
+#ifdef __linux__
+    const int result =
+        posix_fallocate(file_descriptor, 0,
+                        static_cast<off_t>(get_log_size(capacity)));
+#else
+    const int result = ftruncate(file_descriptor,
+                                 static_cast<off_t>(get_log_size(capacity))) ==
+                               -1
+                           ? errno
+                           : 0;
+#endif
+    if (result != 0) {
+      return fail("allocation", result);
+    }
+    if (fdatasync(file_descriptor) == -1) {
+      return fail("fdatasync", errno);
+    }
+  } else {
+    Analytics_Log_Header header;
+    if (pread(file_descriptor, &header, sizeof(header), 0) !=
+            static_cast<ssize_t>(sizeof(header)) ||
+        !is_valid_header(header, static_cast<uint64_t>(status.st_size))) {
+      std::cerr << path << " is not an analytics log" << std::endl;
+      ::close(file_descriptor);
+      return false;
+    }
+    capacity = header.capacity;
+  }
+
+  const size_t mapping_size = get_log_size(capacity);
+  void *mapping = mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED, file_descriptor, 0);
+  if (mapping == MAP_FAILED) {
+    return fail("mmap", errno);
+  }
+  mapping_ = static_cast<char *>(mapping);
+  mapping_size_ = mapping_size;
+  file_descriptor_ = file_descriptor;
+  header_ = reinterpret_cast<Analytics_Log_Header *>(mapping_);
+  records_ = reinterpret_cast<Analytics_Log_Record *>(
+      mapping_ + analytics_log_header_size);
+  capacity_ = capacity;
+
+  uint64_t first_free_slot{0};
+  if (created) {
+    *header_ = Analytics_Log_Header{};
+    header_->capacity = capacity;
+  } else {
+    // Any chunk claimed after the last commit of the earlier run may hold
+    // records, whole or in part: a thread can stop before writing the chunk
+    // it claimed while later chunks are written. So every chunk of the tail
+    // is checked and cleared unless already zero, and slots are handed out
+    // zeroed. Clean chunks are only read, so their pages stay clean.
+    first_free_slot = header_->committed_slots;
+    for (uint64_t chunk = first_free_slot; chunk < capacity;
+         chunk += chunk_slots) {
+      const uint64_t count = std::min<uint64_t>(chunk_slots, capacity - chunk);
+      if (!is_zeroed(&records_[chunk], count)) {
+        std::memset(static_cast<void *>(&records_[chunk]), 0,
+                    static_cast<size_t>(count) * sizeof(Analytics_Log_Record));
+      }
+    }
+  }
+  if (msync(mapping_, analytics_log_header_size, MS_SYNC) == -1) {
+    std::cerr << "Failed to sync the analytics log header: " << errno
+              << std::endl;
+  }
+
+  next_chunk_.store(first_free_slot, std::memory_order_relaxed);
+  dropped_records_.store(0, std::memory_order_relaxed);
+  sync_interval_ = std::max(sync_interval, std::chrono::milliseconds{1});
+  stop_requested_ = false;
+  generation_.store(last_generation.fetch_add(1) + 1,
+                    std::memory_order_release);
+  open_.store(true, std::memory_order_release);
+  commit_thread_ = std::thread{[this]() { run_commits(); }};
+  std::cout << "Logging analytics to " << path << " (" << first_free_slot
+            << " of " << capacity << " slots used)" << std::endl;
+  return true;
+#endif
+}
+
+void AnalyticsLog::close() {
+#ifndef _WIN32
+  std::lock_guard<std::mutex> lock{open_mutex_};
+  if (!open_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  open_.store(false, std::memory_order_release);
+  {
+    std::lock_guard<std::mutex> commit_lock{commit_mutex_};
+    stop_requested_ = true;
+  }
+  commit_condition_.notify_one();
+  commit_thread_.join();
+  commit();
+
+  munmap(mapping_, mapping_size_);
+  ::close(file_descriptor_);
+  mapping_ = nullptr;
+  mapping_size_ = 0;
+  file_descriptor_ = -1;
+  header_ = nullptr;
+  records_ = nullptr;
+  capacity_ = 0;
+  const uint64_t dropped_records =
+      dropped_records_.load(std::memory_order_relaxed);
+  if (dropped_records > 0) {
+    std::cerr << "Analytics log was full: " << dropped_records
+              << " records dropped" << std::endl;
+  }
+#endif
+}
+
+bool AnalyticsLog::is_open() const {
+  return open_.load(std::memory_order_relaxed);
+}
+
+uint64_t AnalyticsLog::get_dropped_records() const {
+  return dropped_records_.load(std::memory_order_relaxed);
+}
+
+void AnalyticsLog::commit() {
+#ifndef _WIN32
+  const uint64_t claimed_slots =
+      std::min(next_chunk_.load(std::memory_order_relaxed), capacity_);
+  // Pages are flushed whole, clean ones cost only their lookup; records of
+  // chunks still being filled reach the disk with a later commit
+  if (msync(mapping_, get_log_size(claimed_slots), MS_SYNC) == -1) {
+    std::cerr << "Failed to sync the analytics log: " << errno << std::endl;
+    return;
+  }
+  if (header_->committed_slots != claimed_slots) {
+    // Published once the records it covers are on disk
+    header_->committed_slots = claimed_slots;
+    if (msync(mapping_, analytics_log_header_size, MS_SYNC) == -1) {
+      std::cerr << "Failed to sync the analytics log header: " << errno
+                << std::endl;
+    }
+  }
+#endif
+}
+
+void AnalyticsLog::run_commits() {
+  std::unique_lock<std::mutex> lock{commit_mutex_};
+  while (!stop_requested_) {
+    commit_condition_.wait_for(lock, sync_interval_,
+                               [this]() { return stop_requested_; });
+    if (stop_requested_) {
+      return;
+    }
+    lock.unlock();
+    commit();
+    lock.lock();
+  }
+}
+
+Analytics_Log_Record *AnalyticsLog::claim_slot() {
+  Claimed_Chunk &chunk = claimed_chunk;
+  const uint64_t generation = generation_.load(std::memory_order_acquire);
+  if (chunk.generation != generation || chunk.next == chunk.end) {
+    // Once the log is full the shared counter is only read
+    uint64_t first_slot = next_chunk_.load(std::memory_order_relaxed);
+    if (first_slot < capacity_) {
+      first_slot =
+          next_chunk_.fetch_add(chunk_slots, std::memory_order_relaxed);
+    }
+    if (first_slot >= capacity_) {
+      if (dropped_records_.fetch_add(1, std::memory_order_relaxed) == 0) {
+        std::cerr << "Analytics log full, records are dropped" << std::endl;
+      }
+      chunk = Claimed_Chunk{};
+      return nullptr;
+    }
+    chunk = Claimed_Chunk{generation, first_slot,
+                          std::min<uint64_t>(first_slot + chunk_slots,
+                                             capacity_)};
+  }
+  return &records_[chunk.next++];
+}
+
+void AnalyticsLog::publish(Analytics_Log_Record &slot, uint64_t message_size,
+                           uint16_t counters) {
+  slot.message_size = message_size;
+  slot.counters = counters;
+  // The timestamp marks the slot as written, so it goes last
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.timestamp_nanoseconds = get_timestamp_nanoseconds();
+}
+
+void AnalyticsLog::append(const MessageAnalytics &analytics) {
+  if (!open_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  Analytics_Log_Record *slot = claim_slot();
+  if (slot == nullptr) {
+    return;
+  }
+  // Slots are handed out zeroed, so only the counters computed are stored
+  store_classes(analytics, *slot);
+  publish(*slot, analytics.length, analytics_character_classes);
+}
+
+void AnalyticsLog::append(const Pipeline_Analytics &analytics,
+                          uint64_t message_size) {
+  if (!open_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  Analytics_Log_Record *slot = claim_slot();
+  if (slot == nullptr) {
+    return;
+  }
+  if ((analytics.counters & analytics_character_classes) != 0U) {
+    store_classes(analytics.classes, *slot);
+  }
+  slot->words_count = analytics.words_count;
+  slot->lines_count = analytics.lines_count;
+  slot->code_points_count = analytics.code_points_count;
+  publish(*slot, message_size, analytics.counters);
+}
+
+AnalyticsLog &get_analytics_log() {
+  static AnalyticsLog analytics_log;
+  return analytics_log;
+}
+
+Analytics_Log_Summary summarize_analytics_log(
+    const Analytics_Log_Record *records, uint64_t count) {
+  Analytics_Log_Summary summary;
+  summary.slots_count = count;
+  // Counters of the groups a record did not compute are 0, so every record
+  // is added whole, without branches
+  std::array<uint64_t, 8> classes{};
+  uint64_t classified_count{0};
+  uint64_t empty_count{0};
+  uint64_t first_timestamp{std::numeric_limits<uint64_t>::max()};
+  uint64_t last_timestamp{0};
+  for (uint64_t i = 0; i < count; ++i) {
+    const Analytics_Log_Record &record = records[i];
+    if (record.timestamp_nanoseconds == 0) {
+      ++empty_count;
+      continue;
+    }
+    first_timestamp = std::min(first_timestamp, record.timestamp_nanoseconds);
+    last_timestamp = std::max(last_timestamp, record.timestamp_nanoseconds);
+    ++summary.analytics
+          .message_sizes[get_message_size_bucket(record.message_size)];
+    classified_count += record.counters & analytics_character_classes;
+    for (size_t j = 0; j < classes.size(); ++j) {
+      classes[j] += record.classes[j];
+    }
+    summary.words_count += record.words_count;
+    summary.lines_count += record.lines_count;
+    summary.code_points_count += record.code_points_count;
+  }
+
+  summary.empty_slots_count = empty_count;
+  summary.analytics.messages_count = count - empty_count;
+  summary.analytics.classified_messages_count = classified_count;
+  for (size_t i = 0; i < message_analytics_counters.size(); ++i) {
+    summary.analytics.classes.*message_analytics_counters[i].counter =
+        static_cast<size_t>(classes[i]);
+  }
+  if (summary.analytics.messages_count > 0) {
+    summary.first_timestamp_nanoseconds = first_timestamp;
+    summary.last_timestamp_nanoseconds = last_timestamp;
+  }
+  return summary;
+}
+
+AnalyticsLogReader::AnalyticsLogReader()
+    : file_descriptor_{-1}, mapping_{nullptr}, mapping_size_{0} {}
+
+AnalyticsLogReader::~AnalyticsLogReader() { close(); }
+
+bool AnalyticsLogReader::open(const std::string &path) {
+#ifdef _WIN32
+  std::cerr << "Failed to open the analytics log " << path
+            << ": not supported on Windows" << std::endl;
+  return false;
+#else
+  close();
+  const int file_descriptor = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (file_descriptor == -1) {
+    std::cerr << "Failed to open the analytics log " << path << ": " << errno
+              << std::endl;
+    return false;
+  }
+  struct stat status {};
+  Analytics_Log_Header header;
+  if (fstat(file_descriptor, &status) == -1 ||
+      pread(file_descriptor, &header, sizeof(header), 0) !=
+          static_cast<ssize_t>(sizeof(header)) ||
+      !is_valid_header(header, static_cast<uint64_t>(status.st_size))) {
+    std::cerr << path << " is not an analytics log" << std::endl;
+    ::close(file_descriptor);
+    return false;
+  }
+  const size_t mapping_size = get_log_size(header.capacity);
+  void *mapping = mmap(nullptr, mapping_size, PROT_READ, MAP_SHARED,
+                       file_descriptor, 0);
+  if (mapping == MAP_FAILED) {
+    std::cerr << "Failed to map the analytics log " << path << ": " << errno
+              << std::endl;
+    ::close(file_descriptor);
+    return false;
+  }
+  // Scanned front to back: the kernel reads ahead
+  madvise(mapping, mapping_size, MADV_SEQUENTIAL);
+  file_descriptor_ = file_descriptor;
+  mapping_ = static_cast<const char *>(mapping);
+  mapping_size_ = mapping_size;
+  return true;
+#endif
+}
+
+void AnalyticsLogReader::close() {
+#ifndef _WIN32
+  if (mapping_ == nullptr) {
+    return;
+  }
+  munmap(const_cast<char *>(mapping_), mapping_size_);
+  ::close(file_descriptor_);
+  mapping_ = nullptr;
+  mapping_size_ = 0;
+  file_descriptor_ = -1;
+#endif
+}
+
+const Analytics_Log_Record *AnalyticsLogReader::get_records() const {
+  return reinterpret_cast<const Analytics_Log_Record *>(
+      mapping_ + analytics_log_header_size);
+}
+
+uint64_t AnalyticsLogReader::get_committed_slots() const {
+  if (mapping_ == nullptr) {
+    return 0;
+  }
+  // A running server updates the header behind our back
+  const auto *header = reinterpret_cast<const volatile Analytics_Log_Header *>(
+      mapping_);
+  const uint64_t committed_slots = header->committed_slots;
+  const uint64_t capacity = header->capacity;
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return std::min(committed_slots, capacity);
+}
+
+}  // namespace WindowsSocketApp
@@ -0,0 +1,106 @@
+#include "../include/AnalyticsPipeline.h"
+
+namespace WindowsSocketApp {
+
+namespace {
+
+using Scan_Function = void (*)(const char *, size_t, Pipeline_Analytics &);
+
+constexpr size_t selection_count{analytics_byte_counters + 1U};
+
+// The character classes alone, through the widest SIMD kernel
+void scan_character_classes(const char *data, size_t size,
+                            Pipeline_Analytics &analytics) {
+  accumulate_message_analytics(data, size, analytics.classes);
+}
+
+// One scan per counter selection, each compiled with only its counters
+template <size_t... Selections>
+constexpr std::array<Scan_Function, sizeof...(Selections)> make_scan_table(
+    std::index_sequence<Selections...>) {
+  return {{&Default_Analytics_Pipeline::run<
+      static_cast<uint16_t>(Selections)>...}};
+}
+
+Scan_Function get_scan_function(uint16_t counters) {
+  static constexpr std::array<Scan_Function, selection_count> scan_table{
+      make_scan_table(std::make_index_sequence<selection_count>{})};
+  counters &= analytics_byte_counters;
+  if (counters == analytics_character_classes) {
+    return &scan_character_classes;
+  }
+  return scan_table[counters];
+}
+
+}  // namespace
+
+PipelineAnalyzer::PipelineAnalyzer(uint16_t counters_val)
+    : scan_{get_scan_function(counters_val)},
+      utf8_analyzer_{},
+      top_words_analyzer_{} {
+  analytics_.counters =
+      static_cast<uint16_t>(counters_val & analytics_all_counters);
+}
+
+void PipelineAnalyzer::update(const char *data, size_t size) {
+  scan_(data, size, analytics_);
+  if ((analytics_.counters & analytics_unicode) != 0U) {
+    utf8_analyzer_.update(data, size);
+    analytics_.unicode = utf8_analyzer_.get_analytics();
+  }
+  if ((analytics_.counters & analytics_top_words) != 0U) {
+    if (!top_words_analyzer_) {
+      top_words_analyzer_ = std::make_unique<TopWordsAnalyzer>();
+    }
+    top_words_analyzer_->update(data, size);
+  }
+}
+
+void PipelineAnalyzer::finish() {
+  if ((analytics_.counters & analytics_top_words) != 0U) {
+    if (!top_words_analyzer_) {
+      top_words_analyzer_ = std::make_unique<TopWordsAnalyzer>();
+    }
+    top_words_analyzer_->finish(analytics_.top_words);
+  }
+}
+
+void PipelineAnalyzer::reset(uint16_t counters) {
+  scan_ = get_scan_function(counters);
+  // The histogram and the top words are cleared only when they were in use
+  const bool clear_histogram =
+      (analytics_.counters & analytics_byte_histogram) != 0U;
+  const bool clear_top_words =
+      (analytics_.counters & analytics_top_words) != 0U;
+  analytics_.counters = static_cast<uint16_t>(counters & analytics_all_counters);
+  analytics_.classes = MessageAnalytics{};
+  analytics_.words_count = 0;
+  analytics_.lines_count = 0;
+  analytics_.code_points_count = 0;
+  analytics_.in_word = false;
+  analytics_.unicode = Utf8_Analytics{};
+  utf8_analyzer_.reset();
+  if (clear_histogram) {
+    analytics_.byte_histogram.fill(0);
+  }
+  if (clear_top_words) {
+    analytics_.top_words = Top_Words_Analytics{};
+  }
+  if (top_words_analyzer_) {
+    top_words_analyzer_->reset();
+  }
+}
+
+const Pipeline_Analytics &PipelineAnalyzer::get_analytics() const {
+  return analytics_;
+}
+
+Pipeline_Analytics calculate_pipeline_analytics(const char *data, size_t size,
+                                                uint16_t counters) {
+  PipelineAnalyzer analyzer{counters};
+  analyzer.update(data, size);
+  analyzer.finish();
+  return analyzer.get_analytics();
+}
+
+}  // namespace WindowsSocketApp
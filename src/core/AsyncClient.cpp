@@ -0,0 +1,570 @@
+#include "../include/AsyncClient.h"
+
+#include <algorithm>
+
+namespace WindowsSocketApp {
+
+AsyncClient::AsyncClient(AsyncEventLoop &loop_val, std::string server_ip_val,
+                         std::string port_val, size_t recv_capacity_val,
+                         bool non_blocking_val)
+    : loop_{&loop_val},
+      server_ip_{std::move(server_ip_val)},
+      port_{std::move(port_val)},
+      recv_buffer_capacity_{recv_capacity_val},
+      non_blocking_{non_blocking_val},
+      connect_options_{},
+      client_initialization_status_{
+          Client_Initialization_Status::NOT_CONNECTED},
+      hints_{},
+      connect_socket_{},
+      next_request_id_{1},
+      next_response_id_{1},
+      binary_analytics_{false},
+      last_response_binary_{false},
+      response_analytics_{},
+      analytics_counters_{0},
+      last_response_counters_{0},
+      pipeline_analytics_{},
+      last_response_batch_{false},
+      last_response_aggregate_{false},
+      aggregate_analytics_{} {
+  hints_.ai_family = default_ai_family;
+  hints_.ai_socktype = default_ai_socktype;
+  hints_.ai_protocol = default_ai_protocol;
+
+  recv_buffer_.reserve(recv_buffer_capacity_);
+}
+
+AsyncClient::~AsyncClient() { close_connection(); }
+
+AsyncClient::AsyncClient(AsyncClient &&source) noexcept = default;
+
+AsyncClient &AsyncClient::operator=(AsyncClient &&other) noexcept {
+  if (this != &other) {
+    // The loop must forget the old socket before it is closed
+    close_connection();
+    loop_ = other.loop_;
+    server_ip_ = std::move(other.server_ip_);
+    port_ = std::move(other.port_);
+    recv_buffer_capacity_ = other.recv_buffer_capacity_;
+    non_blocking_ = other.non_blocking_;
+    connect_options_ = other.connect_options_;
+    client_initialization_status_ = other.client_initialization_status_;
+    hints_ = other.hints_;
+    connect_socket_ = std::move(other.connect_socket_);
+    recv_buffer_ = std::move(other.recv_buffer_);
+    next_request_id_ = other.next_request_id_;
+    next_response_id_ = other.next_response_id_;
+    binary_analytics_ = other.binary_analytics_;
+    last_response_binary_ = other.last_response_binary_;
+    response_analytics_ = other.response_analytics_;
+    analytics_counters_ = other.analytics_counters_;
+    last_response_counters_ = other.last_response_counters_;
+    pipeline_analytics_ = other.pipeline_analytics_;
+    batch_payload_ = std::move(other.batch_payload_);
+    last_response_batch_ = other.last_response_batch_;
+    batch_analytics_ = std::move(other.batch_analytics_);
+    batch_pipeline_analytics_ = std::move(other.batch_pipeline_analytics_);
+    batch_texts_ = std::move(other.batch_texts_);
+    last_response_aggregate_ = other.last_response_aggregate_;
+    aggregate_analytics_ = other.aggregate_analytics_;
+  }
+  return *this;
+}
+
+Task<bool> AsyncClient::connect_to_server() {
+  close_connection();
+  const Resolved_Addresses addresses =
+      get_address_cache().resolve(server_ip_, port_, hints_);
+  if (!addresses) {
+    std::cerr << "Failed to resolve client address and port." << std::endl;
+    co_return false;
+  }
+
+  connect_socket_ = co_await connect_to_fastest_address(
+      *loop_, addresses.get(), connect_options_);
+  if (!connect_socket_.valid()) {
+    // The server may have moved; resolve again on the next attempt
+    get_address_cache().invalidate(server_ip_, port_, hints_);
+    std::cerr << "Unable to connect to server on any available address."
+              << std::endl;
+    co_return false;
+  }
+  if (!non_blocking_ &&
+      !set_socket_non_blocking(connect_socket_.get(), false)) {
+    close_connection();
+    co_return false;
+  }
+  next_request_id_ = 1;
+  next_response_id_ = 1;
+  client_initialization_status_ = Client_Initialization_Status::CONNECTED;
+  co_return true;
+}
+
+bool AsyncClient::adopt_connection(SocketWrapper connection) {
+  close_connection();
+  if (!connection.valid() ||
+      (non_blocking_ && !set_socket_non_blocking(connection.get()))) {
+    return false;
+  }
+  connect_socket_ = std::move(connection);
+  next_request_id_ = 1;
+  next_response_id_ = 1;
+  client_initialization_status_ = Client_Initialization_Status::CONNECTED;
+  return true;
+}
+
+SocketWrapper AsyncClient::release_connection() {
+  SocketWrapper connection{};
+  if (client_initialization_status_ ==
+          Client_Initialization_Status::CONNECTED &&
+      all_responses_received()) {
+    loop_->forget(connect_socket_.get());
+    connection = std::move(connect_socket_);
+  }
+  close_connection();
+  return connection;
+}
+
+void AsyncClient::close_connection() {
+  if (connect_socket_.valid()) {
+    loop_->forget(connect_socket_.get());
+    connect_socket_.close();
+  }
+  client_initialization_status_ = Client_Initialization_Status::NOT_CONNECTED;
+}
+
+Task<bool> AsyncClient::send_all(Send_Segment *segments, size_t segment_count,
+                                 bool log_progress) {
+  size_t total_sent_size{0};
+  skip_sent_bytes(segments, segment_count, 0);
+  while (segment_count > 0) {
+    auto i_send_result =
+        send_segments_once(connect_socket_.get(), segments, segment_count);
+    if (i_send_result == SOCKET_ERROR) {
+      const int error_code = WSAGetLastError();
+      if (is_would_block_error(error_code)) {
+        if (co_await loop_->writable(connect_socket_.get())) {
+          continue;
+        }
+      }
+      std::cout << "send failed with error: " << error_code << std::endl;
+      co_return false;
+    }
+    skip_sent_bytes(segments, segment_count,
+                    static_cast<size_t>(i_send_result));
+    total_sent_size += static_cast<size_t>(i_send_result);
+  }
+  if (log_progress) {
+    std::cout << "Bytes sent: " << total_sent_size << std::endl;
+  }
+  co_return true;
+}
+
+Task<bool> AsyncClient::receive_exactly(char *buffer, size_t size,
+                                        size_t &received_size) {
+  constexpr size_t maximum_read_size{1U << 30U};  // recv() takes an int
+  received_size = 0;
+  while (received_size < size) {
+    const size_t read_size = std::min(size - received_size, maximum_read_size);
+    auto i_receive_result = recv(connect_socket_.get(), buffer + received_size,
+                                 static_cast<int>(read_size), 0);
+    if (i_receive_result == 0) {
+      break;
+    }
+    if (i_receive_result == SOCKET_ERROR) {
+      const int error_code = WSAGetLastError();
+      if (is_would_block_error(error_code)) {
+        if (co_await loop_->readable(connect_socket_.get())) {
+          continue;
+        }
+      }
+      std::cout << "recv failed with error: " << error_code << std::endl;
+      co_return false;
+    }
+    received_size += static_cast<size_t>(i_receive_result);
+  }
+  co_return true;
+}
+
+Task<bool> AsyncClient::send_message(const char *message, size_t message_size,
+                                     bool log_progress) {
+  Send_Segment segment{message, message_size};
+  if (!co_await send_all(&segment, 1, log_progress)) {
+    std::cerr << "Client failed to send message buffer to server." << std::endl;
+    co_return false;
+  }
+  co_return true;
+}
+
+bool AsyncClient::shutdown_message_sending() {
+  if (!shutdown_sending_side(connect_socket_.get())) {
+    std::cerr << "Failed to shutdown client sending side" << std::endl;
+    return false;
+  }
+  client_initialization_status_ =
+      Client_Initialization_Status::SHUTDOWN_FOR_SENDING;
+  return true;
+}
+
+Task<bool> AsyncClient::receive_until_end(bool log_progress) {
+  // Same reads and progress output as receive_until_empty_input()
+  constexpr size_t minimum_read_size{1024};
+  const size_t read_size = std::max(recv_buffer_capacity_, minimum_read_size);
+  last_response_binary_ = false;
+  last_response_batch_ = false;
+  last_response_counters_ = 0;
+  last_response_aggregate_ = false;
+  recv_buffer_.clear();
+  size_t received_size{0};
+  while (true) {
+    recv_buffer_.resize(received_size + read_size);
+    auto i_receive_result =
+        recv(connect_socket_.get(), recv_buffer_.data() + received_size,
+             static_cast<int>(read_size), 0);
+    if (i_receive_result > 0) {
+      if (log_progress) {
+        std::cout << "Bytes received: " << i_receive_result << '\n';
+      }
+      received_size += static_cast<size_t>(i_receive_result);
+      continue;
+    }
+    if (i_receive_result == 0) {
+      if (log_progress) {
+        std::cout << "Connection closing...\n";
+      }
+      break;
+    }
+    const int error_code = WSAGetLastError();
+    if (is_would_block_error(error_code)) {
+      if (co_await loop_->readable(connect_socket_.get())) {
+        continue;
+      }
+    }
+    std::cout << "recv failed with error: " << error_code << std::endl;
+    recv_buffer_.resize(received_size);
+    std::cerr << "Client failed to receive server message." << std::endl;
+    co_return false;
+  }
+  recv_buffer_.resize(received_size);
+  co_return true;
+}
+
+Task<bool> AsyncClient::send_request_frame(const char *message,
+                                           size_t message_size) {
+  if (message_size > max_frame_payload_size) {
+    std::cerr << "Message of " << message_size
+              << " bytes is too large for one frame." << std::endl;
+    co_return false;
+  }
+  Frame_Header header;
+  header.payload_length = static_cast<uint32_t>(message_size);
+  header.type = Frame_Type::REQUEST;
+  header.flags = static_cast<uint16_t>(
+      make_frame_counters_flags(analytics_counters_) |
+      (binary_analytics_ ? frame_flag_binary_analytics : 0));
+  // Taken before the send: its response may be read while the send waits.
+  // A failed send leaves the id used, so the connection is never released
+  // for reuse.
+  header.request_id = next_request_id_++;
+  char encoded_header[frame_header_size];
+  encode_frame_header(header, encoded_header);
+
+  // Header and message leave in one call, without copying the message
+  Send_Segment segments[]{{encoded_header, frame_header_size},
+                          {message, message_size}};
+  if (!co_await send_all(segments, 2, false)) {
+    std::cerr << "Client failed to send request frame." << std::endl;
+    co_return false;
+  }
+  co_return true;
+}
+
+Task<bool> AsyncClient::receive_response_frame() {
+  char encoded_header[frame_header_size];
+  size_t received_size{0};
+  bool received =
+      co_await receive_exactly(encoded_header, frame_header_size,
+                               received_size);
+  if (!received || received_size < frame_header_size) {
+    std::cerr << "Client failed to receive response frame header."
+              << std::endl;
+    co_return false;
+  }
+
+  Frame_Header header;
+  if (decode_frame_header(encoded_header, header) !=
+      Frame_Decode_Status::OK) {
+    std::cerr << "Client received a malformed frame header." << std::endl;
+    co_return false;
+  }
+
+  recv_buffer_.resize(header.payload_length);
+  received = co_await receive_exactly(recv_buffer_.data(),
+                                      recv_buffer_.size(), received_size);
+  if (!received || received_size < recv_buffer_.size()) {
+    std::cerr << "Client failed to receive response frame payload."
+              << std::endl;
+    recv_buffer_.resize(received_size);
+    co_return false;
+  }
+
+  if (header.type == Frame_Type::ERROR_MESSAGE) {
+    std::cerr << "Server rejected request " << header.request_id << ": "
+              << std::string(recv_buffer_.begin(), recv_buffer_.end())
+              << std::endl;
+    co_return false;
+  }
+  if (header.type != Frame_Type::RESPONSE ||
+      header.request_id != next_response_id_) {
+    std::cerr << "Client received an unexpected frame for request "
+              << header.request_id << std::endl;
+    co_return false;
+  }
+  ++next_response_id_;
+
+  last_response_binary_ =
+      (header.flags & frame_flag_binary_analytics) != 0U;
+  last_response_batch_ = (header.flags & frame_flag_batch) != 0U;
+  last_response_counters_ = get_frame_counters(header.flags);
+  last_response_aggregate_ = (header.flags & frame_flag_aggregate) != 0U;
+  if (last_response_aggregate_) {
+    if (last_response_binary_) {
+      if (recv_buffer_.size() != aggregate_analytics_binary_size) {
+        std::cerr << "Client received a malformed aggregate response."
+                  << std::endl;
+        co_return false;
+      }
+      aggregate_analytics_ =
+          decode_aggregate_analytics_binary(recv_buffer_.data());
+    }
+  } else if (last_response_batch_) {
+    if (!decode_batch_response()) {
+      std::cerr << "Client received a malformed batch response." << std::endl;
+      co_return false;
+    }
+  } else if (last_response_binary_ && last_response_counters_ != 0) {
+    if (recv_buffer_.size() !=
+        pipeline_analytics_binary_size(last_response_counters_)) {
+      std::cerr << "Client received a malformed binary analytics response."
+                << std::endl;
+      co_return false;
+    }
+    pipeline_analytics_ = decode_pipeline_analytics_binary(
+        recv_buffer_.data(), last_response_counters_);
+  } else if (last_response_binary_) {
+    if (recv_buffer_.size() != message_analytics_binary_size) {
+      std::cerr << "Client received a malformed binary analytics response."
+                << std::endl;
+      co_return false;
+    }
+    response_analytics_ = decode_message_analytics_binary(recv_buffer_.data());
+  }
+  co_return true;
+}
+
+Task<bool> AsyncClient::request(const char *message, size_t message_size) {
+  if (!co_await send_request_frame(message, message_size)) {
+    co_return false;
+  }
+  const bool received = co_await receive_response_frame();
+  co_return received;
+}
+
+Task<bool> AsyncClient::send_batch_request(
+    const std::vector<std::string> &messages) {
+  // Copied into one payload: batched messages are small, and the copy keeps
+  // the send to three segments whatever their number
+  begin_batch_payload(batch_payload_);
+  for (const auto &message : messages) {
+    append_batch_message(batch_payload_, message.data(), message.size());
+  }
+  if (batch_payload_.size() > max_frame_payload_size) {
+    std::cerr << "Batch of " << batch_payload_.size()
+              << " bytes is too large for one frame." << std::endl;
+    co_return false;
+  }
+
+  Frame_Header header;
+  header.payload_length = static_cast<uint32_t>(batch_payload_.size());
+  header.type = Frame_Type::REQUEST;
+  header.flags = static_cast<uint16_t>(
+      frame_flag_batch | make_frame_counters_flags(analytics_counters_) |
+      (binary_analytics_ ? frame_flag_binary_analytics : 0));
+  header.request_id = next_request_id_++;
+  char encoded_header[frame_header_size];
+  encode_frame_header(header, encoded_header);
+
+  Send_Segment segments[]{{encoded_header, frame_header_size},
+                          {batch_payload_.data(), batch_payload_.size()}};
+  if (!co_await send_all(segments, 2, false)) {
+    std::cerr << "Client failed to send batch request frame." << std::endl;
+    co_return false;
+  }
+  co_return true;
+}
+
+Task<bool> AsyncClient::request_batch(
+    const std::vector<std::string> &messages) {
+  if (!co_await send_batch_request(messages)) {
+    co_return false;
+  }
+  const bool received = co_await receive_response_frame();
+  co_return received;
+}
+
+Task<bool> AsyncClient::send_aggregate_request() {
+  Frame_Header header;
+  header.type = Frame_Type::REQUEST;
+  header.flags = static_cast<uint16_t>(
+      frame_flag_aggregate |
+      (binary_analytics_ ? frame_flag_binary_analytics : 0));
+  header.request_id = next_request_id_++;
+  char encoded_header[frame_header_size];
+  encode_frame_header(header, encoded_header);
+
+  Send_Segment segments[]{{encoded_header, frame_header_size}};
+  if (!co_await send_all(segments, 1, false)) {
+    std::cerr << "Client failed to send aggregate request frame."
+              << std::endl;
+    co_return false;
+  }
+  co_return true;
+}
+
+bool AsyncClient::decode_batch_response() {
+  const char *position = recv_buffer_.data();
+  const char *const end = position + recv_buffer_.size();
+  if (recv_buffer_.size() < batch_count_size) {
+    return false;
+  }
+  const uint32_t count = get_u32(position);
+  position += batch_count_size;
+
+  batch_analytics_.clear();
+  batch_pipeline_analytics_.clear();
+  batch_texts_.clear();
+  const size_t record_size =
+      last_response_counters_ != 0
+          ? pipeline_analytics_binary_size(last_response_counters_)
+          : message_analytics_binary_size;
+  for (uint32_t i = 0; i < count; ++i) {
+    if (last_response_binary_) {
+      if (static_cast<size_t>(end - position) < record_size) {
+        return false;
+      }
+      if (last_response_counters_ != 0) {
+        batch_pipeline_analytics_.push_back(decode_pipeline_analytics_binary(
+            position, last_response_counters_));
+      } else {
+        batch_analytics_.push_back(decode_message_analytics_binary(position));
+      }
+      position += record_size;
+      continue;
+    }
+    if (static_cast<size_t>(end - position) < batch_length_size) {
+      return false;
+    }
+    const uint32_t length = get_u32(position);
+    position += batch_length_size;
+    if (static_cast<size_t>(end - position) < length) {
+      return false;
+    }
+    batch_texts_.emplace_back(position, length);
+    position += length;
+  }
+  return position == end;
+}
+
+Client_Initialization_Status AsyncClient::get_client_init_status() const {
+  return client_initialization_status_;
+}
+
+bool AsyncClient::all_responses_received() const {
+  return next_request_id_ == next_response_id_;
+}
+
+const std::vector<char> &AsyncClient::get_recv_buffer() const {
+  return recv_buffer_;
+}
+
+const MessageAnalytics &AsyncClient::get_response_analytics() const {
+  return response_analytics_;
+}
+
+bool AsyncClient::get_last_response_binary() const {
+  return last_response_binary_;
+}
+
+bool AsyncClient::get_last_response_batch() const {
+  return last_response_batch_;
+}
+
+uint16_t AsyncClient::get_last_response_counters() const {
+  return last_response_counters_;
+}
+
+bool AsyncClient::get_last_response_aggregate() const {
+  return last_response_aggregate_;
+}
+
+const Pipeline_Analytics &AsyncClient::get_pipeline_analytics() const {
+  return pipeline_analytics_;
+}
+
+const std::vector<MessageAnalytics> &AsyncClient::get_batch_analytics()
+    const {
+  return batch_analytics_;
+}
+
+const std::vector<Pipeline_Analytics> &
+AsyncClient::get_batch_pipeline_analytics() const {
+  return batch_pipeline_analytics_;
+}
+
+const std::vector<std::string> &AsyncClient::get_batch_texts() const {
+  return batch_texts_;
+}
+
+const Aggregate_Analytics &AsyncClient::get_aggregate_analytics() const {
+  return aggregate_analytics_;
+}
+
+const Connect_Options &AsyncClient::get_connect_options() const {
+  return connect_options_;
+}
+
+void AsyncClient::set_connect_options(Connect_Options connect_options) {
+  this->connect_options_ = connect_options;
+}
+
+bool AsyncClient::get_binary_analytics() const { return binary_analytics_; }
+
+void AsyncClient::set_binary_analytics(bool binary_analytics) {
+  this->binary_analytics_ = binary_analytics;
+}
+
+uint16_t AsyncClient::get_analytics_counters() const {
+  return analytics_counters_;
+}
+
+void AsyncClient::set_analytics_counters(uint16_t analytics_counters) {
+  this->analytics_counters_ =
+      static_cast<uint16_t>(analytics_counters & analytics_all_counters);
+}
+
+size_t AsyncClient::get_recv_buffer_capacity() const {
+  return recv_buffer_capacity_;
+}
+
+const std::string &AsyncClient::get_port() const { return port_; }
+
+void AsyncClient::set_port(std::string port) { this->port_ = std::move(port); }
+
+const std::string &AsyncClient::get_server_ip() const { return server_ip_; }
+
+void AsyncClient::set_server_ip(std::string server_ip) {
+  this->server_ip_ = std::move(server_ip);
+}
+
+}  // namespace WindowsSocketApp
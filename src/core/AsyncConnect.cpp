@@ -0,0 +1,113 @@
+#include "../include/AsyncConnect.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "../include/WinSockFunctions.h"
+
+namespace WindowsSocketApp {
+
+namespace {
+
+// Families interleaved, starting with the family of the first address
+std::vector<const addrinfo *> interleave_address_families(
+    const addrinfo *addresses) {
+  std::vector<const addrinfo *> preferred;
+  std::vector<const addrinfo *> other;
+  for (const addrinfo *address = addresses; address != nullptr;
+       address = address->ai_next) {
+    (address->ai_family == addresses->ai_family ? preferred : other)
+        .push_back(address);
+  }
+  std::vector<const addrinfo *> ordered;
+  ordered.reserve(preferred.size() + other.size());
+  for (size_t i = 0; i < std::max(preferred.size(), other.size()); ++i) {
+    if (i < preferred.size()) {
+      ordered.push_back(preferred[i]);
+    }
+    if (i < other.size()) {
+      ordered.push_back(other[i]);
+    }
+  }
+  return ordered;
+}
+
+}  // namespace
+
+Task<SocketWrapper> connect_to_fastest_address(AsyncEventLoop &loop,
+                                               const addrinfo *addresses,
+                                               Connect_Options options) {
+  using Clock = AsyncEventLoop::Clock;
+  const std::vector<const addrinfo *> ordered =
+      interleave_address_families(addresses);
+  const auto deadline = Clock::now() + options.timeout;
+  auto next_attempt_at = Clock::now();
+  size_t next_address{0};
+  // Connects in progress
+  std::vector<SocketWrapper> attempts;
+  SocketWrapper winner{};
+
+  while (!winner.valid() && Clock::now() < deadline) {
+    if (next_address < ordered.size() &&
+        (attempts.empty() || Clock::now() >= next_attempt_at)) {
+      const addrinfo &address = *ordered[next_address++];
+      SocketWrapper attempt{create_socket(
+          address.ai_family, address.ai_socktype, address.ai_protocol)};
+      if (!attempt.valid() || !set_socket_non_blocking(attempt.get())) {
+        continue;
+      }
+      if (SOCKET_ERROR != connect(attempt.get(), address.ai_addr,
+                                  static_cast<int>(address.ai_addrlen))) {
+        winner = std::move(attempt);
+        break;
+      }
+      if (!is_connect_in_progress_error(WSAGetLastError())) {
+        continue;
+      }
+      attempts.push_back(std::move(attempt));
+      next_attempt_at = Clock::now() + options.attempt_delay;
+    }
+    if (attempts.empty()) {
+      break;  // Every address failed
+    }
+
+    std::vector<SOCKET> sockets;
+    sockets.reserve(attempts.size());
+    for (const auto &attempt : attempts) {
+      sockets.push_back(attempt.get());
+    }
+    const auto wake_at = next_address < ordered.size()
+                             ? std::min(next_attempt_at, deadline)
+                             : deadline;
+    const bool waited =
+        co_await loop.any_writable(std::move(sockets), wake_at);
+    if (!waited) {
+      break;
+    }
+
+    for (size_t i = 0; i < attempts.size();) {
+      const SOCKET attempt = attempts[i].get();
+      if (!is_socket_writable(attempt)) {
+        ++i;
+        continue;
+      }
+      if (get_pending_socket_error(attempt) == 0) {
+        winner = std::move(attempts[i]);
+        attempts.erase(attempts.begin() + static_cast<std::ptrdiff_t>(i));
+        break;
+      }
+      // Failed; the next address need not wait for the attempt delay
+      loop.forget(attempt);
+      attempts.erase(attempts.begin() + static_cast<std::ptrdiff_t>(i));
+      next_attempt_at = Clock::now();
+    }
+  }
+
+  // The losers are closed by their wrappers
+  for (const auto &attempt : attempts) {
+    loop.forget(attempt.get());
+  }
+  co_return std::move(winner);
+}
+
+}  // namespace WindowsSocketApp
@@ -0,0 +1,262 @@
+#include "../include/AsyncEventLoop.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "../include/WinSockFunctions.h"
+
+namespace WindowsSocketApp {
+
+namespace {
+
+Task<void> mark_finished(Task<void> task, bool &finished) {
+  co_await std::move(task);
+  finished = true;
+}
+
+}  // namespace
+
+AsyncEventLoop::AsyncEventLoop(int max_events_val)
+    : poller_{},
+      max_events_{max_events_val},
+#ifdef __linux__
+      events_(static_cast<size_t>(max_events_val)),
+#endif
+      waiting_count_{0},
+      active_task_count_{0} {}
+
+AsyncEventLoop::Detached_Task AsyncEventLoop::run_detached(
+    AsyncEventLoop &loop, Task<void> task) {
+  co_await std::move(task);
+  --loop.active_task_count_;
+}
+
+void AsyncEventLoop::spawn(Task<void> task) {
+  ++active_task_count_;
+  run_detached(*this, std::move(task));
+}
+
+bool AsyncEventLoop::run() {
+  while (active_task_count_ > 0) {
+    if (waiting_count_ == 0 && timers_.empty()) {
+      std::cerr << "Async tasks are waiting on something other than a socket"
+                << std::endl;
+      return false;
+    }
+    if (!wait_and_dispatch()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool AsyncEventLoop::run_until_complete(Task<void> task) {
+  bool finished{false};
+  spawn(mark_finished(std::move(task), finished));
+  run();
+  return finished;
+}
+
+bool AsyncEventLoop::add_waiter(SOCKET socket, bool for_writing,
+                                std::coroutine_handle<> waiting) {
+#ifdef __linux__
+  if (!poller_.valid()) {
+    poller_ = SocketWrapper{epoll_create1(EPOLL_CLOEXEC)};
+    if (!poller_.valid()) {
+      std::cerr << "Failed to create epoll instance: " << errno << std::endl;
+      return false;
+    }
+  }
+#endif
+  Socket_Waiters &waiters = waiters_[socket];
+#ifdef __linux__
+  if (!waiters.registered) {
+    // Both directions once, edge-triggered: a waiter only ever waits after a
+    // call that would have blocked, so the next edge is still to come.
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    event.data.fd = socket;
+    if (epoll_ctl(poller_.get(), EPOLL_CTL_ADD, socket, &event) == -1) {
+      std::cerr << "epoll_ctl failed with error: " << errno << std::endl;
+      return false;
+    }
+    waiters.registered = true;
+  }
+#endif
+  (for_writing ? waiters.writer : waiters.reader) = waiting;
+  ++waiting_count_;
+  return true;
+}
+
+void AsyncEventLoop::remove_waiter(SOCKET socket, bool for_writing,
+                                   std::coroutine_handle<> waiting) {
+  auto it = waiters_.find(socket);
+  if (it == waiters_.end()) {
+    return;
+  }
+  auto &waiter = for_writing ? it->second.writer : it->second.reader;
+  if (waiter == waiting) {
+    waiter = nullptr;
+    --waiting_count_;
+  }
+}
+
+void AsyncEventLoop::remove_timer(Clock::time_point deadline,
+                                  std::coroutine_handle<> waiting) {
+  auto [first, last] = timers_.equal_range(deadline);
+  for (auto it = first; it != last; ++it) {
+    if (it->second == waiting) {
+      timers_.erase(it);
+      return;
+    }
+  }
+}
+
+bool AsyncEventLoop::Any_Writable_Awaiter::await_suspend(
+    std::coroutine_handle<> waiting_val) {
+  waiting = waiting_val;
+  for (const SOCKET socket : sockets) {
+    if (!loop.add_waiter(socket, true, waiting)) {
+      await_resume();
+      return false;
+    }
+  }
+  loop.timers_.emplace(deadline, waiting);
+  waited = true;
+  return true;
+}
+
+bool AsyncEventLoop::Any_Writable_Awaiter::await_resume() {
+  for (const SOCKET socket : sockets) {
+    loop.remove_waiter(socket, true, waiting);
+  }
+  loop.remove_timer(deadline, waiting);
+  return waited;
+}
+
+void AsyncEventLoop::forget(SOCKET socket) {
+  auto it = waiters_.find(socket);
+  if (it == waiters_.end()) {
+    return;
+  }
+  waiting_count_ -= (it->second.reader ? 1 : 0) + (it->second.writer ? 1 : 0);
+#ifdef __linux__
+  // The socket may live on, e.g. in a ConnectionPool, and be waited on again
+  if (it->second.registered) {
+    epoll_ctl(poller_.get(), EPOLL_CTL_DEL, socket, nullptr);
+  }
+#endif
+  waiters_.erase(it);
+}
+
+bool AsyncEventLoop::wait_and_dispatch() {
+  // Resumed only after the scan: a resumed coroutine may change waiters_
+  std::vector<std::coroutine_handle<>> ready;
+  const auto take_ready = [this, &ready](Socket_Waiters &waiters,
+                                         bool readable, bool writable) {
+    if (readable && waiters.reader) {
+      ready.push_back(std::exchange(waiters.reader, nullptr));
+    }
+    if (writable && waiters.writer) {
+      ready.push_back(std::exchange(waiters.writer, nullptr));
+    }
+  };
+
+  // Milliseconds until the earliest deadline, rounded up; -1 waits forever
+  int timeout{-1};
+  if (!timers_.empty()) {
+    const auto remaining = timers_.begin()->first - Clock::now();
+    timeout = static_cast<int>(std::max<long long>(
+        std::chrono::ceil<std::chrono::milliseconds>(remaining).count(), 0));
+  }
+
+#ifdef __linux__
+  int ready_count{0};
+  if (poller_.valid()) {
+    ready_count =
+        epoll_wait(poller_.get(), events_.data(), max_events_, timeout);
+  } else {
+    // No socket was ever waited on; only timers are pending
+    std::this_thread::sleep_for(std::chrono::milliseconds{timeout});
+  }
+  if (ready_count == -1) {
+    if (errno == EINTR) {
+      return true;
+    }
+    std::cerr << "epoll_wait failed with error: " << errno << std::endl;
+    return false;
+  }
+  for (int i = 0; i < ready_count; ++i) {
+    auto it = waiters_.find(events_[i].data.fd);
+    if (it == waiters_.end()) {
+      continue;
+    }
+    const uint32_t flags = events_[i].events;
+    const bool failed = (flags & (EPOLLERR | EPOLLHUP)) != 0U;
+    take_ready(it->second,
+               failed || (flags & (EPOLLIN | EPOLLRDHUP)) != 0U,
+               failed || (flags & EPOLLOUT) != 0U);
+  }
+#else
+  std::vector<pollfd> descriptors;
+  for (const auto &[socket, waiters] : waiters_) {
+    short events{0};
+    if (waiters.reader) {
+      events |= POLLIN;
+    }
+    if (waiters.writer) {
+      events |= POLLOUT;
+    }
+    if (events != 0) {
+      descriptors.push_back(pollfd{socket, events, 0});
+    }
+  }
+  int ready_count{0};
+  if (descriptors.empty()) {
+    // WSAPoll rejects an empty set; only timers are pending
+    std::this_thread::sleep_for(std::chrono::milliseconds{timeout});
+  } else {
+#ifdef _WIN32
+    ready_count = WSAPoll(descriptors.data(),
+                          static_cast<ULONG>(descriptors.size()), timeout);
+#else
+    ready_count = poll(descriptors.data(),
+                       static_cast<nfds_t>(descriptors.size()), timeout);
+#endif
+  }
+  if (ready_count == SOCKET_ERROR) {
+    std::cerr << "poll failed with error: " << WSAGetLastError() << std::endl;
+    return false;
+  }
+  for (const auto &descriptor : descriptors) {
+    const bool failed = (descriptor.revents & (POLLERR | POLLHUP)) != 0;
+    take_ready(waiters_[descriptor.fd],
+               failed || (descriptor.revents & POLLIN) != 0,
+               failed || (descriptor.revents & POLLOUT) != 0);
+  }
+#endif
+
+  waiting_count_ -= ready.size();
+  const auto now = Clock::now();
+  while (!timers_.empty() && timers_.begin()->first <= now) {
+    ready.push_back(timers_.begin()->second);
+    timers_.erase(timers_.begin());
+  }
+  // A coroutine waiting on several sockets may be ready more than once
+  std::sort(ready.begin(), ready.end(),
+            [](std::coroutine_handle<> lhs, std::coroutine_handle<> rhs) {
+              return lhs.address() < rhs.address();
+            });
+  ready.erase(std::unique(ready.begin(), ready.end()), ready.end());
+  for (const auto handle : ready) {
+    handle.resume();
+  }
+  return true;
+}
+
+size_t AsyncEventLoop::get_active_task_count() const {
+  return active_task_count_;
+}
+
+}  // namespace WindowsSocketApp
@@ -0,0 +1,178 @@
+#include "../include/BufferPool.h"
+
+#include <cstring>
+#include <new>
+
+namespace WindowsSocketApp {
+
+namespace {
+
+constexpr std::align_val_t buffer_alignment{BufferPool::cache_line_size};
+
+size_t size_class_for(size_t size) {
+  size_t size_class{0};
+  while (BufferPool::get_class_buffer_size(size_class) < size) {
+    ++size_class;
+  }
+  return size_class;
+}
+
+}  // namespace
+
+thread_local BufferPool::Thread_Cache BufferPool::thread_cache_;
+
+PooledBuffer::~PooledBuffer() { release(); }
+
+PooledBuffer::PooledBuffer(PooledBuffer &&source) noexcept
+    : data_{source.data_}, size_{source.size_} {
+  source.data_ = nullptr;
+  source.size_ = 0;
+}
+
+PooledBuffer &PooledBuffer::operator=(PooledBuffer &&rhs) noexcept {
+  if (this != &rhs) {
+    release();
+    data_ = rhs.data_;
+    size_ = rhs.size_;
+    rhs.data_ = nullptr;
+    rhs.size_ = 0;
+  }
+  return *this;
+}
+
+void PooledBuffer::release() {
+  if (data_ != nullptr) {
+    get_buffer_pool().release_buffer(data_, size_);
+    data_ = nullptr;
+    size_ = 0;
+  }
+}
+
+void BufferPool::Free_List::push(char *buffer) {
+  std::memcpy(buffer, &head, sizeof(head));
+  head = buffer;
+  ++count;
+}
+
+char *BufferPool::Free_List::pop() {
+  char *buffer = head;
+  std::memcpy(&head, buffer, sizeof(head));
+  --count;
+  return buffer;
+}
+
+BufferPool::Thread_Cache::~Thread_Cache() {
+  for (size_t size_class = 0; size_class < size_class_count; ++size_class) {
+    Free_List &cache = free_buffers[size_class];
+    if (cache.count > 0) {
+      get_buffer_pool().drain(size_class, cache, cache.count);
+    }
+  }
+}
+
+BufferPool::BufferPool() : oversized_buffer_count_{0} {}
+
+BufferPool::~BufferPool() {
+  for (char *slab : slabs_) {
+    ::operator delete(slab, buffer_alignment);
+  }
+}
+
+PooledBuffer BufferPool::acquire(size_t minimum_size) {
+  if (minimum_size > largest_buffer_size) {
+    oversized_buffer_count_.fetch_add(1, std::memory_order_relaxed);
+    return PooledBuffer{
+        static_cast<char *>(::operator new(minimum_size, buffer_alignment)),
+        minimum_size};
+  }
+  const size_t size_class = size_class_for(minimum_size);
+  return PooledBuffer{allocate(size_class), get_class_buffer_size(size_class)};
+}
+
+void BufferPool::release_buffer(char *buffer, size_t size) {
+  if (size > largest_buffer_size) {
+    ::operator delete(buffer, buffer_alignment);
+    oversized_buffer_count_.fetch_sub(1, std::memory_order_relaxed);
+    return;
+  }
+  deallocate(buffer, size_class_for(size));
+}
+
+char *BufferPool::allocate(size_t size_class) {
+  Free_List &cache = thread_cache_.free_buffers[size_class];
+  if (cache.count == 0) {
+    refill(size_class, cache);
+  }
+  return cache.pop();
+}
+
+void BufferPool::deallocate(char *buffer, size_t size_class) {
+  Free_List &cache = thread_cache_.free_buffers[size_class];
+  cache.push(buffer);
+  if (cache.count > thread_cache_capacity) {
+    // Keep half, so a thread alternating between borrowing and returning
+    // does not bounce on the shared lock.
+    drain(size_class, cache, cache.count / 2);
+  }
+}
+
+void BufferPool::refill(size_t size_class, Free_List &cache) {
+  Size_Class &shared = size_classes_[size_class];
+  std::lock_guard<std::mutex> lock{shared.mutex};
+  const size_t batch = thread_cache_capacity / 2;
+  while (cache.count < batch && shared.free_buffers.count > 0) {
+    cache.push(shared.free_buffers.pop());
+  }
+  if (cache.count == 0) {
+    // Buffers are carved one at a time, so untouched parts of a slab do not
+    // become resident.
+    cache.push(carve_from_slab(size_class));
+  }
+}
+
+void BufferPool::drain(size_t size_class, Free_List &cache, size_t count) {
+  Size_Class &shared = size_classes_[size_class];
+  std::lock_guard<std::mutex> lock{shared.mutex};
+  for (size_t i = 0; i < count; ++i) {
+    shared.free_buffers.push(cache.pop());
+  }
+}
+
+char *BufferPool::carve_from_slab(size_t size_class) {
+  // Called with the size class mutex held
+  Size_Class &shared = size_classes_[size_class];
+  const size_t buffer_size = get_class_buffer_size(size_class);
+  if (shared.slab_cursor == shared.slab_end) {
+    auto *slab = static_cast<char *>(::operator new(slab_size,
+                                                    buffer_alignment));
+    {
+      std::lock_guard<std::mutex> lock{slabs_mutex_};
+      slabs_.push_back(slab);
+    }
+    shared.slab_cursor = slab;
+    shared.slab_end = slab + slab_size;
+  }
+  char *buffer = shared.slab_cursor;
+  shared.slab_cursor += buffer_size;
+  return buffer;
+}
+
+size_t BufferPool::get_slab_count() {
+  std::lock_guard<std::mutex> lock{slabs_mutex_};
+  return slabs_.size();
+}
+
+size_t BufferPool::get_oversized_buffer_count() const {
+  return oversized_buffer_count_.load(std::memory_order_relaxed);
+}
+
+size_t BufferPool::get_class_buffer_size(size_t size_class) {
+  return smallest_buffer_size << (2 * size_class);
+}
+
+BufferPool &get_buffer_pool() {
+  static BufferPool buffer_pool;
+  return buffer_pool;
+}
+
+}  // namespace WindowsSocketApp
@@ -0,0 +1,77 @@
+#include "../include/ByteRingBuffer.h"
+
+#include <algorithm>
+
+namespace WindowsSocketApp {
+
+ByteRingBuffer::ByteRingBuffer(size_t capacity_val)
+    : storage_{get_buffer_pool().acquire(capacity_val)},
+      read_position_{0},
+      write_position_{0},
+      used_size_{0},
+      writer_closed_{false},
+      aborted_{false} {}
+
+ByteRingBuffer::Region ByteRingBuffer::acquire_write_region() {
+  std::unique_lock<std::mutex> lock{state_mutex_};
+  state_changed_.wait(
+      lock, [this] { return aborted_ || used_size_ < storage_.size(); });
+  if (aborted_) {
+    return Region{nullptr, 0};
+  }
+  // Free space runs up to the read position or to the end of the storage.
+  const size_t free_size = storage_.size() - used_size_;
+  const size_t contiguous_size =
+      std::min(free_size, storage_.size() - write_position_);
+  return Region{storage_.data() + write_position_, contiguous_size};
+}
+
+void ByteRingBuffer::commit_write(size_t byte_count) {
+  {
+    std::lock_guard<std::mutex> lock{state_mutex_};
+    write_position_ = (write_position_ + byte_count) % storage_.size();
+    used_size_ += byte_count;
+  }
+  state_changed_.notify_all();
+}
+
+void ByteRingBuffer::close_writer() {
+  {
+    std::lock_guard<std::mutex> lock{state_mutex_};
+    writer_closed_ = true;
+  }
+  state_changed_.notify_all();
+}
+
+ByteRingBuffer::Region ByteRingBuffer::acquire_read_region() {
+  std::unique_lock<std::mutex> lock{state_mutex_};
+  state_changed_.wait(
+      lock, [this] { return aborted_ || writer_closed_ || used_size_ > 0; });
+  if (aborted_ || used_size_ == 0) {
+    return Region{nullptr, 0};
+  }
+  const size_t contiguous_size =
+      std::min(used_size_, storage_.size() - read_position_);
+  return Region{storage_.data() + read_position_, contiguous_size};
+}
+
+void ByteRingBuffer::commit_read(size_t byte_count) {
+  {
+    std::lock_guard<std::mutex> lock{state_mutex_};
+    read_position_ = (read_position_ + byte_count) % storage_.size();
+    used_size_ -= byte_count;
+  }
+  state_changed_.notify_all();
+}
+
+void ByteRingBuffer::abort() {
+  {
+    std::lock_guard<std::mutex> lock{state_mutex_};
+    aborted_ = true;
+  }
+  state_changed_.notify_all();
+}
+
+size_t ByteRingBuffer::get_capacity() const { return storage_.size(); }
+
+}  // namespace WindowsSocketApp
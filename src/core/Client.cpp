@@ -1,97 +1,89 @@
 #include "../include/Client.h"
 
+#include <type_traits>
+
+#include "../include/ConnectionPool.h"
+
 namespace WindowsSocketApp {
 
 Client::Client(std::string send_buff_val, size_t recv_capacity_val,
                std::string server_ip_val, std::string port_val)
     : send_buffer_{std::move(send_buff_val)},
-      recv_buffer_capacity_{recv_capacity_val},
-      server_ip_{std::move(server_ip_val)},
-      port_{std::move(port_val)},
-      client_initialization_status_{
-          Client_Initialization_Status::NOT_CONNECTED},
-      client_sockaddr_struct_state_{Sockaddr_Struct_State::EMPTY},
-      result_{nullptr},
-      addrinfo_ptr_{nullptr},
-      hints_{},
-      connect_socket_{} {
-  hints_.ai_family = default_ai_family;
-  hints_.ai_socktype = default_ai_socktype;
-  hints_.ai_protocol = default_ai_protocol;
-
-  recv_buffer_.reserve(recv_buffer_capacity_);
+      event_loop_{std::make_unique<AsyncEventLoop>()},
+      async_client_{*event_loop_, std::move(server_ip_val),
+                    std::move(port_val), recv_capacity_val, false} {}
+
+Client &Client::operator=(Client &&other) noexcept {
+  if (this != &other) {
+    // The old connection leaves its event loop before the loop is destroyed
+    async_client_ = std::move(other.async_client_);
+    event_loop_ = std::move(other.event_loop_);
+    send_buffer_ = std::move(other.send_buffer_);
+  }
+  return *this;
+}
+
+bool Client::run_blocking(Task<bool> task) {
+  return event_loop_->run_until_complete(std::move(task)).value_or(false);
 }
 
 void Client::connect_to_server() {
-  if (!resolve_address_and_port(server_ip_.c_str(), port_.c_str(), &hints_,
-                                result_)) {
-    std::cerr << "Failed to resolve client address and port." << std::endl;
-    return;
+  if (run_blocking(async_client_.connect_to_server())) {
+    std::cout << "Client successfully connected to server." << std::endl;
   }
-  client_sockaddr_struct_state_ = Sockaddr_Struct_State::CREATED;
+}
 
-  if (!result_) {
-    std::cerr << "Error: result_ pointer to addrinfo is null after client "
-                 "address resolution."
+void Client::connect_to_server(ConnectionPool &pool) {
+  if (!async_client_.adopt_connection(pool.acquire(
+          async_client_.get_server_ip(), async_client_.get_port()))) {
+    std::cerr << "Unable to get a pooled connection to the server."
               << std::endl;
-    return;
   }
+}
 
-  // Attempt to connect to an address until one succeeds
-  for (addrinfo_ptr_ = result_.get(); addrinfo_ptr_ != nullptr;
-       addrinfo_ptr_ = addrinfo_ptr_->ai_next) {
-    connect_socket_ = SocketWrapper(create_socket(addrinfo_ptr_->ai_family,
-                                                  addrinfo_ptr_->ai_socktype,
-                                                  addrinfo_ptr_->ai_protocol));
-    if (!connect_socket_.valid()) {
-      std::cerr << "Failed to create client socket." << std::endl;
-      continue;
-    }
-
-    if (SOCKET_ERROR == connect(connect_socket_.get(), addrinfo_ptr_->ai_addr,
-                                static_cast<int>(addrinfo_ptr_->ai_addrlen))) {
-      connect_socket_.close();
-      continue;
-    }
-    // Connection successful!
-    break;
+void Client::release_connection(ConnectionPool &pool) {
+  SocketWrapper connection = async_client_.release_connection();
+  if (connection.valid()) {
+    pool.release(async_client_.get_server_ip(), async_client_.get_port(),
+                 std::move(connection));
   }
-  if (!connect_socket_.valid()) {
-    std::cerr << "Unable to connect to server on any available address."
-              << std::endl;
-    return;
-  }
-  result_.reset();
-  client_sockaddr_struct_state_ = Sockaddr_Struct_State::EMPTY;
-  client_initialization_status_ = Client_Initialization_Status::CONNECTED;
-  std::cout << "Client successfully connected to server." << std::endl;
 }
 
-void Client::send_buffer_to_server() const {
-  if (!send_buffer_content(connect_socket_.get(), send_buffer_)) {
-    std::cerr << "Client failed to send message buffer to server." << std::endl;
-  }
+void Client::send_buffer_to_server() {
+  run_blocking(
+      async_client_.send_message(send_buffer_.data(), send_buffer_.size()));
 }
 
 void Client::shutdown_message_sending() {
-  if (!shutdown_sending_side(connect_socket_.get())) {
-    std::cerr << "Failed to shutdown client sending side" << std::endl;
-  } else {
-    client_initialization_status_ =
-        Client_Initialization_Status::SHUTDOWN_FOR_SENDING;
-  }
+  async_client_.shutdown_message_sending();
 }
 
 void Client::receive_server_message() {
-  recv_buffer_.clear();
-  recv_buffer_.resize(recv_buffer_capacity_);
-  if (!receive_until_empty_input(connect_socket_.get(), recv_buffer_)) {
-    std::cerr << "Client failed to receive server message." << std::endl;
-  }
+  run_blocking(async_client_.receive_until_end());
+}
+
+bool Client::send_request_frame() {
+  return send_request_frame(send_buffer_.data(), send_buffer_.size());
+}
+
+bool Client::send_request_frame(const char *message, size_t message_size) {
+  return run_blocking(async_client_.send_request_frame(message, message_size));
+}
+
+bool Client::receive_response_frame() {
+  return run_blocking(async_client_.receive_response_frame());
+}
+
+bool Client::send_batch_request(const std::vector<std::string> &messages) {
+  return run_blocking(async_client_.send_batch_request(messages));
+}
+
+bool Client::send_aggregate_request() {
+  return run_blocking(async_client_.send_aggregate_request());
 }
 
 Client_Initialization_Status Client::get_client_init_status() const {
-  return client_initialization_status_;
+  return async_client_.get_client_init_status();
 }
 
 const std::string &Client::get_send_message_buffer() const {
@@ -103,24 +95,126 @@ void Client::set_send_message_buffer(std::string send_message_buffer) {
 }
 
 void Client::display_recv_buffer() const {
-  for (const auto c : recv_buffer_) {
+  // Binary records are shown as text
+  const auto write_text = [](const auto &analytics) {
+    std::string text;
+    if constexpr (std::is_same_v<std::decay_t<decltype(analytics)>,
+                                 Pipeline_Analytics>) {
+      append_pipeline_analytics_text(analytics, text);
+    } else {
+      Analytics_Text_Buffer buffer;
+      text.assign(buffer.data(), write_message_analytics_text(analytics, buffer));
+    }
+    return text;
+  };
+  const bool binary{async_client_.get_last_response_binary()};
+  if (binary && async_client_.get_last_response_aggregate()) {
+    std::string text;
+    append_aggregate_analytics_text(get_aggregate_analytics(), text);
+    std::cout << text << " (binary response)" << std::endl;
+    return;
+  }
+  if (async_client_.get_last_response_batch()) {
+    std::vector<std::string> records;
+    if (!binary) {
+      records = get_batch_texts();
+    } else if (async_client_.get_last_response_counters() != 0) {
+      for (const auto &analytics :
+           get_batch_pipeline_analytics()) {
+        records.push_back(write_text(analytics));
+      }
+    } else {
+      for (const auto &analytics : get_batch_analytics()) {
+        records.push_back(write_text(analytics));
+      }
+    }
+    for (size_t i = 0; i < records.size(); ++i) {
+      std::cout << "[" << i << "] " << records[i] << std::endl;
+    }
+    std::cout << "(" << records.size() << " record batch response"
+              << (binary ? ", binary)" : ")") << std::endl;
+    return;
+  }
+  if (binary) {
+    std::cout << (async_client_.get_last_response_counters() != 0
+                      ? write_text(get_pipeline_analytics())
+                      : write_text(get_response_analytics()))
+              << " (binary response)" << std::endl;
+    return;
+  }
+  for (const auto c : async_client_.get_recv_buffer()) {
     std::cout << c;
   }
   std::cout << std::endl;
 }
 
+const MessageAnalytics &Client::get_response_analytics() const {
+  return async_client_.get_response_analytics();
+}
+
+const Pipeline_Analytics &Client::get_pipeline_analytics() const {
+  return async_client_.get_pipeline_analytics();
+}
+
+const std::vector<MessageAnalytics> &Client::get_batch_analytics() const {
+  return async_client_.get_batch_analytics();
+}
+
+const std::vector<Pipeline_Analytics> &Client::get_batch_pipeline_analytics()
+    const {
+  return async_client_.get_batch_pipeline_analytics();
+}
+
+const std::vector<std::string> &Client::get_batch_texts() const {
+  return async_client_.get_batch_texts();
+}
+
+const Aggregate_Analytics &Client::get_aggregate_analytics() const {
+  return async_client_.get_aggregate_analytics();
+}
+
+const Connect_Options &Client::get_connect_options() const {
+  return async_client_.get_connect_options();
+}
+
+void Client::set_connect_options(Connect_Options connect_options) {
+  async_client_.set_connect_options(connect_options);
+}
+
+bool Client::get_binary_analytics() const {
+  return async_client_.get_binary_analytics();
+}
+
+void Client::set_binary_analytics(bool binary_analytics) {
+  async_client_.set_binary_analytics(binary_analytics);
+}
+
+uint16_t Client::get_analytics_counters() const {
+  return async_client_.get_analytics_counters();
+}
+
+void Client::set_analytics_counters(uint16_t analytics_counters) {
+  async_client_.set_analytics_counters(analytics_counters);
+}
+
 size_t Client::get_recv_buffer_capacity() const {
-  return recv_buffer_capacity_;
+  return async_client_.get_recv_buffer_capacity();
 }
 
-const std::string &Client::get_port() const { return port_; }
+const std::string &Client::get_port() const {
+  return async_client_.get_port();
+}
 
-void Client::set_port(std::string port) { this->port_ = std::move(port); }
+void Client::set_port(std::string port) {
+  async_client_.set_port(std::move(port));
+}
 
-const std::string &Client::get_server_ip() const { return server_ip_; }
+const std::string &Client::get_server_ip() const {
+  return async_client_.get_server_ip();
+}
 
 void Client::set_server_ip(std::string server_ip) {
-  this->server_ip_ = std::move(server_ip);
+  async_client_.set_server_ip(std::move(server_ip));
 }
 
-}  // namespace WindowsSocketApp
\ No newline at end of file
+}  // namespace WindowsSocketApp
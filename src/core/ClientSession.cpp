@@ -0,0 +1,307 @@
+#include "../include/ClientSession.h"
+
+#include "../include/AnalyticsCache.h"
+#include "../include/AnalyticsEncoding.h"
+#include "../include/AnalyticsLog.h"
+#include "../include/BufferPool.h"
+#include "../include/ConnectionProtocol.h"
+#include "../include/FlowControl.h"
+#include "../include/ServerMetrics.h"
+#include "../include/StreamingReceiver.h"
+
+namespace WindowsSocketApp {
+
+ClientSession::ClientSession()
+    : recv_buffer_capacity_{default_recv_buffer_capacity},
+      log_progress_{true},
+      receive_mode_{Session_Receive_Mode::BUFFERED},
+      echo_message_{false},
+      client_socket_{},
+      accepted_at_{std::chrono::steady_clock::now()} {}
+
+ClientSession::ClientSession(SocketWrapper client_socket_val,
+                             size_t recv_capacity_val, bool log_progress_val,
+                             Session_Receive_Mode receive_mode_val)
+    : recv_buffer_capacity_{recv_capacity_val},
+      log_progress_{log_progress_val},
+      receive_mode_{receive_mode_val},
+      echo_message_{false},
+      client_socket_{std::move(client_socket_val)},
+      accepted_at_{std::chrono::steady_clock::now()} {}
+
+void ClientSession::record_receive_error() const {
+  get_server_metrics().local().count_error(WSAGetLastError());
+}
+
+void ClientSession::record_send_error() const {
+  const int error_code = WSAGetLastError();
+  if (is_send_timeout_error(error_code)) {
+    get_server_metrics().local().count_slow_reader_closed();
+  } else {
+    get_server_metrics().local().count_error(error_code);
+  }
+}
+
+bool ClientSession::receive_client_message() {
+  const Stage_Timer receive_timer{Server_Stage::RECEIVE};
+  analyzer_.reset();
+  if (receive_mode_ == Session_Receive_Mode::STREAMING) {
+    const StreamingReceiver receiver{StreamingReceiver::default_ring_capacity,
+                                     log_progress_};
+    if (!receiver.receive_and_analyze(client_socket_.get(), analyzer_)) {
+      record_receive_error();
+      std::cerr << "Failed to receive client message" << std::endl;
+      return false;
+    }
+    get_server_metrics().local().add_bytes_received(
+        analyzer_.get_analytics().length);
+    return true;
+  }
+
+  recv_buffer_.clear();
+  recv_buffer_.resize(recv_buffer_capacity_);
+
+  const size_t max_message_size =
+      get_flow_control().get_limits().max_buffered_message_bytes;
+  if (!receive_until_empty_input(client_socket_.get(), recv_buffer_,
+                                 log_progress_, max_message_size)) {
+    if (recv_buffer_.size() > max_message_size) {
+      get_server_metrics().local().count_oversized_message();
+      // The message is not kept
+      recv_buffer_ = std::vector<char>{};
+    } else {
+      record_receive_error();
+    }
+    std::cerr << "Failed to receive client message" << std::endl;
+    return false;
+  }
+  get_server_metrics().local().add_bytes_received(recv_buffer_.size());
+  return true;
+}
+
+void ClientSession::calculate_recv_message_analytics() {
+  const Stage_Timer analyze_timer{Server_Stage::ANALYZE};
+  Analytics_Text_Buffer text;
+  // A streamed message was already analyzed while it was received.
+  if (receive_mode_ == Session_Receive_Mode::BUFFERED) {
+    AnalyticsCache &cache = get_analytics_cache();
+    const bool use_cache = cache.accepts(recv_buffer_.size());
+    Analytics_Cache_Key key{};
+    if (use_cache) {
+      key = make_analytics_cache_key(recv_buffer_.data(), recv_buffer_.size());
+      MessageAnalytics cached_analytics;
+      const size_t cached_length =
+          cache.find(key, false, text, cached_analytics);
+      if (cached_length > 0) {
+        recv_message_analytics_.assign(text.data(), cached_length);
+        Thread_Metrics &metrics = get_server_metrics().local();
+        metrics.count_message_analyzed();
+        metrics.add_message_analytics(cached_analytics);
+        get_analytics_log().append(cached_analytics);
+        return;
+      }
+    }
+    analyzer_.reset();
+    analyzer_.update(recv_buffer_.data(), recv_buffer_.size());
+    if (use_cache) {
+      cache.insert(key, analyzer_.get_analytics());
+    }
+  }
+  const size_t text_length =
+      write_message_analytics_text(analyzer_.get_analytics(), text);
+  recv_message_analytics_.assign(text.data(), text_length);
+  Thread_Metrics &metrics = get_server_metrics().local();
+  metrics.count_message_analyzed();
+  metrics.add_message_analytics(analyzer_.get_analytics());
+  get_analytics_log().append(analyzer_.get_analytics());
+}
+
+bool ClientSession::send_segments_to_client(Send_Segment *segments,
+                                            size_t segment_count) {
+  const Stage_Timer send_timer{Server_Stage::SEND};
+  size_t byte_count{0};
+  for (size_t i = 0; i < segment_count; ++i) {
+    byte_count += segments[i].size;
+  }
+  bool sent{false};
+  if (zero_copy_sender_) {
+    sent = zero_copy_sender_->send(segments, segment_count, log_progress_);
+  } else {
+    sent = send_segments(client_socket_.get(), segments, segment_count,
+                         log_progress_);
+  }
+  Thread_Metrics &metrics = get_server_metrics().local();
+  if (sent) {
+    metrics.add_bytes_sent(byte_count);
+  } else {
+    record_send_error();
+  }
+  return sent;
+}
+
+bool ClientSession::echo_message_to_client() {
+  Send_Segment segment{recv_buffer_.data(), recv_buffer_.size()};
+  if (!send_segments_to_client(&segment, 1)) {
+    std::cerr << "Failed to echo message to client" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool ClientSession::send_recv_message_analytics_to_client() {
+  Send_Segment segment{recv_message_analytics_.data(),
+                       recv_message_analytics_.size()};
+  if (!send_segments_to_client(&segment, 1)) {
+    std::cerr << "Failed to send analytics to client" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool ClientSession::send_echo_and_analytics_to_client() {
+  Send_Segment segments[]{
+      {recv_buffer_.data(), recv_buffer_.size()},
+      {recv_message_analytics_.data(), recv_message_analytics_.size()}};
+  if (!send_segments_to_client(segments, 2)) {
+    std::cerr << "Failed to echo message and analytics to client"
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool ClientSession::shutdown_message_sending() {
+  if (!shutdown_sending_side(client_socket_.get())) {
+    std::cerr << "Failed to shutdown server sending side" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+Wire_Format ClientSession::detect_wire_format() const {
+  char first_byte{0};
+  auto i_peek_result = recv(client_socket_.get(), &first_byte, 1, MSG_PEEK);
+  if (i_peek_result == SOCKET_ERROR) {
+    std::cout << "recv failed with error: " << WSAGetLastError() << std::endl;
+    return Wire_Format::UNKNOWN;
+  }
+  // An empty legacy message ends the input right away
+  return i_peek_result == 1 && is_frame_start(first_byte)
+             ? Wire_Format::FRAMED
+             : Wire_Format::LEGACY;
+}
+
+bool ClientSession::serve_frames() {
+  ConnectionProtocol protocol;
+  Thread_Metrics &metrics = get_server_metrics().local();
+
+  while (!protocol.finished()) {
+    if (!protocol.receive_completed()) {
+      // The read buffer is borrowed only once data is waiting, so a client
+      // idling between requests holds none.
+      if (!wait_for_input(client_socket_.get())) {
+        return false;
+      }
+      const PooledBuffer read_chunk{get_buffer_pool().acquire(frame_read_size)};
+      const auto receive_started = std::chrono::steady_clock::now();
+      auto i_receive_result = recv(client_socket_.get(), read_chunk.data(),
+                                   static_cast<int>(read_chunk.size()), 0);
+      metrics.record_stage(Server_Stage::RECEIVE,
+                           std::chrono::steady_clock::now() - receive_started);
+      if (i_receive_result > 0) {
+        metrics.add_bytes_received(static_cast<uint64_t>(i_receive_result));
+        protocol.on_bytes_received(read_chunk.data(),
+                                   static_cast<size_t>(i_receive_result));
+      } else if (i_receive_result == 0) {
+        protocol.on_end_of_input();
+      } else {
+        metrics.count_error(WSAGetLastError());
+        std::cout << "recv failed with error: " << WSAGetLastError()
+                  << std::endl;
+        return false;
+      }
+    }
+
+    while (protocol.pending_output_size() > 0) {
+      const auto send_started = std::chrono::steady_clock::now();
+      auto i_send_result =
+          send(client_socket_.get(), protocol.pending_output(),
+               static_cast<int>(protocol.pending_output_size()), 0);
+      metrics.record_stage(Server_Stage::SEND,
+                           std::chrono::steady_clock::now() - send_started);
+      if (i_send_result == SOCKET_ERROR) {
+        record_send_error();
+        std::cout << "send failed with error: " << WSAGetLastError()
+                  << std::endl;
+        return false;
+      }
+      metrics.add_bytes_sent(static_cast<uint64_t>(i_send_result));
+      protocol.consume_output(static_cast<size_t>(i_send_result));
+    }
+  }
+  if (log_progress_) {
+    std::cout << "Framed connection closing..." << std::endl;
+  }
+  return shutdown_message_sending();
+}
+
+bool ClientSession::serve() {
+  get_server_metrics().local().record_stage(
+      Server_Stage::ACCEPT, std::chrono::steady_clock::now() - accepted_at_);
+  switch (detect_wire_format()) {
+    case Wire_Format::FRAMED:
+      return serve_frames();
+    case Wire_Format::UNKNOWN:
+      return false;
+    case Wire_Format::LEGACY:
+      break;
+  }
+  if (!receive_client_message()) {
+    return false;
+  }
+  calculate_recv_message_analytics();
+  // A streamed message is not kept, so there is nothing to echo
+  const bool echo =
+      echo_message_ && receive_mode_ == Session_Receive_Mode::BUFFERED;
+  const bool sent = echo ? send_echo_and_analytics_to_client()
+                         : send_recv_message_analytics_to_client();
+  return sent && shutdown_message_sending();
+}
+
+bool ClientSession::valid() const { return client_socket_.valid(); }
+
+SOCKET ClientSession::get_socket() const { return client_socket_.get(); }
+
+void ClientSession::display_recv_buffer() const {
+  for (const auto c : recv_buffer_) {
+    std::cout << c;
+  }
+  std::cout << std::endl;
+}
+
+const std::vector<char> &ClientSession::get_recv_buffer() const {
+  return recv_buffer_;
+}
+
+const std::string &ClientSession::get_recv_message_analytics() const {
+  return recv_message_analytics_;
+}
+
+void ClientSession::set_echo_message(bool echo_message) {
+  this->echo_message_ = echo_message;
+}
+
+void ClientSession::set_zero_copy_send(bool zero_copy_send) {
+  zero_copy_sender_.reset();
+  if (zero_copy_send && client_socket_.valid()) {
+    zero_copy_sender_.emplace(client_socket_.get());
+    zero_copy_sender_->enable();
+  }
+}
+
+bool ClientSession::set_slow_reader_timeout(
+    std::chrono::milliseconds timeout) {
+  return set_socket_send_timeout(client_socket_.get(), timeout);
+}
+
+}  // namespace WindowsSocketApp
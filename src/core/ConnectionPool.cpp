@@ -0,0 +1,124 @@
+#include "../include/ConnectionPool.h"
+
+#include "../include/WinSockFunctions.h"
+
+namespace WindowsSocketApp {
+
+ConnectionPool::ConnectionPool(
+    size_t max_idle_per_server_val,
+    std::chrono::steady_clock::duration idle_timeout_val,
+    AddressCache &address_cache_val, Connect_Options connect_options_val)
+    : max_idle_per_server_{max_idle_per_server_val},
+      idle_timeout_{idle_timeout_val},
+      address_cache_{address_cache_val},
+      connect_options_{connect_options_val},
+      hints_{} {
+  hints_.ai_family = AF_UNSPEC;
+  hints_.ai_socktype = SOCK_STREAM;
+  hints_.ai_protocol = IPPROTO_TCP;
+}
+
+std::string ConnectionPool::make_key(const std::string &host,
+                                     const std::string &port) {
+  return host + '|' + port;
+}
+
+bool ConnectionPool::take_idle(const std::string &key,
+                               Idle_Connection &connection) {
+  std::lock_guard<std::mutex> lock{pool_mutex_};
+  auto it = idle_connections_.find(key);
+  if (it == idle_connections_.end() || it->second.empty()) {
+    return false;
+  }
+  // Last in, first out: the most recently used connection is the least
+  // likely to have been closed by the server meanwhile.
+  connection = std::move(it->second.back());
+  it->second.pop_back();
+  return true;
+}
+
+SocketWrapper ConnectionPool::open_connection(const std::string &host,
+                                              const std::string &port) {
+  const Resolved_Addresses addresses =
+      address_cache_.resolve(host, port, hints_);
+  if (!addresses) {
+    std::cerr << "Failed to resolve " << host << ":" << port << std::endl;
+    return SocketWrapper{};
+  }
+  // A loop of its own, so the pool stays usable from any thread
+  AsyncEventLoop loop;
+  SocketWrapper new_socket =
+      loop.run_until_complete(connect_to_fastest_address(
+                                  loop, addresses.get(), connect_options_))
+          .value_or(SocketWrapper{});
+  if (new_socket.valid() &&
+      !set_socket_non_blocking(new_socket.get(), false)) {
+    new_socket.close();
+  }
+  if (!new_socket.valid()) {
+    // The server may have moved; resolve again next time
+    address_cache_.invalidate(host, port, hints_);
+    std::cerr << "Unable to connect to " << host << ":" << port << std::endl;
+    return new_socket;
+  }
+  std::lock_guard<std::mutex> lock{pool_mutex_};
+  ++statistics_.connections_opened;
+  return new_socket;
+}
+
+SocketWrapper ConnectionPool::acquire(const std::string &host,
+                                      const std::string &port) {
+  const std::string key = make_key(host, port);
+  Idle_Connection connection;
+  // Checked outside the lock; stale connections are closed on the way
+  while (take_idle(key, connection)) {
+    const bool expired =
+        std::chrono::steady_clock::now() - connection.idle_since >
+        idle_timeout_;
+    if (!expired && is_connection_idle(connection.socket.get())) {
+      std::lock_guard<std::mutex> lock{pool_mutex_};
+      ++statistics_.connections_reused;
+      return std::move(connection.socket);
+    }
+    connection.socket.close();
+    std::lock_guard<std::mutex> lock{pool_mutex_};
+    ++statistics_.connections_discarded;
+  }
+  return open_connection(host, port);
+}
+
+void ConnectionPool::release(const std::string &host, const std::string &port,
+                             SocketWrapper socket) {
+  if (!socket.valid()) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock{pool_mutex_};
+  auto &idle = idle_connections_[make_key(host, port)];
+  if (idle.size() >= max_idle_per_server_) {
+    ++statistics_.connections_discarded;
+    return;  // Closed by the wrapper
+  }
+  idle.push_back(
+      Idle_Connection{std::move(socket), std::chrono::steady_clock::now()});
+}
+
+void ConnectionPool::clear() {
+  std::lock_guard<std::mutex> lock{pool_mutex_};
+  idle_connections_.clear();
+}
+
+size_t ConnectionPool::get_idle_count() const {
+  std::lock_guard<std::mutex> lock{pool_mutex_};
+  size_t idle_count{0};
+  for (const auto &[key, idle] : idle_connections_) {
+    idle_count += idle.size();
+  }
+  return idle_count;
+}
+
+Connection_Pool_Statistics ConnectionPool::get_statistics() const {
+  std::lock_guard<std::mutex> lock{pool_mutex_};
+  return statistics_;
+}
+
+}  // namespace WindowsSocketApp
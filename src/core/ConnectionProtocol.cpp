@@ -0,0 +1,419 @@
+#include "../include/ConnectionProtocol.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "../include/AnalyticsCache.h"
+#include "../include/AnalyticsLog.h"
+#include "../include/FlowControl.h"
+#include "../include/ServerMetrics.h"
+
+namespace WindowsSocketApp {
+
+namespace {
+
+// Larger batch buffers are released after their batch instead of being kept
+// for the connection's next one
+constexpr size_t max_kept_batch_capacity{1024 * 1024};
+
+// Adds a message answered with the plain analytics to the server-wide
+// analytics and the analytics log
+void add_message(const MessageAnalytics &analytics) {
+  get_server_metrics().local().add_message_analytics(analytics);
+  get_analytics_log().append(analytics);
+}
+
+// Same for a message answered by a pipeline
+void add_pipeline_message(const Pipeline_Analytics &analytics,
+                          uint64_t message_size) {
+  Thread_Metrics &metrics = get_server_metrics().local();
+  if ((analytics.counters & analytics_character_classes) != 0U) {
+    metrics.add_message_analytics(analytics.classes);
+  } else {
+    metrics.add_message_size(message_size);
+  }
+  get_analytics_log().append(analytics, message_size);
+}
+
+}  // namespace
+
+ConnectionProtocol::ConnectionProtocol()
+    : wire_format_{Wire_Format::UNKNOWN},
+      header_bytes_{},
+      header_bytes_received_{0},
+      payload_bytes_remaining_{0},
+      send_offset_{0},
+      output_consumed_{0},
+      reply_payload_{},
+      keep_message_{false},
+      batch_{false},
+      aggregate_{false},
+      counters_{0},
+      receive_completed_{false},
+      protocol_error_{false} {}
+
+void ConnectionProtocol::on_bytes_received(const char *data, size_t size) {
+  if (receive_completed_ || size == 0) {
+    return;
+  }
+  const Stage_Timer analyze_timer{Server_Stage::ANALYZE};
+  if (wire_format_ == Wire_Format::UNKNOWN) {
+    wire_format_ =
+        is_frame_start(data[0]) ? Wire_Format::FRAMED : Wire_Format::LEGACY;
+    if (wire_format_ == Wire_Format::LEGACY) {
+      // The length of a legacy message is only known at its end
+      start_message(0);
+    }
+  }
+  if (wire_format_ == Wire_Format::LEGACY) {
+    analyze(data, size);
+  } else {
+    on_frame_bytes_received(data, size);
+  }
+}
+
+void ConnectionProtocol::on_frame_bytes_received(const char *data,
+                                                 size_t size) {
+  while (size > 0 && !protocol_error_) {
+    if (header_bytes_received_ < frame_header_size) {
+      const size_t header_part =
+          std::min(size, frame_header_size - header_bytes_received_);
+      std::memcpy(header_bytes_.data() + header_bytes_received_, data,
+                  header_part);
+      header_bytes_received_ += header_part;
+      data += header_part;
+      size -= header_part;
+      if (header_bytes_received_ < frame_header_size) {
+        return;  // Rest of the header arrives with the next read
+      }
+
+      current_frame_ = Frame_Header{};
+      const auto status =
+          decode_frame_header(header_bytes_.data(), current_frame_);
+      if (status == Frame_Decode_Status::BAD_MAGIC) {
+        reject_frame(0, "Malformed frame header");
+        return;
+      }
+      if (status != Frame_Decode_Status::OK ||
+          current_frame_.type != Frame_Type::REQUEST) {
+        reject_frame(current_frame_.request_id, "Unsupported frame type");
+        return;
+      }
+      aggregate_ = (current_frame_.flags & frame_flag_aggregate) != 0U;
+      batch_ = !aggregate_ && (current_frame_.flags & frame_flag_batch) != 0U;
+      counters_ =
+          aggregate_ ? uint16_t{0} : get_frame_counters(current_frame_.flags);
+      if (batch_ && current_frame_.payload_length >
+                        get_flow_control()
+                            .get_limits()
+                            .max_buffered_message_bytes) {
+        reject_frame(current_frame_.request_id, "Batch too large");
+        return;
+      }
+      start_message(current_frame_.payload_length);
+      payload_bytes_remaining_ = current_frame_.payload_length;
+    } else {
+      const size_t payload_part = std::min(size, payload_bytes_remaining_);
+      if (batch_) {
+        message_bytes_.append(data, payload_part);
+      } else if (!aggregate_) {
+        analyze(data, payload_part);
+      }
+      payload_bytes_remaining_ -= payload_part;
+      data += payload_part;
+      size -= payload_part;
+    }
+    if (payload_bytes_remaining_ == 0) {
+      complete_frame();
+    }
+  }
+}
+
+void ConnectionProtocol::start_message(size_t expected_size) {
+  analyzer_.reset();
+  message_bytes_.clear();
+  // Batches are answered message by message without the cache: their
+  // messages are small enough that a lookup costs about as much as analyzing
+  // them.
+  keep_message_ = !batch_ && !aggregate_ && counters_ == 0 &&
+                  get_analytics_cache().accepts(expected_size);
+  if (counters_ != 0 && !batch_) {
+    if (!pipeline_) {
+      pipeline_ = std::make_unique<PipelineAnalyzer>(counters_);
+    }
+    pipeline_->reset(counters_);
+  }
+}
+
+void ConnectionProtocol::analyze(const char *data, size_t size) {
+  if (counters_ != 0) {
+    pipeline_->update(data, size);
+    return;
+  }
+  if (keep_message_) {
+    if (get_analytics_cache().accepts(message_bytes_.size() + size)) {
+      message_bytes_.append(data, size);
+      return;
+    }
+    // Grew too large to be cached: analyze what was kept and stream the rest
+    keep_message_ = false;
+    analyzer_.update(message_bytes_.data(), message_bytes_.size());
+    message_bytes_.clear();
+  }
+  analyzer_.update(data, size);
+}
+
+size_t ConnectionProtocol::write_reply(bool binary) {
+  if (keep_message_) {
+    AnalyticsCache &cache = get_analytics_cache();
+    const Analytics_Cache_Key key =
+        make_analytics_cache_key(message_bytes_.data(), message_bytes_.size());
+    MessageAnalytics cached_analytics;
+    const size_t cached_size =
+        cache.find(key, binary, reply_payload_, cached_analytics);
+    if (cached_size > 0) {
+      add_message(cached_analytics);
+      return cached_size;
+    }
+    analyzer_.update(message_bytes_.data(), message_bytes_.size());
+    cache.insert(key, analyzer_.get_analytics());
+  }
+  add_message(analyzer_.get_analytics());
+  if (binary) {
+    encode_message_analytics_binary(analyzer_.get_analytics(),
+                                    reply_payload_.data());
+    return message_analytics_binary_size;
+  }
+  return write_message_analytics_text(analyzer_.get_analytics(),
+                                      reply_payload_);
+}
+
+void ConnectionProtocol::complete_frame() {
+  const bool binary_reply =
+      (current_frame_.flags & frame_flag_binary_analytics) != 0U;
+  header_bytes_received_ = 0;
+  if (aggregate_) {
+    aggregate_ = false;
+    complete_aggregate(binary_reply);
+    return;
+  }
+  if (batch_) {
+    batch_ = false;
+    if (message_bytes_.size() >= batch_count_size &&
+        get_u32(message_bytes_.data()) >
+            get_flow_control().get_limits().max_batch_messages) {
+      reject_frame(current_frame_.request_id, "Batch too large");
+    } else if (!complete_batch(binary_reply)) {
+      reject_frame(current_frame_.request_id, "Malformed batch");
+    }
+    if (message_bytes_.capacity() > max_kept_batch_capacity) {
+      message_bytes_ = std::string{};
+    }
+    return;
+  }
+  if (counters_ != 0) {
+    pipeline_->finish();
+    add_pipeline_message(pipeline_->get_analytics(),
+                         current_frame_.payload_length);
+    std::string &output = output_for_append();
+    const size_t frame_start = begin_response(output);
+    if (binary_reply) {
+      append_pipeline_analytics_binary(pipeline_->get_analytics(), output);
+    } else {
+      append_pipeline_analytics_text(pipeline_->get_analytics(), output);
+    }
+    finish_response(output, frame_start,
+                    static_cast<uint16_t>(
+                        make_frame_counters_flags(counters_) |
+                        (binary_reply ? frame_flag_binary_analytics : 0)));
+    get_server_metrics().local().count_message_analyzed();
+    return;
+  }
+  const size_t reply_size = write_reply(binary_reply);
+  append_frame(output_for_append(), Frame_Type::RESPONSE,
+               current_frame_.request_id, reply_payload_.data(), reply_size,
+               binary_reply ? frame_flag_binary_analytics : 0);
+  end_reply();
+  get_server_metrics().local().count_message_analyzed();
+}
+
+bool ConnectionProtocol::complete_batch(bool binary) {
+  const char *const payload = message_bytes_.data();
+  const size_t payload_size = message_bytes_.size();
+  if (payload_size < batch_count_size) {
+    return false;
+  }
+  if (counters_ != 0 && !pipeline_) {
+    pipeline_ = std::make_unique<PipelineAnalyzer>(counters_);
+  }
+
+  std::string &output = output_for_append();
+  const size_t frame_start = begin_response(output);
+  output.resize(output.size() + batch_count_size);
+  put_u32(output.data() + frame_start + frame_header_size, get_u32(payload));
+  const bool well_formed = for_each_batch_message(
+      payload, payload_size, [this, &output, binary](const char *message,
+                                                     size_t message_size) {
+        const size_t record_start = output.size();
+        // Text records are prefixed with their length
+        if (!binary) {
+          output.resize(record_start + batch_length_size);
+        }
+        if (counters_ != 0) {
+          pipeline_->reset(counters_);
+          pipeline_->update(message, message_size);
+          pipeline_->finish();
+          add_pipeline_message(pipeline_->get_analytics(), message_size);
+          if (binary) {
+            append_pipeline_analytics_binary(pipeline_->get_analytics(),
+                                             output);
+          } else {
+            append_pipeline_analytics_text(pipeline_->get_analytics(),
+                                           output);
+          }
+        } else {
+          const MessageAnalytics analytics =
+              calculate_message_analytics(message, message_size);
+          add_message(analytics);
+          if (binary) {
+            output.resize(record_start + message_analytics_binary_size);
+            encode_message_analytics_binary(analytics,
+                                            output.data() + record_start);
+          } else {
+            output.append(reply_payload_.data(),
+                          write_message_analytics_text(analytics,
+                                                       reply_payload_));
+          }
+        }
+        if (!binary) {
+          put_u32(output.data() + record_start,
+                  static_cast<uint32_t>(output.size() - record_start -
+                                        batch_length_size));
+        }
+      });
+  if (!well_formed) {
+    output.resize(frame_start);
+    return false;
+  }
+
+  finish_response(output, frame_start,
+                  static_cast<uint16_t>(
+                      frame_flag_batch | make_frame_counters_flags(counters_) |
+                      (binary ? frame_flag_binary_analytics : 0)));
+  get_server_metrics().local().add_messages_analyzed(get_u32(payload));
+  return true;
+}
+
+void ConnectionProtocol::complete_aggregate(bool binary) {
+  // Merged here, off the path of the requests that feed it
+  const Aggregate_Analytics analytics =
+      get_server_metrics().aggregate_analytics();
+  std::string &output = output_for_append();
+  const size_t frame_start = begin_response(output);
+  if (binary) {
+    append_aggregate_analytics_binary(analytics, output);
+  } else {
+    append_aggregate_analytics_text(analytics, output);
+  }
+  finish_response(output, frame_start,
+                  static_cast<uint16_t>(
+                      frame_flag_aggregate |
+                      (binary ? frame_flag_binary_analytics : 0)));
+}
+
+size_t ConnectionProtocol::begin_response(std::string &output) {
+  const size_t frame_start = output.size();
+  output.resize(frame_start + frame_header_size);
+  return frame_start;
+}
+
+void ConnectionProtocol::finish_response(std::string &output,
+                                         size_t frame_start, uint16_t flags) {
+  Frame_Header header;
+  header.payload_length =
+      static_cast<uint32_t>(output.size() - frame_start - frame_header_size);
+  header.type = Frame_Type::RESPONSE;
+  header.flags = flags;
+  header.request_id = current_frame_.request_id;
+  encode_frame_header(header, output.data() + frame_start);
+  end_reply();
+}
+
+void ConnectionProtocol::reject_frame(uint32_t request_id,
+                                      const char *reason) {
+  append_frame(output_for_append(), Frame_Type::ERROR_MESSAGE, request_id,
+               reason, std::strlen(reason));
+  protocol_error_ = true;
+  receive_completed_ = true;
+}
+
+std::string &ConnectionProtocol::output_for_append() {
+  if (send_offset_ < send_buffer_.size()) {
+    return queued_output_;
+  }
+  send_buffer_.clear();
+  send_offset_ = 0;
+  return send_buffer_;
+}
+
+void ConnectionProtocol::end_reply() {
+  reply_ends_.push_back(output_consumed_ + buffered_output_size());
+}
+
+void ConnectionProtocol::on_end_of_input() {
+  if (receive_completed_) {
+    return;
+  }
+  receive_completed_ = true;
+  // A legacy message is complete now; a partial frame left by a framed client
+  // is dropped.
+  if (wire_format_ != Wire_Format::FRAMED) {
+    if (wire_format_ == Wire_Format::UNKNOWN) {
+      start_message(0);  // Empty message
+    }
+    output_for_append().append(reply_payload_.data(), write_reply(false));
+    end_reply();
+    get_server_metrics().local().count_message_analyzed();
+  }
+}
+
+bool ConnectionProtocol::receive_completed() const {
+  return receive_completed_;
+}
+
+Wire_Format ConnectionProtocol::get_wire_format() const { return wire_format_; }
+
+const char *ConnectionProtocol::pending_output() const {
+  return send_buffer_.data() + send_offset_;
+}
+
+size_t ConnectionProtocol::pending_output_size() const {
+  return send_buffer_.size() - send_offset_;
+}
+
+void ConnectionProtocol::consume_output(size_t byte_count) {
+  send_offset_ += byte_count;
+  output_consumed_ += byte_count;
+  while (!reply_ends_.empty() && reply_ends_.front() <= output_consumed_) {
+    reply_ends_.pop_front();
+  }
+  if (send_offset_ == send_buffer_.size() && !queued_output_.empty()) {
+    send_buffer_.swap(queued_output_);
+    queued_output_.clear();
+    send_offset_ = 0;
+  }
+}
+
+size_t ConnectionProtocol::buffered_output_size() const {
+  return pending_output_size() + queued_output_.size();
+}
+
+size_t ConnectionProtocol::pending_reply_count() const {
+  return reply_ends_.size();
+}
+
+bool ConnectionProtocol::finished() const {
+  return receive_completed_ && pending_output_size() == 0;
+}
+
+}  // namespace WindowsSocketApp
@@ -0,0 +1,308 @@
+#include "../include/EpollReactor.h"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#include <algorithm>
+
+#include "../include/ServerMetrics.h"
+#include "../include/WinSockFunctions.h"
+
+namespace WindowsSocketApp {
+
+EpollReactor::EpollReactor(SOCKET listen_socket_val,
+                           size_t read_chunk_size_val, int max_events_val)
+    : listen_socket_{listen_socket_val},
+      max_events_{max_events_val},
+      reactor_status_{Reactor_Status::NOT_STARTED},
+      stop_requested_{false},
+      epoll_fd_{},
+      wakeup_fd_{},
+      next_slow_reader_check_{std::chrono::steady_clock::now()} {
+  read_chunk_.resize(read_chunk_size_val);
+}
+
+bool EpollReactor::register_descriptor(SOCKET descriptor, uint32_t events) {
+  epoll_event event{};
+  event.events = events;
+  event.data.fd = descriptor;
+  if (epoll_ctl(epoll_fd_.get(), EPOLL_CTL_ADD, descriptor, &event) == -1) {
+    std::cerr << "epoll_ctl failed with error: " << errno << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool EpollReactor::run() {
+  epoll_fd_ = SocketWrapper{epoll_create1(EPOLL_CLOEXEC)};
+  wakeup_fd_ = SocketWrapper{eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)};
+  if (!epoll_fd_.valid() || !wakeup_fd_.valid()) {
+    std::cerr << "Failed to create epoll instance: " << errno << std::endl;
+    reactor_status_ = Reactor_Status::FAILED;
+    return false;
+  }
+
+  if (!set_socket_non_blocking(listen_socket_) ||
+      !register_descriptor(listen_socket_, EPOLLIN | EPOLLET) ||
+      !register_descriptor(wakeup_fd_.get(), EPOLLIN)) {
+    reactor_status_ = Reactor_Status::FAILED;
+    return false;
+  }
+
+  reactor_status_ = Reactor_Status::RUNNING;
+  std::vector<epoll_event> events(static_cast<size_t>(max_events_));
+
+  while (!stop_requested_.load(std::memory_order_acquire)) {
+    int ready_count = epoll_wait(epoll_fd_.get(), events.data(), max_events_,
+                                 get_wait_timeout());
+    if (ready_count == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      std::cerr << "epoll_wait failed with error: " << errno << std::endl;
+      reactor_status_ = Reactor_Status::FAILED;
+      return false;
+    }
+
+    for (int i = 0; i < ready_count; ++i) {
+      const SOCKET descriptor = events[i].data.fd;
+      if (descriptor == listen_socket_) {
+        accept_pending_connections();
+      } else if (descriptor != wakeup_fd_.get()) {
+        handle_connection_event(descriptor, events[i].events);
+      }
+    }
+    resume_paused_connections();
+    close_slow_readers();
+  }
+
+  connections_.clear();
+  reactor_status_ = Reactor_Status::STOPPED;
+  return true;
+}
+
+void EpollReactor::request_stop() {
+  stop_requested_.store(true, std::memory_order_release);
+  if (wakeup_fd_.valid()) {
+    uint64_t one{1};
+    (void)write(wakeup_fd_.get(), &one, sizeof(one));
+  }
+}
+
+void EpollReactor::accept_pending_connections() {
+  // Edge-triggered: drain the whole accept queue before returning.
+  while (true) {
+    SOCKET client_socket = accept4(listen_socket_, nullptr, nullptr,
+                                   SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (client_socket == INVALID_SOCKET) {
+      if (is_transient_accept_error(errno)) {
+        continue;
+      }
+      if (!is_would_block_error(errno)) {
+        get_server_metrics().local().count_error(errno);
+        std::cerr << "accept failed: " << errno << std::endl;
+      }
+      return;
+    }
+    get_server_metrics().local().count_accept();
+
+    Connection &connection = connections_[client_socket];
+    connection.socket = SocketWrapper{client_socket};
+    if (!register_descriptor(client_socket,
+                             EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET)) {
+      connections_.erase(client_socket);
+    }
+  }
+}
+
+void EpollReactor::handle_connection_event(SOCKET client_socket,
+                                           uint32_t events) {
+  auto it = connections_.find(client_socket);
+  if (it == connections_.end()) {
+    return;
+  }
+  Connection &connection = it->second;
+
+  if ((events & EPOLLERR) != 0U) {
+    close_connection(client_socket);
+    return;
+  }
+  if ((events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP)) != 0U) {
+    connection.input_ready = true;
+  }
+
+  if (!serve_connection(client_socket, connection)) {
+    close_connection(client_socket);
+    return;
+  }
+  if (connection.protocol.finished()) {
+    shutdown(client_socket, SD_SEND);
+    close_connection(client_socket);
+  }
+}
+
+bool EpollReactor::serve_connection(SOCKET client_socket,
+                                    Connection &connection) {
+  while (true) {
+    if (connection.input_ready && !connection.protocol.receive_completed() &&
+        connection.flow.may_read(connection.protocol)) {
+      if (!read_until_would_block(connection)) {
+        return false;
+      }
+    }
+    // Replies may have been produced by the read above (a framed client gets
+    // one per request) or the socket became writable again after a short
+    // write.
+    const size_t output_before = connection.protocol.buffered_output_size();
+    if (!flush_send_buffer(connection)) {
+      return false;
+    }
+    connection.flow.update(
+        connection.protocol,
+        connection.protocol.buffered_output_size() < output_before);
+
+    if (!connection.input_ready || connection.protocol.receive_completed()) {
+      connection.flow.set_read_paused(false);
+      return true;
+    }
+    if (!connection.flow.may_read(connection.protocol)) {
+      // A short write is resumed by the next EPOLLOUT edge, anything else
+      // only by a retry.
+      if (connection.protocol.pending_output_size() == 0 &&
+          !connection.in_paused_list) {
+        paused_connections_.push_back(client_socket);
+        connection.in_paused_list = true;
+      }
+      connection.flow.set_read_paused(true);
+      return true;
+    }
+    // Reading stopped at a limit and the replies were sent since: go on
+    connection.flow.set_read_paused(false);
+  }
+}
+
+bool EpollReactor::read_until_would_block(Connection &connection) {
+  Thread_Metrics &metrics = get_server_metrics().local();
+  while (!connection.protocol.receive_completed() &&
+         connection.flow.may_read(connection.protocol)) {
+    const auto receive_started = std::chrono::steady_clock::now();
+    auto i_receive_result = recv(connection.socket.get(), read_chunk_.data(),
+                                 read_chunk_.size(), 0);
+    if (i_receive_result > 0) {
+      // Only reads that returned data are timed; the final EAGAIN is not.
+      metrics.record_stage(Server_Stage::RECEIVE,
+                           std::chrono::steady_clock::now() - receive_started);
+      metrics.add_bytes_received(static_cast<uint64_t>(i_receive_result));
+      connection.protocol.on_bytes_received(
+          read_chunk_.data(), static_cast<size_t>(i_receive_result));
+      connection.flow.update(connection.protocol, false);
+    } else if (i_receive_result == 0) {
+      connection.protocol.on_end_of_input();
+      connection.input_ready = false;
+      return true;
+    } else if (errno == EINTR) {
+      continue;
+    } else if (is_would_block_error(errno)) {
+      connection.input_ready = false;
+      return true;
+    } else {
+      metrics.count_error(errno);
+      std::cerr << "recv failed with error: " << errno << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+bool EpollReactor::flush_send_buffer(Connection &connection) {
+  Thread_Metrics &metrics = get_server_metrics().local();
+  while (connection.protocol.pending_output_size() > 0) {
+    const auto send_started = std::chrono::steady_clock::now();
+    auto i_send_result = send(connection.socket.get(),
+                              connection.protocol.pending_output(),
+                              connection.protocol.pending_output_size(),
+                              MSG_NOSIGNAL);
+    if (i_send_result >= 0) {
+      metrics.record_stage(Server_Stage::SEND,
+                           std::chrono::steady_clock::now() - send_started);
+      metrics.add_bytes_sent(static_cast<uint64_t>(i_send_result));
+      connection.protocol.consume_output(static_cast<size_t>(i_send_result));
+    } else if (errno == EINTR) {
+      continue;
+    } else if (is_would_block_error(errno)) {
+      return true;  // Resumed on the next EPOLLOUT edge.
+    } else {
+      metrics.count_error(errno);
+      std::cerr << "send failed with error: " << errno << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+void EpollReactor::close_connection(SOCKET client_socket) {
+  // Closing the descriptor also removes it from the epoll interest list.
+  connections_.erase(client_socket);
+}
+
+int EpollReactor::get_wait_timeout() const {
+  if (!paused_connections_.empty()) {
+    return static_cast<int>(paused_retry_interval.count());
+  }
+  const auto slow_reader_timeout =
+      get_flow_control().get_limits().slow_reader_timeout;
+  if (slow_reader_timeout.count() > 0 && !connections_.empty()) {
+    return static_cast<int>(
+        std::min(slow_reader_timeout, slow_reader_check_interval).count());
+  }
+  return -1;
+}
+
+void EpollReactor::resume_paused_connections() {
+  if (paused_connections_.empty() ||
+      get_flow_control().total_output_over_limit()) {
+    return;
+  }
+  std::vector<SOCKET> paused;
+  paused.swap(paused_connections_);
+  for (const SOCKET client_socket : paused) {
+    // The descriptor may have been closed and reused meanwhile
+    auto it = connections_.find(client_socket);
+    if (it != connections_.end() && it->second.in_paused_list) {
+      // Those still over a limit are paused again
+      it->second.in_paused_list = false;
+      handle_connection_event(client_socket, 0);
+    }
+  }
+}
+
+void EpollReactor::close_slow_readers() {
+  const auto slow_reader_timeout =
+      get_flow_control().get_limits().slow_reader_timeout;
+  const auto now = std::chrono::steady_clock::now();
+  if (slow_reader_timeout.count() == 0 || now < next_slow_reader_check_) {
+    return;
+  }
+  next_slow_reader_check_ =
+      now + std::min(slow_reader_timeout, slow_reader_check_interval);
+  std::vector<SOCKET> slow_readers;
+  for (const auto &[client_socket, connection] : connections_) {
+    if (connection.flow.is_slow_reader(connection.protocol, now)) {
+      slow_readers.push_back(client_socket);
+    }
+  }
+  for (const SOCKET client_socket : slow_readers) {
+    get_server_metrics().local().count_slow_reader_closed();
+    close_connection(client_socket);
+  }
+}
+
+Reactor_Status EpollReactor::get_reactor_status() const {
+  return reactor_status_;
+}
+
+size_t EpollReactor::get_connection_count() const {
+  return connections_.size();
+}
+
+}  // namespace WindowsSocketApp
@@ -0,0 +1,105 @@
+#include "../include/FlowControl.h"
+
+#include "../include/ServerMetrics.h"
+
+namespace WindowsSocketApp {
+
+FlowControl::FlowControl() : limits_{}, total_output_bytes_{0} {}
+
+const Flow_Control_Limits &FlowControl::get_limits() const { return limits_; }
+
+void FlowControl::set_limits(const Flow_Control_Limits &limits) {
+  this->limits_ = limits;
+}
+
+size_t FlowControl::get_total_output_bytes() const {
+  return total_output_bytes_.load(std::memory_order_relaxed);
+}
+
+bool FlowControl::total_output_over_limit() const {
+  return get_total_output_bytes() > limits_.max_total_output_bytes;
+}
+
+FlowControl &get_flow_control() {
+  static FlowControl flow_control;
+  return flow_control;
+}
+
+Connection_Flow::Connection_Flow()
+    : counted_output_bytes_{0},
+      last_progress_{std::chrono::steady_clock::now()},
+      read_paused_{false} {}
+
+Connection_Flow::~Connection_Flow() {
+  if (counted_output_bytes_ > 0) {
+    get_flow_control().total_output_bytes_.fetch_sub(
+        counted_output_bytes_, std::memory_order_relaxed);
+  }
+}
+
+Connection_Flow::Connection_Flow(Connection_Flow &&source) noexcept
+    : counted_output_bytes_{source.counted_output_bytes_},
+      last_progress_{source.last_progress_},
+      read_paused_{source.read_paused_} {
+  source.counted_output_bytes_ = 0;
+}
+
+Connection_Flow &Connection_Flow::operator=(Connection_Flow &&other) noexcept {
+  if (this != &other) {
+    if (counted_output_bytes_ > 0) {
+      get_flow_control().total_output_bytes_.fetch_sub(
+          counted_output_bytes_, std::memory_order_relaxed);
+    }
+    counted_output_bytes_ = other.counted_output_bytes_;
+    last_progress_ = other.last_progress_;
+    read_paused_ = other.read_paused_;
+    other.counted_output_bytes_ = 0;
+  }
+  return *this;
+}
+
+void Connection_Flow::update(const ConnectionProtocol &protocol, bool sent) {
+  const size_t output_bytes = protocol.buffered_output_size();
+  // The slow-reader clock starts when replies start waiting
+  if (sent || (counted_output_bytes_ == 0 && output_bytes > 0)) {
+    last_progress_ = std::chrono::steady_clock::now();
+  }
+  auto &total = get_flow_control().total_output_bytes_;
+  if (output_bytes > counted_output_bytes_) {
+    total.fetch_add(output_bytes - counted_output_bytes_,
+                    std::memory_order_relaxed);
+  } else if (output_bytes < counted_output_bytes_) {
+    total.fetch_sub(counted_output_bytes_ - output_bytes,
+                    std::memory_order_relaxed);
+  }
+  counted_output_bytes_ = output_bytes;
+}
+
+bool Connection_Flow::may_read(const ConnectionProtocol &protocol) const {
+  const FlowControl &flow_control = get_flow_control();
+  const Flow_Control_Limits &limits = flow_control.get_limits();
+  return protocol.buffered_output_size() <=
+             limits.max_connection_output_bytes &&
+         protocol.pending_reply_count() <=
+             limits.max_connection_pending_replies &&
+         !flow_control.total_output_over_limit();
+}
+
+bool Connection_Flow::is_slow_reader(
+    const ConnectionProtocol &protocol,
+    std::chrono::steady_clock::time_point now) const {
+  const auto timeout = get_flow_control().get_limits().slow_reader_timeout;
+  return timeout.count() > 0 && protocol.buffered_output_size() > 0 &&
+         now - last_progress_ > timeout;
+}
+
+bool Connection_Flow::is_read_paused() const { return read_paused_; }
+
+void Connection_Flow::set_read_paused(bool read_paused) {
+  if (read_paused && !read_paused_) {
+    get_server_metrics().local().count_read_pause();
+  }
+  this->read_paused_ = read_paused;
+}
+
+}  // namespace WindowsSocketApp
@@ -0,0 +1,759 @@
+#include "../include/IoUringEngine.h"
+
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/utsname.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "../include/ServerMetrics.h"
+#include "../include/WinSockFunctions.h"
+
+namespace WindowsSocketApp {
+
+namespace {
+
+enum class Ring_Operation : uint64_t {
+  ACCEPT = 1,
+  RECEIVE,
+  SEND,
+  WAKEUP,
+  CANCEL,
+  TIMER
+};
+
+constexpr unsigned operation_shift{56};
+constexpr uint64_t connection_id_mask{(uint64_t{1} << operation_shift) - 1};
+
+uint64_t encode_user_data(Ring_Operation operation, uint64_t connection_id) {
+  return (static_cast<uint64_t>(operation) << operation_shift) |
+         (connection_id & connection_id_mask);
+}
+
+Ring_Operation decode_operation(uint64_t user_data) {
+  return static_cast<Ring_Operation>(user_data >> operation_shift);
+}
+
+uint64_t decode_connection_id(uint64_t user_data) {
+  return user_data & connection_id_mask;
+}
+
+int io_uring_setup(unsigned entries, io_uring_params *params) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int io_uring_enter(int ring_fd, unsigned to_submit, unsigned min_complete,
+                   unsigned flags) {
+  return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit,
+                                  min_complete, flags, nullptr, 0));
+}
+
+int io_uring_register(int ring_fd, unsigned opcode, void *arg,
+                      unsigned nr_args) {
+  return static_cast<int>(
+      syscall(__NR_io_uring_register, ring_fd, opcode, arg, nr_args));
+}
+
+// Multishot recv with provided buffer rings appeared in Linux 6.0.
+constexpr int multishot_receive_kernel_major{6};
+constexpr int multishot_receive_kernel_minor{0};
+
+bool kernel_supports_multishot_receive() {
+  utsname kernel_info{};
+  if (uname(&kernel_info) != 0) {
+    return false;
+  }
+  int major{0};
+  int minor{0};
+  if (std::sscanf(kernel_info.release, "%d.%d", &major, &minor) != 2) {
+    return false;
+  }
+  return major > multishot_receive_kernel_major ||
+         (major == multishot_receive_kernel_major &&
+          minor >= multishot_receive_kernel_minor);
+}
+
+void *map_ring_memory(int ring_fd, size_t length, off_t offset) {
+  void *address = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, ring_fd, offset);
+  return address == MAP_FAILED ? nullptr : address;
+}
+
+}  // namespace
+
+IoUringEngine::MappedRegion::~MappedRegion() {
+  if (address_ != nullptr) {
+    munmap(address_, length_);
+  }
+}
+
+IoUringEngine::MappedRegion::MappedRegion(MappedRegion &&source) noexcept
+    : address_{source.address_}, length_{source.length_} {
+  source.address_ = nullptr;
+  source.length_ = 0;
+}
+
+IoUringEngine::MappedRegion &IoUringEngine::MappedRegion::operator=(
+    MappedRegion &&rhs) noexcept {
+  if (this != &rhs) {
+    if (address_ != nullptr) {
+      munmap(address_, length_);
+    }
+    address_ = rhs.address_;
+    length_ = rhs.length_;
+    rhs.address_ = nullptr;
+    rhs.length_ = 0;
+  }
+  return *this;
+}
+
+IoUringEngine::IoUringEngine(SOCKET listen_socket_val,
+                             unsigned queue_depth_val,
+                             unsigned buffer_count_val,
+                             unsigned buffer_size_val)
+    : listen_socket_{listen_socket_val},
+      queue_depth_{queue_depth_val},
+      buffer_count_{buffer_count_val},
+      buffer_size_{buffer_size_val},
+      reactor_status_{Reactor_Status::NOT_STARTED},
+      stop_requested_{false},
+      ring_fd_{},
+      wakeup_fd_{},
+      wakeup_value_{0},
+      sq_head_{nullptr},
+      sq_tail_{nullptr},
+      sq_mask_{0},
+      sq_array_{nullptr},
+      sqe_entries_{nullptr},
+      cq_head_{nullptr},
+      cq_tail_{nullptr},
+      cq_mask_{0},
+      cqe_entries_{nullptr},
+      provided_buffers_{nullptr},
+      provided_buffers_tail_{0},
+      sq_local_tail_{0},
+      next_connection_id_{1},
+      timer_interval_{},
+      timer_armed_{false},
+      next_slow_reader_check_{std::chrono::steady_clock::now()} {}
+
+bool IoUringEngine::initialize() {
+  if (!kernel_supports_multishot_receive()) {
+    std::cerr << "io_uring multishot receive requires Linux 6.0 or newer"
+              << std::endl;
+    return false;
+  }
+  // Provided buffer rings must have a power-of-two number of entries.
+  if (buffer_count_ == 0 || (buffer_count_ & (buffer_count_ - 1)) != 0 ||
+      buffer_count_ > 32768) {
+    std::cerr << "io_uring buffer count must be a power of two up to 32768"
+              << std::endl;
+    return false;
+  }
+
+  io_uring_params params{};
+  // Multishot receives produce several completions per submission.
+  params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SUBMIT_ALL |
+                 IORING_SETUP_COOP_TASKRUN;
+  params.cq_entries = queue_depth_ * 4;
+  int ring_fd = io_uring_setup(queue_depth_, &params);
+  if (ring_fd < 0 && errno == EINVAL) {
+    params = io_uring_params{};
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = queue_depth_ * 4;
+    ring_fd = io_uring_setup(queue_depth_, &params);
+  }
+  if (ring_fd < 0) {
+    std::cerr << "io_uring_setup failed with error: " << errno << std::endl;
+    return false;
+  }
+  ring_fd_ = SocketWrapper{ring_fd};
+
+  wakeup_fd_ = SocketWrapper{eventfd(0, EFD_CLOEXEC)};
+  if (!wakeup_fd_.valid()) {
+    std::cerr << "Failed to create io_uring wakeup event: " << errno
+              << std::endl;
+    return false;
+  }
+
+  return map_rings(params) && register_provided_buffers();
+}
+
+bool IoUringEngine::map_rings(const io_uring_params &params) {
+  size_t sq_ring_size =
+      params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  size_t cq_ring_size =
+      params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  const bool single_mapping = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mapping) {
+    sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+  }
+
+  sq_ring_ = MappedRegion{
+      map_ring_memory(ring_fd_.get(), sq_ring_size, IORING_OFF_SQ_RING),
+      sq_ring_size};
+  if (!single_mapping) {
+    cq_ring_ = MappedRegion{
+        map_ring_memory(ring_fd_.get(), cq_ring_size, IORING_OFF_CQ_RING),
+        cq_ring_size};
+  }
+  const size_t sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+  sqes_ = MappedRegion{
+      map_ring_memory(ring_fd_.get(), sqes_size, IORING_OFF_SQES), sqes_size};
+
+  if (!sq_ring_.valid() || !sqes_.valid() ||
+      (!single_mapping && !cq_ring_.valid())) {
+    std::cerr << "Failed to map io_uring rings: " << errno << std::endl;
+    return false;
+  }
+
+  char *sq_base = sq_ring_.get();
+  char *cq_base = single_mapping ? sq_ring_.get() : cq_ring_.get();
+
+  sq_head_ = reinterpret_cast<unsigned *>(sq_base + params.sq_off.head);
+  sq_tail_ = reinterpret_cast<unsigned *>(sq_base + params.sq_off.tail);
+  sq_mask_ = *reinterpret_cast<unsigned *>(sq_base + params.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<unsigned *>(sq_base + params.sq_off.array);
+  sqe_entries_ = reinterpret_cast<io_uring_sqe *>(sqes_.get());
+  sq_local_tail_ = *sq_tail_;
+
+  cq_head_ = reinterpret_cast<unsigned *>(cq_base + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned *>(cq_base + params.cq_off.tail);
+  cq_mask_ = *reinterpret_cast<unsigned *>(cq_base + params.cq_off.ring_mask);
+  cqe_entries_ = reinterpret_cast<io_uring_cqe *>(cq_base + params.cq_off.cqes);
+  return true;
+}
+
+bool IoUringEngine::register_provided_buffers() {
+  const size_t ring_size = buffer_count_ * sizeof(io_uring_buf);
+  void *ring_address = mmap(nullptr, ring_size, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (ring_address == MAP_FAILED) {
+    std::cerr << "Failed to allocate io_uring buffer ring: " << errno
+              << std::endl;
+    return false;
+  }
+  buffer_ring_ = MappedRegion{ring_address, ring_size};
+  provided_buffers_ = reinterpret_cast<io_uring_buf_ring *>(ring_address);
+
+  io_uring_buf_reg registration{};
+  registration.ring_addr = reinterpret_cast<uint64_t>(ring_address);
+  registration.ring_entries = buffer_count_;
+  registration.bgid = provided_buffer_group;
+  if (io_uring_register(ring_fd_.get(), IORING_REGISTER_PBUF_RING,
+                        &registration, 1) < 0) {
+    std::cerr << "Failed to register io_uring buffer ring: " << errno
+              << std::endl;
+    return false;
+  }
+
+  buffer_storage_.resize(static_cast<size_t>(buffer_count_) * buffer_size_);
+  for (unsigned buffer_id = 0; buffer_id < buffer_count_; ++buffer_id) {
+    recycle_provided_buffer(static_cast<uint16_t>(buffer_id));
+  }
+  __atomic_store_n(&provided_buffers_->tail, provided_buffers_tail_,
+                   __ATOMIC_RELEASE);
+  return true;
+}
+
+void IoUringEngine::recycle_provided_buffer(uint16_t buffer_id) {
+  // Only the address, length and id are written: the ring tail shares its
+  // slot with the reserved field of the first entry. The entries are indexed
+  // through a plain array because the flexible array member of
+  // io_uring_buf_ring does not start at offset 0 when compiled as C++.
+  auto *entries = reinterpret_cast<io_uring_buf *>(buffer_ring_.get());
+  io_uring_buf &buffer = entries[provided_buffers_tail_ & (buffer_count_ - 1)];
+  buffer.addr = reinterpret_cast<uint64_t>(
+      buffer_storage_.data() + static_cast<size_t>(buffer_id) * buffer_size_);
+  buffer.len = buffer_size_;
+  buffer.bid = buffer_id;
+  ++provided_buffers_tail_;
+}
+
+io_uring_sqe *IoUringEngine::next_submission_entry() {
+  if (sq_local_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) > sq_mask_) {
+    // Queue full: hand the batch to the kernel before taking a new entry.
+    submit_pending(0);
+    if (sq_local_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >
+        sq_mask_) {
+      std::cerr << "io_uring submission queue is full" << std::endl;
+      return nullptr;
+    }
+  }
+  const unsigned index = sq_local_tail_ & sq_mask_;
+  io_uring_sqe *entry = &sqe_entries_[index];
+  std::memset(entry, 0, sizeof(*entry));
+  sq_array_[index] = index;
+  ++sq_local_tail_;
+  return entry;
+}
+
+bool IoUringEngine::submit_pending(unsigned wait_for_completions) {
+  // Buffers recycled while reaping must be visible before new receives.
+  __atomic_store_n(&provided_buffers_->tail, provided_buffers_tail_,
+                   __ATOMIC_RELEASE);
+  __atomic_store_n(sq_tail_, sq_local_tail_, __ATOMIC_RELEASE);
+
+  const unsigned to_submit =
+      sq_local_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+  if (to_submit == 0 && wait_for_completions == 0) {
+    return true;
+  }
+  const unsigned flags = wait_for_completions > 0 ? IORING_ENTER_GETEVENTS : 0;
+  if (io_uring_enter(ring_fd_.get(), to_submit, wait_for_completions, flags) <
+      0) {
+    // Interrupted waits and a momentarily full completion queue are retried
+    // after the pending completions are reaped.
+    if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+      return true;
+    }
+    std::cerr << "io_uring_enter failed with error: " << errno << std::endl;
+    return false;
+  }
+  return true;
+}
+
+void IoUringEngine::arm_accept() {
+  io_uring_sqe *entry = next_submission_entry();
+  if (entry == nullptr) {
+    return;
+  }
+  entry->opcode = IORING_OP_ACCEPT;
+  entry->fd = listen_socket_;
+  entry->accept_flags = SOCK_CLOEXEC;
+  entry->ioprio = IORING_ACCEPT_MULTISHOT;
+  entry->user_data = encode_user_data(Ring_Operation::ACCEPT, 0);
+}
+
+void IoUringEngine::arm_wakeup() {
+  io_uring_sqe *entry = next_submission_entry();
+  if (entry == nullptr) {
+    return;
+  }
+  entry->opcode = IORING_OP_READ;
+  entry->fd = wakeup_fd_.get();
+  entry->addr = reinterpret_cast<uint64_t>(&wakeup_value_);
+  entry->len = sizeof(wakeup_value_);
+  entry->user_data = encode_user_data(Ring_Operation::WAKEUP, 0);
+}
+
+bool IoUringEngine::arm_receive(uint64_t connection_id,
+                                Connection &connection) {
+  io_uring_sqe *entry = next_submission_entry();
+  if (entry == nullptr) {
+    return false;
+  }
+  entry->opcode = IORING_OP_RECV;
+  entry->fd = connection.socket.get();
+  entry->ioprio = IORING_RECV_MULTISHOT;
+  entry->flags = IOSQE_BUFFER_SELECT;
+  entry->buf_group = provided_buffer_group;
+  entry->user_data = encode_user_data(Ring_Operation::RECEIVE, connection_id);
+  ++connection.operations_in_flight;
+  connection.receive_armed = true;
+  return true;
+}
+
+bool IoUringEngine::arm_send(uint64_t connection_id, Connection &connection) {
+  io_uring_sqe *entry = next_submission_entry();
+  if (entry == nullptr) {
+    return false;
+  }
+  entry->opcode = IORING_OP_SEND;
+  entry->fd = connection.socket.get();
+  entry->addr =
+      reinterpret_cast<uint64_t>(connection.protocol.pending_output());
+  entry->len = static_cast<uint32_t>(connection.protocol.pending_output_size());
+  entry->msg_flags = MSG_NOSIGNAL;
+  entry->user_data = encode_user_data(Ring_Operation::SEND, connection_id);
+  ++connection.operations_in_flight;
+  connection.send_in_flight = true;
+  connection.send_started = std::chrono::steady_clock::now();
+  return true;
+}
+
+void IoUringEngine::arm_timer(std::chrono::milliseconds interval) {
+  io_uring_sqe *entry = next_submission_entry();
+  if (entry == nullptr) {
+    return;
+  }
+  timer_interval_.tv_sec = interval.count() / 1000;
+  timer_interval_.tv_nsec = (interval.count() % 1000) * 1000000;
+  entry->opcode = IORING_OP_TIMEOUT;
+  entry->addr = reinterpret_cast<uint64_t>(&timer_interval_);
+  entry->len = 1;
+  entry->user_data = encode_user_data(Ring_Operation::TIMER, 0);
+  timer_armed_ = true;
+}
+
+void IoUringEngine::cancel_receive(uint64_t connection_id) {
+  io_uring_sqe *entry = next_submission_entry();
+  if (entry == nullptr) {
+    return;
+  }
+  entry->opcode = IORING_OP_ASYNC_CANCEL;
+  entry->addr = encode_user_data(Ring_Operation::RECEIVE, connection_id);
+  entry->user_data = encode_user_data(Ring_Operation::CANCEL, connection_id);
+}
+
+void IoUringEngine::flush_output(uint64_t connection_id,
+                                 Connection &connection) {
+  if (connection.send_in_flight) {
+    return;  // handle_send() continues with whatever was produced meanwhile
+  }
+  if (connection.protocol.pending_output_size() > 0) {
+    if (!arm_send(connection_id, connection)) {
+      close_connection(connection_id, connection);
+    }
+  } else if (connection.protocol.finished()) {
+    shutdown(connection.socket.get(), SD_SEND);
+    close_connection(connection_id, connection);
+  }
+}
+
+bool IoUringEngine::run() {
+  if (!ring_fd_.valid()) {
+    std::cerr << "io_uring engine must be initialized before running"
+              << std::endl;
+    reactor_status_ = Reactor_Status::FAILED;
+    return false;
+  }
+
+  reactor_status_ = Reactor_Status::RUNNING;
+  arm_accept();
+  arm_wakeup();
+
+  bool ring_healthy{true};
+  while (!stop_requested_.load(std::memory_order_acquire)) {
+    // One system call submits everything queued while reaping the previous
+    // batch and waits for the next completion.
+    if (!timer_armed_) {
+      const auto timer_interval = get_timer_interval();
+      if (timer_interval.count() > 0) {
+        arm_timer(timer_interval);
+      }
+    }
+    if (!submit_pending(1)) {
+      ring_healthy = false;
+      break;
+    }
+    process_completions();
+    resume_paused_connections();
+    close_slow_readers();
+  }
+
+  // Closing the ring cancels the requests still owned by the kernel before
+  // the connection buffers they reference are released.
+  ring_fd_.close();
+  connections_.clear();
+  reactor_status_ =
+      ring_healthy ? Reactor_Status::STOPPED : Reactor_Status::FAILED;
+  return ring_healthy;
+}
+
+void IoUringEngine::request_stop() {
+  stop_requested_.store(true, std::memory_order_release);
+  if (wakeup_fd_.valid()) {
+    uint64_t one{1};
+    (void)write(wakeup_fd_.get(), &one, sizeof(one));
+  }
+}
+
+void IoUringEngine::process_completions() {
+  unsigned head = *cq_head_;
+  const unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+
+  while (head != tail) {
+    const io_uring_cqe &completion = cqe_entries_[head & cq_mask_];
+    const uint64_t user_data = completion.user_data;
+    const int result = completion.res;
+    const uint32_t flags = completion.flags;
+    ++head;
+
+    switch (decode_operation(user_data)) {
+      case Ring_Operation::ACCEPT:
+        handle_accept(result, flags);
+        break;
+      case Ring_Operation::RECEIVE:
+        handle_receive(decode_connection_id(user_data), result, flags);
+        break;
+      case Ring_Operation::SEND:
+        handle_send(decode_connection_id(user_data), result);
+        break;
+      case Ring_Operation::WAKEUP:
+        if (!stop_requested_.load(std::memory_order_acquire)) {
+          arm_wakeup();
+        }
+        break;
+      case Ring_Operation::CANCEL:
+        break;  // The cancelled receive completes on its own
+      case Ring_Operation::TIMER:
+        timer_armed_ = false;
+        break;
+    }
+  }
+  __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+}
+
+void IoUringEngine::handle_accept(int result, uint32_t flags) {
+  if ((flags & IORING_CQE_F_MORE) == 0U) {
+    arm_accept();  // The multishot accept was terminated, re-arm it
+  }
+  if (result < 0) {
+    if (!is_transient_accept_error(-result)) {
+      get_server_metrics().local().count_error(-result);
+      std::cerr << "accept failed: " << -result << std::endl;
+    }
+    return;
+  }
+  get_server_metrics().local().count_accept();
+
+  const uint64_t connection_id = next_connection_id_++;
+  Connection &connection = connections_[connection_id];
+  connection.socket = SocketWrapper{result};
+  if (!arm_receive(connection_id, connection)) {
+    close_connection(connection_id, connection);
+  }
+}
+
+void IoUringEngine::handle_receive(uint64_t connection_id, int result,
+                                   uint32_t flags) {
+  auto it = connections_.find(connection_id);
+  if ((flags & IORING_CQE_F_BUFFER) != 0U) {
+    const auto buffer_id =
+        static_cast<uint16_t>(flags >> IORING_CQE_BUFFER_SHIFT);
+    if (it != connections_.end() && !it->second.closing && result > 0) {
+      const char *data = buffer_storage_.data() +
+                         static_cast<size_t>(buffer_id) * buffer_size_;
+      get_server_metrics().local().add_bytes_received(
+          static_cast<uint64_t>(result));
+      Connection &connection = it->second;
+      if (connection.flow.is_read_paused()) {
+        connection.held_input.append(data, static_cast<size_t>(result));
+      } else {
+        connection.protocol.on_bytes_received(data,
+                                              static_cast<size_t>(result));
+      }
+    }
+    recycle_provided_buffer(buffer_id);
+  }
+  if (it == connections_.end()) {
+    return;
+  }
+
+  Connection &connection = it->second;
+  const bool receive_still_armed = (flags & IORING_CQE_F_MORE) != 0U;
+  if (!receive_still_armed) {
+    --connection.operations_in_flight;
+    connection.receive_armed = false;
+  }
+  if (connection.closing) {
+    release_if_idle(connection_id);
+    return;
+  }
+
+  if (result > 0 || result == -ENOBUFS || result == -ECANCELED) {
+    // Data, a momentary shortage of provided buffers or a receive cancelled
+    // by flow control: keep receiving unless over a limit.
+    connection.flow.update(connection.protocol, false);
+    if (connection.flow.is_read_paused()) {
+      if (!resume_receive(connection_id, connection)) {
+        return;
+      }
+    } else if (!connection.flow.may_read(connection.protocol)) {
+      pause_receive(connection_id, connection);
+    } else if (!connection.receive_armed &&
+               !connection.protocol.receive_completed() &&
+               !arm_receive(connection_id, connection)) {
+      // The connection may be gone after this, so it is not touched again
+      close_connection(connection_id, connection);
+      return;
+    }
+    flush_output(connection_id, connection);
+  } else if (result == 0) {
+    if (connection.flow.is_read_paused()) {
+      connection.held_end_of_input = true;
+    } else {
+      connection.protocol.on_end_of_input();
+    }
+    flush_output(connection_id, connection);
+  } else {
+    get_server_metrics().local().count_error(-result);
+    std::cerr << "recv failed with error: " << -result << std::endl;
+    close_connection(connection_id, connection);
+  }
+}
+
+void IoUringEngine::handle_send(uint64_t connection_id, int result) {
+  auto it = connections_.find(connection_id);
+  if (it == connections_.end()) {
+    return;
+  }
+
+  Connection &connection = it->second;
+  --connection.operations_in_flight;
+  connection.send_in_flight = false;
+  if (connection.closing) {
+    release_if_idle(connection_id);
+    return;
+  }
+  Thread_Metrics &metrics = get_server_metrics().local();
+  metrics.record_stage(Server_Stage::SEND, std::chrono::steady_clock::now() -
+                                               connection.send_started);
+  if (result < 0) {
+    metrics.count_error(-result);
+    std::cerr << "send failed with error: " << -result << std::endl;
+    close_connection(connection_id, connection);
+    return;
+  }
+
+  // Sends the rest after a short write, or replies queued during this send
+  metrics.add_bytes_sent(static_cast<uint64_t>(result));
+  connection.protocol.consume_output(static_cast<size_t>(result));
+  connection.flow.update(connection.protocol, result > 0);
+  if (resume_receive(connection_id, connection)) {
+    flush_output(connection_id, connection);
+  }
+}
+
+void IoUringEngine::pause_receive(uint64_t connection_id,
+                                  Connection &connection) {
+  if (!connection.flow.is_read_paused()) {
+    connection.flow.set_read_paused(true);
+    if (connection.receive_armed) {
+      cancel_receive(connection_id);
+    }
+  }
+  // Without output of its own only the timer resumes the connection
+  if (connection.protocol.pending_output_size() == 0 &&
+      !connection.in_paused_list) {
+    paused_connections_.push_back(connection_id);
+    connection.in_paused_list = true;
+  }
+}
+
+bool IoUringEngine::resume_receive(uint64_t connection_id,
+                                   Connection &connection) {
+  if (!connection.flow.is_read_paused()) {
+    return true;
+  }
+  if (!process_held_input(connection)) {
+    pause_receive(connection_id, connection);
+    return true;
+  }
+  connection.flow.set_read_paused(false);
+  if (connection.held_end_of_input) {
+    connection.held_end_of_input = false;
+    connection.protocol.on_end_of_input();
+  }
+  // A receive still being cancelled is armed again by its completion
+  if (!connection.receive_armed && !connection.protocol.receive_completed() &&
+      !arm_receive(connection_id, connection)) {
+    close_connection(connection_id, connection);
+    return false;
+  }
+  return true;
+}
+
+bool IoUringEngine::process_held_input(Connection &connection) {
+  // One receive buffer at a time, as if it had just arrived
+  while (connection.flow.may_read(connection.protocol)) {
+    const size_t remaining =
+        connection.held_input.size() - connection.held_input_offset;
+    if (remaining == 0) {
+      std::string{}.swap(connection.held_input);
+      connection.held_input_offset = 0;
+      return true;
+    }
+    const size_t size = std::min<size_t>(remaining, buffer_size_);
+    connection.protocol.on_bytes_received(
+        connection.held_input.data() + connection.held_input_offset, size);
+    connection.held_input_offset += size;
+    connection.flow.update(connection.protocol, false);
+  }
+  return false;
+}
+
+std::chrono::milliseconds IoUringEngine::get_timer_interval() const {
+  if (!paused_connections_.empty()) {
+    return paused_retry_interval;
+  }
+  const auto slow_reader_timeout =
+      get_flow_control().get_limits().slow_reader_timeout;
+  if (slow_reader_timeout.count() > 0 && !connections_.empty()) {
+    return std::min(slow_reader_timeout, slow_reader_check_interval);
+  }
+  return std::chrono::milliseconds{0};
+}
+
+void IoUringEngine::resume_paused_connections() {
+  if (paused_connections_.empty() ||
+      get_flow_control().total_output_over_limit()) {
+    return;
+  }
+  std::vector<uint64_t> paused;
+  paused.swap(paused_connections_);
+  for (const uint64_t connection_id : paused) {
+    auto it = connections_.find(connection_id);
+    if (it != connections_.end() && it->second.in_paused_list) {
+      it->second.in_paused_list = false;
+      if (!it->second.closing &&
+          resume_receive(connection_id, it->second)) {
+        flush_output(connection_id, it->second);
+      }
+    }
+  }
+}
+
+void IoUringEngine::close_slow_readers() {
+  const auto slow_reader_timeout =
+      get_flow_control().get_limits().slow_reader_timeout;
+  const auto now = std::chrono::steady_clock::now();
+  if (slow_reader_timeout.count() == 0 || now < next_slow_reader_check_) {
+    return;
+  }
+  next_slow_reader_check_ =
+      now + std::min(slow_reader_timeout, slow_reader_check_interval);
+  std::vector<uint64_t> slow_readers;
+  for (const auto &[connection_id, connection] : connections_) {
+    if (!connection.closing &&
+        connection.flow.is_slow_reader(connection.protocol, now)) {
+      slow_readers.push_back(connection_id);
+    }
+  }
+  for (const uint64_t connection_id : slow_readers) {
+    get_server_metrics().local().count_slow_reader_closed();
+    close_connection(connection_id, connections_.at(connection_id));
+  }
+}
+
+void IoUringEngine::close_connection(uint64_t connection_id,
+                                     Connection &connection) {
+  connection.closing = true;
+  if (connection.operations_in_flight > 0) {
+    // Completes the armed multishot receive so the connection can be
+    // released once its last completion arrives.
+    shutdown(connection.socket.get(), SHUT_RDWR);
+  }
+  release_if_idle(connection_id);
+}
+
+void IoUringEngine::release_if_idle(uint64_t connection_id) {
+  auto it = connections_.find(connection_id);
+  if (it != connections_.end() && it->second.operations_in_flight == 0) {
+    connections_.erase(it);
+  }
+}
+
+Reactor_Status IoUringEngine::get_reactor_status() const {
+  return reactor_status_;
+}
+
+size_t IoUringEngine::get_connection_count() const {
+  return connections_.size();
+}
+
+}  // namespace WindowsSocketApp
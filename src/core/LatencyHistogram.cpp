@@ -0,0 +1,68 @@
+#include "../include/LatencyHistogram.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace WindowsSocketApp {
+
+LatencyHistogram::LatencyHistogram()
+    : counts_(Buckets::index_for(highest_trackable_value) + 1, 0),
+      total_count_{0},
+      minimum_value_{std::numeric_limits<uint64_t>::max()},
+      maximum_value_{0},
+      value_sum_{0} {}
+
+void LatencyHistogram::record(uint64_t value) {
+  ++counts_[Buckets::index_for(std::min(value, highest_trackable_value))];
+  ++total_count_;
+  minimum_value_ = std::min(minimum_value_, value);
+  maximum_value_ = std::max(maximum_value_, value);
+  value_sum_ += static_cast<long double>(value);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other) {
+  for (size_t i = 0; i < counts_.size(); ++i) {
+    counts_[i] += other.counts_[i];
+  }
+  total_count_ += other.total_count_;
+  minimum_value_ = std::min(minimum_value_, other.minimum_value_);
+  maximum_value_ = std::max(maximum_value_, other.maximum_value_);
+  value_sum_ += other.value_sum_;
+}
+
+void LatencyHistogram::reset() {
+  std::fill(counts_.begin(), counts_.end(), 0);
+  total_count_ = 0;
+  minimum_value_ = std::numeric_limits<uint64_t>::max();
+  maximum_value_ = 0;
+  value_sum_ = 0;
+}
+
+uint64_t LatencyHistogram::get_value_at_percentile(double percentile) const {
+  if (total_count_ == 0) {
+    return 0;
+  }
+  const size_t index = find_percentile_bucket(counts_.data(), counts_.size(),
+                                              total_count_, percentile);
+  if (index == counts_.size()) {
+    return maximum_value_;
+  }
+  return std::min(Buckets::highest_value_at(index), maximum_value_);
+}
+
+uint64_t LatencyHistogram::get_total_count() const { return total_count_; }
+
+uint64_t LatencyHistogram::get_minimum_value() const {
+  return total_count_ == 0 ? 0 : minimum_value_;
+}
+
+uint64_t LatencyHistogram::get_maximum_value() const { return maximum_value_; }
+
+double LatencyHistogram::get_mean_value() const {
+  return total_count_ == 0
+             ? 0.0
+             : static_cast<double>(value_sum_ /
+                                   static_cast<long double>(total_count_));
+}
+
+}  // namespace WindowsSocketApp
@@ -0,0 +1,281 @@
+#include "../include/LoadGenerator.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+#include <thread>
+
+namespace WindowsSocketApp {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Draws request sizes from a Message_Size_Spec; one per thread.
+class Message_Size_Sampler {
+ private:
+  const Message_Size_Spec &spec_;
+  std::mt19937_64 random_engine_;
+  std::uniform_int_distribution<size_t> uniform_sizes_;
+  std::exponential_distribution<double> exponential_sizes_;
+
+ public:
+  Message_Size_Sampler(const Message_Size_Spec &spec_val, uint64_t seed_val)
+      : spec_{spec_val},
+        random_engine_{seed_val},
+        uniform_sizes_{spec_val.minimum_size, spec_val.maximum_size},
+        exponential_sizes_{
+            1.0 / static_cast<double>(std::max<size_t>(spec_val.mean_size,
+                                                       1))} {}
+
+  size_t next() {
+    switch (spec_.distribution) {
+      case Message_Size_Distribution::FIXED:
+        break;
+      case Message_Size_Distribution::UNIFORM:
+        return uniform_sizes_(random_engine_);
+      case Message_Size_Distribution::EXPONENTIAL:
+        return std::clamp(
+            static_cast<size_t>(exponential_sizes_(random_engine_)),
+            spec_.minimum_size, spec_.maximum_size);
+    }
+    return spec_.minimum_size;
+  }
+};
+
+bool parse_size(const std::string &text, size_t &size) {
+  if (text.empty() ||
+      text.find_first_not_of("0123456789") != std::string::npos) {
+    return false;
+  }
+  size = std::strtoull(text.c_str(), nullptr, 10);
+  return true;
+}
+
+}  // namespace
+
+bool Message_Size_Spec::parse(const std::string &text,
+                              Message_Size_Spec &spec) {
+  std::vector<std::string> fields{};
+  size_t field_start{0};
+  while (true) {
+    const size_t separator = text.find(':', field_start);
+    fields.push_back(text.substr(field_start, separator - field_start));
+    if (separator == std::string::npos) {
+      break;
+    }
+    field_start = separator + 1;
+  }
+
+  Message_Size_Spec parsed{};
+  if (fields[0] == "fixed" && fields.size() == 2 &&
+      parse_size(fields[1], parsed.minimum_size)) {
+    parsed.distribution = Message_Size_Distribution::FIXED;
+    parsed.maximum_size = parsed.minimum_size;
+    parsed.mean_size = parsed.minimum_size;
+  } else if (fields[0] == "uniform" && fields.size() == 3 &&
+             parse_size(fields[1], parsed.minimum_size) &&
+             parse_size(fields[2], parsed.maximum_size) &&
+             parsed.minimum_size <= parsed.maximum_size) {
+    parsed.distribution = Message_Size_Distribution::UNIFORM;
+    parsed.mean_size = (parsed.minimum_size + parsed.maximum_size) / 2;
+  } else if (fields[0] == "exponential" &&
+             (fields.size() == 2 || fields.size() == 3) &&
+             parse_size(fields[1], parsed.mean_size) &&
+             parsed.mean_size > 0) {
+    parsed.distribution = Message_Size_Distribution::EXPONENTIAL;
+    parsed.minimum_size = 0;
+    // Without an explicit cap the tail is cut at 16 times the mean
+    parsed.maximum_size = parsed.mean_size * 16;
+    if (fields.size() == 3 && !parse_size(fields[2], parsed.maximum_size)) {
+      return false;
+    }
+  } else {
+    return false;
+  }
+  spec = parsed;
+  return true;
+}
+
+LoadGenerator::LoadGenerator(Load_Generator_Config config_val)
+    : config_{std::move(config_val)} {
+  config_.connection_count = std::max<size_t>(config_.connection_count, 1);
+  config_.thread_count =
+      std::clamp<size_t>(config_.thread_count, 1, config_.connection_count);
+  if (config_.request_rate <= 0) {
+    config_.mode = Load_Mode::CLOSED_LOOP;
+  }
+
+  // Text with the same mix of character classes as ordinary messages
+  static constexpr char alphabet[]{
+      "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 .,!?"};
+  std::mt19937_64 random_engine{config_.connection_count};
+  std::uniform_int_distribution<size_t> letters{0, sizeof(alphabet) - 2};
+  message_text_.resize(config_.message_sizes.maximum_size);
+  for (auto &c : message_text_) {
+    c = alphabet[letters(random_engine)];
+  }
+}
+
+Load_Report LoadGenerator::run() {
+  Load_Report report{};
+  const size_t thread_count{config_.thread_count};
+
+  // All connections are set up before the clock starts
+  std::vector<std::vector<Connection>> thread_connections(thread_count);
+  const auto request_interval = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(
+          config_.mode == Load_Mode::OPEN_LOOP && config_.request_rate > 0
+              ? static_cast<double>(config_.connection_count) /
+                    config_.request_rate
+              : 0.0));
+  for (size_t i = 0; i < config_.connection_count; ++i) {
+    Client client{"", 1024, config_.server_ip, config_.port};
+    client.set_binary_analytics(config_.binary_analytics);
+    client.connect_to_server();
+    if (client.get_client_init_status() !=
+        Client_Initialization_Status::CONNECTED) {
+      ++report.failed_connections;
+      continue;
+    }
+    // Staggered, so the connections' requests are spread over the interval
+    thread_connections[i % thread_count].push_back(
+        Connection{std::move(client),
+                   Clock::time_point{} +
+                       request_interval * i / config_.connection_count});
+  }
+
+  const auto started = Clock::now();
+  const auto deadline = started + config_.duration;
+  std::vector<Load_Report> thread_reports(thread_count);
+  std::vector<std::thread> threads{};
+  for (size_t t = 0; t < thread_count; ++t) {
+    for (auto &connection : thread_connections[t]) {
+      connection.next_request_due += started.time_since_epoch();
+    }
+    threads.emplace_back([this, &thread_connections, &thread_reports,
+                          deadline, t]() {
+      if (config_.mode == Load_Mode::OPEN_LOOP) {
+        run_open_loop(thread_connections[t], deadline, t, thread_reports[t]);
+      } else {
+        run_closed_loop(thread_connections[t], deadline, t,
+                        thread_reports[t]);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  report.elapsed = Clock::now() - started;
+
+  for (const auto &thread_report : thread_reports) {
+    report.completed_requests += thread_report.completed_requests;
+    report.request_bytes += thread_report.request_bytes;
+    report.mismatched_responses += thread_report.mismatched_responses;
+    report.failed_connections += thread_report.failed_connections;
+    report.latencies.merge(thread_report.latencies);
+  }
+  for (auto &connections : thread_connections) {
+    for (auto &connection : connections) {
+      connection.client.shutdown_message_sending();
+    }
+  }
+  return report;
+}
+
+void LoadGenerator::run_closed_loop(std::vector<Connection> &connections,
+                                    Clock::time_point deadline,
+                                    size_t thread_index,
+                                    Load_Report &report) const {
+  Message_Size_Sampler sampler{config_.message_sizes, thread_index + 1};
+  std::vector<size_t> message_sizes(connections.size());
+  std::vector<Clock::time_point> sent_at(connections.size());
+  std::vector<bool> broken(connections.size());
+
+  while (!connections.empty() && Clock::now() < deadline) {
+    // One request on every connection, then the responses in the same order
+    for (size_t i = 0; i < connections.size(); ++i) {
+      message_sizes[i] = sampler.next();
+      sent_at[i] = Clock::now();
+      broken[i] = !send_request(connections[i], message_sizes[i]);
+    }
+    for (size_t i = 0; i < connections.size(); ++i) {
+      if (!broken[i]) {
+        broken[i] = !complete_request(connections[i], message_sizes[i],
+                                      sent_at[i], report);
+      }
+    }
+
+    for (size_t i = connections.size(); i-- > 0;) {
+      if (broken[i]) {
+        ++report.failed_connections;
+        connections.erase(connections.begin() +
+                          static_cast<std::ptrdiff_t>(i));
+      }
+    }
+  }
+}
+
+void LoadGenerator::run_open_loop(std::vector<Connection> &connections,
+                                  Clock::time_point deadline,
+                                  size_t thread_index,
+                                  Load_Report &report) const {
+  Message_Size_Sampler sampler{config_.message_sizes, thread_index + 1};
+  const auto request_interval = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(
+          static_cast<double>(config_.connection_count) /
+          config_.request_rate));
+
+  while (!connections.empty()) {
+    auto next = std::min_element(
+        connections.begin(), connections.end(),
+        [](const Connection &lhs, const Connection &rhs) {
+          return lhs.next_request_due < rhs.next_request_due;
+        });
+    const auto due = next->next_request_due;
+    if (due >= deadline) {
+      return;
+    }
+    std::this_thread::sleep_until(due);
+
+    const size_t message_size = sampler.next();
+    if (!send_request(*next, message_size) ||
+        !complete_request(*next, message_size, due, report)) {
+      ++report.failed_connections;
+      connections.erase(next);
+      continue;
+    }
+    next->next_request_due = due + request_interval;
+  }
+}
+
+bool LoadGenerator::send_request(Connection &connection,
+                                 size_t message_size) const {
+  return connection.client.send_request_frame(message_text_.data(),
+                                              message_size);
+}
+
+bool LoadGenerator::complete_request(Connection &connection,
+                                     size_t message_size,
+                                     Clock::time_point started,
+                                     Load_Report &report) const {
+  if (!connection.client.receive_response_frame()) {
+    return false;
+  }
+  const auto latency = Clock::now() - started;
+  report.latencies.record(static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count()));
+  ++report.completed_requests;
+  report.request_bytes += message_size;
+  if (config_.binary_analytics &&
+      connection.client.get_response_analytics().length != message_size) {
+    ++report.mismatched_responses;
+  }
+  return true;
+}
+
+const Load_Generator_Config &LoadGenerator::get_config() const {
+  return config_;
+}
+
+}  // namespace WindowsSocketApp
@@ -0,0 +1,36 @@
+#include "../include/MessageAnalytics.h"
+
+#include "../include/AnalyticsEncoding.h"
+#include "../include/AnalyticsKernels.h"
+#include "../include/ParallelAnalytics.h"
+
+namespace WindowsSocketApp {
+
+void MessageAnalyzer::update(const char *data, size_t size) {
+  if (size >= parallel_analytics_threshold) {
+    accumulate_message_analytics_parallel(data, size, analytics_,
+                                          get_analytics_pool());
+    return;
+  }
+  accumulate_message_analytics(data, size, analytics_);
+}
+
+void MessageAnalyzer::reset() { analytics_ = MessageAnalytics{}; }
+
+const MessageAnalytics &MessageAnalyzer::get_analytics() const {
+  return analytics_;
+}
+
+MessageAnalytics calculate_message_analytics(const char *data, size_t size) {
+  MessageAnalyzer analyzer;
+  analyzer.update(data, size);
+  return analyzer.get_analytics();
+}
+
+std::string format_message_analytics(const MessageAnalytics &analytics) {
+  Analytics_Text_Buffer text;
+  const size_t text_length = write_message_analytics_text(analytics, text);
+  return std::string(text.data(), text_length);
+}
+
+}  // namespace WindowsSocketApp
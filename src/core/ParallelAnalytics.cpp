@@ -0,0 +1,56 @@
+#include "../include/ParallelAnalytics.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "../include/AnalyticsKernels.h"
+
+namespace WindowsSocketApp {
+
+namespace {
+
+// Each chunk's counters on their own cache line, so workers finishing
+// neighbouring chunks do not invalidate each other's results.
+struct alignas(64) Chunk_Analytics {
+  MessageAnalytics analytics;
+};
+
+void add_analytics(const MessageAnalytics &source, MessageAnalytics &target) {
+  target.length += source.length;
+  target.punctuation_marks_count += source.punctuation_marks_count;
+  target.spaces_count += source.spaces_count;
+  target.digits_count += source.digits_count;
+  target.uppercase_count += source.uppercase_count;
+  target.lowercase_count += source.lowercase_count;
+  target.vowels_count += source.vowels_count;
+  target.consonants_count += source.consonants_count;
+}
+
+}  // namespace
+
+void accumulate_message_analytics_parallel(const char *data, size_t size,
+                                           MessageAnalytics &analytics,
+                                           WorkStealingPool &pool,
+                                           size_t chunk_size) {
+  chunk_size = std::max<size_t>(chunk_size, 1);
+  const size_t chunk_count = (size + chunk_size - 1) / chunk_size;
+  std::vector<Chunk_Analytics> chunks(chunk_count);
+
+  pool.run(chunk_count, [&](size_t chunk) {
+    const size_t offset = chunk * chunk_size;
+    accumulate_message_analytics(data + offset,
+                                 std::min(chunk_size, size - offset),
+                                 chunks[chunk].analytics);
+  });
+
+  for (const auto &chunk : chunks) {
+    add_analytics(chunk.analytics, analytics);
+  }
+}
+
+WorkStealingPool &get_analytics_pool() {
+  static WorkStealingPool analytics_pool;
+  return analytics_pool;
+}
+
+}  // namespace WindowsSocketApp
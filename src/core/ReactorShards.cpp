@@ -0,0 +1,110 @@
+#include "../include/ReactorShards.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <iostream>
+
+namespace WindowsSocketApp {
+
+namespace {
+
+// CPUs the process may run on, in ascending order
+std::vector<int> get_allowed_cpus() {
+  std::vector<int> cpus;
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &allowed)) {
+        cpus.push_back(cpu);
+      }
+    }
+  }
+  return cpus;
+}
+
+bool pin_current_thread(int cpu) {
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  CPU_SET(cpu, &cpus);
+  const int error_code =
+      pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+  if (error_code != 0) {
+    std::cerr << "Failed to pin shard thread to CPU " << cpu << ": "
+              << error_code << std::endl;
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+ReactorShards::ReactorShards(std::vector<SocketWrapper> listen_sockets_val,
+                             size_t read_chunk_size_val, bool pin_to_cpu_val)
+    : read_chunk_size_{read_chunk_size_val},
+      pin_to_cpu_{pin_to_cpu_val},
+      stop_requested_{false} {
+  shards_.reserve(listen_sockets_val.size());
+  for (auto &listen_socket : listen_sockets_val) {
+    Shard shard;
+    shard.listen_socket = std::move(listen_socket);
+    shards_.push_back(std::move(shard));
+  }
+}
+
+void ReactorShards::run_shard(size_t shard_index, int cpu) {
+  // Pinned before the reactor is created, so its memory is first touched
+  // here and placed on this CPU's node
+  if (cpu >= 0) {
+    pin_current_thread(cpu);
+  }
+  Shard &shard = shards_[shard_index];
+  EpollReactor *reactor{nullptr};
+  {
+    auto created = std::make_unique<EpollReactor>(shard.listen_socket.get(),
+                                                  read_chunk_size_);
+    std::lock_guard<std::mutex> lock{reactors_mutex_};
+    shard.reactor = std::move(created);
+    reactor = shard.reactor.get();
+    if (stop_requested_) {
+      reactor->request_stop();
+    }
+  }
+  shard.succeeded = reactor->run();
+}
+
+bool ReactorShards::run() {
+  const std::vector<int> cpus =
+      pin_to_cpu_ ? get_allowed_cpus() : std::vector<int>{};
+
+  std::vector<std::thread> threads;
+  threads.reserve(shards_.size());
+  for (size_t i = 0; i < shards_.size(); ++i) {
+    const int cpu = cpus.empty() ? -1 : cpus[i % cpus.size()];
+    threads.emplace_back(&ReactorShards::run_shard, this, i, cpu);
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  bool succeeded{true};
+  for (const auto &shard : shards_) {
+    succeeded = succeeded && shard.succeeded;
+  }
+  return succeeded;
+}
+
+void ReactorShards::request_stop() {
+  std::lock_guard<std::mutex> lock{reactors_mutex_};
+  stop_requested_ = true;
+  for (auto &shard : shards_) {
+    if (shard.reactor) {
+      shard.reactor->request_stop();
+    }
+  }
+}
+
+size_t ReactorShards::get_shard_count() const { return shards_.size(); }
+
+}  // namespace WindowsSocketApp
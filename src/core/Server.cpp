@@ -1,6 +1,14 @@
 #include "../include/Server.h"
 
-#include "../utils/HelperFunctions.h"
+#include "../include/FlowControl.h"
+#include "../include/ServerMetrics.h"
+#include "../include/WorkerPool.h"
+
+#ifdef __linux__
+#include "../include/EpollReactor.h"
+#include "../include/IoUringEngine.h"
+#include "../include/ReactorShards.h"
+#endif
 
 namespace WindowsSocketApp {
 
@@ -11,21 +19,22 @@ Server::Server(size_t recv_capacity_val, std::string port_val)
       server_sockaddr_struct_state_{Sockaddr_Struct_State::EMPTY},
       result_{nullptr},
       hints_{},
-      listen_socket_{},   // Default constructs to INVALID_SOCKET
-      client_socket_{} {  // Default constructs to INVALID_SOCKET
+      receive_mode_{Session_Receive_Mode::BUFFERED},
+      echo_message_{false},
+      zero_copy_send_{false},
+      reuse_port_{false},
+      listen_socket_{},  // Default constructs to INVALID_SOCKET
+      session_{} {       // Session without a client socket
   hints_.ai_family = default_ai_family;
   hints_.ai_socktype = default_ai_socktype;
   hints_.ai_protocol = default_ai_protocol;
   hints_.ai_flags = default_ai_flags;
-
-  recv_buffer_.reserve(recv_buffer_capacity_);
-  recv_message_analytics_.clear();
 }
 
-void Server::start_server() {
+SocketWrapper Server::open_listen_socket() {
   if (!resolve_address_and_port(nullptr, port_.c_str(), &hints_, result_)) {
     std::cerr << "Failed to resolve server address and port." << std::endl;
-    return;
+    return SocketWrapper{};
   }
   server_sockaddr_struct_state_ = Sockaddr_Struct_State::CREATED;
 
@@ -33,27 +42,41 @@ void Server::start_server() {
     std::cerr << "Error: result_ pointer to addrinfo is null after server "
                  "address resolution"
               << std::endl;
-    return;
+    return SocketWrapper{};
   }
 
-  listen_socket_ = SocketWrapper{create_socket(
+  SocketWrapper listen_socket{create_socket(
       result_->ai_family, result_->ai_socktype, result_->ai_protocol)};
-  if (!listen_socket_.valid()) {
+  if (!listen_socket.valid()) {
     std::cerr << "Failed to create server listen socket" << std::endl;
-    return;
+    return listen_socket;
   }
 
-  if (!bind_socket(listen_socket_.get(), result_->ai_addr,
+  if (reuse_port_ && !enable_reuse_port(listen_socket.get())) {
+    listen_socket.close();
+    return listen_socket;
+  }
+
+  if (!bind_socket(listen_socket.get(), result_->ai_addr,
                    static_cast<int>(result_->ai_addrlen))) {
     std::cerr << "Failed to bind server socket" << std::endl;
-    return;
+    listen_socket.close();
+    return listen_socket;
   }
 
   result_.reset();
   server_sockaddr_struct_state_ = Sockaddr_Struct_State::EMPTY;
 
-  if (!listen_on_socket(listen_socket_.get(), maximum_pending_connections)) {
+  if (!listen_on_socket(listen_socket.get(), maximum_pending_connections)) {
     std::cerr << "Failed to listen on socket" << std::endl;
+    listen_socket.close();
+  }
+  return listen_socket;
+}
+
+void Server::start_server() {
+  listen_socket_ = open_listen_socket();
+  if (!listen_socket_.valid()) {
     return;
   }
   server_initialization_status_ =
@@ -62,109 +85,186 @@ void Server::start_server() {
 }
 
 void Server::accept_connections() {
-  client_socket_ = SocketWrapper{accept_socket(listen_socket_.get())};
+  session_ = ClientSession{SocketWrapper{accept_socket(listen_socket_.get())},
+                           recv_buffer_capacity_, true, receive_mode_};
+  session_.set_echo_message(echo_message_);
+  session_.set_zero_copy_send(zero_copy_send_);
 
-  if (!client_socket_.valid()) {
+  if (!session_.valid()) {
+    get_server_metrics().local().count_error(WSAGetLastError());
     std::cerr << "Failed to accept client connection" << std::endl;
     return;
   }
+  get_server_metrics().local().count_accept();
+  session_.set_slow_reader_timeout(
+      get_flow_control().get_limits().slow_reader_timeout);
 
   server_initialization_status_ =
       Server_Initialization_Status::CLIENT_CONNECTION_HANDLED;
   std::cout << "Client connection handled for client socket: "
-            << client_socket_.get() << std::endl;
-  // No longer need the server socket in this particular single-thread
-  // example, should be re-factored when introducing the multi-threading later
+            << session_.get_socket() << std::endl;
+  // Only a single client is served in this mode, see
+  // serve_with_worker_pool() for the multi-client accept loop.
   listen_socket_.close();
 }
 
-void Server::receive_client_message() {
-  recv_buffer_.clear();
-  recv_buffer_.resize(recv_buffer_capacity_);
+void Server::receive_client_message() { session_.receive_client_message(); }
+
+void Server::calculate_recv_message_analytics() {
+  session_.calculate_recv_message_analytics();
+}
+
+void Server::echo_message_to_client() {
+  session_.echo_message_to_client();
+}
+
+void Server::send_recv_message_analytics_to_client() {
+  session_.send_recv_message_analytics_to_client();
+}
 
-  if (!receive_until_empty_input(client_socket_.get(), recv_buffer_)) {
-    std::cerr << "Failed to receive client message" << std::endl;
+void Server::send_echo_and_analytics_to_client() {
+  session_.send_echo_and_analytics_to_client();
+}
+
+void Server::shutdown_message_sending() {
+  if (!session_.shutdown_message_sending()) {
+    return;
   }
+
+  server_initialization_status_ =
+      Server_Initialization_Status::SHUTDOWN_FOR_SENDING;
 }
 
-void Server::calculate_recv_message_analytics() {
-  size_t recv_message_length{0};
-  int punctuation_marks_count{0};
-  int spaces_count{0};
-  int digits_count{0};
-  int uppercase_count{0};
-  int lowercase_count{0};
-  int vowels_count{0};
-  int consonants_count{0};
-
-  if (!recv_buffer_.empty()) {
-    recv_message_length = recv_buffer_.size();
-
-    for (const auto c : recv_buffer_) {
-      if (c == ' ') {
-        ++spaces_count;
-      } else if ((c >= '!' && c <= '/') || (c >= ':' && c <= '@') ||
-                 (c >= '[' && c <= '`') || (c >= '{' && c <= '~')) {
-        ++punctuation_marks_count;
-      } else if (c >= '0' && c <= '9') {
-        ++digits_count;
-      } else if (c >= 'A' && c <= 'Z') {
-        ++uppercase_count;
-      } else if (c >= 'a' && c <= 'z') {
-        ++lowercase_count;
-      }
-      if (is_vowel(c)) {
-        ++vowels_count;
-      } else if (is_consonant(c)) {
-        ++consonants_count;
+Wire_Format Server::detect_client_wire_format() const {
+  return session_.detect_wire_format();
+}
+
+void Server::serve_framed_client() {
+  if (!session_.serve_frames()) {
+    std::cerr << "Failed to serve framed client" << std::endl;
+    return;
+  }
+
+  server_initialization_status_ =
+      Server_Initialization_Status::SHUTDOWN_FOR_SENDING;
+}
+
+void Server::serve_with_worker_pool(size_t worker_count) {
+  if (server_initialization_status_ !=
+      Server_Initialization_Status::LISTENING_FOR_CONNECTION) {
+    std::cerr << "Server must be listening before serving with a worker pool"
+              << std::endl;
+    return;
+  }
+
+  const Flow_Control_Limits &limits = get_flow_control().get_limits();
+  WorkerPool worker_pool{[](ClientSession &session) { session.serve(); },
+                         worker_count, limits.max_pending_sessions};
+  std::cout << "Worker pool started with " << worker_pool.get_worker_count()
+            << " threads on port " << port_ << std::endl;
+
+  while (true) {
+    SocketWrapper client_socket{accept_socket(listen_socket_.get())};
+    if (!client_socket.valid()) {
+      const auto error_code = WSAGetLastError();
+      get_server_metrics().local().count_error(error_code);
+      if (is_transient_accept_error(error_code)) {
+        continue;
       }
+      std::cerr << "Accept loop stopped" << std::endl;
+      break;
     }
+    get_server_metrics().local().count_accept();
+    ClientSession session{std::move(client_socket), recv_buffer_capacity_,
+                          false, receive_mode_};
+    session.set_echo_message(echo_message_);
+    session.set_zero_copy_send(zero_copy_send_);
+    session.set_slow_reader_timeout(limits.slow_reader_timeout);
+    worker_pool.submit(std::move(session));
   }
+}  // Queued sessions are finished before the worker pool is destroyed
 
-  recv_message_analytics_ =
-      "Received message analytics: Length: " +
-      std::to_string(recv_message_length) +
-      ", punctuation marks count: " + std::to_string(punctuation_marks_count) +
-      ", spaces count: " + std::to_string(spaces_count) +
-      ", digits count: " + std::to_string(digits_count) +
-      ", uppercase letters count: " + std::to_string(uppercase_count) +
-      ", lowercase letters count: " + std::to_string(lowercase_count) +
-      ", vowels count: " + std::to_string(vowels_count) +
-      ", consonants count: " + std::to_string(consonants_count);
-}
+#ifdef __linux__
+void Server::run_event_loop() {
+  if (server_initialization_status_ !=
+      Server_Initialization_Status::LISTENING_FOR_CONNECTION) {
+    std::cerr << "Server must be listening before running the event loop"
+              << std::endl;
+    return;
+  }
 
-void Server::echo_message_to_client() const {
-  if (!send_buffer_content(client_socket_.get(), recv_buffer_)) {
-    std::cerr << "Failed to echo message to client" << std::endl;
-  };
+  EpollReactor reactor{listen_socket_.get(), recv_buffer_capacity_};
+  std::cout << "Event loop started on port " << port_ << std::endl;
+  if (!reactor.run()) {
+    std::cerr << "Event loop terminated with an error" << std::endl;
+  }
 }
 
-void Server::send_recv_message_analytics_to_client() const {
-  if (!send_buffer_content(client_socket_.get(), recv_message_analytics_)) {
-    std::cerr << "Failed to send analytics to client" << std::endl;
+void Server::run_io_uring_loop() {
+  if (server_initialization_status_ !=
+      Server_Initialization_Status::LISTENING_FOR_CONNECTION) {
+    std::cerr << "Server must be listening before running the io_uring loop"
+              << std::endl;
+    return;
+  }
+
+  IoUringEngine engine{listen_socket_.get()};
+  if (!engine.initialize()) {
+    std::cerr << "io_uring is not available, falling back to epoll"
+              << std::endl;
+    run_event_loop();
+    return;
+  }
+  std::cout << "io_uring loop started on port " << port_ << std::endl;
+  if (!engine.run()) {
+    std::cerr << "io_uring loop terminated with an error" << std::endl;
   }
 }
 
-void Server::shutdown_message_sending() {
-  if (!shutdown_sending_side(client_socket_.get())) {
-    std::cerr << "Failed to shutdown server sending side" << std::endl;
+void Server::run_sharded_event_loops(size_t shard_count, bool pin_to_cpu) {
+  if (server_initialization_status_ !=
+          Server_Initialization_Status::LISTENING_FOR_CONNECTION ||
+      !reuse_port_) {
+    std::cerr << "Server must be listening with reuse port enabled before "
+                 "running sharded event loops"
+              << std::endl;
     return;
   }
+  if (shard_count == 0) {
+    shard_count = WorkerPool::default_worker_count();
+  }
 
-  server_initialization_status_ =
-      Server_Initialization_Status::SHUTDOWN_FOR_SENDING;
+  // The first shard takes over the listener of start_server()
+  std::vector<SocketWrapper> listen_sockets;
+  listen_sockets.reserve(shard_count);
+  listen_sockets.push_back(std::move(listen_socket_));
+  while (listen_sockets.size() < shard_count) {
+    SocketWrapper listen_socket = open_listen_socket();
+    if (!listen_socket.valid()) {
+      std::cerr << "Failed to open the listener of shard "
+                << listen_sockets.size() << std::endl;
+      return;
+    }
+    listen_sockets.push_back(std::move(listen_socket));
+  }
+
+  ReactorShards shards{std::move(listen_sockets), recv_buffer_capacity_,
+                       pin_to_cpu};
+  std::cout << "Sharded event loops started on port " << port_ << ": "
+            << shards.get_shard_count() << " shards"
+            << (pin_to_cpu ? ", pinned to CPUs" : "") << std::endl;
+  if (!shards.run()) {
+    std::cerr << "A shard event loop terminated with an error" << std::endl;
+  }
+  server_initialization_status_ = Server_Initialization_Status::NOT_STARTED;
 }
+#endif
 
 Server_Initialization_Status Server::get_server_init_status() const {
   return server_initialization_status_;
 }
 
-void Server::display_recv_buffer() const {
-  for (const auto c : recv_buffer_) {
-    std::cout << c;
-  }
-  std::cout << std::endl;
-}
+void Server::display_recv_buffer() const { session_.display_recv_buffer(); }
 
 size_t Server::get_recv_buffer_capacity() const {
   return recv_buffer_capacity_;
@@ -174,4 +274,28 @@ const std::string &Server::get_port() const { return port_; }
 
 void Server::set_port(std::string port) { this->port_ = std::move(port); }
 
+Session_Receive_Mode Server::get_receive_mode() const { return receive_mode_; }
+
+void Server::set_receive_mode(Session_Receive_Mode receive_mode) {
+  this->receive_mode_ = receive_mode;
+}
+
+bool Server::get_echo_message() const { return echo_message_; }
+
+void Server::set_echo_message(bool echo_message) {
+  this->echo_message_ = echo_message;
+}
+
+bool Server::get_zero_copy_send() const { return zero_copy_send_; }
+
+void Server::set_zero_copy_send(bool zero_copy_send) {
+  this->zero_copy_send_ = zero_copy_send;
+}
+
+bool Server::get_reuse_port() const { return reuse_port_; }
+
+void Server::set_reuse_port(bool reuse_port) {
+  this->reuse_port_ = reuse_port;
+}
+
 }  // namespace WindowsSocketApp
\ No newline at end of file
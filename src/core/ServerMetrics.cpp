@@ -0,0 +1,301 @@
+#include "../include/ServerMetrics.h"
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+
+namespace WindowsSocketApp {
+
+namespace {
+
+uint64_t value_at_percentile(const std::vector<uint64_t> &counts,
+                             uint64_t total_count, double percentile) {
+  const size_t index = find_percentile_bucket(counts.data(), counts.size(),
+                                              total_count, percentile);
+  return index == counts.size()
+             ? 0
+             : Stage_Histogram::Buckets::highest_value_at(index);
+}
+
+}  // namespace
+
+const char *get_server_stage_name(Server_Stage stage) {
+  switch (stage) {
+    case Server_Stage::ACCEPT:
+      return "accept";
+    case Server_Stage::RECEIVE:
+      return "receive";
+    case Server_Stage::ANALYZE:
+      return "analyze";
+    case Server_Stage::SEND:
+      return "send";
+  }
+  return "unknown";
+}
+
+Stage_Histogram::Stage_Histogram() : total_nanoseconds_{0} {
+  for (auto &count : counts_) {
+    count.store(0, std::memory_order_relaxed);
+  }
+}
+
+void Stage_Histogram::record(uint64_t nanoseconds) {
+  auto &count = counts_[Buckets::index_for(
+      std::min(nanoseconds, highest_trackable_value))];
+  count.store(count.load(std::memory_order_relaxed) + 1,
+              std::memory_order_relaxed);
+  total_nanoseconds_.store(
+      total_nanoseconds_.load(std::memory_order_relaxed) + nanoseconds,
+      std::memory_order_relaxed);
+}
+
+void Stage_Histogram::add_to(uint64_t *totals,
+                             uint64_t &total_nanoseconds) const {
+  for (size_t i = 0; i < bucket_count; ++i) {
+    totals[i] += counts_[i].load(std::memory_order_relaxed);
+  }
+  total_nanoseconds += total_nanoseconds_.load(std::memory_order_relaxed);
+}
+
+Thread_Metrics::Thread_Metrics()
+    : accepts_{0},
+      bytes_received_{0},
+      bytes_sent_{0},
+      messages_analyzed_{0},
+      cache_hits_{0},
+      cache_misses_{0},
+      read_pauses_{0},
+      slow_readers_closed_{0},
+      oversized_messages_{0},
+      other_errors_{0},
+      classified_messages_{0} {
+  for (auto &count : message_sizes_) {
+    count.store(0, std::memory_order_relaxed);
+  }
+  for (auto &total : class_totals_) {
+    total.store(0, std::memory_order_relaxed);
+  }
+}
+
+void Thread_Metrics::count_error(int error_code) {
+  // Open addressing over a small table; a slot is taken once its count is
+  // non-zero and keeps its code from then on.
+  const auto start = static_cast<size_t>(static_cast<unsigned>(error_code));
+  for (size_t probe = 0; probe < error_slot_count; ++probe) {
+    Error_Slot &slot = errors_[(start + probe) % error_slot_count];
+    const uint64_t count = slot.count.load(std::memory_order_relaxed);
+    if (count == 0) {
+      slot.code.store(error_code, std::memory_order_relaxed);
+      slot.count.store(1, std::memory_order_release);
+      return;
+    }
+    if (slot.code.load(std::memory_order_relaxed) == error_code) {
+      slot.count.store(count + 1, std::memory_order_relaxed);
+      return;
+    }
+  }
+  add(other_errors_, 1);
+}
+
+void Thread_Metrics::record_stage(Server_Stage stage,
+                                  std::chrono::nanoseconds duration) {
+  stage_latencies_[static_cast<size_t>(stage)].record(
+      static_cast<uint64_t>(std::max<int64_t>(duration.count(), 0)));
+}
+
+void Thread_Metrics::add_message_size(uint64_t size) {
+  add(message_sizes_[get_message_size_bucket(size)], 1);
+}
+
+void Thread_Metrics::add_message_analytics(const MessageAnalytics &analytics) {
+  add_message_size(analytics.length);
+  add(classified_messages_, 1);
+  for (size_t i = 0; i < message_analytics_counters.size(); ++i) {
+    add(class_totals_[i], analytics.*message_analytics_counters[i].counter);
+  }
+}
+
+Thread_Metrics &ServerMetrics::local() {
+  thread_local Thread_Metrics *thread_metrics{nullptr};
+  if (thread_metrics == nullptr) {
+    auto registered = std::make_unique<Thread_Metrics>();
+    thread_metrics = registered.get();
+    std::lock_guard<std::mutex> lock{threads_mutex_};
+    threads_.push_back(std::move(registered));
+  }
+  return *thread_metrics;
+}
+
+Metrics_Snapshot ServerMetrics::snapshot() {
+  Metrics_Snapshot snapshot;
+  std::map<int, uint64_t> errors;
+  std::array<std::vector<uint64_t>, server_stage_count> stage_counts;
+  std::array<uint64_t, server_stage_count> stage_nanoseconds{};
+  for (auto &counts : stage_counts) {
+    counts.assign(Stage_Histogram::bucket_count, 0);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock{threads_mutex_};
+    snapshot.thread_count = threads_.size();
+    for (const auto &thread : threads_) {
+      snapshot.accepts += thread->accepts_.load(std::memory_order_relaxed);
+      snapshot.bytes_received +=
+          thread->bytes_received_.load(std::memory_order_relaxed);
+      snapshot.bytes_sent +=
+          thread->bytes_sent_.load(std::memory_order_relaxed);
+      snapshot.messages_analyzed +=
+          thread->messages_analyzed_.load(std::memory_order_relaxed);
+      snapshot.cache_hits += thread->cache_hits_.load(std::memory_order_relaxed);
+      snapshot.cache_misses +=
+          thread->cache_misses_.load(std::memory_order_relaxed);
+      snapshot.read_pauses +=
+          thread->read_pauses_.load(std::memory_order_relaxed);
+      snapshot.slow_readers_closed +=
+          thread->slow_readers_closed_.load(std::memory_order_relaxed);
+      snapshot.oversized_messages +=
+          thread->oversized_messages_.load(std::memory_order_relaxed);
+      const uint64_t other_errors =
+          thread->other_errors_.load(std::memory_order_relaxed);
+      if (other_errors > 0) {
+        errors[-1] += other_errors;
+      }
+      for (const auto &slot : thread->errors_) {
+        const uint64_t count = slot.count.load(std::memory_order_acquire);
+        if (count > 0) {
+          errors[slot.code.load(std::memory_order_relaxed)] += count;
+        }
+      }
+      for (size_t stage = 0; stage < server_stage_count; ++stage) {
+        thread->stage_latencies_[stage].add_to(stage_counts[stage].data(),
+                                               stage_nanoseconds[stage]);
+      }
+    }
+    add_aggregate_analytics(snapshot.analytics);
+  }
+
+  snapshot.errors.assign(errors.begin(), errors.end());
+  std::stable_sort(snapshot.errors.begin(), snapshot.errors.end(),
+                   [](const auto &lhs, const auto &rhs) {
+                     return lhs.second > rhs.second;
+                   });
+
+  for (size_t stage = 0; stage < server_stage_count; ++stage) {
+    const auto &counts = stage_counts[stage];
+    Stage_Latency_Summary &summary = snapshot.stages[stage];
+    for (size_t i = 0; i < counts.size(); ++i) {
+      summary.count += counts[i];
+      if (counts[i] > 0) {
+        summary.max_nanoseconds =
+            Stage_Histogram::Buckets::highest_value_at(i);
+      }
+    }
+    if (summary.count == 0) {
+      continue;
+    }
+    summary.mean_nanoseconds = stage_nanoseconds[stage] / summary.count;
+    summary.p50_nanoseconds = value_at_percentile(counts, summary.count, 50);
+    summary.p99_nanoseconds = value_at_percentile(counts, summary.count, 99);
+    summary.p999_nanoseconds =
+        value_at_percentile(counts, summary.count, 99.9);
+  }
+  return snapshot;
+}
+
+void ServerMetrics::add_aggregate_analytics(
+    Aggregate_Analytics &analytics) const {
+  for (const auto &thread : threads_) {
+    for (size_t bucket = 0; bucket < message_size_bucket_count; ++bucket) {
+      const uint64_t count =
+          thread->message_sizes_[bucket].load(std::memory_order_relaxed);
+      analytics.message_sizes[bucket] += count;
+      analytics.messages_count += count;
+    }
+    analytics.classified_messages_count +=
+        thread->classified_messages_.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < message_analytics_counters.size(); ++i) {
+      analytics.classes.*message_analytics_counters[i].counter +=
+          static_cast<size_t>(
+              thread->class_totals_[i].load(std::memory_order_relaxed));
+    }
+  }
+}
+
+Aggregate_Analytics ServerMetrics::aggregate_analytics() {
+  Aggregate_Analytics analytics;
+  std::lock_guard<std::mutex> lock{threads_mutex_};
+  add_aggregate_analytics(analytics);
+  return analytics;
+}
+
+ServerMetrics &get_server_metrics() {
+  static ServerMetrics server_metrics;
+  return server_metrics;
+}
+
+std::string format_metrics_report(const Metrics_Snapshot &snapshot) {
+  std::ostringstream report;
+  report << "Server metrics (" << snapshot.thread_count << " threads)\n"
+         << "accepts: " << snapshot.accepts << '\n'
+         << "bytes received: " << snapshot.bytes_received << '\n'
+         << "bytes sent: " << snapshot.bytes_sent << '\n'
+         << "messages analyzed: " << snapshot.messages_analyzed << '\n';
+  const uint64_t cache_lookups = snapshot.cache_hits + snapshot.cache_misses;
+  if (cache_lookups > 0) {
+    report << "analytics cache: " << snapshot.cache_hits << " hits, "
+           << snapshot.cache_misses << " misses, hit ratio "
+           << 100.0 * static_cast<double>(snapshot.cache_hits) /
+                  static_cast<double>(cache_lookups)
+           << "%\n";
+  }
+  report << "flow control: " << snapshot.read_pauses << " read pauses, "
+         << snapshot.slow_readers_closed << " slow readers closed, "
+         << snapshot.oversized_messages << " oversized messages rejected\n"
+         << "errors:";
+  if (snapshot.errors.empty()) {
+    report << " none";
+  }
+  for (const auto &[code, count] : snapshot.errors) {
+    report << ' ' << (code == -1 ? std::string{"other"} : std::to_string(code))
+           << " x" << count;
+  }
+  report << '\n';
+
+  const Aggregate_Analytics &analytics = snapshot.analytics;
+  report << "analytics totals: " << analytics.messages_count << " messages, "
+         << analytics.classified_messages_count << " classified:";
+  for (size_t i = 0; i < message_analytics_counters.size(); ++i) {
+    report << (i == 0 ? " " : ", ") << message_analytics_counters[i].name
+           << ' ' << analytics.classes.*message_analytics_counters[i].counter;
+  }
+  report << "\nmessage sizes (bytes):";
+  if (analytics.messages_count == 0) {
+    report << " none";
+  }
+  for (size_t bucket = 0; bucket < message_size_bucket_count; ++bucket) {
+    if (analytics.message_sizes[bucket] == 0) {
+      continue;
+    }
+    report << ' ' << get_message_size_bucket_label(bucket) << " x"
+           << analytics.message_sizes[bucket];
+  }
+  report << '\n';
+
+  // Latencies in microseconds, to within the histogram precision
+  const auto microseconds = [](uint64_t nanoseconds) {
+    return static_cast<double>(nanoseconds) / 1000.0;
+  };
+  for (size_t stage = 0; stage < server_stage_count; ++stage) {
+    const Stage_Latency_Summary &summary = snapshot.stages[stage];
+    report << get_server_stage_name(static_cast<Server_Stage>(stage))
+           << " latency (us): count " << summary.count << ", mean "
+           << microseconds(summary.mean_nanoseconds) << ", p50 "
+           << microseconds(summary.p50_nanoseconds) << ", p99 "
+           << microseconds(summary.p99_nanoseconds) << ", p99.9 "
+           << microseconds(summary.p999_nanoseconds) << ", max "
+           << microseconds(summary.max_nanoseconds) << '\n';
+  }
+  return report.str();
+}
+
+}  // namespace WindowsSocketApp
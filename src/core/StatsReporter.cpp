@@ -0,0 +1,147 @@
+#include "../include/StatsReporter.h"
+
+#include <csignal>
+
+#include "../include/NetworkTypes.h"
+#include "../include/ServerMetrics.h"
+#include "../include/WinSockFunctions.h"
+
+namespace WindowsSocketApp {
+
+namespace {
+
+#ifndef _WIN32
+// Write end of the signal pipe, for the signal handler
+volatile sig_atomic_t dump_signal_pipe{-1};
+
+constexpr char dump_request{'d'};
+constexpr char stop_request{'q'};
+
+extern "C" void request_metrics_dump(int /*signal_number*/) {
+  const int saved_errno = errno;
+  if (dump_signal_pipe != -1) {
+    (void)write(dump_signal_pipe, &dump_request, 1);
+  }
+  errno = saved_errno;
+}
+#endif
+
+}  // namespace
+
+StatsReporter::StatsReporter() : stop_requested_{false} {}
+
+StatsReporter::~StatsReporter() { stop(); }
+
+bool StatsReporter::start_stats_port(const std::string &port) {
+  addrinfo hints{};
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_protocol = IPPROTO_TCP;
+  AddrInfoPtr address{nullptr};
+  if (!resolve_address_and_port("127.0.0.1", port.c_str(), &hints, address)) {
+    return false;
+  }
+  listen_socket_ = SocketWrapper{create_socket(
+      address->ai_family, address->ai_socktype, address->ai_protocol)};
+  if (!listen_socket_.valid() ||
+      !bind_socket(listen_socket_.get(), address->ai_addr,
+                   static_cast<int>(address->ai_addrlen)) ||
+      !listen_on_socket(listen_socket_.get(), SOMAXCONN)) {
+    std::cerr << "Failed to open stats port " << port << std::endl;
+    listen_socket_.close();
+    return false;
+  }
+  port_thread_ = std::thread{[this]() { serve_stats_port(); }};
+  std::cout << "Stats available on 127.0.0.1:" << port << std::endl;
+  return true;
+}
+
+void StatsReporter::serve_stats_port() {
+  while (!stop_requested_.load(std::memory_order_acquire)) {
+    SocketWrapper client_socket{
+        accept(listen_socket_.get(), nullptr, nullptr)};
+    if (!client_socket.valid()) {
+      if (stop_requested_.load(std::memory_order_acquire) ||
+          !is_transient_accept_error(WSAGetLastError())) {
+        return;
+      }
+      continue;
+    }
+    const std::string report =
+        format_metrics_report(get_server_metrics().snapshot());
+    send_buffer_content(client_socket.get(), report, false);
+    shutdown_sending_side(client_socket.get());
+  }
+}
+
+bool StatsReporter::install_dump_signal() {
+#ifdef _WIN32
+  return false;
+#else
+  int descriptors[2];
+  if (pipe(descriptors) == -1) {
+    std::cerr << "Failed to create the stats signal pipe: " << errno
+              << std::endl;
+    return false;
+  }
+  signal_pipe_read_ = SocketWrapper{descriptors[0]};
+  signal_pipe_write_ = SocketWrapper{descriptors[1]};
+  dump_signal_pipe = descriptors[1];
+  signal_thread_ = std::thread{[this]() { print_on_signal(); }};
+
+  struct sigaction action {};
+  action.sa_handler = request_metrics_dump;
+  sigemptyset(&action.sa_mask);
+  action.sa_flags = SA_RESTART;
+  if (sigaction(SIGUSR1, &action, nullptr) == -1) {
+    std::cerr << "Failed to install the SIGUSR1 handler: " << errno
+              << std::endl;
+    return false;
+  }
+  return true;
+#endif
+}
+
+void StatsReporter::print_on_signal() {
+#ifndef _WIN32
+  char request{0};
+  while (true) {
+    const ssize_t read_result = read(signal_pipe_read_.get(), &request, 1);
+    if (read_result == -1 && errno == EINTR) {
+      continue;
+    }
+    if (read_result != 1 || request == stop_request) {
+      return;
+    }
+    std::cout << format_metrics_report(get_server_metrics().snapshot())
+              << std::flush;
+  }
+#endif
+}
+
+void StatsReporter::stop() {
+  stop_requested_.store(true, std::memory_order_release);
+  if (port_thread_.joinable()) {
+    // Wakes the blocked accept()
+#ifdef _WIN32
+    listen_socket_.close();
+#else
+    shutdown(listen_socket_.get(), SHUT_RDWR);
+#endif
+    port_thread_.join();
+  }
+  listen_socket_.close();
+
+#ifndef _WIN32
+  if (signal_thread_.joinable()) {
+    signal(SIGUSR1, SIG_IGN);
+    dump_signal_pipe = -1;
+    (void)write(signal_pipe_write_.get(), &stop_request, 1);
+    signal_thread_.join();
+  }
+  signal_pipe_read_.close();
+  signal_pipe_write_.close();
+#endif
+}
+
+}  // namespace WindowsSocketApp
@@ -0,0 +1,62 @@
+#include "../include/StreamingReceiver.h"
+
+#include <algorithm>
+#include <iostream>
+#include <thread>
+
+#include "../include/ByteRingBuffer.h"
+
+namespace WindowsSocketApp {
+
+StreamingReceiver::StreamingReceiver(size_t ring_capacity_val,
+                                     bool log_progress_val)
+    : ring_capacity_{ring_capacity_val}, log_progress_{log_progress_val} {}
+
+bool StreamingReceiver::receive_and_analyze(SOCKET sender_socket,
+                                            MessageAnalyzer &analyzer) const {
+  ByteRingBuffer ring{ring_capacity_};
+
+  std::thread analysis_thread{[&ring, &analyzer] {
+    while (true) {
+      const auto region = ring.acquire_read_region();
+      if (region.size == 0) {
+        return;
+      }
+      analyzer.update(region.data, region.size);
+      ring.commit_read(region.size);
+    }
+  }};
+
+  bool received_all{true};
+  while (true) {
+    const auto region = ring.acquire_write_region();
+    const auto read_size = std::min(region.size, maximum_read_size);
+    int i_receive_result =
+        recv(sender_socket, region.data, static_cast<int>(read_size), 0);
+    if (i_receive_result > 0) {
+      if (log_progress_) {
+        std::cout << "Bytes received: " << i_receive_result << '\n';
+      }
+      ring.commit_write(static_cast<size_t>(i_receive_result));
+    } else if (i_receive_result == 0) {
+      if (log_progress_) {
+        std::cout << "Connection closing...\n";
+      }
+      break;
+    } else {
+      std::cout << "recv failed with error: " << WSAGetLastError() << std::endl;
+      received_all = false;
+      break;
+    }
+  }
+
+  if (received_all) {
+    ring.close_writer();  // Let the analysis drain the rest of the ring
+  } else {
+    ring.abort();
+  }
+  analysis_thread.join();
+  return received_all;
+}
+
+}  // namespace WindowsSocketApp
@@ -0,0 +1,301 @@
+#include "../include/TopWords.h"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+#include "../include/AnalyticsCache.h"
+
+namespace WindowsSocketApp {
+
+namespace {
+
+// Sketch sizes: a message's sketches are cleared for every message, the
+// traffic's are shared by all the messages a thread analyzes
+constexpr size_t message_sketch_width{256};
+constexpr size_t message_sketch_capacity{32};
+constexpr size_t traffic_sketch_width{4096};
+constexpr size_t traffic_sketch_capacity{64};
+
+constexpr std::chrono::milliseconds default_window{60000};
+
+// Word bytes folded to lowercase; 0 for the bytes that end a word
+constexpr std::array<uint8_t, 256> make_word_bytes() {
+  std::array<uint8_t, 256> word_bytes{};
+  for (size_t value = 0; value < word_bytes.size(); ++value) {
+    if ((value >= 'a' && value <= 'z') || (value >= '0' && value <= '9') ||
+        value >= 0x80) {
+      word_bytes[value] = static_cast<uint8_t>(value);
+    } else if (value >= 'A' && value <= 'Z') {
+      word_bytes[value] = static_cast<uint8_t>(value | 0x20U);
+    }
+  }
+  return word_bytes;
+}
+
+constexpr std::array<uint8_t, 256> word_bytes{make_word_bytes()};
+
+struct Counted_Term {
+  uint64_t count;
+  const Sketch_Term *term;
+};
+
+// Most frequent first; equal counts in the order of their text, so replies
+// do not depend on the order terms entered the sketches
+void rank_terms(std::vector<Counted_Term> &terms, Ranked_Terms &ranked) {
+  const auto before = [](const Counted_Term &lhs, const Counted_Term &rhs) {
+    if (lhs.count != rhs.count) {
+      return lhs.count > rhs.count;
+    }
+    return std::lexicographical_compare(
+        lhs.term->text.begin(), lhs.term->text.begin() + lhs.term->length,
+        rhs.term->text.begin(), rhs.term->text.begin() + rhs.term->length);
+  };
+  const size_t reported = std::min(terms.size(), ranked.size());
+  std::partial_sort(terms.begin(),
+                    terms.begin() + static_cast<std::ptrdiff_t>(reported),
+                    terms.end(), before);
+  ranked = Ranked_Terms{};
+  for (size_t i = 0; i < reported; ++i) {
+    ranked[i].count = terms[i].count;
+    ranked[i].term = *terms[i].term;
+  }
+}
+
+void rank_candidates(const WordSketch &sketch, Ranked_Terms &ranked) {
+  std::vector<Counted_Term> terms;
+  terms.reserve(sketch.get_candidate_count());
+  for (size_t i = 0; i < sketch.get_candidate_count(); ++i) {
+    terms.push_back(
+        Counted_Term{sketch.get_candidate_count(i),
+                     &sketch.get_candidate_term(i)});
+  }
+  rank_terms(terms, ranked);
+}
+
+int64_t to_milliseconds(std::chrono::steady_clock::time_point time) {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             time.time_since_epoch())
+      .count();
+}
+
+}  // namespace
+
+Traffic_Words_Shard::Traffic_Words_Shard()
+    : words_{WordSketch{traffic_sketch_width, traffic_sketch_capacity},
+             WordSketch{traffic_sketch_width, traffic_sketch_capacity}},
+      bigrams_{WordSketch{traffic_sketch_width, traffic_sketch_capacity},
+               WordSketch{traffic_sketch_width, traffic_sketch_capacity}},
+      current_{0},
+      rotated_at_{std::chrono::steady_clock::now()} {}
+
+std::unique_lock<std::mutex> Traffic_Words_Shard::lock_for_update(
+    std::chrono::steady_clock::time_point now,
+    std::chrono::milliseconds window) {
+  std::unique_lock<std::mutex> lock{mutex_};
+  if (now - rotated_at_ >= window) {
+    // Both generations are stale after two windows without traffic
+    if (now - rotated_at_ >= 2 * window) {
+      words_[current_].clear();
+      bigrams_[current_].clear();
+    }
+    current_ ^= 1U;
+    words_[current_].clear();
+    bigrams_[current_].clear();
+    rotated_at_ = now;
+  }
+  return lock;
+}
+
+void Traffic_Words_Shard::add_word(uint64_t hash, const char *word,
+                                   size_t size) {
+  words_[current_].add(hash, word, size);
+}
+
+void Traffic_Words_Shard::add_bigram(uint64_t hash, const char *bigram,
+                                     size_t size) {
+  bigrams_[current_].add(hash, bigram, size);
+}
+
+TrafficWords::TrafficWords()
+    : window_milliseconds_{default_window.count()},
+      next_refresh_{0},
+      merged_{std::make_shared<const Merged_Terms>()} {}
+
+Traffic_Words_Shard &TrafficWords::local() {
+  thread_local Traffic_Words_Shard *shard{nullptr};
+  if (shard == nullptr) {
+    auto registered = std::make_unique<Traffic_Words_Shard>();
+    shard = registered.get();
+    std::lock_guard<std::mutex> lock{shards_mutex_};
+    shards_.push_back(std::move(registered));
+  }
+  return *shard;
+}
+
+std::chrono::milliseconds TrafficWords::get_window() const {
+  return std::chrono::milliseconds{
+      window_milliseconds_.load(std::memory_order_relaxed)};
+}
+
+void TrafficWords::set_window(std::chrono::milliseconds window) {
+  window_milliseconds_.store(std::max<int64_t>(window.count(), 1),
+                             std::memory_order_relaxed);
+}
+
+void TrafficWords::refresh(std::chrono::steady_clock::time_point now) {
+  std::vector<Traffic_Words_Shard *> shards;
+  {
+    std::lock_guard<std::mutex> lock{shards_mutex_};
+    for (const auto &shard : shards_) {
+      shards.push_back(shard.get());
+    }
+  }
+  const std::chrono::milliseconds window{get_window()};
+
+  // The candidates of every shard, each estimated over all the shards
+  using Sketches = std::array<WordSketch, 2> Traffic_Words_Shard::*;
+  const auto merge = [&shards, now, window](Sketches sketches,
+                                            Ranked_Terms &ranked) {
+    std::vector<uint64_t> hashes;
+    std::vector<Sketch_Term> texts;
+    std::unordered_map<uint64_t, size_t> indexes;
+    for (Traffic_Words_Shard *shard : shards) {
+      // Idle threads' windows expire here
+      const auto lock = shard->lock_for_update(now, window);
+      for (const WordSketch &sketch : shard->*sketches) {
+        for (size_t i = 0; i < sketch.get_candidate_count(); ++i) {
+          const uint64_t hash = sketch.get_candidate_hash(i);
+          if (indexes.emplace(hash, hashes.size()).second) {
+            hashes.push_back(hash);
+            texts.push_back(sketch.get_candidate_term(i));
+          }
+        }
+      }
+    }
+    std::vector<uint64_t> counts(hashes.size(), 0);
+    for (Traffic_Words_Shard *shard : shards) {
+      std::lock_guard<std::mutex> lock{shard->mutex_};
+      for (const WordSketch &sketch : shard->*sketches) {
+        if (sketch.get_total() == 0) {
+          continue;
+        }
+        for (size_t i = 0; i < hashes.size(); ++i) {
+          counts[i] += sketch.estimate(hashes[i]);
+        }
+      }
+    }
+    std::vector<Counted_Term> terms;
+    terms.reserve(hashes.size());
+    for (size_t i = 0; i < hashes.size(); ++i) {
+      terms.push_back(Counted_Term{counts[i], &texts[i]});
+    }
+    rank_terms(terms, ranked);
+  };
+
+  auto merged = std::make_shared<Merged_Terms>();
+  merge(&Traffic_Words_Shard::words_, merged->words);
+  merge(&Traffic_Words_Shard::bigrams_, merged->bigrams);
+  std::atomic_store(&merged_,
+                    std::shared_ptr<const Merged_Terms>{std::move(merged)});
+}
+
+void TrafficWords::get_top_terms(Ranked_Terms &words, Ranked_Terms &bigrams) {
+  const auto now = std::chrono::steady_clock::now();
+  if (to_milliseconds(now) >= next_refresh_.load(std::memory_order_relaxed)) {
+    // One reply refreshes; the others go on with the last merge
+    std::unique_lock<std::mutex> lock{refresh_mutex_, std::try_to_lock};
+    if (lock.owns_lock() &&
+        to_milliseconds(now) >= next_refresh_.load(std::memory_order_relaxed)) {
+      refresh(now);
+      next_refresh_.store(to_milliseconds(now) + refresh_interval.count(),
+                          std::memory_order_relaxed);
+    }
+  }
+  const std::shared_ptr<const Merged_Terms> merged{std::atomic_load(&merged_)};
+  words = merged->words;
+  bigrams = merged->bigrams;
+}
+
+TrafficWords &get_traffic_words() {
+  static TrafficWords traffic_words;
+  return traffic_words;
+}
+
+TopWordsAnalyzer::TopWordsAnalyzer()
+    : words_{message_sketch_width, message_sketch_capacity},
+      bigrams_{message_sketch_width, message_sketch_capacity},
+      word_{},
+      word_size_{0},
+      word_too_long_{false},
+      previous_word_{},
+      previous_word_size_{0} {}
+
+void TopWordsAnalyzer::end_word(Traffic_Words_Shard &shard) {
+  if (word_too_long_) {
+    // Pairs do not span a skipped token
+    previous_word_size_ = 0;
+  } else {
+    const uint64_t hash = hash_message_bytes(word_.data(), word_size_);
+    words_.add(hash, word_.data(), word_size_);
+    shard.add_word(hash, word_.data(), word_size_);
+    if (previous_word_size_ > 0) {
+      char bigram[top_words_max_term_size];
+      std::memcpy(bigram, previous_word_.data(), previous_word_size_);
+      bigram[previous_word_size_] = ' ';
+      std::memcpy(bigram + previous_word_size_ + 1, word_.data(), word_size_);
+      const size_t bigram_size = previous_word_size_ + 1 + word_size_;
+      const uint64_t bigram_hash = hash_message_bytes(bigram, bigram_size);
+      bigrams_.add(bigram_hash, bigram, bigram_size);
+      shard.add_bigram(bigram_hash, bigram, bigram_size);
+    }
+    previous_word_ = word_;
+    previous_word_size_ = word_size_;
+  }
+  word_size_ = 0;
+  word_too_long_ = false;
+}
+
+void TopWordsAnalyzer::update(const char *data, size_t size) {
+  TrafficWords &traffic_words = get_traffic_words();
+  Traffic_Words_Shard &shard = traffic_words.local();
+  const auto lock = shard.lock_for_update(std::chrono::steady_clock::now(),
+                                          traffic_words.get_window());
+  const auto *bytes = reinterpret_cast<const unsigned char *>(data);
+  for (size_t i = 0; i < size; ++i) {
+    const uint8_t word_byte = word_bytes[bytes[i]];
+    if (word_byte != 0) {
+      if (word_size_ < word_.size()) {
+        word_[word_size_++] = static_cast<char>(word_byte);
+      } else {
+        word_too_long_ = true;
+      }
+    } else if (word_size_ > 0) {
+      end_word(shard);
+    }
+  }
+}
+
+void TopWordsAnalyzer::finish(Top_Words_Analytics &analytics) {
+  if (word_size_ > 0) {
+    TrafficWords &traffic_words = get_traffic_words();
+    Traffic_Words_Shard &shard = traffic_words.local();
+    const auto lock = shard.lock_for_update(std::chrono::steady_clock::now(),
+                                            traffic_words.get_window());
+    end_word(shard);
+  }
+  rank_candidates(words_, analytics.message_words);
+  rank_candidates(bigrams_, analytics.message_bigrams);
+  get_traffic_words().get_top_terms(analytics.traffic_words,
+                                    analytics.traffic_bigrams);
+}
+
+void TopWordsAnalyzer::reset() {
+  words_.clear();
+  bigrams_.clear();
+  word_size_ = 0;
+  word_too_long_ = false;
+  previous_word_size_ = 0;
+}
+
+}  // namespace WindowsSocketApp
@@ -0,0 +1,553 @@
+#include "../include/Utf8Analytics.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "../include/AnalyticsKernels.h"
+#include "../include/UnicodeTables.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define UTF8_X86_64 1
+#include <immintrin.h>
+#else
+#define UTF8_X86_64 0
+#endif
+
+// As in AnalyticsKernels.cpp: only the AVX2 functions are compiled for AVX2
+#if defined(__GNUC__) || defined(__clang__)
+#define UTF8_TARGET(isa) __attribute__((target(isa)))
+#else
+#define UTF8_TARGET(isa)
+#endif
+
+namespace WindowsSocketApp {
+
+namespace {
+
+// Length of the sequence a lead byte starts, assuming it is valid
+size_t get_sequence_size(unsigned char lead) {
+  if (lead >= 0xF0U) {
+    return 4;
+  }
+  return lead >= 0xE0U ? 3 : 2;
+}
+
+// Decodes the code point at bytes[i], which must be below size. Returns its
+// length in bytes, or 0 when the sequence is not valid UTF-8: a stray
+// continuation byte, a truncated sequence, an overlong encoding, a
+// surrogate or a value above U+10FFFF.
+size_t decode_code_point(const unsigned char *bytes, size_t size, size_t i,
+                         uint32_t &code_point) {
+  const unsigned char lead = bytes[i];
+  if (lead < 0x80U) {
+    code_point = lead;
+    return 1;
+  }
+  size_t length;
+  uint32_t minimum;
+  if (lead >= 0xC2U && lead <= 0xDFU) {
+    length = 2;
+    minimum = 0x80;
+    code_point = lead & 0x1FU;
+  } else if (lead >= 0xE0U && lead <= 0xEFU) {
+    length = 3;
+    minimum = 0x800;
+    code_point = lead & 0x0FU;
+  } else if (lead >= 0xF0U && lead <= 0xF4U) {
+    length = 4;
+    minimum = 0x10000;
+    code_point = lead & 0x07U;
+  } else {
+    return 0;
+  }
+  if (size - i < length) {
+    return 0;
+  }
+  for (size_t k = 1; k < length; ++k) {
+    const unsigned char byte = bytes[i + k];
+    if ((byte & 0xC0U) != 0x80U) {
+      return 0;
+    }
+    code_point = (code_point << 6U) | (byte & 0x3FU);
+  }
+  if (code_point < minimum || code_point > 0x10FFFF ||
+      (code_point >= 0xD800 && code_point <= 0xDFFF)) {
+    return 0;
+  }
+  return length;
+}
+
+// Code points counted per Unicode_Class: incrementing a counter picked by
+// the class avoids a branch per code point that mixed text mispredicts.
+struct Class_Counts {
+  uint64_t code_points{0};
+  std::array<uint64_t, 8> classes{};
+};
+
+void add_class_counts(const Class_Counts &counts, Utf8_Analytics &analytics) {
+  const auto count = [&counts](Unicode_Class unicode_class) {
+    return counts.classes[static_cast<size_t>(unicode_class)];
+  };
+  analytics.code_points_count += counts.code_points;
+  analytics.uppercase_count += count(Unicode_Class::UPPERCASE);
+  analytics.lowercase_count += count(Unicode_Class::LOWERCASE);
+  analytics.letters_count += count(Unicode_Class::UPPERCASE) +
+                             count(Unicode_Class::LOWERCASE) +
+                             count(Unicode_Class::OTHER_LETTER);
+  analytics.digits_count += count(Unicode_Class::DIGIT);
+  analytics.whitespace_count += count(Unicode_Class::WHITESPACE);
+  analytics.punctuation_count += count(Unicode_Class::PUNCTUATION);
+}
+
+// Counts the code points of bytes[begin, ...) up to the first one ending at
+// or after end. Returns the offset after it, or 0 on an invalid sequence.
+size_t count_code_points(const unsigned char *bytes, size_t size, size_t begin,
+                         size_t end, Class_Counts &counts) {
+  size_t i = begin;
+  while (i < end) {
+    uint32_t code_point;
+    const size_t length = decode_code_point(bytes, size, i, code_point);
+    if (length == 0) {
+      return 0;
+    }
+    ++counts.code_points;
+    ++counts.classes[static_cast<size_t>(get_unicode_class(code_point))];
+    i += length;
+  }
+  return i;
+}
+
+bool scalar_validate(const char *data, size_t size) {
+  const auto *bytes = reinterpret_cast<const unsigned char *>(data);
+  size_t i = 0;
+  while (i < size) {
+    uint32_t code_point;
+    const size_t length = decode_code_point(bytes, size, i, code_point);
+    if (length == 0) {
+      return false;
+    }
+    i += length;
+  }
+  return true;
+}
+
+// Validates and counts in one pass
+bool scalar_kernel(const char *data, size_t size, Utf8_Analytics &analytics) {
+  const auto *bytes = reinterpret_cast<const unsigned char *>(data);
+  Class_Counts counts;
+  const bool valid =
+      size == 0 || count_code_points(bytes, size, 0, size, counts) != 0;
+  add_class_counts(counts, analytics);
+  return valid;
+}
+
+#if UTF8_X86_64
+
+// Error bits of the lookup validator. Each table below maps a nibble of a
+// pair of consecutive bytes (the high and low nibbles of the first, the high
+// nibble of the second) to the errors that pair could be; a pair is an error
+// when all three agree on one.
+constexpr uint8_t too_short{1U << 0U};   // lead not followed by continuation
+constexpr uint8_t too_long{1U << 1U};    // ASCII followed by continuation
+constexpr uint8_t overlong_3{1U << 2U};  // E0 followed by 80..9F
+constexpr uint8_t too_large{1U << 3U};   // F4 followed by 90..BF, or F5..
+constexpr uint8_t surrogate{1U << 4U};   // ED followed by A0..BF
+constexpr uint8_t overlong_2{1U << 5U};  // C0 or C1
+constexpr uint8_t too_large_1000{1U << 6U};  // F5.. followed by 80..8F
+constexpr uint8_t overlong_4{1U << 6U};  // F0 followed by 80..8F
+constexpr uint8_t two_conts{1U << 7U};   // two continuations in a row
+// Errors decided by the first byte's high nibble alone
+constexpr uint8_t carry{too_short | too_long | two_conts};
+
+constexpr std::array<uint8_t, 16> byte_1_high_table{
+    too_long, too_long, too_long, too_long,
+    too_long, too_long, too_long, too_long,
+    two_conts, two_conts, two_conts, two_conts,
+    too_short | overlong_2,
+    too_short,
+    too_short | overlong_3 | surrogate,
+    too_short | too_large | too_large_1000 | overlong_4};
+
+constexpr std::array<uint8_t, 16> byte_1_low_table{
+    carry | overlong_3 | overlong_2 | overlong_4,
+    carry | overlong_2,
+    carry,
+    carry,
+    carry | too_large,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000 | surrogate,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000};
+
+constexpr std::array<uint8_t, 16> byte_2_high_table{
+    too_short, too_short, too_short, too_short,
+    too_short, too_short, too_short, too_short,
+    too_long | overlong_2 | two_conts | overlong_3 | too_large_1000 |
+        overlong_4,
+    too_long | overlong_2 | two_conts | overlong_3 | too_large,
+    too_long | overlong_2 | two_conts | surrogate | too_large,
+    too_long | overlong_2 | two_conts | surrogate | too_large,
+    too_short, too_short, too_short, too_short};
+
+// Bit h of entry l is set when the ASCII byte 0xhl is punctuation (P*)
+std::array<uint8_t, 16> build_ascii_punctuation_rows() {
+  std::array<uint8_t, 16> rows{};
+  for (uint32_t value = 0; value < 0x80; ++value) {
+    if (get_unicode_class(value) == Unicode_Class::PUNCTUATION) {
+      rows[value & 0x0FU] =
+          static_cast<uint8_t>(rows[value & 0x0FU] | (1U << (value >> 4U)));
+    }
+  }
+  return rows;
+}
+
+const std::array<uint8_t, 16> &get_ascii_punctuation_rows() {
+  static const std::array<uint8_t, 16> rows{build_ascii_punctuation_rows()};
+  return rows;
+}
+
+constexpr std::array<uint8_t, 16> high_nibble_bits{1,  2,  4,  8, 16, 32,
+                                                   64, 128, 0, 0, 0,  0,
+                                                   0,  0,  0, 0};
+
+UTF8_TARGET("avx2")
+__m256i broadcast_table(const std::array<uint8_t, 16> &table) {
+  return _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(table.data())));
+}
+
+UTF8_TARGET("avx2")
+__m256i high_nibbles(__m256i bytes) {
+  return _mm256_and_si256(_mm256_srli_epi16(bytes, 4), _mm256_set1_epi8(0x0F));
+}
+
+// The 32 bytes ending N bytes before the end of input: the last N bytes of
+// previous, then input
+template <int N>
+UTF8_TARGET("avx2")
+__m256i previous_bytes(__m256i input, __m256i previous) {
+  return _mm256_alignr_epi8(
+      input, _mm256_permute2x128_si256(previous, input, 0x21), 16 - N);
+}
+
+struct Avx2_Validator {
+  __m256i byte_1_high;
+  __m256i byte_1_low;
+  __m256i byte_2_high;
+  // Lead bytes near the end of a block whose sequence continues in the next
+  __m256i incomplete_limit;
+  __m256i error;
+  __m256i previous_input;
+  __m256i previous_incomplete;
+
+  UTF8_TARGET("avx2")
+  Avx2_Validator()
+      : byte_1_high{broadcast_table(byte_1_high_table)},
+        byte_1_low{broadcast_table(byte_1_low_table)},
+        byte_2_high{broadcast_table(byte_2_high_table)},
+        incomplete_limit{_mm256_setr_epi8(
+            -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+            -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+            static_cast<char>(0xF0 - 1), static_cast<char>(0xE0 - 1),
+            static_cast<char>(0xC0 - 1))},
+        error{_mm256_setzero_si256()},
+        previous_input{_mm256_setzero_si256()},
+        previous_incomplete{_mm256_setzero_si256()} {}
+
+  UTF8_TARGET("avx2")
+  void check(__m256i input) {
+    if (_mm256_movemask_epi8(input) == 0) {
+      // ASCII is valid unless the block before ended inside a sequence
+      error = _mm256_or_si256(error, previous_incomplete);
+    } else {
+      const __m256i previous_1 = previous_bytes<1>(input, previous_input);
+      const __m256i special_cases = _mm256_and_si256(
+          _mm256_and_si256(
+              _mm256_shuffle_epi8(byte_1_high, high_nibbles(previous_1)),
+              _mm256_shuffle_epi8(
+                  byte_1_low,
+                  _mm256_and_si256(previous_1, _mm256_set1_epi8(0x0F)))),
+          _mm256_shuffle_epi8(byte_2_high, high_nibbles(input)));
+      // Third and fourth bytes of a sequence must be continuations, and
+      // only they may follow a continuation
+      const __m256i previous_2 = previous_bytes<2>(input, previous_input);
+      const __m256i previous_3 = previous_bytes<3>(input, previous_input);
+      const __m256i is_third_byte =
+          _mm256_subs_epu8(previous_2, _mm256_set1_epi8(0xE0 - 0x80));
+      const __m256i is_fourth_byte = _mm256_subs_epu8(
+          previous_3, _mm256_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+      const __m256i must_be_continuation = _mm256_and_si256(
+          _mm256_or_si256(is_third_byte, is_fourth_byte),
+          _mm256_set1_epi8(static_cast<char>(0x80)));
+      error = _mm256_or_si256(
+          error, _mm256_xor_si256(must_be_continuation, special_cases));
+      previous_incomplete = _mm256_subs_epu8(input, incomplete_limit);
+    }
+    previous_input = input;
+  }
+
+  UTF8_TARGET("avx2")
+  bool is_valid() const {
+    const __m256i errors = _mm256_or_si256(error, previous_incomplete);
+    return _mm256_testz_si256(errors, errors) != 0;
+  }
+};
+
+UTF8_TARGET("avx2")
+bool avx2_validate(const char *data, size_t size) {
+  Avx2_Validator validator;
+  size_t offset = 0;
+  for (; offset + 32 <= size; offset += 32) {
+    validator.check(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + offset)));
+  }
+  if (offset < size) {
+    // Zero padding ends any sequence still open, which flags it as too short
+    alignas(32) char tail[32]{};
+    std::memcpy(tail, data + offset, size - offset);
+    validator.check(_mm256_load_si256(reinterpret_cast<const __m256i *>(tail)));
+  }
+  return validator.is_valid();
+}
+
+UTF8_TARGET("avx2,popcnt")
+uint64_t count_bits(int mask) {
+  return static_cast<uint64_t>(_mm_popcnt_u32(static_cast<unsigned>(mask)));
+}
+
+// Input already validated: blocks of 32 ASCII bytes are counted with
+// compares, the others are decoded.
+UTF8_TARGET("avx2,popcnt")
+bool avx2_count(const char *data, size_t size, Utf8_Analytics &analytics) {
+  const auto *bytes = reinterpret_cast<const unsigned char *>(data);
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i space = _mm256_set1_epi8(' ');
+  const __m256i before_tab = _mm256_set1_epi8('\t' - 1);
+  const __m256i after_return = _mm256_set1_epi8('\r' + 1);
+  const __m256i before_digit = _mm256_set1_epi8('0' - 1);
+  const __m256i after_digit = _mm256_set1_epi8('9' + 1);
+  const __m256i before_upper = _mm256_set1_epi8('A' - 1);
+  const __m256i after_upper = _mm256_set1_epi8('Z' + 1);
+  const __m256i before_lower = _mm256_set1_epi8('a' - 1);
+  const __m256i after_lower = _mm256_set1_epi8('z' + 1);
+  const __m256i low_nibble = _mm256_set1_epi8(0x0F);
+  const __m256i punctuation_rows =
+      broadcast_table(get_ascii_punctuation_rows());
+  const __m256i row_bits = broadcast_table(high_nibble_bits);
+
+  // Counts of the blocks with other bytes
+  Class_Counts counts;
+  uint64_t ascii_bytes{0};
+  uint64_t whitespace{0};
+  uint64_t digits{0};
+  uint64_t uppercase{0};
+  uint64_t lowercase{0};
+  uint64_t punctuation{0};
+  size_t i = 0;
+  while (i + 32 <= size) {
+    const __m256i block =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+    if (_mm256_movemask_epi8(block) != 0) {
+      i = count_code_points(bytes, size, i, i + 32, counts);
+      if (i == 0) {
+        return false;
+      }
+      continue;
+    }
+    ascii_bytes += 32;
+    whitespace += count_bits(_mm256_movemask_epi8(_mm256_or_si256(
+        _mm256_cmpeq_epi8(block, space),
+        _mm256_and_si256(_mm256_cmpgt_epi8(block, before_tab),
+                         _mm256_cmpgt_epi8(after_return, block)))));
+    digits += count_bits(_mm256_movemask_epi8(
+        _mm256_and_si256(_mm256_cmpgt_epi8(block, before_digit),
+                         _mm256_cmpgt_epi8(after_digit, block))));
+    uppercase += count_bits(_mm256_movemask_epi8(
+        _mm256_and_si256(_mm256_cmpgt_epi8(block, before_upper),
+                         _mm256_cmpgt_epi8(after_upper, block))));
+    lowercase += count_bits(_mm256_movemask_epi8(
+        _mm256_and_si256(_mm256_cmpgt_epi8(block, before_lower),
+                         _mm256_cmpgt_epi8(after_lower, block))));
+    const __m256i rows = _mm256_shuffle_epi8(
+        punctuation_rows, _mm256_and_si256(block, low_nibble));
+    const __m256i bits = _mm256_shuffle_epi8(row_bits, high_nibbles(block));
+    punctuation += 32 - count_bits(_mm256_movemask_epi8(
+                 _mm256_cmpeq_epi8(_mm256_and_si256(rows, bits), zero)));
+    i += 32;
+  }
+  if (i < size && count_code_points(bytes, size, i, size, counts) == 0) {
+    return false;
+  }
+  counts.code_points += ascii_bytes;
+  counts.classes[static_cast<size_t>(Unicode_Class::WHITESPACE)] += whitespace;
+  counts.classes[static_cast<size_t>(Unicode_Class::DIGIT)] += digits;
+  counts.classes[static_cast<size_t>(Unicode_Class::UPPERCASE)] += uppercase;
+  counts.classes[static_cast<size_t>(Unicode_Class::LOWERCASE)] += lowercase;
+  counts.classes[static_cast<size_t>(Unicode_Class::PUNCTUATION)] +=
+      punctuation;
+  add_class_counts(counts, analytics);
+  return true;
+}
+
+UTF8_TARGET("avx2,popcnt")
+bool avx2_kernel(const char *data, size_t size, Utf8_Analytics &analytics) {
+  return avx2_validate(data, size) && avx2_count(data, size, analytics);
+}
+
+#endif  // UTF8_X86_64
+
+using Validate_Function = bool (*)(const char *, size_t);
+using Kernel_Function = bool (*)(const char *, size_t, Utf8_Analytics &);
+
+Validate_Function get_validate_function(Utf8_Kernel kernel) {
+  switch (kernel) {
+    case Utf8_Kernel::SCALAR:
+      return scalar_validate;
+#if UTF8_X86_64
+    case Utf8_Kernel::AVX2:
+      return avx2_validate;
+#endif
+    default:
+      return nullptr;
+  }
+}
+
+Kernel_Function get_kernel_function(Utf8_Kernel kernel) {
+  switch (kernel) {
+    case Utf8_Kernel::SCALAR:
+      return scalar_kernel;
+#if UTF8_X86_64
+    case Utf8_Kernel::AVX2:
+      return avx2_kernel;
+#endif
+    default:
+      return nullptr;
+  }
+}
+
+Utf8_Kernel select_utf8_kernel() {
+  return is_utf8_kernel_supported(Utf8_Kernel::AVX2) ? Utf8_Kernel::AVX2
+                                                     : Utf8_Kernel::SCALAR;
+}
+
+}  // namespace
+
+Utf8_Kernel get_active_utf8_kernel() {
+  static const Utf8_Kernel active_kernel{select_utf8_kernel()};
+  return active_kernel;
+}
+
+bool is_utf8_kernel_supported(Utf8_Kernel kernel) {
+  switch (kernel) {
+    case Utf8_Kernel::SCALAR:
+      return true;
+#if UTF8_X86_64
+    case Utf8_Kernel::AVX2:
+      // Every CPU with AVX2 has POPCNT
+      return is_analytics_kernel_supported(Analytics_Kernel::AVX2);
+#endif
+    default:
+      return false;
+  }
+}
+
+const char *get_utf8_kernel_name(Utf8_Kernel kernel) {
+  switch (kernel) {
+    case Utf8_Kernel::SCALAR:
+      return "scalar";
+    case Utf8_Kernel::AVX2:
+      return "avx2";
+  }
+  return "unknown";
+}
+
+bool is_valid_utf8(const char *data, size_t size) {
+  return get_validate_function(get_active_utf8_kernel())(data, size);
+}
+
+bool run_utf8_analytics(Utf8_Kernel kernel, const char *data, size_t size,
+                        Utf8_Analytics &analytics) {
+  if (!is_utf8_kernel_supported(kernel)) {
+    return false;
+  }
+  if (analytics.valid &&
+      !get_kernel_function(kernel)(data, size, analytics)) {
+    analytics.valid = false;
+  }
+  return true;
+}
+
+Utf8Analyzer::Utf8Analyzer(Utf8_Kernel kernel_val)
+    : kernel_{kernel_val}, analytics_{}, pending_{}, pending_size_{0} {}
+
+void Utf8Analyzer::analyze(const char *data, size_t size) {
+  if (analytics_.valid && !get_kernel_function(kernel_)(data, size,
+                                                        analytics_)) {
+    analytics_.valid = false;
+  }
+}
+
+void Utf8Analyzer::update(const char *data, size_t size) {
+  if (!analytics_.valid || size == 0) {
+    return;
+  }
+  if (pending_size_ > 0) {
+    // Completes the sequence split by the previous chunk
+    const size_t sequence_size =
+        get_sequence_size(static_cast<unsigned char>(pending_[0]));
+    const size_t taken = std::min(sequence_size - pending_size_, size);
+    std::memcpy(pending_.data() + pending_size_, data, taken);
+    pending_size_ += taken;
+    data += taken;
+    size -= taken;
+    if (pending_size_ < sequence_size) {
+      return;
+    }
+    analyze(pending_.data(), pending_size_);
+    pending_size_ = 0;
+  }
+
+  // A lead byte among the last three whose sequence runs past the chunk
+  size_t complete_size = size;
+  for (size_t back = 1; back <= 3 && back <= size; ++back) {
+    const auto byte = static_cast<unsigned char>(data[size - back]);
+    if (byte < 0x80U) {
+      break;
+    }
+    if (byte >= 0xC0U) {
+      if (get_sequence_size(byte) > back) {
+        complete_size = size - back;
+      }
+      break;
+    }
+  }
+  analyze(data, complete_size);
+  pending_size_ = size - complete_size;
+  std::memcpy(pending_.data(), data + complete_size, pending_size_);
+}
+
+void Utf8Analyzer::reset() {
+  analytics_ = Utf8_Analytics{};
+  pending_size_ = 0;
+}
+
+Utf8_Analytics Utf8Analyzer::get_analytics() const {
+  Utf8_Analytics analytics{analytics_};
+  analytics.valid = analytics.valid && pending_size_ == 0;
+  return analytics;
+}
+
+Utf8_Analytics calculate_utf8_analytics(const char *data, size_t size) {
+  Utf8Analyzer analyzer;
+  analyzer.update(data, size);
+  return analyzer.get_analytics();
+}
+
+}  // namespace WindowsSocketApp
@@ -0,0 +1,130 @@
+#include "../include/WordSketch.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace WindowsSocketApp {
+
+namespace {
+
+size_t round_up_to_power_of_two(size_t value) {
+  size_t power{1};
+  while (power < value) {
+    power <<= 1U;
+  }
+  return power;
+}
+
+// Row r uses the counter at (low + r * high) mod width: the two halves of
+// the hash give every row its own index without hashing the term again.
+size_t get_counter_index(uint64_t hash, size_t row, size_t width_mask) {
+  const auto low = static_cast<uint32_t>(hash);
+  const auto high = static_cast<uint32_t>(hash >> 32U);
+  return row * (width_mask + 1) +
+         ((low + static_cast<uint32_t>(row) * high) & width_mask);
+}
+
+}  // namespace
+
+WordSketch::WordSketch(size_t width_val, size_t capacity_val)
+    : width_mask_{round_up_to_power_of_two(std::max<size_t>(width_val, 1)) -
+                  1},
+      counters_(depth * (width_mask_ + 1), 0),
+      candidate_hashes_(std::max<size_t>(capacity_val, 1), 0),
+      candidate_counts_(candidate_hashes_.size(), 0),
+      candidate_terms_(candidate_hashes_.size()),
+      candidate_count_{0},
+      minimum_index_{0},
+      total_{0} {}
+
+uint64_t WordSketch::increment(uint64_t hash) {
+  size_t indexes[depth];
+  uint32_t smallest{std::numeric_limits<uint32_t>::max()};
+  for (size_t row = 0; row < depth; ++row) {
+    indexes[row] = get_counter_index(hash, row, width_mask_);
+    smallest = std::min(smallest, counters_[indexes[row]]);
+  }
+  if (smallest == std::numeric_limits<uint32_t>::max()) {
+    return smallest;
+  }
+  const uint32_t raised = smallest + 1;
+  for (const size_t index : indexes) {
+    counters_[index] = std::max(counters_[index], raised);
+  }
+  return raised;
+}
+
+void WordSketch::find_minimum() {
+  minimum_index_ = static_cast<size_t>(
+      std::min_element(candidate_counts_.begin(),
+                       candidate_counts_.begin() +
+                           static_cast<std::ptrdiff_t>(candidate_count_)) -
+      candidate_counts_.begin());
+}
+
+void WordSketch::add(uint64_t hash, const char *term, size_t size) {
+  ++total_;
+  const uint64_t count = increment(hash);
+  const size_t capacity = candidate_hashes_.size();
+  const bool full = candidate_count_ == capacity;
+  // Most terms of a high-cardinality stream stop here
+  if (full && count <= candidate_counts_[minimum_index_]) {
+    return;
+  }
+
+  for (size_t i = 0; i < candidate_count_; ++i) {
+    if (candidate_hashes_[i] == hash) {
+      candidate_counts_[i] = count;
+      if (full && i == minimum_index_) {
+        find_minimum();
+      }
+      return;
+    }
+  }
+
+  const size_t slot = full ? minimum_index_ : candidate_count_++;
+  candidate_hashes_[slot] = hash;
+  candidate_counts_[slot] = count;
+  Sketch_Term &stored = candidate_terms_[slot];
+  stored.length =
+      static_cast<uint8_t>(std::min(size, stored.text.size()));
+  std::memcpy(stored.text.data(), term, stored.length);
+  if (candidate_count_ == capacity) {
+    find_minimum();
+  }
+}
+
+void WordSketch::clear() {
+  std::fill(counters_.begin(), counters_.end(), 0);
+  candidate_count_ = 0;
+  minimum_index_ = 0;
+  total_ = 0;
+}
+
+uint64_t WordSketch::estimate(uint64_t hash) const {
+  uint32_t smallest{std::numeric_limits<uint32_t>::max()};
+  for (size_t row = 0; row < depth; ++row) {
+    smallest =
+        std::min(smallest, counters_[get_counter_index(hash, row, width_mask_)]);
+  }
+  return smallest;
+}
+
+uint64_t WordSketch::get_total() const { return total_; }
+
+size_t WordSketch::get_candidate_count() const { return candidate_count_; }
+
+uint64_t WordSketch::get_candidate_hash(size_t index) const {
+  return candidate_hashes_[index];
+}
+
+uint64_t WordSketch::get_candidate_count(size_t index) const {
+  return candidate_counts_[index];
+}
+
+const Sketch_Term &WordSketch::get_candidate_term(size_t index) const {
+  return candidate_terms_[index];
+}
+
+}  // namespace WindowsSocketApp
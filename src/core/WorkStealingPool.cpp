@@ -0,0 +1,126 @@
+#include "../include/WorkStealingPool.h"
+
+namespace WindowsSocketApp {
+
+WorkStealingPool::WorkStealingPool(size_t worker_count_val)
+    : batch_generation_{0},
+      stopping_{false},
+      task_{nullptr},
+      remaining_tasks_{0} {
+  if (worker_count_val == 0) {
+    worker_count_val = default_worker_count();
+  }
+  // The last range belongs to the thread calling run().
+  task_ranges_.reserve(worker_count_val + 1);
+  for (size_t i = 0; i < worker_count_val + 1; ++i) {
+    task_ranges_.push_back(std::make_unique<Task_Range>());
+  }
+  workers_.reserve(worker_count_val);
+  for (size_t i = 0; i < worker_count_val; ++i) {
+    workers_.emplace_back(&WorkStealingPool::worker_loop, this, i);
+  }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+  {
+    std::lock_guard<std::mutex> lock{state_mutex_};
+    stopping_ = true;
+  }
+  batch_started_.notify_all();
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+void WorkStealingPool::run(size_t task_count, const Task &task) {
+  std::unique_lock<std::mutex> batch_lock{batch_mutex_, std::try_to_lock};
+  if (!batch_lock.owns_lock() || workers_.empty() || task_count < 2) {
+    for (size_t i = 0; i < task_count; ++i) {
+      task(i);
+    }
+    return;
+  }
+
+  task_ = &task;
+  remaining_tasks_.store(task_count, std::memory_order_relaxed);
+  const size_t participants = task_ranges_.size();
+  for (size_t i = 0; i < participants; ++i) {
+    std::lock_guard<std::mutex> lock{task_ranges_[i]->mutex};
+    task_ranges_[i]->begin = task_count * i / participants;
+    task_ranges_[i]->end = task_count * (i + 1) / participants;
+  }
+  {
+    std::lock_guard<std::mutex> lock{state_mutex_};
+    ++batch_generation_;
+  }
+  batch_started_.notify_all();
+
+  run_tasks(participants - 1);
+
+  std::unique_lock<std::mutex> lock{state_mutex_};
+  batch_finished_.wait(lock, [this] {
+    return remaining_tasks_.load(std::memory_order_acquire) == 0;
+  });
+  task_ = nullptr;
+}
+
+void WorkStealingPool::worker_loop(size_t home_range) {
+  uint64_t seen_generation{0};
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock{state_mutex_};
+      batch_started_.wait(lock, [this, seen_generation] {
+        return stopping_ || batch_generation_ != seen_generation;
+      });
+      if (stopping_) {
+        return;
+      }
+      seen_generation = batch_generation_;
+    }
+    run_tasks(home_range);
+  }
+}
+
+bool WorkStealingPool::take_task(size_t home_range, size_t &task_index) {
+  {
+    Task_Range &own = *task_ranges_[home_range];
+    std::lock_guard<std::mutex> lock{own.mutex};
+    if (own.begin < own.end) {
+      task_index = own.begin++;
+      return true;
+    }
+  }
+  // Steal from the back so the owner keeps walking its range in order.
+  for (size_t offset = 1; offset < task_ranges_.size(); ++offset) {
+    Task_Range &victim =
+        *task_ranges_[(home_range + offset) % task_ranges_.size()];
+    std::lock_guard<std::mutex> lock{victim.mutex};
+    if (victim.begin < victim.end) {
+      task_index = --victim.end;
+      return true;
+    }
+  }
+  return false;
+}
+
+void WorkStealingPool::run_tasks(size_t home_range) {
+  size_t task_index{0};
+  while (take_task(home_range, task_index)) {
+    // task_ was published before the ranges were filled, under the same
+    // range mutex take_task() just acquired.
+    (*task_)(task_index);
+    if (remaining_tasks_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      std::lock_guard<std::mutex> lock{state_mutex_};
+      batch_finished_.notify_all();
+    }
+  }
+}
+
+size_t WorkStealingPool::get_worker_count() const { return workers_.size(); }
+
+size_t WorkStealingPool::default_worker_count() {
+  const auto hardware_threads = std::thread::hardware_concurrency();
+  return hardware_threads <= 1 ? 0 : hardware_threads - 1;
+}
+
+}  // namespace WindowsSocketApp
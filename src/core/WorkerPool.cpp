@@ -0,0 +1,68 @@
+#include "../include/WorkerPool.h"
+
+namespace WindowsSocketApp {
+
+WorkerPool::WorkerPool(Session_Handler session_handler_val,
+                       size_t worker_count_val,
+                       size_t max_pending_sessions_val)
+    : session_handler_{std::move(session_handler_val)},
+      max_pending_sessions_{max_pending_sessions_val},
+      stopping_{false} {
+  if (worker_count_val == 0) {
+    worker_count_val = default_worker_count();
+  }
+  workers_.reserve(worker_count_val);
+  for (size_t i = 0; i < worker_count_val; ++i) {
+    workers_.emplace_back(&WorkerPool::worker_loop, this);
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock{queue_mutex_};
+    stopping_ = true;
+  }
+  queue_not_empty_.notify_all();
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+void WorkerPool::submit(ClientSession session) {
+  {
+    std::unique_lock<std::mutex> lock{queue_mutex_};
+    queue_not_full_.wait(lock, [this] {
+      return max_pending_sessions_ == 0 ||
+             pending_sessions_.size() < max_pending_sessions_;
+    });
+    pending_sessions_.push_back(std::move(session));
+  }
+  queue_not_empty_.notify_one();
+}
+
+void WorkerPool::worker_loop() {
+  while (true) {
+    ClientSession session;
+    {
+      std::unique_lock<std::mutex> lock{queue_mutex_};
+      queue_not_empty_.wait(
+          lock, [this] { return stopping_ || !pending_sessions_.empty(); });
+      if (pending_sessions_.empty()) {
+        return;  // Stopping and nothing left to serve
+      }
+      session = std::move(pending_sessions_.front());
+      pending_sessions_.pop_front();
+    }
+    queue_not_full_.notify_one();
+    session_handler_(session);
+  }  // Session socket is closed here
+}
+
+size_t WorkerPool::get_worker_count() const { return workers_.size(); }
+
+size_t WorkerPool::default_worker_count() {
+  const auto hardware_threads = std::thread::hardware_concurrency();
+  return hardware_threads == 0 ? 1 : hardware_threads;
+}
+
+}  // namespace WindowsSocketApp
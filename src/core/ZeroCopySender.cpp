@@ -0,0 +1,167 @@
+#include "../include/ZeroCopySender.h"
+
+#ifdef __linux__
+#include <linux/errqueue.h>
+#include <poll.h>
+
+#include <cstring>
+#endif
+
+namespace WindowsSocketApp {
+
+ZeroCopySender::ZeroCopySender(SOCKET socket_val, size_t minimum_size_val)
+    : socket_{socket_val},
+      minimum_size_{minimum_size_val},
+      enabled_{false},
+      issued_send_count_{0},
+      completed_send_count_{0},
+      copied_send_count_{0} {}
+
+bool ZeroCopySender::enable() {
+#ifdef __linux__
+  int enable_zero_copy{1};
+  if (setsockopt(socket_, SOL_SOCKET, SO_ZEROCOPY, &enable_zero_copy,
+                 sizeof(enable_zero_copy)) == SOCKET_ERROR) {
+    std::cout << "Zero-copy send unavailable: " << WSAGetLastError()
+              << std::endl;
+    return false;
+  }
+  enabled_ = true;
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool ZeroCopySender::send(Send_Segment *segments, size_t segment_count,
+                          bool log_progress) {
+  size_t total_size{0};
+  for (size_t i = 0; i < segment_count; ++i) {
+    total_size += segments[i].size;
+  }
+  // Once the kernel has copied a zero-copy send, it will keep doing so on
+  // this path; pinning and tracking the pages would only add work.
+  if (!enabled_ || total_size < minimum_size_ || copied_send_count_ > 0) {
+    return send_segments(socket_, segments, segment_count, log_progress);
+  }
+
+  size_t sent_size{0};
+  const bool sent = send_zero_copy(segments, segment_count, sent_size);
+  // The caller may reuse its buffers as soon as send() returns, so wait for
+  // whatever was sent even when a later part failed.
+  const bool completed = wait_for_completions();
+  if (sent && completed && log_progress) {
+    std::cout << "Bytes sent (zero-copy): " << sent_size << std::endl;
+  }
+  return sent && completed;
+}
+
+bool ZeroCopySender::send_zero_copy(Send_Segment *segments,
+                                    size_t segment_count, size_t &sent_size) {
+#ifdef __linux__
+  skip_sent_bytes(segments, segment_count, 0);
+  while (segment_count > 0) {
+    auto i_send_result =
+        send_segments_once(socket_, segments, segment_count, MSG_ZEROCOPY);
+    if (i_send_result == SOCKET_ERROR) {
+      if (errno == ENOBUFS) {
+        // Too many pages pinned for this socket (net.core.optmem_max):
+        // copy the rest.
+        for (size_t i = 0; i < segment_count; ++i) {
+          sent_size += segments[i].size;
+        }
+        return send_segments(socket_, segments, segment_count, false);
+      }
+      std::cout << "send failed with error: " << errno << std::endl;
+      return false;
+    }
+    // Every successful call, even a short one, gets a completion
+    ++issued_send_count_;
+    skip_sent_bytes(segments, segment_count,
+                    static_cast<size_t>(i_send_result));
+    sent_size += static_cast<size_t>(i_send_result);
+  }
+  return true;
+#else
+  (void)segments;
+  (void)segment_count;
+  (void)sent_size;
+  return false;
+#endif
+}
+
+bool ZeroCopySender::read_completions() {
+#ifdef __linux__
+  char control[CMSG_SPACE(sizeof(sock_extended_err)) * 4];
+  while (true) {
+    msghdr message{};
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    if (recvmsg(socket_, &message, MSG_ERRQUEUE) == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (is_would_block_error(errno)) {
+        return true;  // Error queue drained
+      }
+      std::cout << "Reading zero-copy completions failed with error: "
+                << errno << std::endl;
+      return false;
+    }
+
+    for (cmsghdr *header = CMSG_FIRSTHDR(&message); header != nullptr;
+         header = CMSG_NXTHDR(&message, header)) {
+      const bool is_socket_error =
+          (header->cmsg_level == SOL_IP && header->cmsg_type == IP_RECVERR) ||
+          (header->cmsg_level == SOL_IPV6 &&
+           header->cmsg_type == IPV6_RECVERR);
+      if (!is_socket_error) {
+        continue;
+      }
+      sock_extended_err error{};
+      std::memcpy(&error, CMSG_DATA(header), sizeof(error));
+      if (error.ee_origin != SO_EE_ORIGIN_ZEROCOPY || error.ee_errno != 0) {
+        continue;
+      }
+      // One notification covers the inclusive range of send ids
+      // [ee_info, ee_data].
+      const uint32_t range_size = error.ee_data - error.ee_info + 1;
+      completed_send_count_ += range_size;
+      if ((error.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0U) {
+        copied_send_count_ += range_size;
+      }
+    }
+  }
+#else
+  return true;
+#endif
+}
+
+bool ZeroCopySender::wait_for_completions() {
+#ifdef __linux__
+  while (completed_send_count_ != issued_send_count_) {
+    // POLLERR is reported whatever events are asked for
+    pollfd descriptor{socket_, 0, 0};
+    if (poll(&descriptor, 1, -1) == -1 && errno != EINTR) {
+      std::cout << "poll failed with error: " << errno << std::endl;
+      return false;
+    }
+    if ((descriptor.revents & POLLNVAL) != 0 || !read_completions()) {
+      return false;
+    }
+  }
+#endif
+  return true;
+}
+
+bool ZeroCopySender::enabled() const { return enabled_; }
+
+size_t ZeroCopySender::get_zero_copy_send_count() const {
+  return completed_send_count_ - copied_send_count_;
+}
+
+size_t ZeroCopySender::get_copied_send_count() const {
+  return copied_send_count_;
+}
+
+}  // namespace WindowsSocketApp
@@ -0,0 +1,73 @@
+#ifndef ADDRESSCACHE_H
+#define ADDRESSCACHE_H
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "NetworkTypes.h"
+
+namespace WindowsSocketApp {
+
+// Shared, immutable result of one getaddrinfo() call, freed with the last
+// reference.
+using Resolved_Addresses = std::shared_ptr<const addrinfo>;
+
+// Results of getaddrinfo() by host, port and hints, reused until their time
+// to live runs out, so repeated connections to the same server skip the
+// resolver. getaddrinfo() does not report the DNS record TTL, so one fixed
+// TTL applies to every entry. Failed resolutions are not cached. Safe to use
+// from several threads.
+class AddressCache {
+ public:
+  static constexpr std::chrono::seconds default_time_to_live{30};
+
+ private:
+  struct Cache_Entry {
+    Resolved_Addresses addresses;
+    std::chrono::steady_clock::time_point expires_at;
+  };
+
+  std::chrono::steady_clock::duration time_to_live_;
+
+  mutable std::mutex entries_mutex_;
+  std::unordered_map<std::string, Cache_Entry> entries_;
+
+  static std::string make_key(const std::string &host, const std::string &port,
+                              const addrinfo &hints);
+
+ public:
+  explicit AddressCache(
+      std::chrono::steady_clock::duration time_to_live_val =
+          default_time_to_live);
+
+  ~AddressCache() = default;
+
+  AddressCache(const AddressCache &source) = delete;
+  AddressCache &operator=(const AddressCache &other) = delete;
+
+  AddressCache(AddressCache &&source) noexcept = delete;
+  AddressCache &operator=(AddressCache &&other) noexcept = delete;
+
+  // Cached addresses, or the result of a new getaddrinfo() call; nullptr when
+  // the name cannot be resolved.
+  Resolved_Addresses resolve(const std::string &host, const std::string &port,
+                             const addrinfo &hints);
+  // Drops the entry, e.g. after none of its addresses accepted a connection.
+  void invalidate(const std::string &host, const std::string &port,
+                  const addrinfo &hints);
+  void clear();
+
+  [[nodiscard]] size_t size() const;
+  [[nodiscard]] std::chrono::steady_clock::duration get_time_to_live() const;
+  void set_time_to_live(std::chrono::steady_clock::duration time_to_live);
+};
+
+// Process-wide cache used by Client.
+AddressCache &get_address_cache();
+
+}  // namespace WindowsSocketApp
+
+#endif  // ADDRESSCACHE_H
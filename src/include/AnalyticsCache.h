@@ -0,0 +1,132 @@
+#ifndef ANALYTICSCACHE_H
+#define ANALYTICSCACHE_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "AnalyticsEncoding.h"
+#include "MessageAnalytics.h"
+
+namespace WindowsSocketApp {
+
+// 64-bit XXH64 hash of the bytes (words read in native byte order), several
+// bytes per cycle on current CPUs.
+uint64_t hash_message_bytes(const char *data, size_t size, uint64_t seed = 0);
+
+// A message as the cache knows it: its hash and its bytes. The key of a
+// lookup points into the caller's message; the key of an entry into the copy
+// the entry keeps. Keys are equal only when their bytes are.
+struct Analytics_Cache_Key {
+  uint64_t hash{0};
+  const char *data{nullptr};
+  size_t length{0};
+
+  bool operator==(const Analytics_Cache_Key &other) const {
+    return hash == other.hash && length == other.length &&
+           (length == 0 || std::memcmp(data, other.data, length) == 0);
+  }
+};
+
+// Hashed with a seed chosen at random once per process, so clients cannot
+// pick messages that land in the same index bucket or shard.
+Analytics_Cache_Key make_analytics_cache_key(const char *data, size_t size);
+
+// Replies already produced for a message, so a message seen before is
+// answered without analyzing it or encoding its analytics again. Both
+// encodings of a reply are kept, along with a copy of the message: a lookup
+// hits only when the message bytes match, not just the hash, so a client
+// cannot read or poison the reply of another message by finding a collision.
+// Entries live in shards, each with its own lock, LRU list and share of the
+// byte budget; the least recently used entries of a shard are evicted when
+// it runs out of budget. A capacity of 0 disables the cache. Safe to use
+// from several threads; hits and misses are counted in the server metrics.
+class AnalyticsCache {
+ public:
+  static constexpr size_t default_shard_count{16};
+  // Larger messages are rarely repeated, and a connection has to keep the
+  // message until it is complete to look it up, so they are not cached.
+  static constexpr size_t default_max_message_size{64 * 1024};
+
+ private:
+  struct Key_Hasher {
+    size_t operator()(const Analytics_Cache_Key &key) const {
+      return static_cast<size_t>(key.hash);
+    }
+  };
+
+  struct Cache_Entry {
+    // Points into message
+    Analytics_Cache_Key key;
+    std::string message;
+    MessageAnalytics analytics;
+    std::string text;
+    std::array<char, message_analytics_binary_size> binary;
+  };
+
+  // Front is the most recently used entry
+  struct alignas(64) Cache_Shard {
+    std::mutex mutex;
+    std::list<Cache_Entry> entries;
+    std::unordered_map<Analytics_Cache_Key, std::list<Cache_Entry>::iterator,
+                       Key_Hasher>
+        index;
+    size_t size_bytes{0};
+    size_t capacity_bytes{0};
+  };
+
+  std::unique_ptr<Cache_Shard[]> shards_;
+  size_t shard_count_;
+  std::atomic<size_t> capacity_bytes_;
+  std::atomic<size_t> max_message_size_;
+
+  Cache_Shard &shard_for(const Analytics_Cache_Key &key) const;
+  // Memory charged for an entry: its message and text plus list and index
+  // nodes
+  static size_t entry_size(const Cache_Entry &entry);
+  static void evict_to_capacity(Cache_Shard &shard);
+
+ public:
+  explicit AnalyticsCache(size_t capacity_bytes_val = 0,
+                          size_t shard_count_val = default_shard_count);
+
+  ~AnalyticsCache() = default;
+
+  AnalyticsCache(const AnalyticsCache &source) = delete;
+  AnalyticsCache &operator=(const AnalyticsCache &other) = delete;
+
+  AnalyticsCache(AnalyticsCache &&source) noexcept = delete;
+  AnalyticsCache &operator=(AnalyticsCache &&other) noexcept = delete;
+
+  // Whether a message of this size is looked up at all
+  [[nodiscard]] bool accepts(size_t message_size) const;
+  // Copies the cached reply in the requested encoding to output, and the
+  // analytics it encodes to analytics, and returns its size, or returns 0
+  // when the message is not cached.
+  size_t find(const Analytics_Cache_Key &key, bool binary,
+              Analytics_Text_Buffer &output, MessageAnalytics &analytics);
+  void insert(const Analytics_Cache_Key &key,
+              const MessageAnalytics &analytics);
+  void clear();
+
+  [[nodiscard]] size_t size() const;
+  [[nodiscard]] size_t get_size_bytes() const;
+  [[nodiscard]] size_t get_capacity_bytes() const;
+  // Evicts entries when the cache shrinks
+  void set_capacity_bytes(size_t capacity_bytes);
+  [[nodiscard]] size_t get_max_message_size() const;
+  void set_max_message_size(size_t max_message_size);
+};
+
+// Process-wide cache used by the server; disabled until given a capacity.
+AnalyticsCache &get_analytics_cache();
+
+}  // namespace WindowsSocketApp
+
+#endif  // ANALYTICSCACHE_H
@@ -0,0 +1,416 @@
+#ifndef ANALYTICSENCODING_H
+#define ANALYTICSENCODING_H
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "AnalyticsPipeline.h"
+#include "MessageAnalytics.h"
+
+namespace WindowsSocketApp {
+
+// Wire encodings of MessageAnalytics. Both write into caller-provided memory,
+// so a connection that keeps its buffers answers requests without allocating.
+//
+// Binary: the eight counters in declaration order, each an unsigned 64-bit
+// integer in network byte order - 64 bytes in total.
+inline constexpr size_t message_analytics_binary_size{8 * sizeof(uint64_t)};
+// Text: "Received message analytics: Length: 12, punctuation marks count: 1,
+// ..." - never longer than this, even with every counter at its maximum.
+inline constexpr size_t message_analytics_text_capacity{512};
+
+using Analytics_Text_Buffer = std::array<char, message_analytics_text_capacity>;
+
+namespace analytics_encoding_detail {
+
+struct Analytics_Field {
+  const char *label;
+  size_t MessageAnalytics::*counter;
+};
+
+inline constexpr std::array<Analytics_Field, 8> analytics_fields{{
+    {"Received message analytics: Length: ", &MessageAnalytics::length},
+    {", punctuation marks count: ",
+     &MessageAnalytics::punctuation_marks_count},
+    {", spaces count: ", &MessageAnalytics::spaces_count},
+    {", digits count: ", &MessageAnalytics::digits_count},
+    {", uppercase letters count: ", &MessageAnalytics::uppercase_count},
+    {", lowercase letters count: ", &MessageAnalytics::lowercase_count},
+    {", vowels count: ", &MessageAnalytics::vowels_count},
+    {", consonants count: ", &MessageAnalytics::consonants_count},
+}};
+
+// Every label plus the 20 digits of the largest 64-bit counter
+constexpr size_t maximum_text_length() {
+  size_t length{0};
+  for (const auto &field : analytics_fields) {
+    length += std::char_traits<char>::length(field.label) + 20;
+  }
+  return length;
+}
+static_assert(maximum_text_length() <= message_analytics_text_capacity,
+              "message_analytics_text_capacity is too small");
+
+}  // namespace analytics_encoding_detail
+
+// Returns the length of the text written to output.
+inline size_t write_message_analytics_text(const MessageAnalytics &analytics,
+                                           Analytics_Text_Buffer &output) {
+  char *position = output.data();
+  char *const end = output.data() + output.size();
+  for (const auto &field : analytics_encoding_detail::analytics_fields) {
+    const size_t label_length = std::strlen(field.label);
+    std::memcpy(position, field.label, label_length);
+    position += label_length;
+    position = std::to_chars(position, end, analytics.*field.counter).ptr;
+  }
+  return static_cast<size_t>(position - output.data());
+}
+
+inline void encode_message_analytics_binary(const MessageAnalytics &analytics,
+                                            char *output) {
+  for (const auto &field : message_analytics_counters) {
+    const auto value = static_cast<uint64_t>(analytics.*field.counter);
+    for (int shift = 56; shift >= 0; shift -= 8) {
+      *output++ = static_cast<char>(value >> static_cast<unsigned>(shift));
+    }
+  }
+}
+
+// input must hold message_analytics_binary_size bytes.
+inline MessageAnalytics decode_message_analytics_binary(const char *input) {
+  MessageAnalytics analytics;
+  for (const auto &field : message_analytics_counters) {
+    uint64_t value{0};
+    for (int i = 0; i < 8; ++i) {
+      value = (value << 8U) | static_cast<unsigned char>(*input++);
+    }
+    analytics.*field.counter = static_cast<size_t>(value);
+  }
+  return analytics;
+}
+
+// Pipeline_Analytics (AnalyticsPipeline.h), when a client picked its
+// counters. Only the selected counter groups are encoded, in this order:
+// the character classes as above, then words, lines and code points, each
+// an unsigned 64-bit integer, the 256 counters of the byte histogram and the
+// eight UTF-8 counters: valid (0 or 1), code points, letters, uppercase,
+// lowercase, digits, whitespace and punctuation, then the four lists of top
+// words (message words and bigrams, traffic words and bigrams), each
+// top_words_reported entries of an unsigned 64-bit count, a length byte
+// and top_words_max_term_size bytes of text, zero padded.
+// Binary: network byte order, pipeline_analytics_binary_size() bytes.
+// Text: the character classes text, then ", words count: 3", ", lines
+// count: 1", ", code points count: 12", ", byte histogram: 32:2 72:1"
+// (the byte values that occurred, with their counts), ", UTF-8: valid,
+// code points: 12, letters: 10, ..." or ", UTF-8: invalid" and ", top
+// words: "the":12 "server":4, top bigrams: "the server":3, traffic top
+// words: ..., traffic top bigrams: ...".
+inline constexpr size_t pipeline_analytics_binary_size(uint16_t counters) {
+  size_t size{0};
+  if ((counters & analytics_character_classes) != 0U) {
+    size += message_analytics_binary_size;
+  }
+  for (const uint16_t counter :
+       {analytics_words, analytics_lines, analytics_code_points}) {
+    if ((counters & counter) != 0U) {
+      size += sizeof(uint64_t);
+    }
+  }
+  if ((counters & analytics_byte_histogram) != 0U) {
+    size += 256 * sizeof(uint64_t);
+  }
+  if ((counters & analytics_unicode) != 0U) {
+    size += 8 * sizeof(uint64_t);
+  }
+  if ((counters & analytics_top_words) != 0U) {
+    size += 4 * top_words_reported *
+            (sizeof(uint64_t) + 1 + top_words_max_term_size);
+  }
+  return size;
+}
+
+namespace analytics_encoding_detail {
+
+struct Pipeline_Counter {
+  uint16_t counter;
+  const char *label;
+  uint64_t Pipeline_Analytics::*count;
+};
+
+inline constexpr std::array<Pipeline_Counter, 3> pipeline_counters{{
+    {analytics_words, "words count: ", &Pipeline_Analytics::words_count},
+    {analytics_lines, "lines count: ", &Pipeline_Analytics::lines_count},
+    {analytics_code_points, "code points count: ",
+     &Pipeline_Analytics::code_points_count},
+}};
+
+struct Unicode_Counter {
+  const char *label;
+  uint64_t Utf8_Analytics::*count;
+};
+
+inline constexpr std::array<Unicode_Counter, 7> unicode_counters{{
+    {"code points: ", &Utf8_Analytics::code_points_count},
+    {"letters: ", &Utf8_Analytics::letters_count},
+    {"uppercase letters: ", &Utf8_Analytics::uppercase_count},
+    {"lowercase letters: ", &Utf8_Analytics::lowercase_count},
+    {"digits: ", &Utf8_Analytics::digits_count},
+    {"whitespace: ", &Utf8_Analytics::whitespace_count},
+    {"punctuation marks: ", &Utf8_Analytics::punctuation_count},
+}};
+
+struct Top_Words_List {
+  const char *label;
+  Ranked_Terms Top_Words_Analytics::*terms;
+};
+
+inline constexpr std::array<Top_Words_List, 4> top_words_lists{{
+    {"top words:", &Top_Words_Analytics::message_words},
+    {"top bigrams:", &Top_Words_Analytics::message_bigrams},
+    {"traffic top words:", &Top_Words_Analytics::traffic_words},
+    {"traffic top bigrams:", &Top_Words_Analytics::traffic_bigrams},
+}};
+
+inline void append_u64(std::string &output, uint64_t value) {
+  char encoded[sizeof(uint64_t)];
+  for (int i = 0; i < 8; ++i) {
+    encoded[i] = static_cast<char>(value >> static_cast<unsigned>(56 - 8 * i));
+  }
+  output.append(encoded, sizeof(encoded));
+}
+
+inline uint64_t read_u64(const char *&input) {
+  uint64_t value{0};
+  for (int i = 0; i < 8; ++i) {
+    value = (value << 8U) | static_cast<unsigned char>(*input++);
+  }
+  return value;
+}
+
+inline void append_number(std::string &output, uint64_t value) {
+  char digits[20];
+  const char *const end =
+      std::to_chars(digits, digits + sizeof(digits), value).ptr;
+  output.append(digits, static_cast<size_t>(end - digits));
+}
+
+}  // namespace analytics_encoding_detail
+
+inline void append_pipeline_analytics_binary(
+    const Pipeline_Analytics &analytics, std::string &output) {
+  using namespace analytics_encoding_detail;
+  if ((analytics.counters & analytics_character_classes) != 0U) {
+    char classes[message_analytics_binary_size];
+    encode_message_analytics_binary(analytics.classes, classes);
+    output.append(classes, sizeof(classes));
+  }
+  for (const auto &counter : pipeline_counters) {
+    if ((analytics.counters & counter.counter) != 0U) {
+      append_u64(output, analytics.*counter.count);
+    }
+  }
+  if ((analytics.counters & analytics_byte_histogram) != 0U) {
+    for (const uint64_t count : analytics.byte_histogram) {
+      append_u64(output, count);
+    }
+  }
+  if ((analytics.counters & analytics_unicode) != 0U) {
+    append_u64(output, analytics.unicode.valid ? 1U : 0U);
+    for (const auto &counter : unicode_counters) {
+      append_u64(output, analytics.unicode.*counter.count);
+    }
+  }
+  if ((analytics.counters & analytics_top_words) != 0U) {
+    for (const auto &list : top_words_lists) {
+      for (const Ranked_Term &ranked : analytics.top_words.*list.terms) {
+        append_u64(output, ranked.count);
+        output.push_back(static_cast<char>(ranked.term.length));
+        output.append(ranked.term.text.data(), ranked.term.length);
+        output.append(ranked.term.text.size() - ranked.term.length, '\0');
+      }
+    }
+  }
+}
+
+// input must hold pipeline_analytics_binary_size(counters) bytes.
+inline Pipeline_Analytics decode_pipeline_analytics_binary(const char *input,
+                                                           uint16_t counters) {
+  using namespace analytics_encoding_detail;
+  Pipeline_Analytics analytics;
+  analytics.counters = static_cast<uint16_t>(counters & analytics_all_counters);
+  if ((counters & analytics_character_classes) != 0U) {
+    analytics.classes = decode_message_analytics_binary(input);
+    input += message_analytics_binary_size;
+  }
+  for (const auto &counter : pipeline_counters) {
+    if ((counters & counter.counter) != 0U) {
+      analytics.*counter.count = read_u64(input);
+    }
+  }
+  if ((counters & analytics_byte_histogram) != 0U) {
+    for (uint64_t &count : analytics.byte_histogram) {
+      count = read_u64(input);
+    }
+  }
+  if ((counters & analytics_unicode) != 0U) {
+    analytics.unicode.valid = read_u64(input) != 0;
+    for (const auto &counter : unicode_counters) {
+      analytics.unicode.*counter.count = read_u64(input);
+    }
+  }
+  if ((counters & analytics_top_words) != 0U) {
+    for (const auto &list : top_words_lists) {
+      for (Ranked_Term &ranked : analytics.top_words.*list.terms) {
+        ranked.count = read_u64(input);
+        ranked.term.length = static_cast<uint8_t>(
+            std::min<size_t>(static_cast<unsigned char>(*input++),
+                             top_words_max_term_size));
+        std::memcpy(ranked.term.text.data(), input, ranked.term.text.size());
+        input += ranked.term.text.size();
+      }
+    }
+  }
+  return analytics;
+}
+
+inline void append_pipeline_analytics_text(const Pipeline_Analytics &analytics,
+                                           std::string &output) {
+  using namespace analytics_encoding_detail;
+  // Separates every counter from the one before it
+  bool first{true};
+  const auto separate = [&output, &first]() {
+    if (!first) {
+      output.append(", ");
+    }
+    first = false;
+  };
+  if ((analytics.counters & analytics_character_classes) != 0U) {
+    Analytics_Text_Buffer classes;
+    output.append(classes.data(),
+                  write_message_analytics_text(analytics.classes, classes));
+    first = false;
+  } else {
+    output.append("Received message analytics: ");
+  }
+  for (const auto &counter : pipeline_counters) {
+    if ((analytics.counters & counter.counter) != 0U) {
+      separate();
+      output.append(counter.label);
+      append_number(output, analytics.*counter.count);
+    }
+  }
+  if ((analytics.counters & analytics_byte_histogram) != 0U) {
+    separate();
+    output.append("byte histogram:");
+    for (size_t value = 0; value < analytics.byte_histogram.size(); ++value) {
+      if (analytics.byte_histogram[value] != 0) {
+        output.push_back(' ');
+        append_number(output, value);
+        output.push_back(':');
+        append_number(output, analytics.byte_histogram[value]);
+      }
+    }
+  }
+  if ((analytics.counters & analytics_unicode) != 0U) {
+    separate();
+    if (!analytics.unicode.valid) {
+      output.append("UTF-8: invalid");
+    } else {
+      output.append("UTF-8: valid");
+      for (const auto &counter : unicode_counters) {
+        output.append(", ");
+        output.append(counter.label);
+        append_number(output, analytics.unicode.*counter.count);
+      }
+    }
+  }
+  if ((analytics.counters & analytics_top_words) != 0U) {
+    for (const auto &list : top_words_lists) {
+      separate();
+      output.append(list.label);
+      for (const Ranked_Term &ranked : analytics.top_words.*list.terms) {
+        if (ranked.count == 0) {
+          break;
+        }
+        output.append(" \"");
+        output.append(ranked.term.text.data(), ranked.term.length);
+        output.append("\":");
+        append_number(output, ranked.count);
+      }
+    }
+  }
+}
+
+// Aggregate_Analytics (MessageAnalytics.h), the reply to a request with
+// frame_flag_aggregate.
+// Binary: the messages count, the classified messages count, the eight
+// character class totals in the order of the binary encoding above and the
+// message_size_bucket_count message size buckets, each an unsigned 64-bit
+// integer in network byte order - aggregate_analytics_binary_size bytes.
+// Text: "Server analytics: messages: 12, classified messages: 12, length: 60,
+// punctuation marks: 2, ..., message sizes: 1:2 4-7:10" (the size ranges
+// that occurred, in bytes, with their counts).
+inline constexpr size_t aggregate_analytics_binary_size{
+    2 * sizeof(uint64_t) + message_analytics_binary_size +
+    message_size_bucket_count * sizeof(uint64_t)};
+
+inline void append_aggregate_analytics_binary(
+    const Aggregate_Analytics &analytics, std::string &output) {
+  using namespace analytics_encoding_detail;
+  append_u64(output, analytics.messages_count);
+  append_u64(output, analytics.classified_messages_count);
+  char classes[message_analytics_binary_size];
+  encode_message_analytics_binary(analytics.classes, classes);
+  output.append(classes, sizeof(classes));
+  for (const uint64_t count : analytics.message_sizes) {
+    append_u64(output, count);
+  }
+}
+
+// input must hold aggregate_analytics_binary_size bytes.
+inline Aggregate_Analytics decode_aggregate_analytics_binary(
+    const char *input) {
+  using namespace analytics_encoding_detail;
+  Aggregate_Analytics analytics;
+  analytics.messages_count = read_u64(input);
+  analytics.classified_messages_count = read_u64(input);
+  analytics.classes = decode_message_analytics_binary(input);
+  input += message_analytics_binary_size;
+  for (uint64_t &count : analytics.message_sizes) {
+    count = read_u64(input);
+  }
+  return analytics;
+}
+
+inline void append_aggregate_analytics_text(
+    const Aggregate_Analytics &analytics, std::string &output) {
+  using namespace analytics_encoding_detail;
+  output.append("Server analytics: messages: ");
+  append_number(output, analytics.messages_count);
+  output.append(", classified messages: ");
+  append_number(output, analytics.classified_messages_count);
+  for (const auto &counter : message_analytics_counters) {
+    output.append(", ");
+    output.append(counter.name);
+    output.append(": ");
+    append_number(output, analytics.classes.*counter.counter);
+  }
+  output.append(", message sizes:");
+  for (size_t bucket = 0; bucket < analytics.message_sizes.size(); ++bucket) {
+    if (analytics.message_sizes[bucket] != 0) {
+      output.push_back(' ');
+      output.append(get_message_size_bucket_label(bucket));
+      output.push_back(':');
+      append_number(output, analytics.message_sizes[bucket]);
+    }
+  }
+}
+
+}  // namespace WindowsSocketApp
+
+#endif  // ANALYTICSENCODING_H
@@ -0,0 +1,49 @@
+#ifndef ANALYTICSKERNELS_H
+#define ANALYTICSKERNELS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "MessageAnalytics.h"
+
+namespace WindowsSocketApp {
+
+// Character classes of a byte, as bits of get_character_class_table()
+inline constexpr uint8_t class_flag_space{1U << 0U};
+inline constexpr uint8_t class_flag_punctuation{1U << 1U};
+inline constexpr uint8_t class_flag_digit{1U << 2U};
+inline constexpr uint8_t class_flag_uppercase{1U << 3U};
+inline constexpr uint8_t class_flag_lowercase{1U << 4U};
+inline constexpr uint8_t class_flag_vowel{1U << 5U};
+inline constexpr uint8_t class_flag_consonant{1U << 6U};
+
+// Implementations of the character classification behind MessageAnalytics.
+// REFERENCE is the original byte-by-byte loop and defines the expected
+// results; every other kernel produces exactly the same counts.
+//   SCALAR - byte histogram + lookup table, any CPU
+//   SSE2   - 16 bytes per step, x86-64 baseline
+//   AVX2   - 32 bytes per step
+//   AVX512 - 64 bytes per step, requires AVX-512BW
+enum class Analytics_Kernel { REFERENCE, SCALAR, SSE2, AVX2, AVX512 };
+
+// Adds the analytics of data[0, size) to analytics, using the widest kernel
+// supported by the CPU. The kernel is selected once, on first use.
+void accumulate_message_analytics(const char *data, size_t size,
+                                  MessageAnalytics &analytics);
+
+// Classes of every byte value, derived from the REFERENCE kernel
+[[nodiscard]] const std::array<uint8_t, 256> &get_character_class_table();
+
+[[nodiscard]] Analytics_Kernel get_active_analytics_kernel();
+[[nodiscard]] bool is_analytics_kernel_supported(Analytics_Kernel kernel);
+[[nodiscard]] const char *get_analytics_kernel_name(Analytics_Kernel kernel);
+
+// Runs one specific kernel, e.g. to compare it against REFERENCE. Returns
+// false without touching analytics when the CPU does not support it.
+bool run_analytics_kernel(Analytics_Kernel kernel, const char *data,
+                          size_t size, MessageAnalytics &analytics);
+
+}  // namespace WindowsSocketApp
+
+#endif  // ANALYTICSKERNELS_H
@@ -0,0 +1,182 @@
+#ifndef ANALYTICSLOG_H
+#define ANALYTICSLOG_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "AnalyticsPipeline.h"
+#include "MessageAnalytics.h"
+
+namespace WindowsSocketApp {
+
+// Append-only log of the analytics of every message the server answers, for
+// offline reporting. The file is created at its full size: a header page,
+// then a fixed number of record slots, all in the byte order of the machine
+// that wrote them. POSIX only; opening a log fails on Windows.
+
+// "ANALOG01" in the file, on a little-endian machine
+inline constexpr uint64_t analytics_log_magic{0x3130474F4C414E41ULL};
+inline constexpr uint32_t analytics_log_version{1};
+inline constexpr size_t analytics_log_header_size{4096};
+
+// The analytics of one reply. 128 bytes, so a record never straddles a page
+// and a page written out holds whole records.
+struct Analytics_Log_Record {
+  // Wall clock time of the reply, in nanoseconds since the Unix epoch; 0 in
+  // a slot never written. Stored last.
+  uint64_t timestamp_nanoseconds{0};
+  uint64_t message_size{0};
+  // Counter groups computed for the message (analytics_* bits of
+  // AnalyticsPipeline.h); the counters of the other groups are 0
+  uint16_t counters{0};
+  uint16_t reserved_16{0};
+  uint32_t reserved_32{0};
+  // The MessageAnalytics fields, in declaration order
+  std::array<uint64_t, 8> classes{};
+  uint64_t words_count{0};
+  uint64_t lines_count{0};
+  uint64_t code_points_count{0};
+  std::array<uint64_t, 2> reserved{};
+};
+
+static_assert(sizeof(Analytics_Log_Record) == 128,
+              "analytics log records are 128 bytes");
+
+struct Analytics_Log_Header {
+  uint64_t magic{analytics_log_magic};
+  uint32_t version{analytics_log_version};
+  uint32_t record_size{sizeof(Analytics_Log_Record)};
+  // Record slots in the file
+  uint64_t capacity{0};
+  // Slots handed out to writers when the log was last committed; readers
+  // scan this many
+  uint64_t committed_slots{0};
+};
+
+// Writer side. Server threads write their records straight into a shared
+// mapping of the file: each thread claims slots a chunk at a time, so an
+// append is a few stores, with neither a system call nor a lock, and a
+// shared atomic is touched once per chunk. A commit thread flushes the
+// mapping with msync every sync interval (group commit) and then publishes
+// the claimed slots in the header: every record written before a commit
+// started is on disk once it ended. Slots of a chunk its thread never filled
+// stay empty and readers skip them. Once every slot is used further records
+// are dropped and counted.
+class AnalyticsLog {
+ public:
+  static constexpr size_t chunk_slots{512};
+  static constexpr uint64_t default_capacity{2 * 1024 * 1024};
+  static constexpr std::chrono::milliseconds default_sync_interval{1000};
+
+ private:
+  std::mutex open_mutex_;
+  std::atomic<bool> open_;
+  // Changes on every open, so threads drop the chunks of an earlier one
+  std::atomic<uint64_t> generation_;
+  int file_descriptor_;
+  char *mapping_;
+  size_t mapping_size_;
+  Analytics_Log_Header *header_;
+  Analytics_Log_Record *records_;
+  uint64_t capacity_;
+  std::atomic<uint64_t> next_chunk_;
+  std::atomic<uint64_t> dropped_records_;
+
+  std::chrono::milliseconds sync_interval_;
+  std::thread commit_thread_;
+  std::mutex commit_mutex_;
+  std::condition_variable commit_condition_;
+  bool stop_requested_;
+
+  // Next free slot of the calling thread's chunk, nullptr when full
+  Analytics_Log_Record *claim_slot();
+  static void publish(Analytics_Log_Record &slot, uint64_t message_size,
+                      uint16_t counters);
+  void commit();
+  void run_commits();
+
+ public:
+  AnalyticsLog();
+
+  ~AnalyticsLog();
+
+  AnalyticsLog(const AnalyticsLog &source) = delete;
+  AnalyticsLog &operator=(const AnalyticsLog &other) = delete;
+
+  AnalyticsLog(AnalyticsLog &&source) noexcept = delete;
+  AnalyticsLog &operator=(AnalyticsLog &&other) noexcept = delete;
+
+  // Creates the file with room for capacity records, or appends to an
+  // existing log after its committed slots, keeping its capacity. Records
+  // written after the last commit of the earlier run are discarded.
+  bool open(const std::string &path, uint64_t capacity = default_capacity,
+            std::chrono::milliseconds sync_interval = default_sync_interval);
+  // Commits one last time. Must not run while threads are appending.
+  void close();
+
+  [[nodiscard]] bool is_open() const;
+  [[nodiscard]] uint64_t get_dropped_records() const;
+
+  // Log the analytics of a reply; nothing while the log is closed
+  void append(const MessageAnalytics &analytics);
+  void append(const Pipeline_Analytics &analytics, uint64_t message_size);
+};
+
+// Process-wide log of the server; closed unless --analytics-log is given.
+AnalyticsLog &get_analytics_log();
+
+// Totals over the records of a log
+struct Analytics_Log_Summary {
+  uint64_t slots_count{0};
+  uint64_t empty_slots_count{0};
+  uint64_t first_timestamp_nanoseconds{0};
+  uint64_t last_timestamp_nanoseconds{0};
+  Aggregate_Analytics analytics;
+  uint64_t words_count{0};
+  uint64_t lines_count{0};
+  uint64_t code_points_count{0};
+};
+
+// One pass over the records; written so the compiler keeps the totals in
+// registers, and bound by memory bandwidth rather than by the loop.
+Analytics_Log_Summary summarize_analytics_log(
+    const Analytics_Log_Record *records, uint64_t count);
+
+// Reader side: a read-only mapping of a log, which may be open for writing
+// by a running server at the same time.
+class AnalyticsLogReader {
+ private:
+  int file_descriptor_;
+  const char *mapping_;
+  size_t mapping_size_;
+
+ public:
+  AnalyticsLogReader();
+
+  ~AnalyticsLogReader();
+
+  AnalyticsLogReader(const AnalyticsLogReader &source) = delete;
+  AnalyticsLogReader &operator=(const AnalyticsLogReader &other) = delete;
+
+  AnalyticsLogReader(AnalyticsLogReader &&source) noexcept = delete;
+  AnalyticsLogReader &operator=(AnalyticsLogReader &&other) noexcept = delete;
+
+  // Fails on a file that is not an analytics log of this machine's format
+  bool open(const std::string &path);
+  void close();
+
+  [[nodiscard]] const Analytics_Log_Record *get_records() const;
+  // The slots committed so far, re-read from the header on every call
+  [[nodiscard]] uint64_t get_committed_slots() const;
+};
+
+}  // namespace WindowsSocketApp
+
+#endif  // ANALYTICSLOG_H
@@ -0,0 +1,284 @@
+#ifndef ANALYTICSPIPELINE_H
+#define ANALYTICSPIPELINE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <tuple>
+#include <utility>
+
+#include "AnalyticsKernels.h"
+#include "MessageAnalytics.h"
+#include "TopWords.h"
+#include "Utf8Analytics.h"
+
+namespace WindowsSocketApp {
+
+// Counter groups a client may ask for, as bits of a counter selection.
+// Character classes are the eight counters of MessageAnalytics.
+inline constexpr uint16_t analytics_character_classes{0x0001};
+inline constexpr uint16_t analytics_words{0x0002};
+inline constexpr uint16_t analytics_lines{0x0004};
+inline constexpr uint16_t analytics_code_points{0x0008};
+inline constexpr uint16_t analytics_byte_histogram{0x0010};
+// The message decoded as UTF-8 (Utf8Analytics.h)
+inline constexpr uint16_t analytics_unicode{0x0020};
+// The most frequent words and bigrams (TopWords.h)
+inline constexpr uint16_t analytics_top_words{0x0040};
+inline constexpr uint16_t analytics_all_counters{0x007F};
+// The counter groups computed by a byte scan of the pipeline below
+inline constexpr uint16_t analytics_byte_counters{0x001F};
+
+// Results of an analytics pipeline. Only the counter groups in counters are
+// meaningful; the others stay zero.
+struct Pipeline_Analytics {
+  uint16_t counters{0};
+  MessageAnalytics classes;
+  // Runs of bytes other than ASCII whitespace
+  uint64_t words_count{0};
+  // Newline characters, as counted by wc -l
+  uint64_t lines_count{0};
+  // Bytes that do not continue a UTF-8 sequence: the code points of valid
+  // UTF-8 text
+  uint64_t code_points_count{0};
+  std::array<uint64_t, 256> byte_histogram{};
+  Utf8_Analytics unicode;
+  Top_Words_Analytics top_words;
+  // Scan state carried from one chunk of a message to the next: the last
+  // byte seen belonged to a word
+  bool in_word{false};
+};
+
+// Policies are the counters an Analytics_Pipeline is composed of. Each names
+// its counter group and keeps its counts in a State, loaded from the results
+// before a chunk is scanned and stored back after it, so the counts live in
+// registers during the scan:
+//   static constexpr uint16_t counter;
+//   struct State;
+//   static State load(Pipeline_Analytics &analytics);
+//   static void consume(State &state, unsigned char byte);
+//   static void store(const State &state, Pipeline_Analytics &analytics);
+
+struct Character_Classes_Policy {
+  static constexpr uint16_t counter{analytics_character_classes};
+
+  struct State {
+    const uint8_t *class_table{nullptr};
+    MessageAnalytics counts;
+  };
+
+  static State load(Pipeline_Analytics &analytics) {
+    return State{get_character_class_table().data(), analytics.classes};
+  }
+
+  static void consume(State &state, unsigned char byte) {
+    const unsigned flags = state.class_table[byte];
+    MessageAnalytics &counts = state.counts;
+    ++counts.length;
+    counts.spaces_count += flags & class_flag_space;
+    counts.punctuation_marks_count += (flags & class_flag_punctuation) >> 1U;
+    counts.digits_count += (flags & class_flag_digit) >> 2U;
+    counts.uppercase_count += (flags & class_flag_uppercase) >> 3U;
+    counts.lowercase_count += (flags & class_flag_lowercase) >> 4U;
+    counts.vowels_count += (flags & class_flag_vowel) >> 5U;
+    counts.consonants_count += (flags & class_flag_consonant) >> 6U;
+  }
+
+  static void store(const State &state, Pipeline_Analytics &analytics) {
+    analytics.classes = state.counts;
+  }
+};
+
+struct Words_Policy {
+  static constexpr uint16_t counter{analytics_words};
+
+  // in_word is 0 or 1. Word starts are counted with integer arithmetic:
+  // compilers turn the boolean form into a branch that prose mispredicts.
+  struct State {
+    uint64_t count{0};
+    uint64_t in_word{0};
+  };
+
+  static State load(Pipeline_Analytics &analytics) {
+    return State{analytics.words_count, analytics.in_word ? 1U : 0U};
+  }
+
+  static void consume(State &state, unsigned char byte) {
+    // Not ' ' and not one of '\t', '\n', '\v', '\f' and '\r'
+    const uint64_t in_word = static_cast<uint64_t>(byte != ' ') &
+                             static_cast<uint64_t>(byte - 9U > 4U);
+    state.count += in_word & (state.in_word ^ 1U);
+    state.in_word = in_word;
+  }
+
+  static void store(const State &state, Pipeline_Analytics &analytics) {
+    analytics.words_count = state.count;
+    analytics.in_word = state.in_word != 0;
+  }
+};
+
+struct Lines_Policy {
+  static constexpr uint16_t counter{analytics_lines};
+
+  struct State {
+    uint64_t count{0};
+  };
+
+  static State load(Pipeline_Analytics &analytics) {
+    return State{analytics.lines_count};
+  }
+
+  static void consume(State &state, unsigned char byte) {
+    state.count += static_cast<uint64_t>(byte == '\n');
+  }
+
+  static void store(const State &state, Pipeline_Analytics &analytics) {
+    analytics.lines_count = state.count;
+  }
+};
+
+struct Code_Points_Policy {
+  static constexpr uint16_t counter{analytics_code_points};
+
+  struct State {
+    uint64_t count{0};
+  };
+
+  static State load(Pipeline_Analytics &analytics) {
+    return State{analytics.code_points_count};
+  }
+
+  static void consume(State &state, unsigned char byte) {
+    state.count += static_cast<uint64_t>((byte & 0xC0U) != 0x80U);
+  }
+
+  static void store(const State &state, Pipeline_Analytics &analytics) {
+    analytics.code_points_count = state.count;
+  }
+};
+
+struct Byte_Histogram_Policy {
+  static constexpr uint16_t counter{analytics_byte_histogram};
+
+  // Counts straight into the results: 256 counters do not fit registers
+  struct State {
+    uint64_t *counts{nullptr};
+  };
+
+  static State load(Pipeline_Analytics &analytics) {
+    return State{analytics.byte_histogram.data()};
+  }
+
+  static void consume(State &state, unsigned char byte) {
+    ++state.counts[byte];
+  }
+
+  static void store(const State &, Pipeline_Analytics &) {}
+};
+
+// Counters composed at compile time into one pass over the bytes. run<S>()
+// instantiates the scan for counter selection S: the selected policies are
+// fused into a single loop and the others are compiled out, so a counter
+// nobody asked for costs nothing.
+template <typename... Policies>
+class Analytics_Pipeline {
+ private:
+  template <uint16_t Selection, typename Policy>
+  static constexpr bool is_selected{(Selection & Policy::counter) != 0U};
+
+  template <uint16_t Selection, typename Policy>
+  static void load_if_selected(typename Policy::State &state,
+                               Pipeline_Analytics &analytics) {
+    if constexpr (is_selected<Selection, Policy>) {
+      state = Policy::load(analytics);
+    }
+  }
+
+  template <uint16_t Selection, typename Policy>
+  static void consume_if_selected(typename Policy::State &state,
+                                  unsigned char byte) {
+    if constexpr (is_selected<Selection, Policy>) {
+      Policy::consume(state, byte);
+    }
+  }
+
+  template <uint16_t Selection, typename Policy>
+  static void store_if_selected(const typename Policy::State &state,
+                                Pipeline_Analytics &analytics) {
+    if constexpr (is_selected<Selection, Policy>) {
+      Policy::store(state, analytics);
+    }
+  }
+
+  template <uint16_t Selection, size_t... Indexes>
+  static void run_policies(const char *data, size_t size,
+                           Pipeline_Analytics &analytics,
+                           std::index_sequence<Indexes...>) {
+    std::tuple<typename Policies::State...> states{};
+    (load_if_selected<Selection, Policies>(std::get<Indexes>(states),
+                                           analytics),
+     ...);
+    const auto *bytes = reinterpret_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; ++i) {
+      const unsigned char byte = bytes[i];
+      (consume_if_selected<Selection, Policies>(std::get<Indexes>(states),
+                                                byte),
+       ...);
+    }
+    (store_if_selected<Selection, Policies>(std::get<Indexes>(states),
+                                            analytics),
+     ...);
+  }
+
+ public:
+  // Every counter group the pipeline can produce
+  static constexpr uint16_t counters{(Policies::counter | ... | 0U)};
+
+  // Adds the counts of data[0, size) to analytics. Counter groups outside
+  // the pipeline are ignored.
+  template <uint16_t Selection>
+  static void run(const char *data, size_t size,
+                  Pipeline_Analytics &analytics) {
+    run_policies<Selection & counters>(data, size, analytics,
+                                       std::index_sequence_for<Policies...>{});
+  }
+};
+
+using Default_Analytics_Pipeline =
+    Analytics_Pipeline<Character_Classes_Policy, Words_Policy, Lines_Policy,
+                       Code_Points_Policy, Byte_Histogram_Policy>;
+
+// Runtime front end of Default_Analytics_Pipeline: picks the scan compiled
+// for the selection once, then feeds it chunks of a message like
+// MessageAnalyzer. The character classes alone use the SIMD kernels of
+// AnalyticsKernels.h; the UTF-8 counters and the top words are computed
+// alongside the scan, the latter by a TopWordsAnalyzer created on first use.
+class PipelineAnalyzer {
+ private:
+  using Scan_Function = void (*)(const char *, size_t, Pipeline_Analytics &);
+
+  Scan_Function scan_;
+  Pipeline_Analytics analytics_;
+  Utf8Analyzer utf8_analyzer_;
+  std::unique_ptr<TopWordsAnalyzer> top_words_analyzer_;
+
+ public:
+  explicit PipelineAnalyzer(uint16_t counters_val = analytics_all_counters);
+
+  void update(const char *data, size_t size);
+  // Ends the message before its analytics are read: the top words count
+  // the word the message ends in only then
+  void finish();
+  // Starts a new message, counting the given counter groups
+  void reset(uint16_t counters);
+
+  [[nodiscard]] const Pipeline_Analytics &get_analytics() const;
+};
+
+Pipeline_Analytics calculate_pipeline_analytics(const char *data, size_t size,
+                                                uint16_t counters);
+
+}  // namespace WindowsSocketApp
+
+#endif  // ANALYTICSPIPELINE_H
@@ -0,0 +1,180 @@
+#ifndef ASYNCCLIENT_H
+#define ASYNCCLIENT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "AddressCache.h"
+#include "AnalyticsEncoding.h"
+#include "AnalyticsPipeline.h"
+#include "AsyncConnect.h"
+#include "AsyncEventLoop.h"
+#include "AsyncTask.h"
+#include "FrameProtocol.h"
+#include "NetworkTypes.h"
+#include "SocketWrapper.h"
+#include "WinSockFunctions.h"
+
+namespace WindowsSocketApp {
+
+enum class Client_Initialization_Status {
+  NOT_CONNECTED,
+  CONNECTED,
+  SHUTDOWN_FOR_SENDING
+};
+
+// One connection to the server whose connect, send and receive calls are
+// coroutines. Each call tries the socket first and waits on the event loop
+// only when it would block, so a single thread running the loop can keep
+// thousands of AsyncClients busy. With non_blocking off the socket is
+// switched to blocking once connected, and every later task finishes as soon
+// as it is started; Client is built that way. At most one send and one
+// receive may be in progress at a time. The client must stay in place, and
+// any message passed in alive, until the task using it finished.
+class AsyncClient {
+ public:
+  static constexpr size_t default_recv_buffer_capacity{1024};
+
+ private:
+  static constexpr auto default_ai_family{AF_UNSPEC};
+  static constexpr auto default_ai_socktype{SOCK_STREAM};
+  static constexpr auto default_ai_protocol{IPPROTO_TCP};
+
+  AsyncEventLoop *loop_;
+  std::string server_ip_;
+  std::string port_;
+  size_t recv_buffer_capacity_;
+  bool non_blocking_;
+  Connect_Options connect_options_;
+
+  Client_Initialization_Status client_initialization_status_;
+  addrinfo hints_;
+
+  SocketWrapper connect_socket_;
+
+  std::vector<char> recv_buffer_;
+
+  // Framed protocol: id of the next request sent and of the next response
+  // expected. The server answers the requests of a connection in order.
+  uint32_t next_request_id_;
+  uint32_t next_response_id_;
+  // Ask for the binary analytics encoding instead of text
+  bool binary_analytics_;
+  bool last_response_binary_;
+  MessageAnalytics response_analytics_;
+  // Counter groups to ask for (AnalyticsPipeline.h), 0 for the plain
+  // analytics, and those the last response carried
+  uint16_t analytics_counters_;
+  uint16_t last_response_counters_;
+  Pipeline_Analytics pipeline_analytics_;
+  // Batch requests: the payload being sent, and the records of the last
+  // batch response, decoded in whichever encoding it used
+  std::string batch_payload_;
+  bool last_response_batch_;
+  std::vector<MessageAnalytics> batch_analytics_;
+  std::vector<Pipeline_Analytics> batch_pipeline_analytics_;
+  std::vector<std::string> batch_texts_;
+  // Aggregate requests: the last response carried the server-wide analytics,
+  // decoded here when binary
+  bool last_response_aggregate_;
+  Aggregate_Analytics aggregate_analytics_;
+
+  // Sends every byte of the segments; segments is used as scratch space.
+  Task<bool> send_all(Send_Segment *segments, size_t segment_count,
+                      bool log_progress);
+  // Like receive_exactly() in WinSockFunctions.h
+  Task<bool> receive_exactly(char *buffer, size_t size,
+                             size_t &received_size);
+  // Splits the batch response in the receive buffer into its records
+  bool decode_batch_response();
+
+ public:
+  explicit AsyncClient(
+      AsyncEventLoop &loop_val, std::string server_ip_val,
+      std::string port_val,
+      size_t recv_capacity_val = default_recv_buffer_capacity,
+      bool non_blocking_val = true);
+
+  ~AsyncClient();
+
+  AsyncClient(const AsyncClient &source) = delete;
+  AsyncClient &operator=(const AsyncClient &other) = delete;
+
+  AsyncClient(AsyncClient &&source) noexcept;
+  AsyncClient &operator=(AsyncClient &&other) noexcept;
+
+  // Races connects across the addresses from the process-wide AddressCache,
+  // see connect_to_fastest_address(). The resolver itself blocks, but only
+  // on a cache miss.
+  Task<bool> connect_to_server();
+  // Takes over an already connected socket, e.g. one from a ConnectionPool.
+  bool adopt_connection(SocketWrapper connection);
+  // Gives up the connection when every framed request sent on it was
+  // answered, and closes it otherwise (the result is then invalid).
+  SocketWrapper release_connection();
+  void close_connection();
+
+  // Legacy protocol: the message, then a shutdown of the sending side, and
+  // the reply is read until the server closes the connection.
+  Task<bool> send_message(const char *message, size_t message_size,
+                          bool log_progress = true);
+  bool shutdown_message_sending();
+  Task<bool> receive_until_end(bool log_progress = true);
+
+  // Framed protocol: the message goes out as one request frame and the
+  // matching response frame's payload ends up in the receive buffer.
+  // Requests may be sent while earlier responses are still being read.
+  Task<bool> send_request_frame(const char *message, size_t message_size);
+  Task<bool> receive_response_frame();
+  // Both of the above, for one request at a time
+  Task<bool> request(const char *message, size_t message_size);
+  // All messages in one batch request frame; its response is read by
+  // receive_response_frame() like any other, and its records end up in
+  // get_batch_analytics() or get_batch_texts().
+  Task<bool> send_batch_request(const std::vector<std::string> &messages);
+  Task<bool> request_batch(const std::vector<std::string> &messages);
+  // Asks for the server-wide analytics (frame_flag_aggregate), in the
+  // encoding picked by set_binary_analytics(); the response is read by
+  // receive_response_frame().
+  Task<bool> send_aggregate_request();
+
+  [[nodiscard]] Client_Initialization_Status get_client_init_status() const;
+  // True when every request frame sent was answered
+  [[nodiscard]] bool all_responses_received() const;
+  [[nodiscard]] const std::vector<char> &get_recv_buffer() const;
+  // Analytics decoded from the last binary response frame
+  [[nodiscard]] const MessageAnalytics &get_response_analytics() const;
+  [[nodiscard]] bool get_last_response_binary() const;
+  [[nodiscard]] bool get_last_response_batch() const;
+  [[nodiscard]] uint16_t get_last_response_counters() const;
+  [[nodiscard]] bool get_last_response_aggregate() const;
+  // Analytics decoded from the last binary response frame that picked its
+  // counters
+  [[nodiscard]] const Pipeline_Analytics &get_pipeline_analytics() const;
+  // One record per message of the last batch response, in request order
+  [[nodiscard]] const std::vector<MessageAnalytics> &get_batch_analytics()
+      const;
+  [[nodiscard]] const std::vector<Pipeline_Analytics> &
+  get_batch_pipeline_analytics() const;
+  [[nodiscard]] const std::vector<std::string> &get_batch_texts() const;
+  // Server-wide analytics decoded from the last binary aggregate response
+  [[nodiscard]] const Aggregate_Analytics &get_aggregate_analytics() const;
+  [[nodiscard]] const Connect_Options &get_connect_options() const;
+  void set_connect_options(Connect_Options connect_options);
+  [[nodiscard]] bool get_binary_analytics() const;
+  void set_binary_analytics(bool binary_analytics);
+  [[nodiscard]] uint16_t get_analytics_counters() const;
+  // Counter groups requested from now on, any analytics_* bits; 0 asks for
+  // the plain character class analytics
+  void set_analytics_counters(uint16_t analytics_counters);
+  [[nodiscard]] size_t get_recv_buffer_capacity() const;
+  [[nodiscard]] const std::string &get_port() const;
+  void set_port(std::string port);
+  [[nodiscard]] const std::string &get_server_ip() const;
+  void set_server_ip(std::string server_ip);
+};
+
+}  // namespace WindowsSocketApp
+
+#endif  // ASYNCCLIENT_H
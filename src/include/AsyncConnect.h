@@ -0,0 +1,34 @@
+#ifndef ASYNCCONNECT_H
+#define ASYNCCONNECT_H
+
+#include <chrono>
+
+#include "AsyncEventLoop.h"
+#include "AsyncTask.h"
+#include "NetworkTypes.h"
+#include "SocketWrapper.h"
+
+namespace WindowsSocketApp {
+
+struct Connect_Options {
+  // How long an attempt runs alone before the next address is tried as
+  // well (the "Connection Attempt Delay" of RFC 8305)
+  std::chrono::milliseconds attempt_delay{250};
+  // Limit for the whole connect, over all addresses
+  std::chrono::milliseconds timeout{10000};
+};
+
+// Happy Eyeballs connect (RFC 8305): non-blocking connects raced across the
+// resolved addresses, with address families alternating from the family of
+// the first address. Attempts start attempt_delay apart, or at once when the
+// previous attempt failed. The first socket to connect wins; the others are
+// closed. The winner is left non-blocking and waited on by the loop; it is
+// invalid when no address connected before the timeout. addresses must stay
+// alive until the task finished.
+Task<SocketWrapper> connect_to_fastest_address(AsyncEventLoop &loop,
+                                               const addrinfo *addresses,
+                                               Connect_Options options = {});
+
+}  // namespace WindowsSocketApp
+
+#endif  // ASYNCCONNECT_H
@@ -0,0 +1,162 @@
+#ifndef ASYNCEVENTLOOP_H
+#define ASYNCEVENTLOOP_H
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <map>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "AsyncTask.h"
+#include "SocketWrapper.h"
+
+namespace WindowsSocketApp {
+
+// Single-threaded event loop driving coroutines that wait for non-blocking
+// sockets. A coroutine tries its socket call first and only on "would block"
+// awaits readable()/writable(); the loop resumes it once the socket is ready.
+// Edge-triggered epoll on Linux, WSAPoll/poll elsewhere. Any number of
+// sockets may be waited on, but at most one reader and one writer per socket
+// at a time. Not thread-safe: tasks are spawned and run on one thread.
+class AsyncEventLoop {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+ private:
+  static constexpr int default_max_events{256};
+
+  struct Socket_Waiters {
+    std::coroutine_handle<> reader;
+    std::coroutine_handle<> writer;
+    bool registered{false};
+  };
+
+  // Owns a spawned task; finishes on its own and tells the loop
+  struct Detached_Task {
+    struct promise_type {
+      Detached_Task get_return_object() const noexcept { return {}; }
+      std::suspend_never initial_suspend() const noexcept { return {}; }
+      std::suspend_never final_suspend() const noexcept { return {}; }
+      void return_void() const noexcept {}
+      void unhandled_exception() const noexcept { std::terminate(); }
+    };
+  };
+
+  // co_await yields false, without suspending, when the socket cannot be
+  // watched
+  struct Socket_Awaiter {
+    AsyncEventLoop &loop;
+    SOCKET socket;
+    bool for_writing;
+    bool waited{false};
+
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(std::coroutine_handle<> waiting) {
+      waited = loop.add_waiter(socket, for_writing, waiting);
+      return waited;
+    }
+    bool await_resume() const noexcept { return waited; }
+  };
+
+  // Waits for the first of several sockets to turn writable, or for the
+  // deadline. co_await yields false, without suspending, when a socket
+  // cannot be watched; the caller then checks which sockets are ready.
+  struct Any_Writable_Awaiter {
+    AsyncEventLoop &loop;
+    std::vector<SOCKET> sockets;
+    Clock::time_point deadline;
+    std::coroutine_handle<> waiting{nullptr};
+    bool waited{false};
+
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(std::coroutine_handle<> waiting_val);
+    // Withdraws the waits that did not fire
+    bool await_resume();
+  };
+
+  // epoll descriptor on Linux, created by the first wait and closed by the
+  // socket wrapper, so a loop whose sockets never block costs nothing
+  SocketWrapper poller_;
+  int max_events_;
+#ifdef __linux__
+  // Sized once, so waiting does not allocate
+  std::vector<epoll_event> events_;
+#endif
+  std::unordered_map<SOCKET, Socket_Waiters> waiters_;
+  // Coroutines to resume at a deadline, earliest first
+  std::multimap<Clock::time_point, std::coroutine_handle<>> timers_;
+  size_t waiting_count_;
+  size_t active_task_count_;
+
+  static Detached_Task run_detached(AsyncEventLoop &loop, Task<void> task);
+  template <typename T>
+  static Task<void> store_result(Task<T> task, std::optional<T> &result) {
+    result.emplace(co_await std::move(task));
+  }
+
+  bool add_waiter(SOCKET socket, bool for_writing,
+                  std::coroutine_handle<> waiting);
+  // Undoes add_waiter() when the waiter is still there
+  void remove_waiter(SOCKET socket, bool for_writing,
+                     std::coroutine_handle<> waiting);
+  void remove_timer(Clock::time_point deadline,
+                    std::coroutine_handle<> waiting);
+  // Blocks until at least one waited-for socket is ready or the earliest
+  // deadline passed, and resumes the waiters.
+  bool wait_and_dispatch();
+
+ public:
+  explicit AsyncEventLoop(int max_events_val = default_max_events);
+
+  ~AsyncEventLoop() = default;
+
+  AsyncEventLoop(const AsyncEventLoop &source) = delete;
+  AsyncEventLoop &operator=(const AsyncEventLoop &other) = delete;
+
+  AsyncEventLoop(AsyncEventLoop &&source) noexcept = delete;
+  AsyncEventLoop &operator=(AsyncEventLoop &&other) noexcept = delete;
+
+  // Starts the task right away; it runs until its first wait.
+  void spawn(Task<void> task);
+  // Runs until every spawned task has finished. False when polling failed or
+  // tasks are left waiting on something other than a socket.
+  bool run();
+
+  // Blocking call of a coroutine: spawns it and runs the loop, along with
+  // every other task spawned meanwhile. Empty when the loop failed first.
+  template <typename T>
+  std::optional<T> run_until_complete(Task<T> task) {
+    std::optional<T> result;
+    spawn(store_result(std::move(task), result));
+    run();
+    return result;
+  }
+  bool run_until_complete(Task<void> task);
+
+  [[nodiscard]] Socket_Awaiter readable(SOCKET socket) {
+    return Socket_Awaiter{*this, socket, false};
+  }
+  [[nodiscard]] Socket_Awaiter writable(SOCKET socket) {
+    return Socket_Awaiter{*this, socket, true};
+  }
+  // With no sockets, a sleep until the deadline
+  [[nodiscard]] Any_Writable_Awaiter any_writable(std::vector<SOCKET> sockets,
+                                                  Clock::time_point deadline) {
+    return Any_Writable_Awaiter{*this, std::move(sockets), deadline};
+  }
+  // Must be called before a waited-on socket is closed or handed to another
+  // loop.
+  void forget(SOCKET socket);
+
+  [[nodiscard]] size_t get_active_task_count() const;
+};
+
+}  // namespace WindowsSocketApp
+
+#endif  // ASYNCEVENTLOOP_H
@@ -0,0 +1,148 @@
+#ifndef ASYNCTASK_H
+#define ASYNCTASK_H
+
+#if !defined(__cpp_impl_coroutine)
+#error "AsyncTask.h needs C++20 coroutines; build this target as C++20"
+#endif
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+namespace WindowsSocketApp {
+
+template <typename T = void>
+class Task;
+
+namespace detail {
+
+struct Task_Promise_Base {
+  // Resumed when the task finishes; the awaiting coroutine
+  std::coroutine_handle<> continuation;
+  std::exception_ptr exception;
+
+  struct Final_Awaiter {
+    bool await_ready() const noexcept { return false; }
+    // Symmetric transfer, so long chains of tasks finishing synchronously do
+    // not grow the stack
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(
+        std::coroutine_handle<Promise> finished) const noexcept {
+      const auto continuation = finished.promise().continuation;
+      return continuation ? continuation : std::noop_coroutine();
+    }
+    void await_resume() const noexcept {}
+  };
+
+  std::suspend_always initial_suspend() const noexcept { return {}; }
+  Final_Awaiter final_suspend() const noexcept { return {}; }
+  void unhandled_exception() noexcept { exception = std::current_exception(); }
+};
+
+template <typename T>
+struct Task_Promise : Task_Promise_Base {
+  std::optional<T> value;
+
+  Task<T> get_return_object() noexcept;
+  void return_value(T result) { value.emplace(std::move(result)); }
+  T take_result() {
+    if (exception) {
+      std::rethrow_exception(exception);
+    }
+    return std::move(*value);
+  }
+};
+
+template <>
+struct Task_Promise<void> : Task_Promise_Base {
+  Task<void> get_return_object() noexcept;
+  void return_void() const noexcept {}
+  void take_result() const {
+    if (exception) {
+      std::rethrow_exception(exception);
+    }
+  }
+};
+
+}  // namespace detail
+
+// Lazily started coroutine returning T. Nothing runs until the task is
+// awaited (co_await task) or handed to AsyncEventLoop; the awaiting
+// coroutine resumes once it finishes. Move-only; destroying an unfinished
+// task destroys its coroutine frame.
+// GCC 12 miscompiles co_await inside && and || and in co_return, so await
+// in a statement of its own.
+template <typename T>
+class Task {
+ public:
+  using promise_type = detail::Task_Promise<T>;
+
+ private:
+  std::coroutine_handle<promise_type> handle_;
+
+ public:
+  Task() : handle_{nullptr} {}
+  explicit Task(std::coroutine_handle<promise_type> handle_val)
+      : handle_{handle_val} {}
+
+  ~Task() {
+    if (handle_) {
+      handle_.destroy();
+    }
+  }
+
+  Task(const Task &source) = delete;
+  Task &operator=(const Task &other) = delete;
+
+  Task(Task &&source) noexcept
+      : handle_{std::exchange(source.handle_, nullptr)} {}
+  Task &operator=(Task &&other) noexcept {
+    if (this != &other) {
+      if (handle_) {
+        handle_.destroy();
+      }
+      handle_ = std::exchange(other.handle_, nullptr);
+    }
+    return *this;
+  }
+
+  [[nodiscard]] bool valid() const { return static_cast<bool>(handle_); }
+  [[nodiscard]] bool done() const { return !handle_ || handle_.done(); }
+
+  auto operator co_await() && noexcept {
+    struct Awaiter {
+      std::coroutine_handle<promise_type> task;
+
+      bool await_ready() const noexcept { return !task || task.done(); }
+      std::coroutine_handle<> await_suspend(
+          std::coroutine_handle<> awaiting) const noexcept {
+        task.promise().continuation = awaiting;
+        return task;
+      }
+      T await_resume() const { return task.promise().take_result(); }
+    };
+    return Awaiter{handle_};
+  }
+  auto operator co_await() & noexcept {
+    return std::move(*this).operator co_await();
+  }
+};
+
+namespace detail {
+
+template <typename T>
+Task<T> Task_Promise<T>::get_return_object() noexcept {
+  return Task<T>{std::coroutine_handle<Task_Promise<T>>::from_promise(*this)};
+}
+
+inline Task<void> Task_Promise<void>::get_return_object() noexcept {
+  return Task<void>{
+      std::coroutine_handle<Task_Promise<void>>::from_promise(*this)};
+}
+
+}  // namespace detail
+
+}  // namespace WindowsSocketApp
+
+#endif  // ASYNCTASK_H
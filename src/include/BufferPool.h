@@ -0,0 +1,126 @@
+#ifndef BUFFERPOOL_H
+#define BUFFERPOOL_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace WindowsSocketApp {
+
+class BufferPool;
+
+// Buffer borrowed from the BufferPool, returned to it when destroyed. Hold
+// one only while a read into it is in progress so idle connections pin no
+// memory.
+class PooledBuffer {
+ private:
+  char *data_;
+  size_t size_;
+
+ public:
+  PooledBuffer() : data_{nullptr}, size_{0} {}
+  PooledBuffer(char *data_val, size_t size_val)
+      : data_{data_val}, size_{size_val} {}
+  ~PooledBuffer();
+
+  PooledBuffer(PooledBuffer &&source) noexcept;
+  PooledBuffer &operator=(PooledBuffer &&rhs) noexcept;
+
+  PooledBuffer(const PooledBuffer &source) = delete;
+  PooledBuffer &operator=(const PooledBuffer &rhs) = delete;
+
+  // Returns the buffer to the pool early
+  void release();
+
+  [[nodiscard]] char *data() const { return data_; }
+  // At least the size that was requested
+  [[nodiscard]] size_t size() const { return size_; }
+  [[nodiscard]] bool valid() const { return data_ != nullptr; }
+};
+
+// Process-wide slab allocator for I/O buffers. Requests are rounded up to one
+// of four size classes (4, 16, 64 and 256 KiB); buffers of a class are carved
+// from 1 MiB slabs on demand and recycled through free lists:
+//   - every thread keeps a small cache per class, so borrowing and returning
+//     buffers normally touches no lock shared with other threads;
+//   - caches exchange buffers with the shared per-class lists in batches.
+// Every buffer starts on a cache-line boundary. Slabs are kept until the
+// process exits; larger requests bypass the pool.
+class BufferPool {
+ public:
+  static constexpr size_t cache_line_size{64};
+  static constexpr size_t size_class_count{4};
+  static constexpr size_t smallest_buffer_size{4 * 1024};
+  static constexpr size_t largest_buffer_size{256 * 1024};
+  static constexpr size_t slab_size{1024 * 1024};
+  // Buffers of one class a thread keeps before handing half of them back
+  static constexpr size_t thread_cache_capacity{8};
+
+ private:
+  // Singly linked through the first bytes of each free buffer
+  struct Free_List {
+    char *head{nullptr};
+    size_t count{0};
+
+    void push(char *buffer);
+    char *pop();
+  };
+
+  struct Size_Class {
+    std::mutex mutex;
+    Free_List free_buffers;
+    char *slab_cursor{nullptr};
+    char *slab_end{nullptr};
+  };
+
+  struct Thread_Cache {
+    std::array<Free_List, size_class_count> free_buffers;
+    // Hands the cached buffers back when the thread exits
+    ~Thread_Cache();
+  };
+
+  static thread_local Thread_Cache thread_cache_;
+
+  std::array<Size_Class, size_class_count> size_classes_;
+
+  std::mutex slabs_mutex_;
+  std::vector<char *> slabs_;
+  std::atomic<size_t> oversized_buffer_count_;
+
+  BufferPool();
+
+  char *allocate(size_t size_class);
+  void deallocate(char *buffer, size_t size_class);
+  void refill(size_t size_class, Free_List &cache);
+  void drain(size_t size_class, Free_List &cache, size_t count);
+  char *carve_from_slab(size_t size_class);
+  void release_buffer(char *buffer, size_t size);
+
+  friend BufferPool &get_buffer_pool();
+  friend class PooledBuffer;
+
+ public:
+  ~BufferPool();
+
+  BufferPool(const BufferPool &source) = delete;
+  BufferPool &operator=(const BufferPool &other) = delete;
+
+  BufferPool(BufferPool &&source) noexcept = delete;
+  BufferPool &operator=(BufferPool &&other) noexcept = delete;
+
+  [[nodiscard]] PooledBuffer acquire(size_t minimum_size);
+
+  [[nodiscard]] size_t get_slab_count();
+  [[nodiscard]] size_t get_oversized_buffer_count() const;
+
+  [[nodiscard]] static size_t get_class_buffer_size(size_t size_class);
+};
+
+// The pool shared by all connections, created on first use.
+BufferPool &get_buffer_pool();
+
+}  // namespace WindowsSocketApp
+
+#endif  // BUFFERPOOL_H
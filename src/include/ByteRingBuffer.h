@@ -0,0 +1,67 @@
+#ifndef BYTERINGBUFFER_H
+#define BYTERINGBUFFER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+#include "BufferPool.h"
+
+namespace WindowsSocketApp {
+
+// Fixed-capacity byte ring shared by one producer and one consumer thread.
+// Each side works directly on a contiguous region of the ring (no extra
+// copy) and only takes the lock to publish how many bytes it produced or
+// consumed, or to sleep while the ring is full or empty.
+// The storage is borrowed from the buffer pool, so the capacity is rounded up
+// to its size class.
+class ByteRingBuffer {
+ public:
+  struct Region {
+    char *data;
+    size_t size;
+  };
+
+ private:
+  PooledBuffer storage_;
+  size_t read_position_;
+  size_t write_position_;
+  size_t used_size_;
+  bool writer_closed_;
+  bool aborted_;
+
+  std::mutex state_mutex_;
+  std::condition_variable state_changed_;
+
+ public:
+  explicit ByteRingBuffer(size_t capacity_val);
+
+  ~ByteRingBuffer() = default;
+
+  ByteRingBuffer(const ByteRingBuffer &source) = delete;
+  ByteRingBuffer &operator=(const ByteRingBuffer &other) = delete;
+
+  ByteRingBuffer(ByteRingBuffer &&source) noexcept = delete;
+  ByteRingBuffer &operator=(ByteRingBuffer &&other) noexcept = delete;
+
+  // Producer side. Waits for free space; an empty region means the ring was
+  // aborted.
+  Region acquire_write_region();
+  void commit_write(size_t byte_count);
+  // No more data will be written; the consumer drains what is left.
+  void close_writer();
+
+  // Consumer side. Waits for data; an empty region means the writer closed
+  // the ring and everything was consumed, or the ring was aborted.
+  Region acquire_read_region();
+  void commit_read(size_t byte_count);
+
+  // Wakes both sides and makes every further acquire return an empty region.
+  void abort();
+
+  [[nodiscard]] size_t get_capacity() const;
+};
+
+}  // namespace WindowsSocketApp
+
+#endif  // BYTERINGBUFFER_H
@@ -5,18 +5,15 @@
 #include <string>
 #include <vector>
 
-#include "NetworkTypes.h"
-#include "SocketWrapper.h"
-#include "WinSockFunctions.h"
+#include "AsyncClient.h"
+#include "AsyncEventLoop.h"
 
 namespace WindowsSocketApp {
 
-enum class Client_Initialization_Status {
-  NOT_CONNECTED,
-  CONNECTED,
-  SHUTDOWN_FOR_SENDING
-};
+class ConnectionPool;
 
+// Blocking client: every call runs the matching AsyncClient coroutine to
+// completion on a private event loop.
 class Client {
  private:
   inline static const char *default_send_buffer{"Test Message!"};
@@ -24,25 +21,14 @@ class Client {
   inline static const char *default_server_ip{"localhost"};
   inline static const char *default_port{"27015"};
 
-  static constexpr auto default_ai_family{AF_UNSPEC};
-  static constexpr auto default_ai_socktype{SOCK_STREAM};
-  static constexpr auto default_ai_protocol{IPPROTO_TCP};
-
   std::string send_buffer_;
-  size_t recv_buffer_capacity_;
-  std::string server_ip_;
-  std::string port_;
-
-  Client_Initialization_Status client_initialization_status_;
-  Sockaddr_Struct_State client_sockaddr_struct_state_;
 
-  AddrInfoPtr result_;
-  addrinfo *addrinfo_ptr_;
-  addrinfo hints_;
+  // Drives the AsyncClient's tasks. Only connecting waits on the loop; the
+  // connected socket blocks, so later tasks finish without it polling.
+  std::unique_ptr<AsyncEventLoop> event_loop_;
+  AsyncClient async_client_;
 
-  SocketWrapper connect_socket_;
-
-  std::vector<char> recv_buffer_;
+  bool run_blocking(Task<bool> task);
 
  public:
   explicit Client(std::string send_buff_val = default_send_buffer,
@@ -56,13 +42,56 @@ class Client {
   Client &operator=(const Client &other) = delete;
 
   Client(Client &&source) noexcept = default;
-  Client &operator=(Client &&other) noexcept = default;
+  Client &operator=(Client &&other) noexcept;
 
+  // Server addresses come from the process-wide AddressCache, so repeated
+  // connections skip the resolver. Connects are raced across the addresses
+  // and give up after the connect timeout.
   void connect_to_server();
-  void send_buffer_to_server() const;
+  // Takes an idle connection to the server from the pool, or a new one.
+  void connect_to_server(ConnectionPool &pool);
+  // Hands the connection back to the pool when every framed request sent on
+  // it was answered, and closes it otherwise.
+  void release_connection(ConnectionPool &pool);
+  void send_buffer_to_server();
   void shutdown_message_sending();
   void receive_server_message();
 
+  // Framed protocol: the message buffer goes out as one request frame and
+  // the matching response frame's payload ends up in the receive buffer.
+  // Several requests may be sent before their responses are read; the
+  // connection stays open for further requests.
+  bool send_request_frame();
+  // Sends the given message instead of the message buffer
+  bool send_request_frame(const char *message, size_t message_size);
+  bool receive_response_frame();
+  // All messages as one batch request frame, answered by one response frame
+  // with a record per message
+  bool send_batch_request(const std::vector<std::string> &messages);
+  // Asks for the server-wide analytics instead of sending a message
+  bool send_aggregate_request();
+  // Analytics decoded from the last binary response frame
+  [[nodiscard]] const MessageAnalytics &get_response_analytics() const;
+  // Analytics decoded from the last binary response frame that picked its
+  // counters
+  [[nodiscard]] const Pipeline_Analytics &get_pipeline_analytics() const;
+  // Records of the last batch response, binary or text
+  [[nodiscard]] const std::vector<MessageAnalytics> &get_batch_analytics()
+      const;
+  [[nodiscard]] const std::vector<Pipeline_Analytics> &
+  get_batch_pipeline_analytics() const;
+  [[nodiscard]] const std::vector<std::string> &get_batch_texts() const;
+  // Server-wide analytics of the last binary aggregate response
+  [[nodiscard]] const Aggregate_Analytics &get_aggregate_analytics() const;
+  [[nodiscard]] const Connect_Options &get_connect_options() const;
+  void set_connect_options(Connect_Options connect_options);
+  [[nodiscard]] bool get_binary_analytics() const;
+  void set_binary_analytics(bool binary_analytics);
+  // Counter groups of AnalyticsPipeline.h to ask for; 0 (the default) asks
+  // for the plain character class analytics
+  [[nodiscard]] uint16_t get_analytics_counters() const;
+  void set_analytics_counters(uint16_t analytics_counters);
+
   [[nodiscard]] Client_Initialization_Status get_client_init_status() const;
   [[nodiscard]] const std::string &get_send_message_buffer() const;
   void set_send_message_buffer(std::string send_message_buffer);
@@ -0,0 +1,105 @@
+#ifndef CLIENTSESSION_H
+#define CLIENTSESSION_H
+
+#include <chrono>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "FrameProtocol.h"
+#include "MessageAnalytics.h"
+#include "SocketWrapper.h"
+#include "WinSockFunctions.h"
+#include "ZeroCopySender.h"
+
+namespace WindowsSocketApp {
+
+// BUFFERED keeps the whole message (needed to display or echo it);
+// STREAMING analyzes it while it is received, in constant memory.
+enum class Session_Receive_Mode { BUFFERED, STREAMING };
+
+// Per-connection state of the server: the accepted socket, the message
+// received on it and the analytics produced for it. Sessions are move-only and
+// independent of each other, so any number of them can be served in parallel.
+class ClientSession {
+ private:
+  static constexpr int default_recv_buffer_capacity{1024};
+  static constexpr size_t frame_read_size{16 * 1024};
+
+  size_t recv_buffer_capacity_;
+  bool log_progress_;
+  Session_Receive_Mode receive_mode_;
+  // Legacy replies: send the message back ahead of its analytics, and send
+  // large replies with MSG_ZEROCOPY through a sender enabled once for the
+  // session, so its completions and copy fallback carry over between sends
+  bool echo_message_;
+  std::optional<ZeroCopySender> zero_copy_sender_;
+
+  SocketWrapper client_socket_;
+  // Start of the accept-queue wait recorded in the server metrics
+  std::chrono::steady_clock::time_point accepted_at_;
+
+  std::vector<char> recv_buffer_;
+  MessageAnalyzer analyzer_;
+  std::string recv_message_analytics_;
+
+  bool send_segments_to_client(Send_Segment *segments, size_t segment_count);
+  void record_receive_error() const;
+  // A send timeout means the client stopped reading
+  void record_send_error() const;
+
+ public:
+  ClientSession();
+  explicit ClientSession(
+      SocketWrapper client_socket_val,
+      size_t recv_capacity_val = default_recv_buffer_capacity,
+      bool log_progress_val = true,
+      Session_Receive_Mode receive_mode_val = Session_Receive_Mode::BUFFERED);
+
+  ~ClientSession() = default;
+
+  ClientSession(const ClientSession &source) = delete;
+  ClientSession &operator=(const ClientSession &other) = delete;
+
+  ClientSession(ClientSession &&source) noexcept = default;
+  ClientSession &operator=(ClientSession &&other) noexcept = default;
+
+  bool receive_client_message();
+  // A buffered message is answered from the AnalyticsCache when it is there
+  void calculate_recv_message_analytics();
+  bool echo_message_to_client();
+  bool send_recv_message_analytics_to_client();
+  // The received message followed by its analytics, in one scatter-gather
+  // send. Same bytes as echo_message_to_client() and then
+  // send_recv_message_analytics_to_client(), without the second syscall.
+  bool send_echo_and_analytics_to_client();
+  bool shutdown_message_sending();
+
+  // Waits for the first byte from the client and tells from it whether the
+  // client speaks the framed protocol. Nothing is consumed from the socket.
+  Wire_Format detect_wire_format() const;
+  // Answers request frames until the client shuts down its sending side.
+  bool serve_frames();
+
+  // Runs the whole receive -> analyze -> send -> shutdown pipeline, for a
+  // legacy client, or serve_frames() for a framed one. The message is echoed
+  // ahead of the analytics when enabled and the session buffers it.
+  bool serve();
+
+  [[nodiscard]] bool valid() const;
+  [[nodiscard]] SOCKET get_socket() const;
+  void display_recv_buffer() const;
+  [[nodiscard]] const std::vector<char> &get_recv_buffer() const;
+  [[nodiscard]] const std::string &get_recv_message_analytics() const;
+  void set_echo_message(bool echo_message);
+  // Falls back to copying sends where MSG_ZEROCOPY is unavailable. Set once
+  // the session holds its socket.
+  void set_zero_copy_send(bool zero_copy_send);
+  // Sends fail once the client read nothing for the timeout, so a client
+  // that stops reading does not hold its thread; 0 waits forever.
+  bool set_slow_reader_timeout(std::chrono::milliseconds timeout);
+};
+
+}  // namespace WindowsSocketApp
+
+#endif  // CLIENTSESSION_H
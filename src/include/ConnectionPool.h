@@ -0,0 +1,94 @@
+#ifndef CONNECTIONPOOL_H
+#define CONNECTIONPOOL_H
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "AddressCache.h"
+#include "AsyncConnect.h"
+#include "SocketWrapper.h"
+
+namespace WindowsSocketApp {
+
+struct Connection_Pool_Statistics {
+  uint64_t connections_opened{0};
+  uint64_t connections_reused{0};
+  // Idle connections closed because the peer closed them, they idled too
+  // long or the pool for their server was full
+  uint64_t connections_discarded{0};
+};
+
+// Idle client connections by server, reused by later requests so they skip
+// both the resolver (through the AddressCache) and the TCP handshake. New
+// connections are raced across the server's addresses. A
+// connection is checked before it is handed out again: one with anything
+// waiting on it (end of input, reset, stray data) or idle for longer than
+// the idle timeout is closed instead. Only connections whose every response
+// was read may be released; the framed protocol keeps them open between
+// requests. Safe to use from several threads.
+class ConnectionPool {
+ public:
+  static constexpr size_t default_max_idle_per_server{8};
+  static constexpr std::chrono::seconds default_idle_timeout{60};
+
+ private:
+  struct Idle_Connection {
+    SocketWrapper socket;
+    std::chrono::steady_clock::time_point idle_since;
+  };
+
+  size_t max_idle_per_server_;
+  std::chrono::steady_clock::duration idle_timeout_;
+  AddressCache &address_cache_;
+  Connect_Options connect_options_;
+  addrinfo hints_;
+
+  mutable std::mutex pool_mutex_;
+  std::unordered_map<std::string, std::vector<Idle_Connection>>
+      idle_connections_;
+  Connection_Pool_Statistics statistics_;
+
+  static std::string make_key(const std::string &host,
+                              const std::string &port);
+  // Most recently released idle connection of the server, if any
+  bool take_idle(const std::string &key, Idle_Connection &connection);
+  SocketWrapper open_connection(const std::string &host,
+                                const std::string &port);
+
+ public:
+  explicit ConnectionPool(
+      size_t max_idle_per_server_val = default_max_idle_per_server,
+      std::chrono::steady_clock::duration idle_timeout_val =
+          default_idle_timeout,
+      AddressCache &address_cache_val = get_address_cache(),
+      Connect_Options connect_options_val = {});
+
+  ~ConnectionPool() = default;
+
+  ConnectionPool(const ConnectionPool &source) = delete;
+  ConnectionPool &operator=(const ConnectionPool &other) = delete;
+
+  ConnectionPool(ConnectionPool &&source) noexcept = delete;
+  ConnectionPool &operator=(ConnectionPool &&other) noexcept = delete;
+
+  // A healthy idle connection to the server or a new one; invalid when no
+  // connection could be made.
+  SocketWrapper acquire(const std::string &host, const std::string &port);
+  // Keeps the connection for reuse, or closes it when the server already
+  // has max_idle_per_server idle connections.
+  void release(const std::string &host, const std::string &port,
+               SocketWrapper socket);
+  // Closes every idle connection.
+  void clear();
+
+  [[nodiscard]] size_t get_idle_count() const;
+  [[nodiscard]] Connection_Pool_Statistics get_statistics() const;
+};
+
+}  // namespace WindowsSocketApp
+
+#endif  // CONNECTIONPOOL_H
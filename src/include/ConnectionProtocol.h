@@ -0,0 +1,129 @@
+#ifndef CONNECTIONPROTOCOL_H
+#define CONNECTIONPROTOCOL_H
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+
+#include "AnalyticsEncoding.h"
+#include "AnalyticsPipeline.h"
+#include "FrameProtocol.h"
+#include "MessageAnalytics.h"
+
+namespace WindowsSocketApp {
+
+// Transport-independent server side of one client connection. Event-driven
+// I/O engines feed it the bytes they read and drain the reply it produces, so
+// the message handling is the same whatever backend moves the bytes.
+// Received bytes are analyzed as they arrive and never stored, so the memory
+// used by a connection does not depend on the size of the message. While the
+// AnalyticsCache is enabled, messages it accepts are kept instead, until they
+// are complete: a cached reply is then sent without analyzing them.
+// The first byte selects the wire format:
+//   LEGACY - one message ended by the client's shutdown, one plain reply;
+//   FRAMED - any number of request frames, each answered by a response frame
+//            as soon as its payload is complete (see FrameProtocol.h).
+// A batch request is kept whole and its messages analyzed in one pass over
+// it, their records written straight into the output. A request that picks
+// its counters is analyzed by a PipelineAnalyzer, created on first use.
+// Every message analyzed is added to the server-wide analytics of the
+// calling thread (ServerMetrics.h), which an aggregate request reads back,
+// and to the analytics log when one is open (AnalyticsLog.h).
+class ConnectionProtocol {
+ private:
+  Wire_Format wire_format_;
+  MessageAnalyzer analyzer_;
+
+  // Framed input: header bytes collected so far and the frame being read
+  std::array<char, frame_header_size> header_bytes_;
+  size_t header_bytes_received_;
+  Frame_Header current_frame_;
+  size_t payload_bytes_remaining_;
+
+  // Output handed out by pending_output(). Replies produced while part of it
+  // is still unsent are queued separately, so the region an engine is
+  // sending from never moves.
+  std::string send_buffer_;
+  size_t send_offset_;
+  std::string queued_output_;
+  // Output bytes consumed so far, and the offset in that count at which each
+  // reply not yet fully sent ends
+  uint64_t output_consumed_;
+  std::deque<uint64_t> reply_ends_;
+
+  // Reply payloads are encoded here first, so producing one allocates
+  // nothing once the output buffers have reached their working size.
+  Analytics_Text_Buffer reply_payload_;
+
+  // Current message, kept for the cache lookup, or current batch payload
+  std::string message_bytes_;
+  bool keep_message_;
+  bool batch_;
+  // The current frame asks for the server-wide analytics; its payload is
+  // skipped
+  bool aggregate_;
+  // Counters picked by the current frame, 0 for the plain analytics
+  uint16_t counters_;
+  std::unique_ptr<PipelineAnalyzer> pipeline_;
+
+  bool receive_completed_;
+  bool protocol_error_;
+
+  void on_frame_bytes_received(const char *data, size_t size);
+  void start_message(size_t expected_size);
+  void analyze(const char *data, size_t size);
+  // Encodes the reply to the current message in reply_payload_, from the
+  // cache when possible, and returns its size.
+  size_t write_reply(bool binary);
+  void complete_frame();
+  // Answers the batch kept in message_bytes_; false when it is malformed
+  bool complete_batch(bool binary);
+  void complete_aggregate(bool binary);
+  // A response whose payload is encoded straight into the output: the header
+  // is reserved first and written once the payload length is known.
+  size_t begin_response(std::string &output);
+  void finish_response(std::string &output, size_t frame_start,
+                       uint16_t flags);
+  void reject_frame(uint32_t request_id, const char *reason);
+  std::string &output_for_append();
+  // Marks the end of the output as the end of a reply
+  void end_reply();
+
+ public:
+  ConnectionProtocol();
+
+  ~ConnectionProtocol() = default;
+
+  ConnectionProtocol(const ConnectionProtocol &source) = delete;
+  ConnectionProtocol &operator=(const ConnectionProtocol &other) = delete;
+
+  ConnectionProtocol(ConnectionProtocol &&source) noexcept = default;
+  ConnectionProtocol &operator=(ConnectionProtocol &&other) noexcept = default;
+
+  void on_bytes_received(const char *data, size_t size);
+  // The client shut down its sending side. A legacy message is complete and
+  // its analytics become the pending output; a framed connection just ends.
+  void on_end_of_input();
+
+  // No further input will be processed: the client ended it or sent a
+  // malformed frame.
+  [[nodiscard]] bool receive_completed() const;
+  [[nodiscard]] Wire_Format get_wire_format() const;
+  // Stays valid until the next consume_output() call, whatever is received
+  // in the meantime.
+  [[nodiscard]] const char *pending_output() const;
+  [[nodiscard]] size_t pending_output_size() const;
+  void consume_output(size_t byte_count);
+  // All output not yet consumed, the pending output included
+  [[nodiscard]] size_t buffered_output_size() const;
+  // Replies produced and not yet fully consumed
+  [[nodiscard]] size_t pending_reply_count() const;
+  // Input ended and the whole reply was handed to the transport.
+  [[nodiscard]] bool finished() const;
+};
+
+}  // namespace WindowsSocketApp
+
+#endif  // CONNECTIONPROTOCOL_H
@@ -0,0 +1,100 @@
+#ifndef EPOLLREACTOR_H
+#define EPOLLREACTOR_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "ConnectionProtocol.h"
+#include "FlowControl.h"
+#include "NetworkTypes.h"
+#include "SocketWrapper.h"
+
+namespace WindowsSocketApp {
+
+// Single-threaded, edge-triggered epoll event loop (Linux only).
+// The listening socket stays open for the whole lifetime of the loop and all
+// accepted connections are non-blocking, so a slow client only delays itself.
+// Every connection goes through the same receive -> analyze -> send pipeline
+// as the blocking server: the message ends when the client shuts down its
+// sending side, the analytics are sent back and the connection is closed.
+// Reading from a connection pauses while its unsent replies are over the
+// FlowControl limits, leaving the input to TCP flow control, and resumes once
+// they drained; connections whose client stopped reading are closed.
+class EpollReactor {
+ private:
+  static constexpr int default_max_events{256};
+  static constexpr size_t default_read_chunk_size{16 * 1024};
+  // How often connections paused by the process-wide output limit retry,
+  // and the longest interval between checks for slow readers
+  static constexpr std::chrono::milliseconds paused_retry_interval{10};
+  static constexpr std::chrono::milliseconds slow_reader_check_interval{1000};
+
+  struct Connection {
+    SocketWrapper socket;
+    ConnectionProtocol protocol;
+    Connection_Flow flow;
+    // Input may be waiting: the last read did not end with EAGAIN
+    bool input_ready{false};
+    bool in_paused_list{false};
+  };
+
+  SOCKET listen_socket_;
+  int max_events_;
+
+  Reactor_Status reactor_status_;
+  std::atomic<bool> stop_requested_;
+
+  // epoll and eventfd descriptors are plain file descriptors on Linux, so the
+  // socket RAII wrapper closes them just as well.
+  SocketWrapper epoll_fd_;
+  SocketWrapper wakeup_fd_;
+
+  std::unordered_map<SOCKET, Connection> connections_;
+  std::vector<char> read_chunk_;
+  // Paused with no output of their own left to send, so no EPOLLOUT edge
+  // will resume them
+  std::vector<SOCKET> paused_connections_;
+  std::chrono::steady_clock::time_point next_slow_reader_check_;
+
+  bool register_descriptor(SOCKET descriptor, uint32_t events);
+  void accept_pending_connections();
+  void handle_connection_event(SOCKET client_socket, uint32_t events);
+  // Reads and sends until the input is drained or paused; false when the
+  // connection failed.
+  bool serve_connection(SOCKET client_socket, Connection &connection);
+  bool read_until_would_block(Connection &connection);
+  bool flush_send_buffer(Connection &connection);
+  void close_connection(SOCKET client_socket);
+  [[nodiscard]] int get_wait_timeout() const;
+  void resume_paused_connections();
+  void close_slow_readers();
+
+ public:
+  explicit EpollReactor(SOCKET listen_socket_val,
+                        size_t read_chunk_size_val = default_read_chunk_size,
+                        int max_events_val = default_max_events);
+
+  ~EpollReactor() = default;
+
+  EpollReactor(const EpollReactor &source) = delete;
+  EpollReactor &operator=(const EpollReactor &other) = delete;
+
+  EpollReactor(EpollReactor &&source) noexcept = delete;
+  EpollReactor &operator=(EpollReactor &&other) noexcept = delete;
+
+  // Blocks the calling thread until request_stop() is called or an
+  // unrecoverable epoll error occurs.
+  bool run();
+  // Safe to call from any thread.
+  void request_stop();
+
+  [[nodiscard]] Reactor_Status get_reactor_status() const;
+  [[nodiscard]] size_t get_connection_count() const;
+};
+
+}  // namespace WindowsSocketApp
+
+#endif  // EPOLLREACTOR_H
@@ -0,0 +1,103 @@
+#ifndef FLOWCONTROL_H
+#define FLOWCONTROL_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+
+#include "ConnectionProtocol.h"
+
+namespace WindowsSocketApp {
+
+struct Flow_Control_Limits {
+  // Replies produced for one connection and not yet sent. The event-driven
+  // engines stop reading from a connection above either limit and resume
+  // once its client has read enough of them.
+  size_t max_connection_output_bytes{1024 * 1024};
+  size_t max_connection_pending_replies{256};
+  // Replies not yet sent, summed over every connection of the process
+  size_t max_total_output_bytes{256 * 1024 * 1024};
+  // Largest legacy message a session receiving into a buffer accepts, and
+  // largest batch request payload, which is always kept whole
+  size_t max_buffered_message_bytes{64 * 1024 * 1024};
+  // Messages in one batch request, which bounds the size of its reply
+  size_t max_batch_messages{65536};
+  // Accepted sessions waiting for a worker of the pool; the accept loop
+  // pauses while the queue is full.
+  size_t max_pending_sessions{1024};
+  // A connection whose replies wait this long without any of their bytes
+  // being sent is closed; 0 waits forever.
+  std::chrono::milliseconds slow_reader_timeout{30000};
+};
+
+// Process-wide flow control: the limits and the output waiting to be sent
+// over all connections. The limits are meant to be set before serving.
+class FlowControl {
+ private:
+  Flow_Control_Limits limits_;
+  std::atomic<size_t> total_output_bytes_;
+
+  FlowControl();
+
+  friend FlowControl &get_flow_control();
+  friend class Connection_Flow;
+
+ public:
+  ~FlowControl() = default;
+
+  FlowControl(const FlowControl &source) = delete;
+  FlowControl &operator=(const FlowControl &other) = delete;
+
+  FlowControl(FlowControl &&source) noexcept = delete;
+  FlowControl &operator=(FlowControl &&other) noexcept = delete;
+
+  [[nodiscard]] const Flow_Control_Limits &get_limits() const;
+  void set_limits(const Flow_Control_Limits &limits);
+  [[nodiscard]] size_t get_total_output_bytes() const;
+  [[nodiscard]] bool total_output_over_limit() const;
+};
+
+FlowControl &get_flow_control();
+
+// Flow control of one connection of an event-driven engine: keeps the
+// connection's unsent replies counted in the process-wide total, and notes
+// when they last made progress to tell slow readers apart. A reply burst
+// read from one chunk of input may overshoot the limits by that chunk.
+class Connection_Flow {
+ private:
+  size_t counted_output_bytes_;
+  std::chrono::steady_clock::time_point last_progress_;
+  bool read_paused_;
+
+ public:
+  Connection_Flow();
+
+  // Takes the connection's output out of the total
+  ~Connection_Flow();
+
+  Connection_Flow(const Connection_Flow &source) = delete;
+  Connection_Flow &operator=(const Connection_Flow &other) = delete;
+
+  Connection_Flow(Connection_Flow &&source) noexcept;
+  Connection_Flow &operator=(Connection_Flow &&other) noexcept;
+
+  // To be called whenever the protocol produced or sent output; sent tells
+  // that some of it went out.
+  void update(const ConnectionProtocol &protocol, bool sent);
+  // Whether more input may be read: the connection and the process are
+  // within their limits.
+  [[nodiscard]] bool may_read(const ConnectionProtocol &protocol) const;
+  // Replies are waiting and none of their bytes went out for the
+  // slow-reader timeout.
+  [[nodiscard]] bool is_slow_reader(
+      const ConnectionProtocol &protocol,
+      std::chrono::steady_clock::time_point now) const;
+
+  [[nodiscard]] bool is_read_paused() const;
+  // Counted in the server metrics when reading stops
+  void set_read_paused(bool read_paused);
+};
+
+}  // namespace WindowsSocketApp
+
+#endif  // FLOWCONTROL_H
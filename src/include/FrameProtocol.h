@@ -0,0 +1,222 @@
+#ifndef FRAMEPROTOCOL_H
+#define FRAMEPROTOCOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace WindowsSocketApp {
+
+// Framed wire protocol. Every message travels as a 16-byte header followed
+// by its payload, so any number of requests and responses can share one
+// long-lived connection instead of one connection per message. All header
+// fields are in network byte order:
+//   offset  0  magic           F5 46 52 31 ("\xF5" "FR1")
+//   offset  4  payload length  uint32
+//   offset  8  message type    uint16, Frame_Type
+//   offset 10  flags           uint16, frame_flag_* bits
+//   offset 12  request id      uint32, echoed in the response
+// 0xF5 never occurs in UTF-8 text, so the server tells a framed client from a
+// legacy one (plain message ended by shutdown) by the first byte it receives.
+inline constexpr uint32_t frame_magic{0xF5465231};
+inline constexpr size_t frame_header_size{16};
+// The most the payload length field can describe; a larger payload cannot
+// travel as one frame.
+inline constexpr size_t max_frame_payload_size{0xFFFFFFFFU};
+
+// Request: answer with the binary analytics encoding (AnalyticsEncoding.h)
+// instead of text. Response: the payload uses the binary encoding.
+inline constexpr uint16_t frame_flag_binary_analytics{0x0001};
+// Request: the payload is a batch of messages, each to be analyzed on its
+// own. Response: the payload holds one analytics record per message, in the
+// order of the request. Batch payloads, in network byte order:
+//   request   uint32 count, then per message: uint32 length, its bytes
+//   response  uint32 count, then per message: the binary encoding when
+//             frame_flag_binary_analytics is set, otherwise uint32 length
+//             and the text
+// Many small messages then cost one frame and one round trip instead of one
+// each.
+inline constexpr uint16_t frame_flag_batch{0x0002};
+inline constexpr size_t batch_count_size{4};
+inline constexpr size_t batch_length_size{4};
+// Request: answer with the server-wide analytics of every message analyzed
+// so far (Aggregate_Analytics of MessageAnalytics.h, encoded as in
+// AnalyticsEncoding.h) instead of analyzing the payload, which is ignored;
+// the batch and counters flags are ignored too. Response: the payload is the
+// aggregate.
+inline constexpr uint16_t frame_flag_aggregate{0x0004};
+// Request: bits 8-14 pick the counter groups to compute (analytics_* bits of
+// AnalyticsPipeline.h, shifted left by 8), with the reply in the pipeline
+// encoding of AnalyticsEncoding.h. Zero asks for the character classes in
+// the plain encoding. Response: the counters the payload holds.
+inline constexpr uint16_t frame_flags_counters{0x7F00};
+inline constexpr unsigned frame_counters_shift{8};
+
+[[nodiscard]] inline constexpr uint16_t get_frame_counters(uint16_t flags) {
+  return static_cast<uint16_t>((flags & frame_flags_counters) >>
+                               frame_counters_shift);
+}
+
+[[nodiscard]] inline constexpr uint16_t make_frame_counters_flags(
+    uint16_t counters) {
+  return static_cast<uint16_t>((counters << frame_counters_shift) &
+                               frame_flags_counters);
+}
+
+enum class Frame_Type : uint16_t {
+  REQUEST = 1,       // payload: message (or batch) to analyze
+  RESPONSE = 2,      // payload: analytics of the request with the same id
+  ERROR_MESSAGE = 3  // payload: reason; the server then closes the connection
+};
+
+// How a client talks to the server, decided by its first byte.
+enum class Wire_Format { UNKNOWN, LEGACY, FRAMED };
+
+struct Frame_Header {
+  uint32_t payload_length{0};
+  Frame_Type type{Frame_Type::REQUEST};
+  uint16_t flags{0};
+  uint32_t request_id{0};
+};
+
+enum class Frame_Decode_Status { OK, BAD_MAGIC, BAD_TYPE };
+
+[[nodiscard]] inline bool is_frame_start(char first_byte) {
+  return static_cast<unsigned char>(first_byte) == (frame_magic >> 24U);
+}
+
+// Network byte order fields of headers and batch payloads
+inline void put_u16(char *target, uint16_t value) {
+  target[0] = static_cast<char>(value >> 8U);
+  target[1] = static_cast<char>(value);
+}
+
+inline void put_u32(char *target, uint32_t value) {
+  put_u16(target, static_cast<uint16_t>(value >> 16U));
+  put_u16(target + 2, static_cast<uint16_t>(value));
+}
+
+[[nodiscard]] inline uint16_t get_u16(const char *source) {
+  return static_cast<uint16_t>(
+      (static_cast<unsigned>(static_cast<unsigned char>(source[0])) << 8U) |
+      static_cast<unsigned char>(source[1]));
+}
+
+[[nodiscard]] inline uint32_t get_u32(const char *source) {
+  return (static_cast<uint32_t>(get_u16(source)) << 16U) |
+         get_u16(source + 2);
+}
+
+inline void encode_frame_header(const Frame_Header &header, char *output) {
+  put_u32(output, frame_magic);
+  put_u32(output + 4, header.payload_length);
+  put_u16(output + 8, static_cast<uint16_t>(header.type));
+  put_u16(output + 10, header.flags);
+  put_u32(output + 12, header.request_id);
+}
+
+// input must hold frame_header_size bytes. header is filled in even when the
+// type is unknown, so an error reply can still carry the request id.
+inline Frame_Decode_Status decode_frame_header(const char *input,
+                                               Frame_Header &header) {
+  if (get_u32(input) != frame_magic) {
+    return Frame_Decode_Status::BAD_MAGIC;
+  }
+  header.payload_length = get_u32(input + 4);
+  header.type = static_cast<Frame_Type>(get_u16(input + 8));
+  header.flags = get_u16(input + 10);
+  header.request_id = get_u32(input + 12);
+  switch (header.type) {
+    case Frame_Type::REQUEST:
+    case Frame_Type::RESPONSE:
+    case Frame_Type::ERROR_MESSAGE:
+      return Frame_Decode_Status::OK;
+  }
+  return Frame_Decode_Status::BAD_TYPE;
+}
+
+// Appends a complete frame (header and payload) to output. Once output has
+// grown to its working size this does not allocate. Returns false, leaving
+// output as it was, when the payload is over max_frame_payload_size.
+inline bool append_frame(std::string &output, Frame_Type type,
+                         uint32_t request_id, const char *payload,
+                         size_t payload_size, uint16_t flags = 0) {
+  if (payload_size > max_frame_payload_size) {
+    return false;
+  }
+  Frame_Header header;
+  header.payload_length = static_cast<uint32_t>(payload_size);
+  header.type = type;
+  header.flags = flags;
+  header.request_id = request_id;
+
+  char encoded_header[frame_header_size];
+  encode_frame_header(header, encoded_header);
+  output.append(encoded_header, frame_header_size);
+  output.append(payload, payload_size);
+  return true;
+}
+
+inline bool append_frame(std::string &output, Frame_Type type,
+                         uint32_t request_id, const std::string &payload,
+                         uint16_t flags = 0) {
+  return append_frame(output, type, request_id, payload.data(),
+                      payload.size(), flags);
+}
+
+// Replaces payload by an empty batch request payload
+inline void begin_batch_payload(std::string &payload) {
+  payload.assign(batch_count_size, '\0');
+}
+
+// Appends one message to a batch request payload and counts it
+inline void append_batch_message(std::string &payload, const char *message,
+                                 size_t message_size) {
+  char encoded_length[batch_length_size];
+  put_u32(encoded_length, static_cast<uint32_t>(message_size));
+  payload.append(encoded_length, batch_length_size);
+  payload.append(message, message_size);
+  put_u32(payload.data(), get_u32(payload.data()) + 1);
+}
+
+// Calls visit(data, size) for each message of a batch request payload, in
+// order. Returns false, before visiting anything, when the payload is
+// malformed: too short, or its lengths do not add up to its size.
+template <typename Visitor>
+bool for_each_batch_message(const char *payload, size_t payload_size,
+                            Visitor &&visit) {
+  if (payload_size < batch_count_size) {
+    return false;
+  }
+  const uint32_t count = get_u32(payload);
+  const char *const end = payload + payload_size;
+  // Validated in a first pass, so the caller may reply as it visits
+  const char *position = payload + batch_count_size;
+  for (uint32_t i = 0; i < count; ++i) {
+    if (static_cast<size_t>(end - position) < batch_length_size) {
+      return false;
+    }
+    const uint32_t length = get_u32(position);
+    position += batch_length_size;
+    if (static_cast<size_t>(end - position) < length) {
+      return false;
+    }
+    position += length;
+  }
+  if (position != end) {
+    return false;
+  }
+
+  position = payload + batch_count_size;
+  for (uint32_t i = 0; i < count; ++i) {
+    const uint32_t length = get_u32(position);
+    position += batch_length_size;
+    visit(position, static_cast<size_t>(length));
+    position += length;
+  }
+  return true;
+}
+
+}  // namespace WindowsSocketApp
+
+#endif  // FRAMEPROTOCOL_H
@@ -0,0 +1,191 @@
+#ifndef IOURINGENGINE_H
+#define IOURINGENGINE_H
+
+#include <linux/io_uring.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ConnectionProtocol.h"
+#include "FlowControl.h"
+#include "NetworkTypes.h"
+#include "SocketWrapper.h"
+
+namespace WindowsSocketApp {
+
+// io_uring based server loop (Linux 6.0+), driven through the raw system
+// calls so no extra library is needed.
+//   - one multishot accept keeps the listener armed for every new client;
+//   - every connection has one multishot recv that picks its buffers from a
+//     ring of provided buffers registered with the kernel up front;
+//   - accepts, receives and sends of all connections are submitted and reaped
+//     in batches, one io_uring_enter per loop iteration.
+// initialize() fails on kernels without these features so the caller can fall
+// back to the epoll or blocking modes.
+// Like EpollReactor, reading pauses while a connection's unsent replies are
+// over the FlowControl limits (its multishot recv is cancelled and armed again
+// once they drained) and connections whose client stopped reading are closed.
+// Data the kernel delivers before the cancel takes effect is held unprocessed
+// until the connection resumes, so it costs its own size and no replies.
+class IoUringEngine {
+ private:
+  static constexpr unsigned default_queue_depth{1024};
+  static constexpr unsigned default_buffer_count{1024};
+  static constexpr unsigned default_buffer_size{16 * 1024};
+  static constexpr uint16_t provided_buffer_group{0};
+  // See EpollReactor
+  static constexpr std::chrono::milliseconds paused_retry_interval{10};
+  static constexpr std::chrono::milliseconds slow_reader_check_interval{1000};
+
+  // Memory shared with the kernel, unmapped on destruction.
+  class MappedRegion {
+   private:
+    void *address_;
+    size_t length_;
+
+   public:
+    MappedRegion() : address_{nullptr}, length_{0} {}
+    MappedRegion(void *address_val, size_t length_val)
+        : address_{address_val}, length_{length_val} {}
+    ~MappedRegion();
+
+    MappedRegion(MappedRegion &&source) noexcept;
+    MappedRegion &operator=(MappedRegion &&rhs) noexcept;
+
+    MappedRegion(const MappedRegion &source) = delete;
+    MappedRegion &operator=(const MappedRegion &rhs) = delete;
+
+    [[nodiscard]] char *get() const { return static_cast<char *>(address_); }
+    [[nodiscard]] bool valid() const { return address_ != nullptr; }
+  };
+
+  struct Connection {
+    SocketWrapper socket;
+    ConnectionProtocol protocol;
+    // The connection is released only once the kernel holds no more
+    // requests that reference it.
+    unsigned operations_in_flight{0};
+    // At most one send per connection, so replies leave in order
+    bool send_in_flight{false};
+    bool receive_armed{false};
+    bool in_paused_list{false};
+    bool closing{false};
+    Connection_Flow flow;
+    // Input received while paused, from held_input_offset on, and whether
+    // the end of input followed it
+    std::string held_input;
+    size_t held_input_offset{0};
+    bool held_end_of_input{false};
+    // Submission time of the send in flight, for the SEND stage metric
+    std::chrono::steady_clock::time_point send_started;
+  };
+
+  SOCKET listen_socket_;
+  unsigned queue_depth_;
+  unsigned buffer_count_;
+  unsigned buffer_size_;
+
+  Reactor_Status reactor_status_;
+  std::atomic<bool> stop_requested_;
+
+  SocketWrapper ring_fd_;
+  SocketWrapper wakeup_fd_;
+  uint64_t wakeup_value_;
+
+  MappedRegion sq_ring_;
+  MappedRegion cq_ring_;
+  MappedRegion sqes_;
+  MappedRegion buffer_ring_;
+  std::vector<char> buffer_storage_;
+
+  // Views into the rings shared with the kernel
+  unsigned *sq_head_;
+  unsigned *sq_tail_;
+  unsigned sq_mask_;
+  unsigned *sq_array_;
+  io_uring_sqe *sqe_entries_;
+  unsigned *cq_head_;
+  unsigned *cq_tail_;
+  unsigned cq_mask_;
+  io_uring_cqe *cqe_entries_;
+  io_uring_buf_ring *provided_buffers_;
+  uint16_t provided_buffers_tail_;
+
+  unsigned sq_local_tail_;
+  uint64_t next_connection_id_;
+  std::unordered_map<uint64_t, Connection> connections_;
+
+  // Paused with no output of their own left to send, so no send completion
+  // will resume them; retried on the timer
+  std::vector<uint64_t> paused_connections_;
+  __kernel_timespec timer_interval_;
+  bool timer_armed_;
+  std::chrono::steady_clock::time_point next_slow_reader_check_;
+
+  bool map_rings(const io_uring_params &params);
+  bool register_provided_buffers();
+  void recycle_provided_buffer(uint16_t buffer_id);
+
+  io_uring_sqe *next_submission_entry();
+  bool submit_pending(unsigned wait_for_completions);
+
+  void arm_accept();
+  void arm_wakeup();
+  // False when the submission queue is full; the caller then closes the
+  // connection, after which it must not touch it again.
+  bool arm_receive(uint64_t connection_id, Connection &connection);
+  bool arm_send(uint64_t connection_id, Connection &connection);
+  void arm_timer(std::chrono::milliseconds interval);
+  void cancel_receive(uint64_t connection_id);
+  void flush_output(uint64_t connection_id, Connection &connection);
+  void pause_receive(uint64_t connection_id, Connection &connection);
+  // False when the connection was closed, after which it must not be
+  // touched again.
+  bool resume_receive(uint64_t connection_id, Connection &connection);
+  // Processes held input while the limits allow; true when none is left.
+  bool process_held_input(Connection &connection);
+  [[nodiscard]] std::chrono::milliseconds get_timer_interval() const;
+  void resume_paused_connections();
+  void close_slow_readers();
+
+  void process_completions();
+  void handle_accept(int result, uint32_t flags);
+  void handle_receive(uint64_t connection_id, int result, uint32_t flags);
+  void handle_send(uint64_t connection_id, int result);
+  void close_connection(uint64_t connection_id, Connection &connection);
+  void release_if_idle(uint64_t connection_id);
+
+ public:
+  explicit IoUringEngine(SOCKET listen_socket_val,
+                         unsigned queue_depth_val = default_queue_depth,
+                         unsigned buffer_count_val = default_buffer_count,
+                         unsigned buffer_size_val = default_buffer_size);
+
+  ~IoUringEngine() = default;
+
+  IoUringEngine(const IoUringEngine &source) = delete;
+  IoUringEngine &operator=(const IoUringEngine &other) = delete;
+
+  IoUringEngine(IoUringEngine &&source) noexcept = delete;
+  IoUringEngine &operator=(IoUringEngine &&other) noexcept = delete;
+
+  // Sets up the rings and registers the receive buffers. Returns false when
+  // the kernel lacks io_uring or the multishot operations used here.
+  bool initialize();
+  // Blocks the calling thread until request_stop() is called or the ring
+  // fails.
+  bool run();
+  // Safe to call from any thread.
+  void request_stop();
+
+  [[nodiscard]] Reactor_Status get_reactor_status() const;
+  [[nodiscard]] size_t get_connection_count() const;
+};
+
+}  // namespace WindowsSocketApp
+
+#endif  // IOURINGENGINE_H
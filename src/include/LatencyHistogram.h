@@ -0,0 +1,110 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace WindowsSocketApp {
+
+// Log-linear bucketing shared by the latency histograms: values below
+// 2^(precision_bits + 1) get a bucket each, and every power-of-two range
+// above is split into 2^precision_bits linear sub-buckets, keeping a value's
+// top precision_bits + 1 bits.
+template <unsigned precision_bits>
+struct Log_Linear_Buckets {
+  static constexpr uint64_t sub_bucket_count{uint64_t{1} << precision_bits};
+  static constexpr uint64_t linear_range{sub_bucket_count * 2};
+
+  static constexpr size_t index_for(uint64_t value) {
+    unsigned shift{0};
+    while ((value >> shift) >= linear_range) {
+      ++shift;
+    }
+    return static_cast<size_t>(shift * sub_bucket_count + (value >> shift));
+  }
+
+  // Largest value that falls into the bucket at index
+  static constexpr uint64_t highest_value_at(size_t index) {
+    if (index < linear_range) {
+      return index;
+    }
+    const uint64_t shift = index / sub_bucket_count - 1;
+    const uint64_t sub_bucket = index - shift * sub_bucket_count;
+    return ((sub_bucket + 1) << shift) - 1;
+  }
+};
+
+// Index of the bucket holding the value of rank ceil(percentile% of
+// total_count), at least the first value; bucket_count when the counts hold
+// fewer than total_count values.
+inline size_t find_percentile_bucket(const uint64_t *counts,
+                                     size_t bucket_count,
+                                     uint64_t total_count,
+                                     double percentile) {
+  percentile = std::clamp(percentile, 0.0, 100.0);
+  const auto wanted_count = std::max<uint64_t>(
+      static_cast<uint64_t>(std::ceil(percentile / 100.0 *
+                                      static_cast<double>(total_count))),
+      1);
+  uint64_t cumulative_count{0};
+  for (size_t i = 0; i < bucket_count; ++i) {
+    cumulative_count += counts[i];
+    if (cumulative_count >= wanted_count) {
+      return i;
+    }
+  }
+  return bucket_count;
+}
+
+// HDR-style histogram of latencies in nanoseconds. Every power-of-two range
+// is split into the same number of linear sub-buckets, so any recorded value
+// is reported within 0.1% of itself whether it is 2 microseconds or 2
+// seconds, in a fixed ~280 KiB of counters. Recording is a couple of shifts
+// and an increment; a histogram belongs to one thread and the per-thread
+// histograms are merged for the report.
+class LatencyHistogram {
+ public:
+  // 2^precision_bits sub-buckets per power of two: 1/1024 relative error
+  static constexpr unsigned precision_bits{10};
+  // Larger values (about 2.4 hours) are clamped to this
+  static constexpr uint64_t highest_trackable_value{(uint64_t{1} << 43U) - 1};
+
+ private:
+  using Buckets = Log_Linear_Buckets<precision_bits>;
+
+  std::vector<uint64_t> counts_;
+  uint64_t total_count_;
+  uint64_t minimum_value_;
+  uint64_t maximum_value_;
+  long double value_sum_;
+
+ public:
+  LatencyHistogram();
+
+  ~LatencyHistogram() = default;
+
+  LatencyHistogram(const LatencyHistogram &source) = default;
+  LatencyHistogram &operator=(const LatencyHistogram &other) = default;
+
+  LatencyHistogram(LatencyHistogram &&source) noexcept = default;
+  LatencyHistogram &operator=(LatencyHistogram &&other) noexcept = default;
+
+  void record(uint64_t value);
+  void merge(const LatencyHistogram &other);
+  void reset();
+
+  // Smallest recorded value v such that percentile% of the values are <= v
+  // (to within the histogram precision). 0 when nothing was recorded.
+  [[nodiscard]] uint64_t get_value_at_percentile(double percentile) const;
+  [[nodiscard]] uint64_t get_total_count() const;
+  [[nodiscard]] uint64_t get_minimum_value() const;
+  [[nodiscard]] uint64_t get_maximum_value() const;
+  [[nodiscard]] double get_mean_value() const;
+};
+
+}  // namespace WindowsSocketApp
+
+#endif  // LATENCYHISTOGRAM_H
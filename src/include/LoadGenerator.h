@@ -0,0 +1,107 @@
+#ifndef LOADGENERATOR_H
+#define LOADGENERATOR_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Client.h"
+#include "LatencyHistogram.h"
+
+namespace WindowsSocketApp {
+
+// CLOSED_LOOP: every connection sends its next request as soon as the
+// previous response arrived, so the server sets the pace.
+// OPEN_LOOP: requests are due at a fixed total rate whatever the server
+// does. A request that could not go out on time is sent as soon as possible
+// and its latency is measured from when it was due, so a stalled server
+// shows up in the tail latencies instead of silently lowering the rate.
+enum class Load_Mode { CLOSED_LOOP, OPEN_LOOP };
+
+enum class Message_Size_Distribution { FIXED, UNIFORM, EXPONENTIAL };
+
+// Parsed from "fixed:N", "uniform:MIN:MAX" or "exponential:MEAN[:MAX]".
+struct Message_Size_Spec {
+  Message_Size_Distribution distribution{Message_Size_Distribution::FIXED};
+  size_t minimum_size{64};
+  size_t maximum_size{64};
+  size_t mean_size{64};
+
+  static bool parse(const std::string &text, Message_Size_Spec &spec);
+};
+
+struct Load_Generator_Config {
+  std::string server_ip{"localhost"};
+  std::string port{"27015"};
+  size_t thread_count{1};
+  size_t connection_count{1};
+  std::chrono::milliseconds duration{std::chrono::seconds{10}};
+  Load_Mode mode{Load_Mode::CLOSED_LOOP};
+  // OPEN_LOOP: requests per second over all connections
+  double request_rate{0};
+  Message_Size_Spec message_sizes;
+  // Binary responses are checked against the length of the request
+  bool binary_analytics{true};
+};
+
+struct Load_Report {
+  uint64_t completed_requests{0};
+  uint64_t request_bytes{0};
+  // Responses whose analytics do not match the request
+  uint64_t mismatched_responses{0};
+  // Connections that could not be opened or broke during the run
+  uint64_t failed_connections{0};
+  std::chrono::nanoseconds elapsed{0};
+  LatencyHistogram latencies;
+};
+
+// Headless load generator for capacity planning and regression checks.
+// Opens connection_count framed connections with Client, spreads them over
+// thread_count threads and keeps them busy for the configured duration;
+// each thread records into its own histogram, merged into the report.
+// Each connection has at most one request outstanding.
+class LoadGenerator {
+ private:
+  struct Connection {
+    Client client;
+    // OPEN_LOOP: when the next request on this connection is due
+    std::chrono::steady_clock::time_point next_request_due;
+  };
+
+  Load_Generator_Config config_;
+  // Random text; a request of size n sends the first n bytes
+  std::string message_text_;
+
+  void run_closed_loop(std::vector<Connection> &connections,
+                       std::chrono::steady_clock::time_point deadline,
+                       size_t thread_index, Load_Report &report) const;
+  void run_open_loop(std::vector<Connection> &connections,
+                     std::chrono::steady_clock::time_point deadline,
+                     size_t thread_index, Load_Report &report) const;
+  bool send_request(Connection &connection, size_t message_size) const;
+  // Waits for the response and records its latency
+  bool complete_request(Connection &connection, size_t message_size,
+                        std::chrono::steady_clock::time_point started,
+                        Load_Report &report) const;
+
+ public:
+  explicit LoadGenerator(Load_Generator_Config config_val);
+
+  ~LoadGenerator() = default;
+
+  LoadGenerator(const LoadGenerator &source) = delete;
+  LoadGenerator &operator=(const LoadGenerator &other) = delete;
+
+  LoadGenerator(LoadGenerator &&source) noexcept = default;
+  LoadGenerator &operator=(LoadGenerator &&other) noexcept = default;
+
+  // Blocks for the configured duration plus connection set-up.
+  Load_Report run();
+
+  [[nodiscard]] const Load_Generator_Config &get_config() const;
+};
+
+}  // namespace WindowsSocketApp
+
+#endif  // LOADGENERATOR_H
@@ -0,0 +1,117 @@
+#ifndef MESSAGEANALYTICS_H
+#define MESSAGEANALYTICS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace WindowsSocketApp {
+
+// Character statistics reported back to the client for every message.
+struct MessageAnalytics {
+  size_t length{0};
+  size_t punctuation_marks_count{0};
+  size_t spaces_count{0};
+  size_t digits_count{0};
+  size_t uppercase_count{0};
+  size_t lowercase_count{0};
+  size_t vowels_count{0};
+  size_t consonants_count{0};
+};
+
+// The counters of MessageAnalytics in declaration order, with their names,
+// for code that treats all of them alike.
+struct Message_Analytics_Counter {
+  const char *name;
+  size_t MessageAnalytics::*counter;
+};
+
+inline constexpr std::array<Message_Analytics_Counter, 8>
+    message_analytics_counters{{
+        {"length", &MessageAnalytics::length},
+        {"punctuation marks", &MessageAnalytics::punctuation_marks_count},
+        {"spaces", &MessageAnalytics::spaces_count},
+        {"digits", &MessageAnalytics::digits_count},
+        {"uppercase letters", &MessageAnalytics::uppercase_count},
+        {"lowercase letters", &MessageAnalytics::lowercase_count},
+        {"vowels", &MessageAnalytics::vowels_count},
+        {"consonants", &MessageAnalytics::consonants_count},
+    }};
+
+// Incremental form of calculate_message_analytics(): a message can be fed in
+// chunks of any size and the result equals the analytics of the whole message,
+// so arbitrarily large messages are analyzed without being kept in memory.
+// A single update() of parallel_analytics_threshold bytes or more is counted
+// on all cores (ParallelAnalytics.h).
+class MessageAnalyzer {
+ private:
+  MessageAnalytics analytics_;
+
+ public:
+  MessageAnalyzer() = default;
+
+  void update(const char *data, size_t size);
+  void reset();
+
+  [[nodiscard]] const MessageAnalytics &get_analytics() const;
+};
+
+MessageAnalytics calculate_message_analytics(const char *data, size_t size);
+
+// Message sizes are counted in powers of two: bucket 0 holds the empty
+// messages and bucket i those of 2^(i-1) to 2^i - 1 bytes, the last bucket
+// every larger message as well.
+inline constexpr size_t message_size_bucket_count{34};
+
+[[nodiscard]] inline size_t get_message_size_bucket(uint64_t size) {
+#if defined(_MSC_VER) && !defined(__clang__)
+  size_t bucket{0};
+  while (size != 0 && bucket + 1 < message_size_bucket_count) {
+    size >>= 1U;
+    ++bucket;
+  }
+  return bucket;
+#else
+  // The number of significant bits of size
+  const size_t bucket =
+      size == 0 ? 0 : 64 - static_cast<size_t>(__builtin_clzll(size));
+  return bucket < message_size_bucket_count ? bucket
+                                            : message_size_bucket_count - 1;
+#endif
+}
+
+// The sizes a bucket holds, in bytes: "0", "1", "2-3", ..., and "N+" for the
+// last bucket.
+[[nodiscard]] inline std::string get_message_size_bucket_label(size_t bucket) {
+  if (bucket < 2) {
+    return std::to_string(bucket);
+  }
+  std::string label{std::to_string(uint64_t{1} << (bucket - 1))};
+  if (bucket + 1 == message_size_bucket_count) {
+    label.push_back('+');
+    return label;
+  }
+  label.push_back('-');
+  label.append(std::to_string((uint64_t{1} << bucket) - 1));
+  return label;
+}
+
+// Running totals of the analytics of every message a server analyzed, over
+// all its connections. The character classes are summed over the messages
+// whose reply computed them: all of them but those that picked counter
+// groups without the classes.
+struct Aggregate_Analytics {
+  uint64_t messages_count{0};
+  uint64_t classified_messages_count{0};
+  MessageAnalytics classes;
+  std::array<uint64_t, message_size_bucket_count> message_sizes{};
+};
+
+// Human-readable form sent to the client, e.g.
+// "Received message analytics: Length: 12, punctuation marks count: 1, ..."
+std::string format_message_analytics(const MessageAnalytics &analytics);
+
+}  // namespace WindowsSocketApp
+
+#endif  // MESSAGEANALYTICS_H
@@ -1,14 +1,16 @@
 #ifndef NETWORKTYPES_H
 #define NETWORKTYPES_H
 
-#include <winsock2.h>
-#include <ws2tcpip.h>
+#include "SocketPlatform.h"
 
 #include <memory>
 
 namespace WindowsSocketApp {
 enum class Sockaddr_Struct_State { EMPTY, CREATED };
 
+// Lifecycle of the event-driven server engines.
+enum class Reactor_Status { NOT_STARTED, RUNNING, STOPPED, FAILED };
+
 struct AddrInfoDeleter {
   void operator()(addrinfo *addrinfo_ptr) const {
     if (addrinfo_ptr != nullptr) {
@@ -0,0 +1,37 @@
+#ifndef PARALLELANALYTICS_H
+#define PARALLELANALYTICS_H
+
+#include <cstddef>
+
+#include "MessageAnalytics.h"
+#include "WorkStealingPool.h"
+
+namespace WindowsSocketApp {
+
+// Messages at least this large are analyzed on all cores; below it waking
+// the pool costs more than it saves. The size is that of one
+// MessageAnalyzer::update() call, not of the whole message. Only a message
+// handed over whole reaches it: the buffered sessions of the single and pool
+// modes (ClientSession without --stream) and the messages of a batch
+// request, which is kept whole in every mode. The streaming, epoll,
+// io_uring and sharded paths feed receive chunks of at most 64 KiB and stay
+// serial, so their memory use does not depend on the message size.
+inline constexpr size_t parallel_analytics_threshold{1024 * 1024};
+// Chunks small enough to stay in a core's L2 cache while being counted.
+inline constexpr size_t parallel_analytics_chunk_size{256 * 1024};
+
+// Adds the analytics of data[0, size) to analytics. The buffer is split into
+// chunk_size pieces that are counted on pool and the per-chunk counters are
+// summed; the result is identical to a serial pass.
+void accumulate_message_analytics_parallel(
+    const char *data, size_t size, MessageAnalytics &analytics,
+    WorkStealingPool &pool,
+    size_t chunk_size = parallel_analytics_chunk_size);
+
+// Process-wide pool used by MessageAnalyzer for large messages, created on
+// first use with one worker per additional hardware thread.
+WorkStealingPool &get_analytics_pool();
+
+}  // namespace WindowsSocketApp
+
+#endif  // PARALLELANALYTICS_H
@@ -0,0 +1,63 @@
+#ifndef REACTORSHARDS_H
+#define REACTORSHARDS_H
+
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "EpollReactor.h"
+#include "SocketWrapper.h"
+
+namespace WindowsSocketApp {
+
+// One EpollReactor per shard, each on a thread of its own with its own
+// SO_REUSEPORT listener on the same port (Linux only). The kernel spreads
+// new connections over the listeners, and a connection stays on the shard
+// that accepted it, so shards share no listener, accept queue, connection
+// table or event loop. Optionally every shard thread is pinned to one of the
+// CPUs the process may run on, in order. Each reactor is created by its own
+// thread after pinning, so its buffers are first touched on that CPU's node.
+class ReactorShards {
+ private:
+  struct Shard {
+    SocketWrapper listen_socket;
+    // Set by the shard thread; guarded by reactors_mutex_
+    std::unique_ptr<EpollReactor> reactor;
+    bool succeeded{true};
+  };
+
+  std::vector<Shard> shards_;
+  size_t read_chunk_size_;
+  bool pin_to_cpu_;
+  std::mutex reactors_mutex_;
+  // Stops the reactors that are created after request_stop()
+  bool stop_requested_;
+
+  void run_shard(size_t shard_index, int cpu);
+
+ public:
+  // One shard per listener; every listener must be bound to the same port
+  // with SO_REUSEPORT.
+  ReactorShards(std::vector<SocketWrapper> listen_sockets_val,
+                size_t read_chunk_size_val, bool pin_to_cpu_val);
+
+  ~ReactorShards() = default;
+
+  ReactorShards(const ReactorShards &source) = delete;
+  ReactorShards &operator=(const ReactorShards &other) = delete;
+
+  ReactorShards(ReactorShards &&source) noexcept = delete;
+  ReactorShards &operator=(ReactorShards &&other) noexcept = delete;
+
+  // Blocks until every shard stopped; false when any of them failed.
+  bool run();
+  // Safe to call from any thread.
+  void request_stop();
+
+  [[nodiscard]] size_t get_shard_count() const;
+};
+
+}  // namespace WindowsSocketApp
+
+#endif  // REACTORSHARDS_H
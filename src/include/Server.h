@@ -5,6 +5,7 @@
 #include <string>
 #include <vector>
 
+#include "ClientSession.h"
 #include "NetworkTypes.h"
 #include "SocketWrapper.h"
 #include "WinSockFunctions.h"
@@ -38,11 +39,19 @@ class Server {
   AddrInfoPtr result_;
   addrinfo hints_;
 
+  Session_Receive_Mode receive_mode_;
+  bool echo_message_;
+  bool zero_copy_send_;
+  // Listeners bound with SO_REUSEPORT, so more of them can share the port
+  bool reuse_port_;
+
   SocketWrapper listen_socket_;
-  SocketWrapper client_socket_;
 
-  std::vector<char> recv_buffer_;
-  std::string recv_message_analytics_;
+  // Client served by the single-client API below
+  ClientSession session_;
+
+  // Bound and listening socket on the port; invalid on failure
+  SocketWrapper open_listen_socket();
 
  public:
   explicit Server(size_t recv_capacity_val = default_recv_buffer_capacity,
@@ -60,15 +69,48 @@ class Server {
   void accept_connections();
   void receive_client_message();
   void calculate_recv_message_analytics();
-  void echo_message_to_client() const;
-  void send_recv_message_analytics_to_client() const;
+  void echo_message_to_client();
+  void send_recv_message_analytics_to_client();
+  void send_echo_and_analytics_to_client();
   void shutdown_message_sending();
+  // For the connected client: whether it uses the framed protocol, and
+  // serving all of its request frames over the one connection.
+  [[nodiscard]] Wire_Format detect_client_wire_format() const;
+  void serve_framed_client();
+
+  // Keeps accepting clients and serves every connection on a fixed pool of
+  // worker threads (0 = one per hardware thread). Blocks until accept fails.
+  void serve_with_worker_pool(size_t worker_count = 0);
+
+#ifdef __linux__
+  // Serves any number of clients from the calling thread with an
+  // edge-triggered epoll loop. The listening socket stays open; the call
+  // blocks until the process is terminated or epoll fails.
+  void run_event_loop();
+  // Same as run_event_loop() but driven by io_uring with batched multishot
+  // accept/recv. Falls back to the epoll loop when io_uring is unavailable.
+  void run_io_uring_loop();
+  // One event loop per shard (0 = one per hardware thread), each with an
+  // SO_REUSEPORT listener of its own; see ReactorShards. Needs reuse port
+  // enabled before start_server(). Blocks like run_event_loop().
+  void run_sharded_event_loops(size_t shard_count = 0,
+                               bool pin_to_cpu = false);
+#endif
 
   [[nodiscard]] Server_Initialization_Status get_server_init_status() const;
   void display_recv_buffer() const;
   [[nodiscard]] size_t get_recv_buffer_capacity() const;
   [[nodiscard]] const std::string &get_port() const;
   void set_port(std::string port);
+  [[nodiscard]] Session_Receive_Mode get_receive_mode() const;
+  void set_receive_mode(Session_Receive_Mode receive_mode);
+  // Applied to the sessions accepted afterwards (see ClientSession)
+  [[nodiscard]] bool get_echo_message() const;
+  void set_echo_message(bool echo_message);
+  [[nodiscard]] bool get_zero_copy_send() const;
+  void set_zero_copy_send(bool zero_copy_send);
+  [[nodiscard]] bool get_reuse_port() const;
+  void set_reuse_port(bool reuse_port);
 };
 
 }  // namespace WindowsSocketApp
@@ -0,0 +1,214 @@
+#ifndef SERVERMETRICS_H
+#define SERVERMETRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "LatencyHistogram.h"
+#include "MessageAnalytics.h"
+
+namespace WindowsSocketApp {
+
+// Stages timed by the server. ACCEPT is the time an accepted connection
+// waits before a thread starts serving it; the others are the time spent in
+// one receive call, one analysis step and one send.
+enum class Server_Stage { ACCEPT, RECEIVE, ANALYZE, SEND };
+inline constexpr size_t server_stage_count{4};
+
+[[nodiscard]] const char *get_server_stage_name(Server_Stage stage);
+
+// Log-linear latency histogram: 8 sub-buckets per power of two (12.5%
+// precision) from 1 ns to about 18 minutes. Written by one thread only, so
+// recording needs no atomic read-modify-write; other threads may read it at
+// any time. The buckets are those of LatencyHistogram, only coarser.
+class Stage_Histogram {
+ public:
+  static constexpr unsigned precision_bits{3};
+  static constexpr unsigned value_bits{40};
+  using Buckets = Log_Linear_Buckets<precision_bits>;
+  static constexpr uint64_t highest_trackable_value{
+      (uint64_t{1} << value_bits) - 1};
+  static constexpr size_t bucket_count{
+      Buckets::index_for(highest_trackable_value) + 1};
+
+ private:
+  std::array<std::atomic<uint64_t>, bucket_count> counts_;
+  std::atomic<uint64_t> total_nanoseconds_;
+
+ public:
+  Stage_Histogram();
+
+  void record(uint64_t nanoseconds);
+
+  // Adds the counts to totals (bucket_count entries) and the summed time to
+  // total_nanoseconds.
+  void add_to(uint64_t *totals, uint64_t &total_nanoseconds) const;
+};
+
+// Counters of one server thread. Only the owning thread writes them: every
+// update is a relaxed load and store of its own cache lines, never a lock or
+// a contended atomic operation. Readers merge all threads' counters lazily
+// when a report is requested.
+class Thread_Metrics {
+ public:
+  static constexpr size_t error_slot_count{32};
+
+ private:
+  struct Error_Slot {
+    std::atomic<int> code{0};
+    std::atomic<uint64_t> count{0};
+  };
+
+  alignas(64) std::atomic<uint64_t> accepts_;
+  std::atomic<uint64_t> bytes_received_;
+  std::atomic<uint64_t> bytes_sent_;
+  std::atomic<uint64_t> messages_analyzed_;
+  std::atomic<uint64_t> cache_hits_;
+  std::atomic<uint64_t> cache_misses_;
+  std::atomic<uint64_t> read_pauses_;
+  std::atomic<uint64_t> slow_readers_closed_;
+  std::atomic<uint64_t> oversized_messages_;
+  std::atomic<uint64_t> other_errors_;
+  std::array<Error_Slot, error_slot_count> errors_;
+  std::array<Stage_Histogram, server_stage_count> stage_latencies_;
+  // Server-wide analytics: the size of every message analyzed, and the
+  // character classes in the order of the MessageAnalytics fields
+  alignas(64) std::array<std::atomic<uint64_t>, message_size_bucket_count>
+      message_sizes_;
+  std::atomic<uint64_t> classified_messages_;
+  std::array<std::atomic<uint64_t>, message_analytics_counters.size()>
+      class_totals_;
+
+  static void add(std::atomic<uint64_t> &counter, uint64_t amount) {
+    counter.store(counter.load(std::memory_order_relaxed) + amount,
+                  std::memory_order_relaxed);
+  }
+
+  friend class ServerMetrics;
+
+ public:
+  Thread_Metrics();
+
+  void count_accept() { add(accepts_, 1); }
+  void add_bytes_received(uint64_t byte_count) {
+    add(bytes_received_, byte_count);
+  }
+  void add_bytes_sent(uint64_t byte_count) { add(bytes_sent_, byte_count); }
+  void count_message_analyzed() { add(messages_analyzed_, 1); }
+  void add_messages_analyzed(uint64_t message_count) {
+    add(messages_analyzed_, message_count);
+  }
+  // Lookups in the AnalyticsCache
+  void count_cache_hit() { add(cache_hits_, 1); }
+  void count_cache_miss() { add(cache_misses_, 1); }
+  // Flow control: reading from a connection paused, a connection closed
+  // because its client stopped reading, a message rejected for its size
+  void count_read_pause() { add(read_pauses_, 1); }
+  void count_slow_reader_closed() { add(slow_readers_closed_, 1); }
+  void count_oversized_message() { add(oversized_messages_, 1); }
+  // errno on POSIX, WSAGetLastError() on Windows
+  void count_error(int error_code);
+  void record_stage(Server_Stage stage, std::chrono::nanoseconds duration);
+  // Adds a message to the server-wide analytics: its size only when its
+  // character classes were not computed
+  void add_message_size(uint64_t size);
+  void add_message_analytics(const MessageAnalytics &analytics);
+};
+
+struct Stage_Latency_Summary {
+  uint64_t count{0};
+  uint64_t mean_nanoseconds{0};
+  uint64_t p50_nanoseconds{0};
+  uint64_t p99_nanoseconds{0};
+  uint64_t p999_nanoseconds{0};
+  uint64_t max_nanoseconds{0};
+};
+
+struct Metrics_Snapshot {
+  size_t thread_count{0};
+  uint64_t accepts{0};
+  uint64_t bytes_received{0};
+  uint64_t bytes_sent{0};
+  uint64_t messages_analyzed{0};
+  uint64_t cache_hits{0};
+  uint64_t cache_misses{0};
+  uint64_t read_pauses{0};
+  uint64_t slow_readers_closed{0};
+  uint64_t oversized_messages{0};
+  // (error code, count), most frequent first; -1 collects codes that did
+  // not fit the per-thread table
+  std::vector<std::pair<int, uint64_t>> errors;
+  std::array<Stage_Latency_Summary, server_stage_count> stages;
+  Aggregate_Analytics analytics;
+};
+
+// Registry of the per-thread counters of the whole process.
+class ServerMetrics {
+ private:
+  std::mutex threads_mutex_;
+  std::vector<std::unique_ptr<Thread_Metrics>> threads_;
+
+  ServerMetrics() = default;
+
+  // threads_mutex_ must be held
+  void add_aggregate_analytics(Aggregate_Analytics &analytics) const;
+
+  friend ServerMetrics &get_server_metrics();
+
+ public:
+  ~ServerMetrics() = default;
+
+  ServerMetrics(const ServerMetrics &source) = delete;
+  ServerMetrics &operator=(const ServerMetrics &other) = delete;
+
+  ServerMetrics(ServerMetrics &&source) noexcept = delete;
+  ServerMetrics &operator=(ServerMetrics &&other) noexcept = delete;
+
+  // Counters of the calling thread. Registered on first use (the only time
+  // the registry lock is taken) and kept after the thread exits, so totals
+  // never go backwards.
+  Thread_Metrics &local();
+
+  [[nodiscard]] Metrics_Snapshot snapshot();
+  // The server-wide analytics alone, for clients that query them: merges
+  // the analytics of every thread, nothing else
+  [[nodiscard]] Aggregate_Analytics aggregate_analytics();
+};
+
+ServerMetrics &get_server_metrics();
+
+// Plain-text report of a snapshot, one line per figure.
+std::string format_metrics_report(const Metrics_Snapshot &snapshot);
+
+// Records the time from construction to destruction as one stage sample of
+// the calling thread.
+class Stage_Timer {
+ private:
+  Server_Stage stage_;
+  std::chrono::steady_clock::time_point started_;
+
+ public:
+  explicit Stage_Timer(Server_Stage stage_val)
+      : stage_{stage_val}, started_{std::chrono::steady_clock::now()} {}
+  ~Stage_Timer() {
+    get_server_metrics().local().record_stage(
+        stage_, std::chrono::steady_clock::now() - started_);
+  }
+
+  Stage_Timer(const Stage_Timer &source) = delete;
+  Stage_Timer &operator=(const Stage_Timer &other) = delete;
+
+  Stage_Timer(Stage_Timer &&source) noexcept = delete;
+  Stage_Timer &operator=(Stage_Timer &&other) noexcept = delete;
+};
+
+}  // namespace WindowsSocketApp
+
+#endif  // SERVERMETRICS_H
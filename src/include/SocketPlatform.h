@@ -0,0 +1,44 @@
+#ifndef SOCKETPLATFORM_H
+#define SOCKETPLATFORM_H
+
+// Single place that pulls in the native socket headers. On Windows this is
+// WinSock2; everywhere else the Berkeley socket API is used and the handful
+// of WinSock names the rest of the code relies on are mapped onto it, so the
+// helpers in WinSockFunctions.h compile unchanged on both platforms.
+
+#ifdef _WIN32
+// Keep windows.h from defining min/max macros that break std::min/std::max.
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <windows.h>
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <cerrno>
+
+using SOCKET = int;
+inline constexpr SOCKET INVALID_SOCKET{-1};
+inline constexpr int SOCKET_ERROR{-1};
+inline constexpr int SD_SEND{SHUT_WR};
+
+// Placeholder so the Winsock start-up signature stays the same on POSIX.
+struct WSADATA {};
+
+inline int closesocket(SOCKET s) { return ::close(s); }
+inline int WSAGetLastError() { return errno; }
+inline int WSACleanup() { return 0; }
+#endif
+
+#endif  // SOCKETPLATFORM_H
@@ -1,7 +1,7 @@
 #ifndef SOCKETWRAPPER_H
 #define SOCKETWRAPPER_H
 
-#include <winsock2.h>
+#include "SocketPlatform.h"
 
 namespace WindowsSocketApp {
 
@@ -0,0 +1,55 @@
+#ifndef STATSREPORTER_H
+#define STATSREPORTER_H
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "SocketWrapper.h"
+
+namespace WindowsSocketApp {
+
+// Publishes the server metrics (ServerMetrics.h) without touching the
+// serving threads: each report merges the per-thread counters when it is
+// requested.
+//   - Stats port: every connection to 127.0.0.1:<port> receives the current
+//     report as plain text and is closed, e.g. `nc 127.0.0.1 9100`.
+//   - Dump signal (POSIX): SIGUSR1 prints the report to standard output. The
+//     handler only writes a byte to a pipe; a reporter thread does the rest.
+class StatsReporter {
+ private:
+  std::atomic<bool> stop_requested_;
+
+  SocketWrapper listen_socket_;
+  std::thread port_thread_;
+
+  // Signal pipe; plain file descriptors on POSIX, closed by the wrapper
+  SocketWrapper signal_pipe_read_;
+  SocketWrapper signal_pipe_write_;
+  std::thread signal_thread_;
+
+  void serve_stats_port();
+  void print_on_signal();
+
+ public:
+  StatsReporter();
+
+  ~StatsReporter();
+
+  StatsReporter(const StatsReporter &source) = delete;
+  StatsReporter &operator=(const StatsReporter &other) = delete;
+
+  StatsReporter(StatsReporter &&source) noexcept = delete;
+  StatsReporter &operator=(StatsReporter &&other) noexcept = delete;
+
+  // Listens on the loopback interface only.
+  bool start_stats_port(const std::string &port);
+  // Always false on Windows, which has no SIGUSR1.
+  bool install_dump_signal();
+  // Stops both reporters; also done by the destructor.
+  void stop();
+};
+
+}  // namespace WindowsSocketApp
+
+#endif  // STATSREPORTER_H
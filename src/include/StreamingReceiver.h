@@ -0,0 +1,35 @@
+#ifndef STREAMINGRECEIVER_H
+#define STREAMINGRECEIVER_H
+
+#include "MessageAnalytics.h"
+#include "SocketPlatform.h"
+
+namespace WindowsSocketApp {
+
+// Constant-memory receive for messages of any size. Data read from the socket
+// goes into a fixed-size ByteRingBuffer and a second thread feeds it into a
+// MessageAnalyzer, so analysis overlaps with the network receive and memory
+// use is bounded by the ring capacity instead of the message size.
+class StreamingReceiver {
+ public:
+  static constexpr size_t default_ring_capacity{256 * 1024};
+
+ private:
+  static constexpr size_t maximum_read_size{64 * 1024};
+
+  size_t ring_capacity_;
+  bool log_progress_;
+
+ public:
+  explicit StreamingReceiver(size_t ring_capacity_val = default_ring_capacity,
+                             bool log_progress_val = true);
+
+  // Receives until the peer shuts down its sending side, accumulating the
+  // analytics of everything received into analyzer.
+  bool receive_and_analyze(SOCKET sender_socket,
+                           MessageAnalyzer &analyzer) const;
+};
+
+}  // namespace WindowsSocketApp
+
+#endif  // STREAMINGRECEIVER_H
@@ -0,0 +1,139 @@
+#ifndef TOPWORDS_H
+#define TOPWORDS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "WordSketch.h"
+
+namespace WindowsSocketApp {
+
+// Terms reported per list, most frequent first
+inline constexpr size_t top_words_reported{8};
+
+// A reported term; count 0 marks an unused entry
+struct Ranked_Term {
+  uint64_t count{0};
+  Sketch_Term term;
+};
+
+using Ranked_Terms = std::array<Ranked_Term, top_words_reported>;
+
+// The most frequent words and pairs of consecutive words (bigrams) of one
+// message, and of all the traffic of the server over its rolling window.
+// Words are runs of ASCII letters and digits and of bytes above 0x7F, so
+// UTF-8 words stay whole; ASCII letters are folded to lowercase.
+struct Top_Words_Analytics {
+  Ranked_Terms message_words{};
+  Ranked_Terms message_bigrams{};
+  Ranked_Terms traffic_words{};
+  Ranked_Terms traffic_bigrams{};
+};
+
+// Rolling window over the traffic of one thread: the terms are counted in
+// the current generation, and the window is the current generation plus
+// the previous one, so it spans between one and two window lengths.
+class Traffic_Words_Shard {
+ private:
+  std::mutex mutex_;
+  std::array<WordSketch, 2> words_;
+  std::array<WordSketch, 2> bigrams_;
+  size_t current_;
+  std::chrono::steady_clock::time_point rotated_at_;
+
+  friend class TrafficWords;
+
+ public:
+  Traffic_Words_Shard();
+
+  // Locks the shard for the thread's analyzers and starts a new generation
+  // when the current one is a window old
+  [[nodiscard]] std::unique_lock<std::mutex> lock_for_update(
+      std::chrono::steady_clock::time_point now,
+      std::chrono::milliseconds window);
+
+  // The shard must be locked
+  void add_word(uint64_t hash, const char *word, size_t size);
+  void add_bigram(uint64_t hash, const char *bigram, size_t size);
+};
+
+// Process-wide top terms of the traffic. Each thread counts into its own
+// shard, so analyzers of different threads never wait for each other; the
+// shards are merged at most once per refresh interval, by whichever reply
+// finds the merged lists stale, and replies read the last merge.
+class TrafficWords {
+ public:
+  static constexpr std::chrono::milliseconds refresh_interval{1000};
+
+ private:
+  struct Merged_Terms {
+    Ranked_Terms words{};
+    Ranked_Terms bigrams{};
+  };
+
+  std::mutex shards_mutex_;
+  std::vector<std::unique_ptr<Traffic_Words_Shard>> shards_;
+  std::atomic<int64_t> window_milliseconds_;
+  std::mutex refresh_mutex_;
+  std::atomic<int64_t> next_refresh_;
+  std::shared_ptr<const Merged_Terms> merged_;
+
+  TrafficWords();
+
+  void refresh(std::chrono::steady_clock::time_point now);
+
+  friend TrafficWords &get_traffic_words();
+
+ public:
+  ~TrafficWords() = default;
+
+  TrafficWords(const TrafficWords &source) = delete;
+  TrafficWords &operator=(const TrafficWords &other) = delete;
+
+  TrafficWords(TrafficWords &&source) noexcept = delete;
+  TrafficWords &operator=(TrafficWords &&other) noexcept = delete;
+
+  Traffic_Words_Shard &local();
+
+  [[nodiscard]] std::chrono::milliseconds get_window() const;
+  void set_window(std::chrono::milliseconds window);
+
+  void get_top_terms(Ranked_Terms &words, Ranked_Terms &bigrams);
+};
+
+TrafficWords &get_traffic_words();
+
+// Counts the words and bigrams of a message received in chunks, which may
+// split a word, into sketches of its own and into the traffic shard of the
+// calling thread.
+class TopWordsAnalyzer {
+ private:
+  WordSketch words_;
+  WordSketch bigrams_;
+  std::array<char, top_words_max_word_size> word_;
+  size_t word_size_;
+  bool word_too_long_;
+  std::array<char, top_words_max_word_size> previous_word_;
+  size_t previous_word_size_;
+
+  void end_word(Traffic_Words_Shard &shard);
+
+ public:
+  TopWordsAnalyzer();
+
+  void update(const char *data, size_t size);
+  // Ends the message: counts the word it ended in and reports the top
+  // terms of the message and of the traffic
+  void finish(Top_Words_Analytics &analytics);
+  void reset();
+};
+
+}  // namespace WindowsSocketApp
+
+#endif  // TOPWORDS_H
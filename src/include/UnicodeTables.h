@@ -0,0 +1,46 @@
+#ifndef UNICODETABLES_H
+#define UNICODETABLES_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace WindowsSocketApp {
+
+// The classes of code points counted by the UTF-8 analytics, from the
+// Unicode general categories and the White_Space property. A code point in
+// White_Space counts as WHITESPACE whatever its category.
+enum class Unicode_Class : uint8_t {
+  OTHER = 0,
+  WHITESPACE = 1,    // White_Space
+  UPPERCASE = 2,     // Lu
+  LOWERCASE = 3,     // Ll
+  OTHER_LETTER = 4,  // Lt, Lm, Lo
+  DIGIT = 5,         // Nd
+  PUNCTUATION = 6    // Pc, Pd, Ps, Pe, Pi, Pf, Po
+};
+
+// Two-stage lookup table, generated by tools/generate_unicode_tables.py:
+// stage 1 maps a block of 256 code points to a block of stage 2, which
+// packs the classes of its code points two per byte, the even one in the
+// low nibble. About 20 KiB in total.
+inline constexpr size_t unicode_block_size{256};
+inline constexpr size_t unicode_stage_1_size{0x110000 / unicode_block_size};
+
+extern const std::array<uint8_t, unicode_stage_1_size> unicode_stage_1;
+extern const uint8_t unicode_stage_2[];
+
+// code_point must be below 0x110000.
+[[nodiscard]] inline Unicode_Class get_unicode_class(uint32_t code_point) {
+  const size_t block = unicode_stage_1[code_point / unicode_block_size];
+  const uint8_t pair =
+      unicode_stage_2[(block * unicode_block_size +
+                       code_point % unicode_block_size) /
+                      2];
+  return static_cast<Unicode_Class>((code_point & 1U) != 0U ? pair >> 4U
+                                                            : pair & 0x0FU);
+}
+
+}  // namespace WindowsSocketApp
+
+#endif  // UNICODETABLES_H
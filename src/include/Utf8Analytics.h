@@ -0,0 +1,74 @@
+#ifndef UTF8ANALYTICS_H
+#define UTF8ANALYTICS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace WindowsSocketApp {
+
+// Analytics of a message read as UTF-8: its code points counted by Unicode
+// class (UnicodeTables.h). The counts are meaningful only while the message
+// is valid; scanning stops at the first invalid sequence.
+struct Utf8_Analytics {
+  bool valid{true};
+  uint64_t code_points_count{0};
+  // Uppercase, lowercase and other letters (Lu, Ll, Lt, Lm, Lo)
+  uint64_t letters_count{0};
+  uint64_t uppercase_count{0};
+  uint64_t lowercase_count{0};
+  // Decimal digits of any script (Nd)
+  uint64_t digits_count{0};
+  // White_Space code points, such as U+0020, U+00A0 and U+3000
+  uint64_t whitespace_count{0};
+  // Punctuation marks (P*); symbols such as '+' and '$' are not counted
+  uint64_t punctuation_count{0};
+};
+
+// Implementations of the UTF-8 validation and counting. SCALAR decodes one
+// code point at a time and defines the expected results. AVX2 validates 32
+// bytes per step with the lookup algorithm of Keiser and Lemire and counts
+// runs of ASCII 32 bytes at a time; it decodes other bytes like SCALAR.
+enum class Utf8_Kernel { SCALAR, AVX2 };
+
+[[nodiscard]] Utf8_Kernel get_active_utf8_kernel();
+[[nodiscard]] bool is_utf8_kernel_supported(Utf8_Kernel kernel);
+[[nodiscard]] const char *get_utf8_kernel_name(Utf8_Kernel kernel);
+
+// Whether data[0, size) is valid UTF-8 on its own, using the widest kernel
+// supported by the CPU
+[[nodiscard]] bool is_valid_utf8(const char *data, size_t size);
+
+// Runs one specific kernel over a whole message. Returns false without
+// touching analytics when the CPU does not support it.
+bool run_utf8_analytics(Utf8_Kernel kernel, const char *data, size_t size,
+                        Utf8_Analytics &analytics);
+
+// Accumulates the UTF-8 analytics of a message received in chunks, which
+// may split a multi-byte sequence; the bytes of a split sequence are kept
+// until the rest arrives.
+class Utf8Analyzer {
+ private:
+  Utf8_Kernel kernel_;
+  Utf8_Analytics analytics_;
+  std::array<char, 4> pending_;
+  size_t pending_size_;
+
+  void analyze(const char *data, size_t size);
+
+ public:
+  explicit Utf8Analyzer(Utf8_Kernel kernel_val = get_active_utf8_kernel());
+
+  void update(const char *data, size_t size);
+  void reset();
+
+  // A message ending inside a sequence is invalid
+  [[nodiscard]] Utf8_Analytics get_analytics() const;
+};
+
+[[nodiscard]] Utf8_Analytics calculate_utf8_analytics(const char *data,
+                                                      size_t size);
+
+}  // namespace WindowsSocketApp
+
+#endif  // UTF8ANALYTICS_H
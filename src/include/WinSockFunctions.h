@@ -1,16 +1,18 @@
 #ifndef WINSOCKFUNCTIONS_H
 #define WINSOCKFUNCTIONS_H
 
-#include <windows.h>
-#include <winsock2.h>
-#include <ws2tcpip.h>
-
+#include <algorithm>
+#include <chrono>
+#include <csignal>
 #include <cstdlib>
 #include <iostream>
+#include <limits>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "NetworkTypes.h"
+#include "SocketPlatform.h"
 
 // Need to link with Ws2_32.lib for Server
 // Need to link with Ws2_32.lib, Mswsock.lib, and Advapi32.lib for Client
@@ -23,11 +25,21 @@
 namespace WindowsSocketApp {
 
 inline bool initialize_winsock_2_0(WSADATA &wsaData) {
+#ifdef _WIN32
   int i_result = WSAStartup(MAKEWORD(2, 2), &wsaData);
   if (i_result != 0) {
     std::cout << "WSAStartup failed with error: " << i_result << std::endl;
     return false;
   }
+#else
+  (void)wsaData;
+  // A peer that disconnects mid-send must surface as EPIPE from send(), not
+  // terminate the process, to match WinSock behaviour.
+  if (std::signal(SIGPIPE, SIG_IGN) == SIG_ERR) {
+    std::cout << "Failed to ignore SIGPIPE" << std::endl;
+    return false;
+  }
+#endif
   return true;
 }
 
@@ -62,6 +74,25 @@ inline bool bind_socket(SOCKET s, const sockaddr *name, int namelen) {
   return true;
 }
 
+// Lets several sockets bind the same address and port, with the kernel
+// spreading incoming connections over their listeners (Linux 3.9+, BSD).
+inline bool enable_reuse_port(SOCKET s) {
+#ifdef SO_REUSEPORT
+  int enabled{1};
+  if (setsockopt(s, SOL_SOCKET, SO_REUSEPORT, &enabled, sizeof(enabled)) ==
+      SOCKET_ERROR) {
+    std::cout << "setsockopt SO_REUSEPORT failed with error: "
+              << WSAGetLastError() << std::endl;
+    return false;
+  }
+  return true;
+#else
+  (void)s;
+  std::cout << "SO_REUSEPORT is not supported on this platform" << std::endl;
+  return false;
+#endif
+}
+
 inline bool listen_on_socket(SOCKET s, int backlog) {
   auto i_result = listen(s, backlog);
   if (i_result == SOCKET_ERROR) {
@@ -80,50 +111,323 @@ inline SOCKET accept_socket(SOCKET listen_socket) {
   return new_socket;
 }
 
-inline bool receive_until_empty_input(SOCKET sender_socket,
-                                      std::vector<char> &recv_buffer) {
+// Receives until the peer shuts down its sending side. The initial size of
+// recv_buffer is the size of a single read; the buffer grows as the message
+// arrives and holds exactly the received message on return, or what was
+// received of it on failure. Fails once the message grows beyond max_size
+// bytes.
+inline bool receive_until_empty_input(
+    SOCKET sender_socket, std::vector<char> &recv_buffer,
+    bool log_progress = true,
+    size_t max_size = std::numeric_limits<size_t>::max()) {
+  constexpr size_t minimum_read_size{1024};
+  const size_t read_size = std::max(recv_buffer.size(), minimum_read_size);
+  size_t received_size{0};
   int i_receive_result{-1};
   do {
-    i_receive_result = recv(sender_socket, recv_buffer.data(),
-                            static_cast<int>(recv_buffer.size()), 0);
+    if (recv_buffer.size() - received_size < read_size) {
+      recv_buffer.resize(received_size + read_size);
+    }
+    i_receive_result = recv(sender_socket, recv_buffer.data() + received_size,
+                            static_cast<int>(read_size), 0);
     if (i_receive_result > 0) {
-      std::cout << "Bytes received: " << i_receive_result << '\n';
-      recv_buffer.resize(i_receive_result);
-    } else if (i_receive_result == 0)
-      std::cout << "Connection closing...\n";
-    else {
+      if (log_progress) {
+        std::cout << "Bytes received: " << i_receive_result << '\n';
+      }
+      received_size += static_cast<size_t>(i_receive_result);
+      if (received_size > max_size) {
+        std::cout << "Message exceeds " << max_size << " bytes" << std::endl;
+        recv_buffer.resize(received_size);
+        return false;
+      }
+    } else if (i_receive_result == 0) {
+      if (log_progress) {
+        std::cout << "Connection closing...\n";
+      }
+    } else {
       std::cout << "recv failed with error: " << WSAGetLastError() << std::endl;
+      recv_buffer.resize(received_size);
       return false;
     }
 
   } while (i_receive_result > 0);
+  recv_buffer.resize(received_size);
   return true;
 }
-// Overloaded version of send_buffer_content for vector buffers
-inline bool send_buffer_content(SOCKET receiver_socket,
-                                const std::vector<char> &buffer) {
-  auto i_send_result =
-      send(receiver_socket, buffer.data(), static_cast<int>(buffer.size()), 0);
-  if (i_send_result == SOCKET_ERROR) {
-    std::cout << "send failed with error: " << WSAGetLastError() << std::endl;
+
+// Blocks until data or the end of input is waiting on the socket, without
+// consuming anything.
+inline bool wait_for_input(SOCKET receiver_socket) {
+  char next_byte{0};
+  if (recv(receiver_socket, &next_byte, 1, MSG_PEEK) == SOCKET_ERROR) {
+    std::cout << "recv failed with error: " << WSAGetLastError() << std::endl;
     return false;
   }
-  std::cout << "Bytes sent: " << i_send_result << std::endl;
   return true;
 }
+
+// True when nothing at all is waiting on a connection that should be quiet:
+// no data, no end of input and no error. An idle request/response
+// connection that fails this was closed or reset by the peer.
+inline bool is_connection_idle(SOCKET s) {
+#ifdef _WIN32
+  WSAPOLLFD descriptor{};
+  descriptor.fd = s;
+  descriptor.events = POLLRDNORM;
+  return WSAPoll(&descriptor, 1, 0) == 0;
+#else
+  pollfd descriptor{};
+  descriptor.fd = s;
+  descriptor.events = POLLIN;
+  return poll(&descriptor, 1, 0) == 0;
+#endif
+}
+
+// True when a connecting socket has finished, successfully or not, i.e. it
+// is writable or has an error. Does not wait.
+inline bool is_socket_writable(SOCKET s) {
+#ifdef _WIN32
+  WSAPOLLFD descriptor{};
+  descriptor.fd = s;
+  descriptor.events = POLLWRNORM;
+  return WSAPoll(&descriptor, 1, 0) > 0;
+#else
+  pollfd descriptor{};
+  descriptor.fd = s;
+  descriptor.events = POLLOUT;
+  return poll(&descriptor, 1, 0) > 0;
+#endif
+}
+
+// Receives exactly size bytes unless the peer shuts down its sending side
+// first; received_size tells how many arrived. Returns false on errors only.
+inline bool receive_exactly(SOCKET sender_socket, char *buffer, size_t size,
+                            size_t &received_size) {
+  constexpr size_t maximum_read_size{1U << 30U};  // recv() takes an int
+  received_size = 0;
+  while (received_size < size) {
+    const size_t read_size = std::min(size - received_size, maximum_read_size);
+    auto i_receive_result = recv(sender_socket, buffer + received_size,
+                                 static_cast<int>(read_size), 0);
+    if (i_receive_result == 0) {
+      break;
+    }
+    if (i_receive_result == SOCKET_ERROR) {
+      std::cout << "recv failed with error: " << WSAGetLastError() << std::endl;
+      return false;
+    }
+    received_size += static_cast<size_t>(i_receive_result);
+  }
+  return true;
+}
+
+// One piece of a scatter-gather send.
+struct Send_Segment {
+  const char *data;
+  size_t size;
+};
+
+// Segments handed to the kernel by a single send call
+inline constexpr size_t maximum_segments_per_send{16};
+
+// Sends the segments in one writev-style call (WSASend on Windows, sendmsg
+// elsewhere). Returns the number of bytes the kernel accepted, which may be
+// fewer than requested, or SOCKET_ERROR.
+inline long long send_segments_once(SOCKET receiver_socket,
+                                    const Send_Segment *segments,
+                                    size_t segment_count, int flags = 0) {
+  constexpr size_t maximum_segment_size{1U << 30U};
+  segment_count = std::min(segment_count, maximum_segments_per_send);
+#ifdef _WIN32
+  WSABUF buffers[maximum_segments_per_send];
+  for (size_t i = 0; i < segment_count; ++i) {
+    buffers[i].buf = const_cast<char *>(segments[i].data);
+    buffers[i].len =
+        static_cast<ULONG>(std::min(segments[i].size, maximum_segment_size));
+  }
+  DWORD sent_size{0};
+  if (WSASend(receiver_socket, buffers, static_cast<DWORD>(segment_count),
+              &sent_size, static_cast<DWORD>(flags), nullptr,
+              nullptr) == SOCKET_ERROR) {
+    return SOCKET_ERROR;
+  }
+  return static_cast<long long>(sent_size);
+#else
+  iovec buffers[maximum_segments_per_send];
+  for (size_t i = 0; i < segment_count; ++i) {
+    buffers[i].iov_base = const_cast<char *>(segments[i].data);
+    buffers[i].iov_len = std::min(segments[i].size, maximum_segment_size);
+  }
+  msghdr message{};
+  message.msg_iov = buffers;
+  message.msg_iovlen = segment_count;
+  ssize_t sent_size{-1};
+  do {
+    sent_size = sendmsg(receiver_socket, &message, flags);
+  } while (sent_size == -1 && errno == EINTR);
+  return sent_size;
+#endif
+}
+
+// Drops the first byte_count bytes from the segments, after a send that
+// accepted only part of them.
+inline void skip_sent_bytes(Send_Segment *&segments, size_t &segment_count,
+                            size_t byte_count) {
+  while (segment_count > 0 && byte_count >= segments->size) {
+    byte_count -= segments->size;
+    ++segments;
+    --segment_count;
+  }
+  if (segment_count > 0) {
+    segments->data += byte_count;
+    segments->size -= byte_count;
+  }
+}
+
+// Sends every byte of the segments, in as few calls as the kernel allows:
+// a short write is resumed from where it stopped. segments is used as
+// scratch space and no longer describes the data on return.
+inline bool send_segments(SOCKET receiver_socket, Send_Segment *segments,
+                          size_t segment_count, bool log_progress = true) {
+  size_t total_sent_size{0};
+  skip_sent_bytes(segments, segment_count, 0);
+  while (segment_count > 0) {
+    auto i_send_result =
+        send_segments_once(receiver_socket, segments, segment_count);
+    if (i_send_result == SOCKET_ERROR) {
+      std::cout << "send failed with error: " << WSAGetLastError() << std::endl;
+      return false;
+    }
+    skip_sent_bytes(segments, segment_count,
+                    static_cast<size_t>(i_send_result));
+    total_sent_size += static_cast<size_t>(i_send_result);
+  }
+  if (log_progress) {
+    std::cout << "Bytes sent: " << total_sent_size << std::endl;
+  }
+  return true;
+}
+
+// Overloaded version of send_buffer_content for vector buffers
+inline bool send_buffer_content(SOCKET receiver_socket,
+                                const std::vector<char> &buffer,
+                                bool log_progress = true) {
+  Send_Segment segment{buffer.data(), buffer.size()};
+  return send_segments(receiver_socket, &segment, 1, log_progress);
+}
 // Overloaded version of send_buffer_content for std::string buffers
 inline bool send_buffer_content(SOCKET receiver_socket,
-                                const std::string &buffer) {
-  auto i_send_result =
-      send(receiver_socket, buffer.c_str(), static_cast<int>(buffer.size()), 0);
-  if (i_send_result == SOCKET_ERROR) {
-    std::cout << "send failed with error: " << WSAGetLastError() << std::endl;
+                                const std::string &buffer,
+                                bool log_progress = true) {
+  Send_Segment segment{buffer.data(), buffer.size()};
+  return send_segments(receiver_socket, &segment, 1, log_progress);
+}
+
+// Switches the socket back to blocking mode when non_blocking is false.
+inline bool set_socket_non_blocking(SOCKET s, bool non_blocking = true) {
+#ifdef _WIN32
+  u_long non_blocking_mode{non_blocking ? 1U : 0U};
+  auto i_result = ioctlsocket(s, FIONBIO, &non_blocking_mode);
+#else
+  int flags = fcntl(s, F_GETFL, 0);
+  auto i_result =
+      flags == -1 ? -1
+                  : fcntl(s, F_SETFL,
+                          non_blocking ? flags | O_NONBLOCK
+                                       : flags & ~O_NONBLOCK);
+#endif
+  if (i_result == SOCKET_ERROR) {
+    std::cout << "Failed to switch socket to "
+              << (non_blocking ? "non-blocking" : "blocking")
+              << " mode: " << WSAGetLastError() << std::endl;
     return false;
   }
-  std::cout << "Bytes sent: " << i_send_result << std::endl;
   return true;
 }
 
+// Blocking sends on the socket fail once they made no progress for timeout,
+// so a peer that stops reading cannot hold the sender forever. 0 waits
+// without limit.
+inline bool set_socket_send_timeout(SOCKET s,
+                                    std::chrono::milliseconds timeout) {
+#ifdef _WIN32
+  const auto timeout_value = static_cast<DWORD>(timeout.count());
+  auto i_result = setsockopt(s, SOL_SOCKET, SO_SNDTIMEO,
+                             reinterpret_cast<const char *>(&timeout_value),
+                             sizeof(timeout_value));
+#else
+  timeval timeout_value{};
+  timeout_value.tv_sec = static_cast<time_t>(timeout.count() / 1000);
+  timeout_value.tv_usec =
+      static_cast<suseconds_t>(timeout.count() % 1000) * 1000;
+  auto i_result = setsockopt(s, SOL_SOCKET, SO_SNDTIMEO, &timeout_value,
+                             sizeof(timeout_value));
+#endif
+  if (i_result == SOCKET_ERROR) {
+    std::cout << "setsockopt SO_SNDTIMEO failed with error: "
+              << WSAGetLastError() << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// True when a blocking send failed because the send timeout expired.
+inline bool is_send_timeout_error(int error_code) {
+#ifdef _WIN32
+  return error_code == WSAETIMEDOUT;
+#else
+  return error_code == EAGAIN || error_code == EWOULDBLOCK;
+#endif
+}
+
+// True when a non-blocking socket call failed only because it would block.
+inline bool is_would_block_error(int error_code) {
+#ifdef _WIN32
+  return error_code == WSAEWOULDBLOCK;
+#else
+  return error_code == EAGAIN || error_code == EWOULDBLOCK;
+#endif
+}
+
+// True when connect() on a non-blocking socket only started the handshake;
+// the socket turns writable once it is done.
+inline bool is_connect_in_progress_error(int error_code) {
+#ifdef _WIN32
+  return error_code == WSAEWOULDBLOCK;
+#else
+  return error_code == EINPROGRESS;
+#endif
+}
+
+// Error of a finished non-blocking connect, 0 when it succeeded.
+inline int get_pending_socket_error(SOCKET s) {
+  int error_code{0};
+#ifdef _WIN32
+  int option_size{sizeof(error_code)};
+  if (getsockopt(s, SOL_SOCKET, SO_ERROR,
+                 reinterpret_cast<char *>(&error_code),
+                 &option_size) == SOCKET_ERROR) {
+#else
+  socklen_t option_size{sizeof(error_code)};
+  if (getsockopt(s, SOL_SOCKET, SO_ERROR, &error_code, &option_size) ==
+      SOCKET_ERROR) {
+#endif
+    return WSAGetLastError();
+  }
+  return error_code;
+}
+
+// True when accept() failed because of the pending connection only (the
+// client gave up before it was accepted) and the listener is still usable.
+inline bool is_transient_accept_error(int error_code) {
+#ifdef _WIN32
+  return error_code == WSAECONNRESET || error_code == WSAEINTR;
+#else
+  return error_code == EINTR || error_code == ECONNABORTED ||
+         error_code == EPROTO;
+#endif
+}
+
 inline bool shutdown_sending_side(SOCKET receiver_socket) {
   auto i_send_result = shutdown(receiver_socket, SD_SEND);
   if (i_send_result == SOCKET_ERROR) {
@@ -0,0 +1,68 @@
+#ifndef WORDSKETCH_H
+#define WORDSKETCH_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace WindowsSocketApp {
+
+// Longest word counted by the top-words analytics, in bytes; longer tokens,
+// such as encoded blobs, are skipped. A term is a word or a pair of words
+// joined by a space.
+inline constexpr size_t top_words_max_word_size{24};
+inline constexpr size_t top_words_max_term_size{2 * top_words_max_word_size +
+                                                1};
+
+struct Sketch_Term {
+  uint8_t length{0};
+  std::array<char, top_words_max_term_size> text{};
+};
+
+// Approximate counts of the most frequent terms of a stream in fixed memory,
+// whatever the number of distinct terms:
+// - a Count-Min sketch of depth rows of width counters estimates the count of
+//   any term, never below its true count; it is updated conservatively, only
+//   the rows holding the smallest count being raised
+// - the terms with the highest estimates are kept as candidates, with their
+//   text; a term enters once its estimate exceeds that of the smallest
+//   candidate, which it then replaces
+// Terms are identified by a 64-bit hash supplied by the caller.
+class WordSketch {
+ public:
+  static constexpr size_t depth{4};
+
+ private:
+  size_t width_mask_;
+  std::vector<uint32_t> counters_;
+  std::vector<uint64_t> candidate_hashes_;
+  std::vector<uint64_t> candidate_counts_;
+  std::vector<Sketch_Term> candidate_terms_;
+  size_t candidate_count_;
+  size_t minimum_index_;
+  uint64_t total_;
+
+  uint64_t increment(uint64_t hash);
+  void find_minimum();
+
+ public:
+  // width is rounded up to a power of two
+  WordSketch(size_t width_val, size_t capacity_val);
+
+  void add(uint64_t hash, const char *term, size_t size);
+  void clear();
+
+  [[nodiscard]] uint64_t estimate(uint64_t hash) const;
+  // Terms added since the last clear
+  [[nodiscard]] uint64_t get_total() const;
+
+  [[nodiscard]] size_t get_candidate_count() const;
+  [[nodiscard]] uint64_t get_candidate_hash(size_t index) const;
+  [[nodiscard]] uint64_t get_candidate_count(size_t index) const;
+  [[nodiscard]] const Sketch_Term &get_candidate_term(size_t index) const;
+};
+
+}  // namespace WindowsSocketApp
+
+#endif  // WORDSKETCH_H
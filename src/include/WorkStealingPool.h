@@ -0,0 +1,75 @@
+#ifndef WORKSTEALINGPOOL_H
+#define WORKSTEALINGPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace WindowsSocketApp {
+
+// Fork/join pool for splitting one large computation over all cores.
+// run() hands out task indices [0, task_count) in contiguous ranges, one per
+// participant (the workers plus the calling thread). Each participant works
+// through its own range from the front; once it is empty it steals from the
+// back of the others', so uneven chunks still finish together.
+// One batch runs at a time; a caller that finds the pool busy runs its batch
+// alone instead of waiting.
+class WorkStealingPool {
+ public:
+  using Task = std::function<void(size_t)>;
+
+ private:
+  struct Task_Range {
+    std::mutex mutex;
+    size_t begin{0};
+    size_t end{0};
+  };
+
+  std::vector<std::unique_ptr<Task_Range>> task_ranges_;
+  std::vector<std::thread> workers_;
+
+  std::mutex batch_mutex_;  // held by the caller of the running batch
+
+  std::mutex state_mutex_;
+  std::condition_variable batch_started_;
+  std::condition_variable batch_finished_;
+  uint64_t batch_generation_;
+  bool stopping_;
+
+  const Task *task_;
+  std::atomic<size_t> remaining_tasks_;
+
+  void worker_loop(size_t home_range);
+  bool take_task(size_t home_range, size_t &task_index);
+  void run_tasks(size_t home_range);
+
+ public:
+  // worker_count_val == 0 selects one worker per additional hardware thread;
+  // the calling thread of run() is the remaining participant.
+  explicit WorkStealingPool(size_t worker_count_val = 0);
+
+  ~WorkStealingPool();
+
+  WorkStealingPool(const WorkStealingPool &source) = delete;
+  WorkStealingPool &operator=(const WorkStealingPool &other) = delete;
+
+  WorkStealingPool(WorkStealingPool &&source) noexcept = delete;
+  WorkStealingPool &operator=(WorkStealingPool &&other) noexcept = delete;
+
+  // Calls task(i) for every i in [0, task_count) and returns once all calls
+  // have completed. task must not throw.
+  void run(size_t task_count, const Task &task);
+
+  [[nodiscard]] size_t get_worker_count() const;
+
+  [[nodiscard]] static size_t default_worker_count();
+};
+
+}  // namespace WindowsSocketApp
+
+#endif  // WORKSTEALINGPOOL_H
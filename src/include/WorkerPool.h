@@ -0,0 +1,63 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "ClientSession.h"
+
+namespace WindowsSocketApp {
+
+// Fixed set of worker threads that serve accepted client sessions. The accept
+// loop hands every new session to submit(); an idle worker picks it up and
+// runs the session handler on it. With a bounded queue, submit() waits for
+// room, so an overloaded server stops accepting and new clients wait in the
+// listen backlog instead of in memory.
+class WorkerPool {
+ public:
+  using Session_Handler = std::function<void(ClientSession &)>;
+
+ private:
+  Session_Handler session_handler_;
+
+  std::mutex queue_mutex_;
+  std::condition_variable queue_not_empty_;
+  std::condition_variable queue_not_full_;
+  std::deque<ClientSession> pending_sessions_;
+  size_t max_pending_sessions_;
+  bool stopping_;
+
+  std::vector<std::thread> workers_;
+
+  void worker_loop();
+
+ public:
+  // worker_count_val == 0 selects one worker per hardware thread;
+  // max_pending_sessions_val == 0 leaves the queue unbounded.
+  explicit WorkerPool(Session_Handler session_handler_val,
+                      size_t worker_count_val = 0,
+                      size_t max_pending_sessions_val = 0);
+
+  // Finishes the sessions already queued, then joins the workers.
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool &source) = delete;
+  WorkerPool &operator=(const WorkerPool &other) = delete;
+
+  WorkerPool(WorkerPool &&source) noexcept = delete;
+  WorkerPool &operator=(WorkerPool &&other) noexcept = delete;
+
+  void submit(ClientSession session);
+
+  [[nodiscard]] size_t get_worker_count() const;
+
+  [[nodiscard]] static size_t default_worker_count();
+};
+
+}  // namespace WindowsSocketApp
+
+#endif  // WORKERPOOL_H
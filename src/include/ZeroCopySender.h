@@ -0,0 +1,68 @@
+#ifndef ZEROCOPYSENDER_H
+#define ZEROCOPYSENDER_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "WinSockFunctions.h"
+
+namespace WindowsSocketApp {
+
+// Sends large buffers on a blocking socket with MSG_ZEROCOPY (Linux 4.14+):
+// the kernel transmits straight from the caller's pages instead of copying
+// them into socket buffers. The pages must stay untouched until the kernel
+// reports it is done with them on the socket's error queue, so send()
+// returns only after every one of its sends has completed.
+// Where zero-copy is unavailable, and once the kernel reports that it had
+// to copy anyway (loopback, devices without scatter-gather), sends fall back
+// to send_segments().
+class ZeroCopySender {
+ public:
+  // Smaller sends are cheaper to copy than to pin and track
+  static constexpr size_t default_minimum_size{64 * 1024};
+
+ private:
+  SOCKET socket_;
+  size_t minimum_size_;
+  bool enabled_;
+
+  // Ids the kernel gives zero-copy sends are consecutive per socket
+  uint32_t issued_send_count_;
+  uint32_t completed_send_count_;
+  size_t copied_send_count_;
+
+  bool send_zero_copy(Send_Segment *segments, size_t segment_count,
+                      size_t &sent_size);
+  bool read_completions();
+  bool wait_for_completions();
+
+ public:
+  explicit ZeroCopySender(SOCKET socket_val,
+                          size_t minimum_size_val = default_minimum_size);
+
+  ~ZeroCopySender() = default;
+
+  ZeroCopySender(const ZeroCopySender &source) = delete;
+  ZeroCopySender &operator=(const ZeroCopySender &other) = delete;
+
+  ZeroCopySender(ZeroCopySender &&source) noexcept = default;
+  ZeroCopySender &operator=(ZeroCopySender &&other) noexcept = default;
+
+  // Turns on SO_ZEROCOPY for the socket. False when the platform or kernel
+  // does not support it; send() then always copies.
+  bool enable();
+
+  // Same contract as send_segments(): every byte is sent, short writes are
+  // resumed and segments is used as scratch space.
+  bool send(Send_Segment *segments, size_t segment_count,
+            bool log_progress = true);
+
+  [[nodiscard]] bool enabled() const;
+  // Sends the kernel completed without copying / had to copy after all
+  [[nodiscard]] size_t get_zero_copy_send_count() const;
+  [[nodiscard]] size_t get_copied_send_count() const;
+};
+
+}  // namespace WindowsSocketApp
+
+#endif  // ZEROCOPYSENDER_H
@@ -0,0 +1,190 @@
+#ifndef BENCHMARKHARNESS_H
+#define BENCHMARKHARNESS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace WindowsSocketApp {
+
+// Keeps the compiler from discarding a result that is otherwise unused.
+template <typename T>
+inline void do_not_optimize(const T &value) {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  static volatile const void *sink{nullptr};
+  sink = &value;
+#endif
+}
+
+struct Benchmark_Result {
+  std::string name;
+  size_t bytes_per_operation{0};
+  // Median over the repetitions, and the fastest repetition
+  double nanoseconds_per_operation{0};
+  double fastest_nanoseconds_per_operation{0};
+};
+
+// Small self-contained microbenchmark harness for the benchmarks target.
+// Each benchmark is calibrated to a batch of operations long enough to time,
+// then repeated; the median time per operation is reported, so results from
+// different commits on the same machine can be compared directly. Results
+// can be written as CSV and a previous CSV loaded as the baseline that every
+// line is compared against.
+class BenchmarkRunner {
+ public:
+  static constexpr size_t default_repetitions{5};
+  static constexpr std::chrono::milliseconds default_minimum_time{100};
+
+ private:
+  std::chrono::milliseconds minimum_time_;
+  size_t repetitions_;
+  std::string filter_;
+  std::vector<Benchmark_Result> results_;
+  // Benchmark name -> nanoseconds per operation
+  std::map<std::string, double> baseline_;
+
+  template <typename Operation>
+  static double time_batch(Operation &operation, uint64_t batch_size) {
+    const auto started = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < batch_size; ++i) {
+      operation();
+    }
+    return std::chrono::duration<double, std::nano>(
+               std::chrono::steady_clock::now() - started)
+        .count();
+  }
+
+  void print_result(const Benchmark_Result &result) const {
+    std::cout << std::left << std::setw(56) << result.name << std::right
+              << std::fixed << std::setprecision(1) << std::setw(14)
+              << result.nanoseconds_per_operation << " ns";
+    if (result.bytes_per_operation > 0) {
+      std::cout << std::setprecision(2) << std::setw(10)
+                << static_cast<double>(result.bytes_per_operation) /
+                       result.nanoseconds_per_operation
+                << " GB/s";
+    } else {
+      std::cout << std::setw(15) << "";
+    }
+    const auto baseline = baseline_.find(result.name);
+    if (baseline != baseline_.end() && baseline->second > 0) {
+      // Positive: slower than the baseline
+      std::cout << std::showpos << std::setprecision(1) << std::setw(10)
+                << (result.nanoseconds_per_operation / baseline->second -
+                    1.0) * 100.0
+                << "%" << std::noshowpos;
+    }
+    std::cout << std::endl;
+  }
+
+ public:
+  explicit BenchmarkRunner(
+      std::chrono::milliseconds minimum_time_val = default_minimum_time,
+      size_t repetitions_val = default_repetitions,
+      std::string filter_val = {})
+      : minimum_time_{minimum_time_val},
+        repetitions_{std::max<size_t>(repetitions_val, 1)},
+        filter_{std::move(filter_val)} {}
+
+  // Whether a benchmark with this name is selected by the filter
+  [[nodiscard]] bool selected(const std::string &name) const {
+    return filter_.empty() || name.find(filter_) != std::string::npos;
+  }
+
+  // Times operation(), which processes bytes_per_operation bytes (0 when
+  // throughput makes no sense), unless the filter excludes it.
+  template <typename Operation>
+  void run(const std::string &name, size_t bytes_per_operation,
+           Operation &&operation) {
+    if (!selected(name)) {
+      return;
+    }
+    const double repetition_time =
+        std::chrono::duration<double, std::nano>(minimum_time_).count() /
+        static_cast<double>(repetitions_);
+
+    // Double the batch until it is long enough to time, then size it to
+    // one repetition.
+    uint64_t batch_size{1};
+    double batch_time = time_batch(operation, batch_size);
+    while (batch_time < repetition_time / 8 && batch_size < (1ULL << 40U)) {
+      batch_size *= 2;
+      batch_time = time_batch(operation, batch_size);
+    }
+    batch_size = std::max<uint64_t>(
+        static_cast<uint64_t>(repetition_time /
+                              (batch_time / static_cast<double>(batch_size))),
+        1);
+
+    std::vector<double> per_operation(repetitions_);
+    for (auto &time : per_operation) {
+      time = time_batch(operation, batch_size) /
+             static_cast<double>(batch_size);
+    }
+    std::sort(per_operation.begin(), per_operation.end());
+
+    Benchmark_Result result;
+    result.name = name;
+    result.bytes_per_operation = bytes_per_operation;
+    result.nanoseconds_per_operation = per_operation[per_operation.size() / 2];
+    result.fastest_nanoseconds_per_operation = per_operation.front();
+    print_result(result);
+    results_.push_back(std::move(result));
+  }
+
+  bool load_baseline(const std::string &path) {
+    std::ifstream input{path};
+    if (!input) {
+      std::cerr << "Failed to open baseline " << path << std::endl;
+      return false;
+    }
+    std::string line;
+    std::getline(input, line);  // Header
+    while (std::getline(input, line)) {
+      std::istringstream fields{line};
+      std::string name;
+      std::string bytes;
+      std::string nanoseconds;
+      if (std::getline(fields, name, ',') && std::getline(fields, bytes, ',') &&
+          std::getline(fields, nanoseconds, ',')) {
+        baseline_[name] = std::strtod(nanoseconds.c_str(), nullptr);
+      }
+    }
+    return true;
+  }
+
+  bool write_csv(const std::string &path) const {
+    std::ofstream output{path};
+    if (!output) {
+      std::cerr << "Failed to write " << path << std::endl;
+      return false;
+    }
+    output << "name,bytes_per_operation,nanoseconds_per_operation,"
+              "fastest_nanoseconds_per_operation\n";
+    output << std::fixed << std::setprecision(2);
+    for (const auto &result : results_) {
+      output << result.name << ',' << result.bytes_per_operation << ','
+             << result.nanoseconds_per_operation << ','
+             << result.fastest_nanoseconds_per_operation << '\n';
+    }
+    return true;
+  }
+
+  [[nodiscard]] const std::vector<Benchmark_Result> &get_results() const {
+    return results_;
+  }
+};
+
+}  // namespace WindowsSocketApp
+
+#endif  // BENCHMARKHARNESS_H
@@ -1,8 +1,6 @@
 #ifndef HELPERFUNCTIONS_H
 #define HELPERFUNCTIONS_H
 
-#include <cctype>
-
 namespace WindowsSocketApp {
 
 inline bool is_vowel(char c) {
@@ -18,7 +16,12 @@ inline bool is_vowel(char c) {
   }
 }
 
-inline bool is_consonant(char c) { return std::isalpha(c) && !is_vowel(c); }
+// ASCII letters only: std::isalpha() is undefined for the negative chars of
+// bytes above 0x7F and depends on the locale.
+inline bool is_consonant(char c) {
+  const char folded = static_cast<char>(c | 0x20);
+  return folded >= 'a' && folded <= 'z' && !is_vowel(c);
+}
 
 }  // namespace WindowsSocketApp
 
@@ -0,0 +1,369 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../src/include/AnalyticsEncoding.h"
+#include "../src/include/AnalyticsKernels.h"
+#include "../src/include/Utf8Analytics.h"
+
+namespace {
+
+using WindowsSocketApp::Analytics_Kernel;
+using WindowsSocketApp::MessageAnalytics;
+using WindowsSocketApp::Utf8_Analytics;
+using WindowsSocketApp::Utf8_Kernel;
+
+constexpr Analytics_Kernel tested_kernels[]{
+    Analytics_Kernel::SCALAR, Analytics_Kernel::SSE2, Analytics_Kernel::AVX2,
+    Analytics_Kernel::AVX512};
+
+bool same_analytics(const MessageAnalytics &lhs, const MessageAnalytics &rhs) {
+  return lhs.length == rhs.length &&
+         lhs.punctuation_marks_count == rhs.punctuation_marks_count &&
+         lhs.spaces_count == rhs.spaces_count &&
+         lhs.digits_count == rhs.digits_count &&
+         lhs.uppercase_count == rhs.uppercase_count &&
+         lhs.lowercase_count == rhs.lowercase_count &&
+         lhs.vowels_count == rhs.vowels_count &&
+         lhs.consonants_count == rhs.consonants_count;
+}
+
+// Counts already present, so a kernel that overwrites instead of adding
+// fails too
+MessageAnalytics make_initial_analytics() {
+  MessageAnalytics analytics{};
+  analytics.length = 1000;
+  analytics.punctuation_marks_count = 1;
+  analytics.spaces_count = 2;
+  analytics.digits_count = 3;
+  analytics.uppercase_count = 4;
+  analytics.lowercase_count = 5;
+  analytics.vowels_count = 6;
+  analytics.consonants_count = 7;
+  return analytics;
+}
+
+// Runs every supported kernel on data[0, size) and compares it with
+// REFERENCE; returns the number of kernels that differ.
+int check(const char *name, const char *data, size_t size) {
+  MessageAnalytics expected = make_initial_analytics();
+  WindowsSocketApp::run_analytics_kernel(Analytics_Kernel::REFERENCE, data,
+                                         size, expected);
+  int failures{0};
+  for (const Analytics_Kernel kernel : tested_kernels) {
+    MessageAnalytics actual = make_initial_analytics();
+    if (WindowsSocketApp::run_analytics_kernel(kernel, data, size, actual) &&
+        !same_analytics(expected, actual)) {
+      std::cerr << "Kernel " << WindowsSocketApp::get_analytics_kernel_name(
+                                    kernel)
+                << " differs from the reference on " << name << ", "
+                << size << " bytes" << std::endl;
+      ++failures;
+    }
+  }
+  return failures;
+}
+
+std::string make_random_bytes(std::mt19937_64 &random_engine, size_t size) {
+  std::string bytes(size, '\0');
+  for (char &c : bytes) {
+    c = static_cast<char>(random_engine() & 0xFFU);
+  }
+  return bytes;
+}
+
+// Letters, digits, spaces and punctuation, mostly
+std::string make_random_text(std::mt19937_64 &random_engine, size_t size) {
+  static constexpr char alphabet[]{
+      "aeiouAEIOUbcdfgBCDFG xyzXYZ 0123456789 .,;:!?'\"-()\t\n"};
+  std::string text(size, '\0');
+  for (char &c : text) {
+    c = alphabet[random_engine() % (sizeof(alphabet) - 1)];
+  }
+  return text;
+}
+
+constexpr Utf8_Kernel tested_utf8_kernels[]{Utf8_Kernel::SCALAR,
+                                            Utf8_Kernel::AVX2};
+
+// The counts are compared only for valid UTF-8, where they are meaningful
+bool same_utf8_analytics(const Utf8_Analytics &lhs, const Utf8_Analytics &rhs) {
+  if (!lhs.valid || !rhs.valid) {
+    return lhs.valid == rhs.valid;
+  }
+  return lhs.code_points_count == rhs.code_points_count &&
+         lhs.letters_count == rhs.letters_count &&
+         lhs.uppercase_count == rhs.uppercase_count &&
+         lhs.lowercase_count == rhs.lowercase_count &&
+         lhs.digits_count == rhs.digits_count &&
+         lhs.whitespace_count == rhs.whitespace_count &&
+         lhs.punctuation_count == rhs.punctuation_count;
+}
+
+void append_code_point(std::string &text, uint32_t code_point) {
+  if (code_point < 0x80U) {
+    text += static_cast<char>(code_point);
+  } else if (code_point < 0x800U) {
+    text += static_cast<char>(0xC0U | (code_point >> 6U));
+    text += static_cast<char>(0x80U | (code_point & 0x3FU));
+  } else if (code_point < 0x10000U) {
+    text += static_cast<char>(0xE0U | (code_point >> 12U));
+    text += static_cast<char>(0x80U | ((code_point >> 6U) & 0x3FU));
+    text += static_cast<char>(0x80U | (code_point & 0x3FU));
+  } else {
+    text += static_cast<char>(0xF0U | (code_point >> 18U));
+    text += static_cast<char>(0x80U | ((code_point >> 12U) & 0x3FU));
+    text += static_cast<char>(0x80U | ((code_point >> 6U) & 0x3FU));
+    text += static_cast<char>(0x80U | (code_point & 0x3FU));
+  }
+}
+
+// Valid UTF-8 of about size bytes: runs of ASCII text long enough for the
+// 32-byte steps, between code points of every length
+std::string make_random_utf8(std::mt19937_64 &random_engine, size_t size) {
+  std::string text;
+  while (text.size() < size) {
+    switch (random_engine() % 4) {
+      case 0:
+        text += make_random_text(random_engine, random_engine() % 80);
+        break;
+      case 1:
+        append_code_point(text, 0x80U + random_engine() % (0x800U - 0x80U));
+        break;
+      case 2: {
+        uint32_t code_point = 0x800U + random_engine() % (0x10000U - 0x800U);
+        if (code_point >= 0xD800U && code_point <= 0xDFFFU) {
+          code_point -= 0x800U;
+        }
+        append_code_point(text, code_point);
+        break;
+      }
+      default:
+        append_code_point(text,
+                          0x10000U + random_engine() % (0x110000U - 0x10000U));
+        break;
+    }
+  }
+  return text;
+}
+
+// Sequences that are never valid UTF-8
+const char *const invalid_sequences[]{
+    // Overlong encodings
+    "\xC0\x80", "\xC1\xBF", "\xE0\x80\x80", "\xE0\x9F\xBF",
+    "\xF0\x80\x80\x80", "\xF0\x8F\xBF\xBF",
+    // Surrogates
+    "\xED\xA0\x80", "\xED\xBF\xBF",
+    // Above U+10FFFF, and bytes that never occur
+    "\xF4\x90\x80\x80", "\xF5\x80\x80\x80", "\xF8", "\xFE", "\xFF",
+    // Stray continuation bytes
+    "\x80", "\xBF", "\x80\x80",
+    // Sequences cut short by ASCII
+    "\xC3" "a", "\xE2\x82" "a", "\xF0\x9F\x98" "a"};
+
+// Runs both UTF-8 kernels on data[0, size), whole and through a Utf8Analyzer
+// fed in random chunks, plus is_valid_utf8(), and compares them with SCALAR
+// on the whole message; returns the number of differences. expected_valid
+// is 1 or 0 when the validity is known, -1 otherwise.
+int check_utf8(std::mt19937_64 &random_engine, const char *name,
+               const char *data, size_t size, int expected_valid = -1) {
+  Utf8_Analytics expected;
+  WindowsSocketApp::run_utf8_analytics(Utf8_Kernel::SCALAR, data, size,
+                                       expected);
+  int failures{0};
+  const auto report = [&](const char *what) {
+    std::cerr << what << " differs from the scalar UTF-8 kernel on " << name
+              << ", " << size << " bytes" << std::endl;
+    ++failures;
+  };
+  if (expected_valid != -1 && expected.valid != (expected_valid == 1)) {
+    report("The expected validity");
+  }
+  if (WindowsSocketApp::is_valid_utf8(data, size) != expected.valid) {
+    report("is_valid_utf8()");
+  }
+  for (const Utf8_Kernel kernel : tested_utf8_kernels) {
+    Utf8_Analytics actual;
+    if (!WindowsSocketApp::run_utf8_analytics(kernel, data, size, actual)) {
+      continue;
+    }
+    if (!same_utf8_analytics(expected, actual)) {
+      report(WindowsSocketApp::get_utf8_kernel_name(kernel));
+    }
+    WindowsSocketApp::Utf8Analyzer analyzer{kernel};
+    for (size_t offset = 0; offset < size;) {
+      const size_t chunk_size =
+          std::min<size_t>(1 + random_engine() % 70, size - offset);
+      analyzer.update(data + offset, chunk_size);
+      offset += chunk_size;
+    }
+    if (!same_utf8_analytics(expected, analyzer.get_analytics())) {
+      report("Utf8Analyzer in chunks");
+    }
+  }
+  return failures;
+}
+
+// The UTF-8 kernels on valid text, on every sequence length placed across
+// every position of a 32-byte block, whole and truncated, and on valid text
+// with invalid sequences or random bytes put in
+int check_utf8_kernels(std::mt19937_64 &random_engine) {
+  int failures{0};
+  for (const uint32_t code_point : {0xE9U, 0x20ACU, 0x1F600U}) {
+    std::string sequence;
+    append_code_point(sequence, code_point);
+    for (size_t padding = 0; padding < 70; ++padding) {
+      std::string text(padding, 'a');
+      text += sequence;
+      text += std::string(40, 'b');
+      failures += check_utf8(random_engine, "a sequence across a block edge",
+                             text.data(), text.size(), 1);
+      for (size_t kept = 1; kept < sequence.size(); ++kept) {
+        failures += check_utf8(random_engine, "a truncated sequence",
+                               text.data(), padding + kept, 0);
+      }
+    }
+  }
+
+  for (int round = 0; round < 2000; ++round) {
+    const std::string text =
+        make_random_utf8(random_engine, random_engine() % 300);
+    failures += check_utf8(random_engine, "random UTF-8", text.data(),
+                           text.size(), 1);
+    for (const char *const sequence : invalid_sequences) {
+      std::string corrupted{text};
+      // Inserted before an ASCII byte or a lead byte, so the text around it
+      // stays valid
+      size_t position = random_engine() % (corrupted.size() + 1);
+      while (position < corrupted.size() &&
+             (static_cast<unsigned char>(corrupted[position]) & 0xC0U) ==
+                 0x80U) {
+        ++position;
+      }
+      corrupted.insert(position, sequence);
+      failures += check_utf8(random_engine, "UTF-8 with an invalid sequence",
+                             corrupted.data(), corrupted.size(), 0);
+    }
+    if (!text.empty()) {
+      std::string corrupted{text};
+      corrupted[random_engine() % corrupted.size()] =
+          static_cast<char>(random_engine() & 0xFFU);
+      failures += check_utf8(random_engine, "UTF-8 with a random byte",
+                             corrupted.data(), corrupted.size());
+    }
+  }
+
+  const std::string large = make_random_utf8(random_engine, 1024 * 1024);
+  failures += check_utf8(random_engine, "random UTF-8", large.data(),
+                         large.size(), 1);
+  return failures;
+}
+
+// The text reply of invalid UTF-8 still carries every section after the
+// UTF-8 one; returns 1 when it does not.
+int check_invalid_utf8_text() {
+  WindowsSocketApp::Pipeline_Analytics analytics;
+  analytics.counters = WindowsSocketApp::analytics_unicode |
+                       WindowsSocketApp::analytics_top_words;
+  analytics.unicode.valid = false;
+  WindowsSocketApp::Ranked_Term &word = analytics.top_words.message_words[0];
+  word.count = 2;
+  word.term.length = 5;
+  std::memcpy(word.term.text.data(), "hello", 5);
+
+  std::string text;
+  WindowsSocketApp::append_pipeline_analytics_text(analytics, text);
+  const std::string expected{
+      "Received message analytics: UTF-8: invalid, top words: \"hello\":2, "
+      "top bigrams:, traffic top words:, traffic top bigrams:"};
+  if (text != expected) {
+    std::cerr << "Text reply of invalid UTF-8 with top words: \"" << text
+              << "\", expected \"" << expected << '"' << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+}  // namespace
+
+// Differential test of the analytics kernels: every kernel the CPU supports
+// against REFERENCE, on every length up to a few vectors (so every tail
+// length of every vector width), at every alignment of a 64-byte block, and
+// on larger inputs on both sides of the histogram threshold. Inputs are
+// random bytes over the whole range, random text, bytes >= 0x80 only and
+// every byte value. The UTF-8 kernels are checked the same way against
+// SCALAR, on valid text and on text with invalid sequences, and so is the
+// text encoding of a reply to invalid UTF-8. The exit code is 1 when
+// anything differs.
+int main() {
+  for (const Analytics_Kernel kernel : tested_kernels) {
+    std::cout << WindowsSocketApp::get_analytics_kernel_name(kernel) << ": "
+              << (WindowsSocketApp::is_analytics_kernel_supported(kernel)
+                      ? "tested"
+                      : "not supported by this CPU, skipped")
+              << std::endl;
+  }
+
+  std::mt19937_64 random_engine{20240601};
+  int failures{0};
+
+  constexpr size_t max_short_size{300};
+  constexpr size_t alignment_count{64};
+  const std::string random_bytes =
+      make_random_bytes(random_engine, max_short_size + alignment_count);
+  const std::string random_text =
+      make_random_text(random_engine, max_short_size + alignment_count);
+  std::string high_bytes(max_short_size + alignment_count, '\0');
+  for (size_t i = 0; i < high_bytes.size(); ++i) {
+    high_bytes[i] = static_cast<char>(0x80U + (i % 0x80U));
+  }
+  for (size_t offset = 0; offset < alignment_count; ++offset) {
+    for (size_t size = 0; size <= max_short_size; ++size) {
+      failures += check("random bytes", random_bytes.data() + offset, size);
+      failures += check("random text", random_text.data() + offset, size);
+      failures += check("bytes >= 0x80", high_bytes.data() + offset, size);
+    }
+  }
+
+  std::string every_byte;
+  for (int repeat = 0; repeat < 3; ++repeat) {
+    for (int value = 0; value < 256; ++value) {
+      every_byte += static_cast<char>(value);
+    }
+  }
+  failures += check("every byte value", every_byte.data(), every_byte.size());
+
+  for (const size_t size :
+       {size_t{4095}, size_t{4096}, size_t{4097}, size_t{65537},
+        size_t{1024 * 1024 + 13}}) {
+    const std::string bytes = make_random_bytes(random_engine, size);
+    const std::string text = make_random_text(random_engine, size);
+    failures += check("random bytes", bytes.data(), bytes.size());
+    failures += check("random text", text.data(), text.size());
+    // A single repeated byte puts the whole input in one histogram bucket
+    const std::string repeated(size, static_cast<char>(0xE9));
+    failures += check("repeated 0xE9", repeated.data(), repeated.size());
+  }
+
+  for (const Utf8_Kernel kernel : tested_utf8_kernels) {
+    std::cout << "UTF-8 " << WindowsSocketApp::get_utf8_kernel_name(kernel)
+              << ": "
+              << (WindowsSocketApp::is_utf8_kernel_supported(kernel)
+                      ? "tested"
+                      : "not supported by this CPU, skipped")
+              << std::endl;
+  }
+  failures += check_utf8_kernels(random_engine);
+  failures += check_invalid_utf8_text();
+
+  if (failures > 0) {
+    std::cerr << failures << " mismatch(es)" << std::endl;
+    return 1;
+  }
+  std::cout << "Every supported kernel matches the reference" << std::endl;
+  return 0;
+}
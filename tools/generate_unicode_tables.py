@@ -0,0 +1,88 @@
+#!/usr/bin/env python3
+"""Generates src/core/UnicodeTables.cpp from the Unicode Character Database
+bundled with Python (unicodedata).
+
+    python3 tools/generate_unicode_tables.py > src/core/UnicodeTables.cpp
+
+Every code point gets a Unicode_Class (see UnicodeTables.h), stored in a
+two-stage table: the first stage maps each block of 256 code points to one
+of the distinct blocks of the second stage, which holds a 4-bit class per
+code point.
+"""
+
+import sys
+import unicodedata
+
+BLOCK_SIZE = 256
+
+# Unicode_Class values, in the order of the enum in UnicodeTables.h
+OTHER, WHITESPACE, UPPERCASE, LOWERCASE, OTHER_LETTER, DIGIT, PUNCTUATION = \
+    range(7)
+
+# The White_Space property (PropList.txt); unicodedata does not expose it
+WHITE_SPACE = set(range(0x09, 0x0E)) | {
+    0x20, 0x85, 0xA0, 0x1680, 0x2028, 0x2029, 0x202F, 0x205F, 0x3000
+} | set(range(0x2000, 0x200B))
+
+
+def unicode_class(code_point):
+    if code_point in WHITE_SPACE:
+        return WHITESPACE
+    category = unicodedata.category(chr(code_point))
+    if category == "Lu":
+        return UPPERCASE
+    if category == "Ll":
+        return LOWERCASE
+    if category[0] == "L":
+        return OTHER_LETTER
+    if category == "Nd":
+        return DIGIT
+    if category[0] == "P":
+        return PUNCTUATION
+    return OTHER
+
+
+def main():
+    blocks = {}
+    stage_1 = []
+    for start in range(0, 0x110000, BLOCK_SIZE):
+        block = tuple(unicode_class(code_point)
+                      for code_point in range(start, start + BLOCK_SIZE))
+        stage_1.append(blocks.setdefault(block, len(blocks)))
+    assert len(blocks) <= 256
+
+    stage_2 = []
+    for block in blocks:
+        for i in range(0, BLOCK_SIZE, 2):
+            stage_2.append(block[i] | (block[i + 1] << 4))
+
+    def rows(values):
+        lines = []
+        for i in range(0, len(values), 12):
+            lines.append("    " + ", ".join(
+                "0x%02X" % value for value in values[i:i + 12]) + ",")
+        return "\n".join(lines)
+
+    print("""// Generated by tools/generate_unicode_tables.py from Unicode %s.
+// Do not edit by hand.
+
+#include "../include/UnicodeTables.h"
+
+namespace WindowsSocketApp {
+
+const std::array<uint8_t, unicode_stage_1_size> unicode_stage_1{{
+%s
+}};
+
+// %d blocks
+const uint8_t unicode_stage_2[]{
+%s
+};
+
+}  // namespace WindowsSocketApp""" % (unicodedata.unidata_version,
+                                     rows(stage_1), len(blocks), rows(stage_2)))
+    print("%d distinct blocks" % len(blocks), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()